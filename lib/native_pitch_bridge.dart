@@ -16,6 +16,7 @@ import 'package:music_life/services/permission_service.dart';
 import 'package:music_life/pigeon/native_pitch_messages.dart';
 import 'package:music_life/utils/app_logger.dart';
 import 'package:music_life/utils/ring_buffer.dart';
+import 'package:music_life/utils/tuner_transposition.dart';
 
 // ── FFI struct matching MLPitchResult in src/app_bridge/pitch_detector_ffi.h ──
 
@@ -24,6 +24,57 @@ final class MLPitchResult extends Struct {
   external Array<Uint8> noteName;
 }
 
+// ── FFI structs matching the result mailbox in pitch_detector_ffi.h ──────────
+
+/// Mirrors the C struct `MLPitchMailboxSlot`.
+///
+/// Read in place from `ml_pitch_mailbox_results`: result `n` is complete in
+/// slot `(n - 1) % resultCapacity` while `sequence` is `2n` (odd while being
+/// written), so a reader checks it before and after copying the fields.
+final class MLPitchMailboxSlot extends Struct {
+  @Uint32()
+  external int sequence;
+
+  @Int32()
+  external int pitched;
+
+  @Float()
+  external double frequency;
+
+  @Float()
+  external double probability;
+
+  @Int32()
+  external int midiNote;
+
+  @Float()
+  external double centsOffset;
+
+  @Int64()
+  external int endSample;
+}
+
+/// Mirrors the C struct `MLPitchMailboxHeader`.
+final class MLPitchMailboxHeader extends Struct {
+  @Uint64()
+  external int resultsPublished;
+
+  @Uint64()
+  external int samplesWritten;
+
+  @Uint64()
+  external int samplesConsumed;
+
+  @Uint64()
+  external int samplesDropped;
+
+  @Uint32()
+  external int sampleCapacity;
+
+  @Uint32()
+  external int resultCapacity;
+}
+
 // ── FFI function typedefs ─────────────────────────────────────────────────────
 
 typedef _MLCreateNative = Pointer<Void> Function(
@@ -34,10 +85,32 @@ typedef _MLCreateDart = Pointer<Void> Function(
 typedef _MLDestroyNative = Void Function(Pointer<Void> handle);
 typedef _MLDestroyDart = void Function(Pointer<Void> handle);
 
-typedef _MLProcessNative = MLPitchResult Function(
-    Pointer<Void> handle, Pointer<Float> samples, Int32 numSamples);
-typedef _MLProcessDart = MLPitchResult Function(
-    Pointer<Void> handle, Pointer<Float> samples, int numSamples);
+typedef _MLMailboxCreateNative = Pointer<Void> Function(
+    Pointer<Void> handle, Int32 sampleCapacity, Int32 resultCapacity);
+typedef _MLMailboxCreateDart = Pointer<Void> Function(
+    Pointer<Void> handle, int sampleCapacity, int resultCapacity);
+
+typedef _MLMailboxDestroyNative = Void Function(Pointer<Void> mailbox);
+typedef _MLMailboxDestroyDart = void Function(Pointer<Void> mailbox);
+
+typedef _MLMailboxHeaderNative = Pointer<MLPitchMailboxHeader> Function(
+    Pointer<Void> mailbox);
+typedef _MLMailboxHeaderDart = Pointer<MLPitchMailboxHeader> Function(
+    Pointer<Void> mailbox);
+
+typedef _MLMailboxSamplesNative = Pointer<Float> Function(
+    Pointer<Void> mailbox);
+typedef _MLMailboxSamplesDart = Pointer<Float> Function(Pointer<Void> mailbox);
+
+typedef _MLMailboxResultsNative = Pointer<MLPitchMailboxSlot> Function(
+    Pointer<Void> mailbox);
+typedef _MLMailboxResultsDart = Pointer<MLPitchMailboxSlot> Function(
+    Pointer<Void> mailbox);
+
+typedef _MLMailboxCommitAndPumpNative = Int32 Function(
+    Pointer<Void> mailbox, Int32 numSamples);
+typedef _MLMailboxCommitAndPumpDart = int Function(
+    Pointer<Void> mailbox, int numSamples);
 
 typedef _MLNativeLogCallbackNative = Void Function(
     Int32 level, Pointer<Utf8> message);
@@ -58,6 +131,11 @@ typedef _NativePitchResourceFactory = _NativePitchResources Function({
   required double threshold,
 });
 
+// The isolate appends whole frames and drains them before the next one, so
+// two frames of samples never fill up; results are read after every frame.
+const int _mailboxFramesCapacity = 2;
+const int _mailboxResultCapacity = 16;
+
 const int _mlLogLevelTrace = 0;
 const int _mlLogLevelDebug = 1;
 const int _mlLogLevelInfo = 2;
@@ -95,13 +173,29 @@ _NativePitchResources _createNativeResources({
   if (handle == nullptr) {
     throw StateError('ml_pitch_detector_create returned a null handle.');
   }
+  final nativeDestroy = lib.lookupFunction<_MLDestroyNative, _MLDestroyDart>(
+      'ml_pitch_detector_destroy');
+
+  final mailbox = lib.lookupFunction<_MLMailboxCreateNative,
+          _MLMailboxCreateDart>('ml_pitch_mailbox_create')(
+      handle, frameSize * _mailboxFramesCapacity, _mailboxResultCapacity);
+  if (mailbox == nullptr) {
+    nativeDestroy(handle);
+    throw StateError('ml_pitch_mailbox_create returned a null mailbox.');
+  }
 
   return _NativePitchResources(
     handle: handle,
-    nativeDestroy: lib.lookupFunction<_MLDestroyNative, _MLDestroyDart>(
-        'ml_pitch_detector_destroy'),
-    persistentBuffer: malloc.allocate<Float>(frameSize * sizeOf<Float>()),
+    nativeDestroy: nativeDestroy,
+    mailbox: mailbox,
+    mailboxDestroy:
+        lib.lookupFunction<_MLMailboxDestroyNative, _MLMailboxDestroyDart>(
+            'ml_pitch_mailbox_destroy'),
     handleFinalizer: handleFinalizer,
+    mailboxFinalizer: NativeFinalizer(
+      lib.lookup<NativeFunction<_MLMailboxDestroyNative>>(
+          'ml_pitch_mailbox_destroy'),
+    ),
   );
 }
 
@@ -160,12 +254,23 @@ final class _NativePitchResources {
   const _NativePitchResources({
     required this.handle,
     required this.nativeDestroy,
-    required this.persistentBuffer,
+    required this.mailbox,
+    required this.mailboxDestroy,
     required this.handleFinalizer,
+    required this.mailboxFinalizer,
   });
 
   final Pointer<Void> handle;
   final _MLDestroyDart nativeDestroy;
-  final Pointer<Float> persistentBuffer;
+
+  /// `MLPitchMailbox*` feeding [handle]; destroy it before the handle.
+  final Pointer<Void> mailbox;
+  final _MLMailboxDestroyDart mailboxDestroy;
   final NativeFinalizer handleFinalizer;
+  final NativeFinalizer mailboxFinalizer;
+
+  void destroy() {
+    mailboxDestroy(mailbox);
+    nativeDestroy(handle);
+  }
 }
@@ -5,8 +5,7 @@ class NativePitchIsolateManager {
   static const int _maxHeartbeatToken = 0x7fffffff;
 
   NativePitchIsolateManager({
-    required this.handle,
-    required this.buffer,
+    required this.mailbox,
     required this.frameSize,
     required this.entryPoint,
     required this.onMessage,
@@ -18,8 +17,7 @@ class NativePitchIsolateManager {
     this.heartbeatTimeout = const Duration(seconds: 6),
   });
 
-  final Pointer<Void> handle;
-  final Pointer<Float> buffer;
+  final Pointer<Void> mailbox;
   final int frameSize;
   final void Function(IsolateSetup setup) entryPoint;
   final void Function(dynamic message) onMessage;
@@ -57,8 +55,7 @@ class NativePitchIsolateManager {
     _exitPort = exitPort;
     final setup = IsolateSetup(
       resultPort: resultPort.sendPort,
-      handle: handle,
-      buffer: buffer,
+      mailbox: mailbox,
       frameSize: frameSize,
     );
 
@@ -347,8 +344,24 @@ void _audioProcessingIsolate(IsolateSetup setup) {
     return;
   }
 
-  final process = lib.lookupFunction<_MLProcessNative, _MLProcessDart>(
-      'ml_pitch_detector_process');
+  // Frames go straight into the mailbox's sample ring and one call commits
+  // them and runs every hop they complete; results are read in place from
+  // the mapped slots, so a frame costs a single FFI crossing.
+  final mailbox = setup.mailbox;
+  final header = lib
+      .lookupFunction<_MLMailboxHeaderNative, _MLMailboxHeaderDart>(
+          'ml_pitch_mailbox_header')(mailbox)
+      .ref;
+  final commitAndPump = lib.lookupFunction<_MLMailboxCommitAndPumpNative,
+      _MLMailboxCommitAndPumpDart>('ml_pitch_mailbox_commit_and_pump');
+  final sampleRing = lib
+      .lookupFunction<_MLMailboxSamplesNative, _MLMailboxSamplesDart>(
+          'ml_pitch_mailbox_samples')(mailbox)
+      .asTypedList(header.sampleCapacity);
+  final slots = lib.lookupFunction<_MLMailboxResultsNative,
+      _MLMailboxResultsDart>('ml_pitch_mailbox_results')(mailbox);
+  final resultCapacity = header.resultCapacity;
+  int resultsRead = 0;
 
   final sampleBuf = RingBuffer();
   int peakBufferedSamples = 0;
@@ -404,8 +417,10 @@ void _audioProcessingIsolate(IsolateSetup setup) {
   void processFrame(Float32List frame) {
     final stopwatch = Stopwatch()..start();
     try {
-      setup.buffer.asTypedList(frame.length).setAll(0, frame);
-      final result = process(setup.handle, setup.buffer, frame.length);
+      _appendToMailbox(sampleRing, header.samplesWritten, frame);
+      if (commitAndPump(mailbox, frame.length) < 0) {
+        throw StateError('Mailbox sample ring overflowed.');
+      }
       if (analysisBufferCount > 0 && fftSize > 0) {
         final spectrumBuffer = spectrumBuffers[nextSpectrumBufferIndex];
         _fillSpectrumBins(
@@ -431,19 +446,28 @@ void _audioProcessingIsolate(IsolateSetup setup) {
       if (lastFrameProcessingMicros > maxFrameProcessingMicros) {
         maxFrameProcessingMicros = lastFrameProcessingMicros;
       }
-      if (result.pitched != 0) {
-        final bytes = <int>[];
-        for (int i = 0; i < 8; i++) {
-          final b = result.noteName[i];
-          if (b == 0) break;
-          bytes.add(b);
-        }
+      final published = header.resultsPublished;
+      // Results older than the slot ring were overwritten unseen.
+      final oldest = math.max(resultsRead + 1, published - resultCapacity + 1);
+      resultsRead = published;
+      for (int n = oldest; n <= published; n++) {
+        final slot = slots[(n - 1) & (resultCapacity - 1)];
+        final sequence = (2 * n) & 0xffffffff;
+        if (slot.sequence != sequence) continue;
+        final pitched = slot.pitched != 0;
+        final frequency = slot.frequency;
+        final centsOffset = slot.centsOffset;
+        final midiNote = slot.midiNote;
+        if (slot.sequence != sequence || !pitched) continue;
         setup.resultPort.send(
           NativePitchResultMessage(
-            noteName: String.fromCharCodes(bytes),
-            frequency: result.frequency,
-            centsOffset: result.centsOffset,
-            midiNote: result.midiNote,
+            noteName: transposedNoteNameFromMidi(
+              midiNote: midiNote,
+              transposition: TunerTransposition.c,
+            ),
+            frequency: frequency,
+            centsOffset: centsOffset,
+            midiNote: midiNote,
           ).encode(),
         );
       }
@@ -534,6 +558,15 @@ void _audioProcessingIsolate(IsolateSetup setup) {
   });
 }
 
+/// Copies [frame] into the mailbox sample ring at [samplesWritten], wrapping
+/// at the end; the caller commits it afterwards.
+void _appendToMailbox(Float32List ring, int samplesWritten, Float32List frame) {
+  final start = samplesWritten & (ring.length - 1);
+  final first = math.min(frame.length, ring.length - start);
+  ring.setRange(start, start + first, frame);
+  ring.setRange(0, frame.length - first, frame, first);
+}
+
 Duration _clampDurationToZero(int microseconds) {
   return Duration(microseconds: microseconds < 0 ? 0 : microseconds);
 }
@@ -18,8 +18,6 @@ class NativePitchBridge implements Finalizable {
       NativeCallable<_MLNativeLogCallbackNative>.listener(
     _onNativeLog,
   );
-  static final NativeFinalizer _bufferFinalizer =
-      NativeFinalizer(malloc.nativeFree);
 
   final int _sampleRate;
   final int _frameSize;
@@ -139,8 +137,7 @@ class NativePitchBridge implements Finalizable {
     try {
       final resources = _ensureNativeResourcesInitialized();
       final manager = NativePitchIsolateManager(
-        handle: resources.handle,
-        buffer: resources.persistentBuffer,
+        mailbox: resources.mailbox,
         frameSize: _frameSize,
         entryPoint: _audioProcessingIsolate,
         onMessage: (msg) {
@@ -209,9 +206,9 @@ class NativePitchBridge implements Finalizable {
       resources.handle.cast(),
       detach: this,
     );
-    _bufferFinalizer.attach(
+    resources.mailboxFinalizer.attach(
       this,
-      resources.persistentBuffer.cast(),
+      resources.mailbox.cast(),
       detach: this,
     );
     _nativeResources = resources;
@@ -250,7 +247,7 @@ class NativePitchBridge implements Finalizable {
     _nativeResources = null;
     if (resources != null) {
       resources.handleFinalizer.detach(this);
-      _bufferFinalizer.detach(this);
+      resources.mailboxFinalizer.detach(this);
     }
     _audioSub?.cancel();
     _audioSub = null;
@@ -279,8 +276,7 @@ class NativePitchBridge implements Finalizable {
 
     if (isolate == null || exitPort == null) {
       // No isolate was started; free native resources immediately.
-      resources.nativeDestroy(resources.handle);
-      malloc.free(resources.persistentBuffer);
+      resources.destroy();
       return;
     }
 
@@ -298,8 +294,7 @@ class NativePitchBridge implements Finalizable {
       forceKillTimer?.cancel();
       exitSub?.cancel();
       exitPort.close();
-      resources.nativeDestroy(resources.handle);
-      malloc.free(resources.persistentBuffer);
+      resources.destroy();
     }
 
     exitSub = exitPort.listen((_) => freeNativeResources());
@@ -132,14 +132,14 @@ class NativeIsolateMetrics {
 class IsolateSetup {
   const IsolateSetup({
     required this.resultPort,
-    required this.handle,
-    required this.buffer,
+    required this.mailbox,
     required this.frameSize,
   });
 
   final SendPort resultPort;
-  final Pointer<Void> handle;
-  final Pointer<Float> buffer;
+
+  /// `MLPitchMailbox*` the isolate feeds, pumps and reads results from.
+  final Pointer<Void> mailbox;
   final int frameSize;
 }
 
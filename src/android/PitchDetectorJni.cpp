@@ -2,11 +2,79 @@
 
 #include <jni.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 namespace {
 
-music_life::PitchDetector* fromHandle(jlong handle) {
+// Floats per record written to the registered result buffer:
+// pitched, frequency, probability, midi_note, cents_offset, end_offset.
+constexpr int kDirectResultStride = 6;
+constexpr int kPcm16ChunkSamples = 1024;
+constexpr float kPcm16Scale = 1.0f / 32768.0f;
+
+struct NativePitchDetector {
+    std::unique_ptr<music_life::PitchDetector> detector;
+
+    // Direct buffers registered once from Kotlin; addresses stay valid for as
+    // long as the Java side keeps the buffers reachable.
+    const void* input = nullptr;
+    jlong       input_bytes = 0;
+    float*      results = nullptr;
+    int         result_capacity = 0;
+
+    // Fold gains for the interleaved path, copied in at registration so the
+    // per-block call makes no JNI array calls; 0 gains averages the channels.
+    float       channel_weights[music_life::PitchDetector::kMaxChannels] = {};
+    int         channel_weight_count = 0;
+
+    std::vector<float> pcm16_scratch = std::vector<float>(kPcm16ChunkSamples);
+    music_life::PitchDetector::Result block_results[16];
+    int block_offsets[16];
+};
+
+NativePitchDetector* fromHandle(jlong handle) {
     if (handle == 0) return nullptr;
-    return reinterpret_cast<music_life::PitchDetector*>(handle);
+    return reinterpret_cast<NativePitchDetector*>(handle);
+}
+
+void writeRecord(NativePitchDetector& native, const music_life::PitchDetector::Result& r, int end_offset, int index) {
+    float* record = native.results + static_cast<ptrdiff_t>(index) * kDirectResultStride;
+    record[0] = r.pitched ? 1.0f : 0.0f;
+    record[1] = r.frequency;
+    record[2] = r.probability;
+    record[3] = static_cast<float>(r.midi_note);
+    record[4] = r.cents_offset;
+    record[5] = static_cast<float>(end_offset);
+}
+
+// Runs every hop in the `count` interleaved frames at samples and appends
+// records to the registered result buffer starting at record *written; base
+// is added to end offsets.  Mono input has one channel and no weights.
+void processIntoResults(NativePitchDetector& native,
+                        const float* samples,
+                        int count,
+                        int channels,
+                        const float* weights,
+                        int base,
+                        int* written) {
+    constexpr int kBatch = static_cast<int>(sizeof(native.block_offsets) / sizeof(int));
+    const int min_hop = std::min(native.detector->min_hop_size(), native.detector->strobe_hop_size());
+    const int slice_size = min_hop * (kBatch - 1);
+    for (int offset = 0; offset < count;) {
+        const int slice = std::min(slice_size, count - offset);
+        const int room = std::min(kBatch, native.result_capacity - *written);
+        const int produced = native.detector->process_block_interleaved(
+            samples + static_cast<ptrdiff_t>(offset) * channels, slice, channels, weights,
+            native.block_results, room, native.block_offsets);
+        for (int i = 0; i < produced; ++i) {
+            writeRecord(native, native.block_results[i], base + offset + native.block_offsets[i], *written);
+            ++*written;
+        }
+        offset += slice;
+    }
 }
 
 void throwRuntimeException(JNIEnv* env, const char* message) {
@@ -33,13 +101,19 @@ Java_com_musiclife_PitchDetector_nativeCreate(
     jfloat threshold,
     jfloat referencePitchHz) {
     try {
-        auto* detector = new music_life::PitchDetector(
-            static_cast<int>(sampleRate),
-            static_cast<int>(frameSize),
-            static_cast<float>(threshold),
-            static_cast<float>(referencePitchHz)
-        );
-        return reinterpret_cast<jlong>(detector);
+        auto* native = new NativePitchDetector();
+        try {
+            native->detector = std::make_unique<music_life::PitchDetector>(
+                static_cast<int>(sampleRate),
+                static_cast<int>(frameSize),
+                static_cast<float>(threshold),
+                static_cast<float>(referencePitchHz)
+            );
+        } catch (...) {
+            delete native;
+            throw;
+        }
+        return reinterpret_cast<jlong>(native);
     } catch (...) {
         throwRuntimeException(env, "Failed to create native PitchDetector");
         return 0;
@@ -61,9 +135,9 @@ Java_com_musiclife_PitchDetector_nativeReset(
     jobject /* thiz */,
     jlong handle) {
     (void)env;
-    auto* detector = fromHandle(handle);
-    if (detector) {
-        detector->reset();
+    auto* native = fromHandle(handle);
+    if (native) {
+        native->detector->reset();
     }
 }
 
@@ -74,10 +148,40 @@ Java_com_musiclife_PitchDetector_nativeSetReferencePitch(
     jlong handle,
     jfloat referencePitchHz) {
     (void)env;
-    auto* detector = fromHandle(handle);
-    if (!detector) return JNI_FALSE;
+    auto* native = fromHandle(handle);
+    if (!native) return JNI_FALSE;
     try {
-        detector->set_reference_pitch(static_cast<float>(referencePitchHz));
+        native->detector->set_reference_pitch(static_cast<float>(referencePitchHz));
+        return JNI_TRUE;
+    } catch (...) {
+        return JNI_FALSE;
+    }
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_musiclife_PitchDetector_nativeReconfigure(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jint frameSize,
+    jfloat threshold,
+    jboolean adaptiveFrameSize,
+    jint fftBackend) {
+    (void)env;
+    auto* native = fromHandle(handle);
+    if (!native) return JNI_FALSE;
+    // Same numbering as MLFftBackend.
+    static constexpr music_life::FftBackend kBackends[] = {
+        music_life::FftBackend::Auto, music_life::FftBackend::Radix2,
+        music_life::FftBackend::Accelerate, music_life::FftBackend::Fftw};
+    if (fftBackend < 0 || fftBackend > 3) return JNI_FALSE;
+    try {
+        music_life::PitchDetector::AnalysisConfig config;
+        config.frame_size          = static_cast<int>(frameSize);
+        config.threshold           = static_cast<float>(threshold);
+        config.adaptive_frame_size = adaptiveFrameSize == JNI_TRUE;
+        config.fft_backend         = kBackends[fftBackend];
+        native->detector->reconfigure(config);
         return JNI_TRUE;
     } catch (...) {
         return JNI_FALSE;
@@ -92,8 +196,8 @@ Java_com_musiclife_PitchDetector_nativeProcess(
     jfloatArray samples,
     jint numSamples,
     jfloatArray resultOut) {
-    auto* detector = fromHandle(handle);
-    if (!detector || !samples || numSamples <= 0 || !resultOut) return;
+    auto* native = fromHandle(handle);
+    if (!native || !samples || numSamples <= 0 || !resultOut) return;
 
     struct FloatArrayGuard {
         JNIEnv* env;
@@ -115,7 +219,7 @@ Java_com_musiclife_PitchDetector_nativeProcess(
 
     music_life::PitchDetector::Result result{};
     try {
-        result = detector->process(sampleGuard.data, static_cast<int>(numSamples));
+        result = native->detector->process(sampleGuard.data, static_cast<int>(numSamples));
     } catch (...) {
         return;
     }
@@ -129,3 +233,167 @@ Java_com_musiclife_PitchDetector_nativeProcess(
     };
     env->SetFloatArrayRegion(resultOut, 0, 5, out);
 }
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_musiclife_PitchDetector_nativeRegisterDirectBuffers(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jobject input,
+    jobject results,
+    jfloatArray channelWeights) {
+    auto* native = fromHandle(handle);
+    if (!native || !input || !results) return JNI_FALSE;
+
+    const jsize weight_count = channelWeights ? env->GetArrayLength(channelWeights) : 0;
+    if (channelWeights && (weight_count < 1 || weight_count > music_life::PitchDetector::kMaxChannels)) {
+        throwRuntimeException(env, "Channel weights must hold between 1 and kMaxChannels gains");
+        return JNI_FALSE;
+    }
+
+    void* input_address = env->GetDirectBufferAddress(input);
+    const jlong input_bytes = env->GetDirectBufferCapacity(input);
+    void* results_address = env->GetDirectBufferAddress(results);
+    const jlong results_bytes = env->GetDirectBufferCapacity(results);
+    if (!input_address || input_bytes <= 0 || !results_address ||
+        results_bytes < static_cast<jlong>(kDirectResultStride * sizeof(float)) ||
+        reinterpret_cast<uintptr_t>(input_address) % alignof(float) != 0 ||
+        reinterpret_cast<uintptr_t>(results_address) % alignof(float) != 0) {
+        throwRuntimeException(env, "Direct buffers must be non-empty, float-aligned direct ByteBuffers");
+        return JNI_FALSE;
+    }
+
+    native->input = input_address;
+    native->input_bytes = input_bytes;
+    native->results = static_cast<float*>(results_address);
+    native->result_capacity = static_cast<int>(
+        std::min<jlong>(results_bytes / static_cast<jlong>(kDirectResultStride * sizeof(float)), 1 << 20));
+    if (channelWeights) env->GetFloatArrayRegion(channelWeights, 0, weight_count, native->channel_weights);
+    native->channel_weight_count = static_cast<int>(weight_count);
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_musiclife_PitchDetector_nativeProcessDirectFloat(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jint numSamples) {
+    (void)env;
+    auto* native = fromHandle(handle);
+    if (!native || !native->input || numSamples <= 0 ||
+        static_cast<jlong>(numSamples) * static_cast<jlong>(sizeof(float)) > native->input_bytes) {
+        return -1;
+    }
+
+    int written = 0;
+    try {
+        processIntoResults(*native, static_cast<const float*>(native->input),
+                           static_cast<int>(numSamples), 1, nullptr, 0, &written);
+    } catch (...) {
+        return -1;
+    }
+    return written;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_musiclife_PitchDetector_nativeProcessDirectPcm16(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jint numSamples) {
+    (void)env;
+    auto* native = fromHandle(handle);
+    if (!native || !native->input || numSamples <= 0 ||
+        static_cast<jlong>(numSamples) * static_cast<jlong>(sizeof(int16_t)) > native->input_bytes) {
+        return -1;
+    }
+
+    const auto* pcm = static_cast<const int16_t*>(native->input);
+    float* scratch = native->pcm16_scratch.data();
+    int written = 0;
+    try {
+        for (int base = 0; base < numSamples; base += kPcm16ChunkSamples) {
+            const int count = std::min(kPcm16ChunkSamples, static_cast<int>(numSamples) - base);
+            for (int i = 0; i < count; ++i) {
+                scratch[i] = static_cast<float>(pcm[base + i]) * kPcm16Scale;
+            }
+            processIntoResults(*native, scratch, count, 1, nullptr, base, &written);
+        }
+    } catch (...) {
+        return -1;
+    }
+    return written;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_musiclife_PitchDetector_nativeProcessDirectInterleaved(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jint numFrames,
+    jint channels) {
+    (void)env;
+    auto* native = fromHandle(handle);
+    if (!native || !native->input || numFrames <= 0 || channels < 1 ||
+        channels > music_life::PitchDetector::kMaxChannels ||
+        (native->channel_weight_count > 0 && native->channel_weight_count < channels) ||
+        static_cast<jlong>(numFrames) * channels * static_cast<jlong>(sizeof(float)) > native->input_bytes) {
+        return -1;
+    }
+
+    const float* weights = native->channel_weight_count > 0 ? native->channel_weights : nullptr;
+    int written = 0;
+    try {
+        processIntoResults(*native, static_cast<const float*>(native->input), static_cast<int>(numFrames),
+                           static_cast<int>(channels), weights, 0, &written);
+    } catch (...) {
+        return -1;
+    }
+    return written;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_musiclife_PitchDetector_nativeEnableChannelDetection(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jint channels) {
+    (void)env;
+    auto* native = fromHandle(handle);
+    if (!native) return JNI_FALSE;
+    try {
+        native->detector->enable_channel_detection(static_cast<int>(channels));
+        return JNI_TRUE;
+    } catch (...) {
+        return JNI_FALSE;
+    }
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_musiclife_PitchDetector_nativeProcessDirectChannels(
+    JNIEnv* env,
+    jobject /* thiz */,
+    jlong handle,
+    jint numFrames) {
+    (void)env;
+    auto* native = fromHandle(handle);
+    if (!native || !native->input || numFrames <= 0) return -1;
+    const int channels = native->detector->channel_count();
+    if (channels == 0 || channels > native->result_capacity ||
+        static_cast<jlong>(numFrames) * channels * static_cast<jlong>(sizeof(float)) > native->input_bytes) {
+        return -1;
+    }
+
+    // One record per channel, in channel order; every end offset is the block end.
+    music_life::PitchDetector::Result results[music_life::PitchDetector::kMaxChannels];
+    try {
+        native->detector->process_channels(static_cast<const float*>(native->input), static_cast<int>(numFrames), results);
+    } catch (...) {
+        return -1;
+    }
+    for (int c = 0; c < channels; ++c) {
+        writeRecord(*native, results[c], static_cast<int>(numFrames), c);
+    }
+    return channels;
+}
@@ -1,6 +1,9 @@
 package com.musiclife
 
 import java.io.Closeable
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
 
 class PitchDetector(
     sampleRate: Int,
@@ -19,6 +22,12 @@ class PitchDetector(
     private var nativeHandle: Long = nativeCreate(sampleRate, frameSize, threshold, referencePitchHz)
     private val resultBuffer = FloatArray(5)
 
+    // Direct-buffer fast path: registered once, then reused for every block.
+    private var directInput: ByteBuffer? = null
+    private var directResults: ByteBuffer? = null
+    private var directResultView: FloatBuffer? = null
+    private var directChannelWeights = 0
+
     init {
         require(nativeHandle != 0L) { "Failed to create native PitchDetector" }
     }
@@ -37,6 +46,95 @@ class PitchDetector(
         )
     }
 
+    /**
+     * Registers direct buffers for the zero-copy path. [input] receives audio
+     * as float32 or PCM16 (native byte order); [maxResults] bounds the number
+     * of hops reported per call. [channelWeights] holds one gain per channel
+     * for [processDirectInterleaved]: null averages the channels and a single
+     * 1 selects one. The gains are copied natively here; attach again to
+     * change them. Returns the input buffer to fill.
+     */
+    fun attachDirectBuffers(
+        inputCapacityBytes: Int,
+        maxResults: Int = 16,
+        channelWeights: FloatArray? = null,
+    ): ByteBuffer {
+        require(inputCapacityBytes > 0 && maxResults > 0)
+        require(channelWeights == null || channelWeights.size in 1..MAX_CHANNELS)
+        val input = ByteBuffer.allocateDirect(inputCapacityBytes).order(ByteOrder.nativeOrder())
+        val results = ByteBuffer.allocateDirect(maxResults * DIRECT_RESULT_STRIDE * Float.SIZE_BYTES)
+            .order(ByteOrder.nativeOrder())
+        check(nativeRegisterDirectBuffers(nativeHandle, input, results, channelWeights)) {
+            "Failed to register direct buffers"
+        }
+        directInput = input
+        directResults = results
+        directResultView = results.asFloatBuffer()
+        directChannelWeights = channelWeights?.size ?: 0
+        return input
+    }
+
+    /** Processes [numSamples] float32 samples from the attached input buffer; returns the hop count. */
+    fun processDirectFloat(numSamples: Int): Int {
+        check(directInput != null) { "attachDirectBuffers() must be called first" }
+        return nativeProcessDirectFloat(nativeHandle, numSamples)
+    }
+
+    /** Processes [numSamples] PCM16 samples from the attached input buffer; returns the hop count. */
+    fun processDirectPcm16(numSamples: Int): Int {
+        check(directInput != null) { "attachDirectBuffers() must be called first" }
+        return nativeProcessDirectPcm16(nativeHandle, numSamples)
+    }
+
+    /**
+     * Processes [numFrames] interleaved float32 frames of [channels] channels
+     * from the attached input buffer, folded to mono on the way into the
+     * detector with the gains given to [attachDirectBuffers]. Offsets are in
+     * frames. Returns the hop count.
+     */
+    fun processDirectInterleaved(numFrames: Int, channels: Int): Int {
+        check(directInput != null) { "attachDirectBuffers() must be called first" }
+        require(directChannelWeights == 0 || directChannelWeights >= channels)
+        return nativeProcessDirectInterleaved(nativeHandle, numFrames, channels)
+    }
+
+    /**
+     * Enables per-channel detection of [channels] interleaved channels, sharing
+     * this detector's FFT plans. Call before audio starts.
+     */
+    fun enableChannelDetection(channels: Int): Boolean {
+        return nativeEnableChannelDetection(nativeHandle, channels)
+    }
+
+    /**
+     * Processes [numFrames] interleaved float32 frames from the attached input
+     * buffer per channel; result [c] (see [directResult]) is channel c.
+     * Returns the channel count, or -1 on error.
+     */
+    fun processDirectChannels(numFrames: Int): Int {
+        check(directInput != null) { "attachDirectBuffers() must be called first" }
+        return nativeProcessDirectChannels(nativeHandle, numFrames)
+    }
+
+    /** Reads hop [index] written by the last processDirect* call. */
+    fun directResult(index: Int): Result {
+        val view = checkNotNull(directResultView) { "attachDirectBuffers() must be called first" }
+        val base = index * DIRECT_RESULT_STRIDE
+        return Result(
+            pitched     = view.get(base) != 0.0f,
+            frequency   = view.get(base + 1),
+            probability = view.get(base + 2),
+            midiNote    = view.get(base + 3).toInt(),
+            centsOffset = view.get(base + 4),
+        )
+    }
+
+    /** Sample index (within the last processed block) at which hop [index] was analysed. */
+    fun directResultEndOffset(index: Int): Int {
+        val view = checkNotNull(directResultView) { "attachDirectBuffers() must be called first" }
+        return view.get(index * DIRECT_RESULT_STRIDE + 5).toInt()
+    }
+
     fun reset() {
         nativeReset(nativeHandle)
     }
@@ -45,6 +143,22 @@ class PitchDetector(
         return nativeSetReferencePitch(nativeHandle, referencePitchHz)
     }
 
+    /**
+     * Changes frame size, threshold, adaptive framing and FFT backend
+     * (one of the FFT_BACKEND_* constants) while audio is running. The new
+     * engines are built on the calling thread and swapped in at the next hop
+     * with the input history carried over, so the tuner display never blanks.
+     * Call from one control thread.
+     */
+    fun reconfigure(
+        frameSize: Int,
+        threshold: Float,
+        adaptiveFrameSize: Boolean = false,
+        fftBackend: Int = FFT_BACKEND_AUTO,
+    ): Boolean {
+        return nativeReconfigure(nativeHandle, frameSize, threshold, adaptiveFrameSize, fftBackend)
+    }
+
     override fun close() {
         if (nativeHandle != 0L) {
             nativeDestroy(nativeHandle)
@@ -62,9 +176,35 @@ class PitchDetector(
     private external fun nativeDestroy(handle: Long)
     private external fun nativeReset(handle: Long)
     private external fun nativeSetReferencePitch(handle: Long, referencePitchHz: Float): Boolean
+    private external fun nativeReconfigure(
+        handle: Long,
+        frameSize: Int,
+        threshold: Float,
+        adaptiveFrameSize: Boolean,
+        fftBackend: Int,
+    ): Boolean
     private external fun nativeProcess(handle: Long, samples: FloatArray, numSamples: Int, result: FloatArray)
+    private external fun nativeRegisterDirectBuffers(
+        handle: Long,
+        input: ByteBuffer,
+        results: ByteBuffer,
+        channelWeights: FloatArray?,
+    ): Boolean
+    private external fun nativeProcessDirectFloat(handle: Long, numSamples: Int): Int
+    private external fun nativeProcessDirectPcm16(handle: Long, numSamples: Int): Int
+    private external fun nativeProcessDirectInterleaved(handle: Long, numFrames: Int, channels: Int): Int
+    private external fun nativeEnableChannelDetection(handle: Long, channels: Int): Boolean
+    private external fun nativeProcessDirectChannels(handle: Long, numFrames: Int): Int
 
     companion object {
+        private const val DIRECT_RESULT_STRIDE = 6
+        private const val MAX_CHANNELS = 8
+
+        const val FFT_BACKEND_AUTO = 0
+        const val FFT_BACKEND_RADIX2 = 1
+        const val FFT_BACKEND_ACCELERATE = 2
+        const val FFT_BACKEND_FFTW = 3
+
         init {
             System.loadLibrary("music_life_jni")
         }
@@ -0,0 +1,94 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "contour_aligner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <vector>
+
+namespace {
+
+using music_life::ContourAligner;
+using music_life::ffi::emit_log;
+
+static_assert(sizeof(MLAlignmentStep) == sizeof(ContourAligner::Step) &&
+              offsetof(MLAlignmentStep, take_frame) == offsetof(ContourAligner::Step, take),
+              "MLAlignmentStep must match the ContourAligner::Step layout.");
+static_assert(sizeof(MLNoteDeviation) == sizeof(ContourAligner::NoteDeviation) &&
+              offsetof(MLNoteDeviation, cents_error) == offsetof(ContourAligner::NoteDeviation, cents_error) &&
+              offsetof(MLNoteDeviation, duration_ratio) == offsetof(ContourAligner::NoteDeviation, duration_ratio),
+              "MLNoteDeviation must match the ContourAligner::NoteDeviation layout.");
+
+}  // namespace
+
+int ml_align_contours(const float* ref,
+                      int ref_frames,
+                      const float* take,
+                      int take_frames,
+                      int dims,
+                      int band,
+                      float max_cost,
+                      MLAlignmentStep* path,
+                      int max_steps) noexcept {
+    if (!ref || !take || ref_frames < 1 || take_frames < 1 || dims < 1 || dims > ContourAligner::kMaxDims ||
+        band < 1 || !(max_cost > 0.0f) || !std::isfinite(max_cost) || max_steps < 0 || (max_steps > 0 && !path)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_align_contours: invalid arguments");
+        return -1;
+    }
+    try {
+        ContourAligner::Config config;
+        config.band = band;
+        config.max_cost = max_cost;
+        const ContourAligner::Alignment alignment =
+            ContourAligner(config).align(ref, ref_frames, take, take_frames, dims);
+        const int length = static_cast<int>(alignment.path.size());
+        std::copy_n(alignment.path.begin(), std::min(length, max_steps), reinterpret_cast<ContourAligner::Step*>(path));
+        emit_log(ML_LOG_LEVEL_DEBUG,
+                 "ml_align_contours: ref=%d take=%d dims=%d band=%d steps=%d cost=%.1f",
+                 ref_frames,
+                 take_frames,
+                 dims,
+                 band,
+                 length,
+                 alignment.cost);
+        return length;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_align_contours: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_align_contours: unknown exception");
+        return -1;
+    }
+}
+
+int ml_align_note_deviations(const float* ref_cents,
+                             int ref_frames,
+                             const float* take_cents,
+                             int take_frames,
+                             const MLAlignmentStep* path,
+                             int path_length,
+                             MLNoteDeviation* out,
+                             int max_notes) noexcept {
+    if (!ref_cents || !take_cents || !path || path_length < 1 || max_notes < 0 || (max_notes > 0 && !out)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_align_note_deviations: invalid arguments");
+        return -1;
+    }
+    try {
+        const auto* steps = reinterpret_cast<const ContourAligner::Step*>(path);
+        const std::vector<ContourAligner::Step> warp(steps, steps + path_length);
+        const std::vector<ContourAligner::NoteDeviation> notes =
+            ContourAligner::note_deviations(ref_cents, ref_frames, take_cents, take_frames, warp);
+        const int count = static_cast<int>(notes.size());
+        std::copy_n(notes.begin(), std::min(count, max_notes), reinterpret_cast<ContourAligner::NoteDeviation*>(out));
+        return count;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_align_note_deviations: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_align_note_deviations: unknown exception");
+        return -1;
+    }
+}
@@ -0,0 +1,271 @@
+#include "async_log.h"
+
+#include "pitch_detector_ffi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace music_life {
+namespace ffi {
+
+namespace {
+
+constexpr size_t kLogQueueCapacity = 256;  // Power of two
+constexpr size_t kFormattedLogSize = 512;
+
+static_assert((kLogQueueCapacity & (kLogQueueCapacity - 1)) == 0,
+              "kLogQueueCapacity must be a power of two.");
+
+// Bounded multi-producer queue (Vyukov): each cell carries a sequence number
+// so producers claim cells with a single CAS and never wait for consumers.
+struct LogCell {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+};
+
+struct LogQueue {
+    LogCell cells[kLogQueueCapacity];
+    std::atomic<size_t> enqueue_pos{0};
+    std::atomic<size_t> dequeue_pos{0};
+    std::atomic<unsigned long long> dropped{0};
+
+    LogQueue() {
+        for (size_t i = 0; i < kLogQueueCapacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const LogRecord& record) noexcept {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            LogCell& cell = cells[pos & (kLogQueueCapacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.record = record;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Single consumer (callers hold g_drain_mutex).
+    bool pop(LogRecord& out) noexcept {
+        const size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        LogCell& cell = cells[pos & (kLogQueueCapacity - 1)];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != pos + 1) {
+            return false;
+        }
+        out = cell.record;
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        cell.sequence.store(pos + kLogQueueCapacity, std::memory_order_release);
+        return true;
+    }
+};
+
+LogQueue g_log_queue;
+std::atomic<MLLogCallback> g_log_callback{nullptr};
+std::mutex g_drain_mutex;
+
+std::mutex g_thread_mutex;
+std::condition_variable g_thread_cv;
+std::thread g_drain_thread;
+bool g_stop_drain_thread = false;
+std::atomic<bool> g_drain_thread_running{false};
+
+bool is_conversion(char c) {
+    switch (c) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        case 's':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool is_length_modifier(char c) {
+    return c == 'l' || c == 'h' || c == 'z' || c == 'j' || c == 't' || c == 'L' || c == 'q';
+}
+
+// Re-applies each conversion of the recorded format to its captured argument.
+// Length modifiers are normalised so integers are always printed as 64-bit.
+void format_record(const LogRecord& record, char* out, size_t out_size) {
+    size_t used = 0;
+    int next_arg = 0;
+    const char* p = record.fmt;
+    auto append = [&](int written) {
+        if (written > 0) used = std::min(out_size - 1, used + static_cast<size_t>(written));
+    };
+
+    while (*p != '\0' && used + 1 < out_size) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[32];
+        size_t spec_len = 0;
+        spec[spec_len++] = *p++;
+        while (*p != '\0' && !is_conversion(*p) && spec_len + 4 < sizeof(spec)) {
+            if (!is_length_modifier(*p)) spec[spec_len++] = *p;
+            ++p;
+        }
+        if (*p == '\0') break;
+        const char conversion = *p++;
+
+        if (next_arg >= record.arg_count) {
+            append(std::snprintf(out + used, out_size - used, "<?>"));
+            continue;
+        }
+        const LogArg& arg = record.args[next_arg++];
+        switch (conversion) {
+            case 's': {
+                spec[spec_len++] = 's';
+                spec[spec_len] = '\0';
+                const char* text = arg.kind == LogArg::Text ? record.text + arg.text_offset : "<?>";
+                append(std::snprintf(out + used, out_size - used, spec, text));
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                const double value = arg.kind == LogArg::Double ? arg.d
+                                   : arg.kind == LogArg::Int ? static_cast<double>(arg.i)
+                                   : static_cast<double>(arg.u);
+                append(std::snprintf(out + used, out_size - used, spec, value));
+                break;
+            }
+            case 'c': {
+                spec[spec_len++] = 'c';
+                spec[spec_len] = '\0';
+                append(std::snprintf(out + used, out_size - used, spec, static_cast<int>(arg.i)));
+                break;
+            }
+            default: {
+                // Integer conversions: widen to long long regardless of the
+                // length modifier used at the call site.
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                if (conversion == 'd' || conversion == 'i') {
+                    const long long value = arg.kind == LogArg::Double ? static_cast<long long>(arg.d) : arg.i;
+                    append(std::snprintf(out + used, out_size - used, spec, value));
+                } else {
+                    const unsigned long long value =
+                        arg.kind == LogArg::Double ? static_cast<unsigned long long>(arg.d) : arg.u;
+                    append(std::snprintf(out + used, out_size - used, spec, value));
+                }
+                break;
+            }
+        }
+    }
+    out[used] = '\0';
+}
+
+void deliver(int level, const char* message) {
+    std::fprintf(stderr, "[music-life] %s\n", message);
+    const MLLogCallback callback = g_log_callback.load(std::memory_order_acquire);
+    if (callback) {
+        callback(level, message);
+    }
+}
+
+void drain_thread_main(int interval_ms) {
+    std::unique_lock<std::mutex> lock(g_thread_mutex);
+    while (!g_stop_drain_thread) {
+        lock.unlock();
+        drain_logs();
+        lock.lock();
+        g_thread_cv.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                             [] { return g_stop_drain_thread; });
+    }
+    lock.unlock();
+    drain_logs();
+}
+
+} // namespace
+
+bool enqueue_log(const LogRecord& record) noexcept {
+    return g_log_queue.push(record);
+}
+
+int drain_logs() noexcept {
+    std::lock_guard<std::mutex> lock(g_drain_mutex);
+    int delivered = 0;
+    LogRecord record;
+    char message[kFormattedLogSize];
+
+    const unsigned long long dropped = g_log_queue.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        std::snprintf(message, sizeof(message), "log queue full: dropped %llu messages", dropped);
+        deliver(ML_LOG_LEVEL_ERROR, message);
+    }
+    while (g_log_queue.pop(record)) {
+        format_record(record, message, sizeof(message));
+        deliver(record.level, message);
+        ++delivered;
+    }
+    return delivered;
+}
+
+bool log_drain_thread_running() noexcept {
+    return g_drain_thread_running.load(std::memory_order_acquire);
+}
+
+void set_log_callback(MLLogCallback callback) noexcept {
+    g_log_callback.store(callback, std::memory_order_release);
+}
+
+bool start_log_drain_thread(int interval_ms) noexcept {
+    std::lock_guard<std::mutex> lock(g_thread_mutex);
+    if (g_drain_thread.joinable()) {
+        return true;
+    }
+    try {
+        g_stop_drain_thread = false;
+        g_drain_thread = std::thread(drain_thread_main, interval_ms);
+        g_drain_thread_running.store(true, std::memory_order_release);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void stop_log_drain_thread() noexcept {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(g_thread_mutex);
+        if (!g_drain_thread.joinable()) {
+            return;
+        }
+        g_stop_drain_thread = true;
+        thread = std::move(g_drain_thread);
+    }
+    g_thread_cv.notify_all();
+    thread.join();
+    g_drain_thread_running.store(false, std::memory_order_release);
+}
+
+} // namespace ffi
+} // namespace music_life
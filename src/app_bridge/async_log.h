@@ -0,0 +1,119 @@
+#pragma once
+
+// Real-time-safe logging for the C bridge.
+//
+// Producers capture a static format string (which doubles as the message ID)
+// plus its arguments into a fixed-size record and push it onto a preallocated
+// lock-free ring; nothing is formatted, allocated or written on the calling
+// thread.  Records are formatted and delivered to stderr and the registered
+// MLLogCallback by drain_logs(), called either from the optional background
+// drain thread or explicitly through ml_pitch_detector_drain_logs().
+
+#include "pitch_detector_ffi.h"
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace music_life {
+namespace ffi {
+
+constexpr int    kMaxLogArgs  = 8;
+constexpr size_t kLogTextSize = 128;
+
+struct LogArg {
+    enum Kind : unsigned char { Int, Unsigned, Double, Text };
+    Kind kind;
+    union {
+        long long          i;
+        unsigned long long u;
+        double             d;
+        size_t             text_offset;
+    };
+};
+
+struct LogRecord {
+    int         level;
+    const char* fmt;        ///< Must have static storage duration
+    int         arg_count;
+    LogArg      args[kMaxLogArgs];
+    size_t      text_used;
+    char        text[kLogTextSize];  ///< NUL-separated copies of %s arguments
+};
+
+/** Lock-free, wait-free on success.  Returns false (and counts a drop) when full. */
+bool enqueue_log(const LogRecord& record) noexcept;
+
+/** Format and deliver every queued record.  Returns the number delivered. */
+int drain_logs() noexcept;
+
+/** True while the background drain thread is running. */
+bool log_drain_thread_running() noexcept;
+
+void set_log_callback(MLLogCallback callback) noexcept;
+bool start_log_drain_thread(int interval_ms) noexcept;
+void stop_log_drain_thread() noexcept;
+
+namespace detail {
+
+template <typename T>
+void capture_log_arg(LogRecord& record, T value) noexcept {
+    if (record.arg_count >= kMaxLogArgs) return;
+    LogArg& arg = record.args[record.arg_count++];
+    if constexpr (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>) {
+        arg.kind = LogArg::Text;
+        arg.text_offset = record.text_used;
+        const char* text = value ? value : "(null)";
+        const size_t room = kLogTextSize - record.text_used;
+        if (room == 0) {
+            arg.text_offset = kLogTextSize - 1;
+            return;
+        }
+        size_t length = std::strlen(text);
+        if (length >= room) length = room - 1;
+        std::memcpy(record.text + record.text_used, text, length);
+        record.text[record.text_used + length] = '\0';
+        record.text_used += length + 1;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        arg.kind = LogArg::Double;
+        arg.d = static_cast<double>(value);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        arg.kind = LogArg::Int;
+        arg.i = static_cast<long long>(value);
+    } else {
+        static_assert(std::is_integral_v<T>, "Unsupported log argument type");
+        arg.kind = LogArg::Unsigned;
+        arg.u = static_cast<unsigned long long>(value);
+    }
+}
+
+} // namespace detail
+
+/** Queue a log record without formatting or blocking.  Safe on the audio thread. */
+template <typename... Args>
+void emit_log_rt(int level, const char* fmt, Args... args) noexcept {
+    LogRecord record;
+    record.level = level;
+    record.fmt = fmt;
+    record.arg_count = 0;
+    record.text_used = 0;
+    record.text[kLogTextSize - 1] = '\0';
+    (detail::capture_log_arg(record, args), ...);
+    enqueue_log(record);
+}
+
+/**
+ * Queue a log record and, unless the background drain thread owns delivery,
+ * deliver it before returning.  For control-path entry points only; audio
+ * paths use emit_log_rt().
+ */
+template <typename... Args>
+void emit_log(int level, const char* fmt, Args... args) noexcept {
+    emit_log_rt(level, fmt, args...);
+    if (!log_drain_thread_running()) {
+        drain_logs();
+    }
+}
+
+} // namespace ffi
+} // namespace music_life
@@ -0,0 +1,84 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "chroma.h"
+
+#include <cmath>
+#include <exception>
+#include <memory>
+
+struct MLChromaHandle {
+    std::unique_ptr<music_life::ChromaAnalyzer> analyzer;
+};
+
+namespace {
+
+using music_life::ffi::emit_log;
+using music_life::ffi::emit_log_rt;
+
+static_assert(static_cast<int>(music_life::ChordQuality::Sus4) == ML_CHORD_SUS4,
+              "MLChordQuality must mirror music_life::ChordQuality.");
+
+}  // namespace
+
+MLChromaHandle* ml_chroma_create(int sample_rate, int frame_size, float reference_pitch_hz) noexcept {
+    if (sample_rate <= 0 || frame_size < 256 || frame_size > 32768 || !std::isfinite(reference_pitch_hz)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_chroma_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* handle = new MLChromaHandle{
+            std::make_unique<music_life::ChromaAnalyzer>(sample_rate, frame_size, reference_pitch_hz)
+        };
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_chroma_create: sample_rate=%d frame_size=%d reference_pitch_hz=%0.2f",
+                 sample_rate,
+                 frame_size,
+                 reference_pitch_hz);
+        return handle;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_chroma_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_chroma_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_chroma_destroy(MLChromaHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_chroma_destroy");
+    delete handle;
+}
+
+void ml_chroma_reset(MLChromaHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_TRACE, "ml_chroma_reset");
+    handle->analyzer->reset();
+}
+
+MLChromaResult ml_chroma_process(MLChromaHandle* handle, const float* samples, int num_samples) noexcept {
+    MLChromaResult out{};
+    out.chord_root = -1;
+    out.key_tonic  = -1;
+    if (!handle || !samples || num_samples <= 0) return out;
+
+    try {
+        const music_life::ChromaAnalyzer::Result r = handle->analyzer->process(samples, num_samples);
+        out.updated = r.updated ? 1 : 0;
+        for (int i = 0; i < music_life::ChromaAnalyzer::kPitchClasses; ++i) {
+            out.chroma[i] = r.chroma[i];
+        }
+        out.chord_root       = r.chord_root;
+        out.chord_quality    = static_cast<int>(r.chord_quality);
+        out.chord_confidence = r.chord_confidence;
+        out.key_tonic        = r.key_tonic;
+        out.key_minor        = r.key_minor ? 1 : 0;
+        out.key_confidence   = r.key_confidence;
+    } catch (const std::exception& e) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_chroma_process: exception: %s", e.what());
+    } catch (...) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_chroma_process: unknown exception");
+    }
+    return out;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+// Shared internals of the C bridge.  Not part of the public FFI surface; only
+// included by translation units under src/app_bridge.
+
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "note_segmenter.h"
+#include "pitch_detector.h"
+#include "practice_stats.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+struct MLPitchDetectorHandle {
+    std::unique_ptr<music_life::PitchDetector> detector;
+    std::atomic<int> max_process_samples;  ///< Raised by ml_pitch_detector_reconfigure
+    // Optional note segmentation (ml_pitch_detector_enable_note_events).
+    std::unique_ptr<music_life::NoteSegmenter> segmenter;
+    std::unique_ptr<music_life::SpscQueue<music_life::NoteSegmenter::Event>> note_events;
+    // Optional practice statistics (ml_pitch_detector_enable_practice_stats).
+    std::unique_ptr<music_life::PracticeStats> practice_stats;
+    std::unique_ptr<music_life::TripleBuffer<music_life::PracticeStats::Summary>> practice_summaries;
+    int practice_hops_unpublished = 0;
+    int64_t samples_fed = 0;  ///< Audio-thread sample clock for note event positions
+};
+
+namespace music_life {
+namespace ffi {
+
+constexpr int kProcessBlockBatch = 16;
+
+constexpr int kPracticePublishHops = 32;
+
+/** Feed one fresh result to the handle's note segmenter and practice
+ *  statistics, if enabled.  Statistics are published every
+ *  kPracticePublishHops hops and whenever a sustained tone ends, so they are
+ *  current as soon as playing stops. */
+inline void publish_hop(MLPitchDetectorHandle& handle,
+                        const PitchDetector::Result& result,
+                        int64_t end_sample) {
+    if (handle.segmenter) {
+        NoteSegmenter::Event events[NoteSegmenter::kMaxEventsPerHop];
+        const int count = handle.segmenter->push(result, end_sample, events);
+        for (int i = 0; i < count; ++i) {
+            handle.note_events->push(events[i]);
+        }
+    }
+    if (handle.practice_stats) {
+        const bool was_in_run = handle.practice_stats->in_run();
+        handle.practice_stats->push(result, end_sample);
+        if (++handle.practice_hops_unpublished >= kPracticePublishHops ||
+            (was_in_run && !handle.practice_stats->in_run())) {
+            handle.practice_stats->summarize(handle.practice_summaries->back());
+            handle.practice_summaries->publish();
+            handle.practice_hops_unpublished = 0;
+        }
+    }
+}
+
+/**
+ * Run PitchDetector::process_block_interleaved over an arbitrarily long
+ * block of interleaved frames, staging results in fixed-size stack batches
+ * so the bridge never allocates.
+ *
+ * on_result(const PitchDetector::Result&, int end_offset) is called for each
+ * of the first max_results hops; later hops advance timing without analysis.
+ *
+ * @return Number of results delivered.
+ */
+template <typename OnResult>
+int process_interleaved_batched(PitchDetector& detector,
+                                const float* samples,
+                                int num_frames,
+                                int channels,
+                                const float* weights,
+                                int max_results,
+                                OnResult&& on_result) {
+    // A slice of (batch - 1) hops can complete at most `batch` analyses.  A
+    // target can be set at any time, so size for the strobe hop as well.
+    const int min_hop = std::min(detector.min_hop_size(), detector.strobe_hop_size());
+    const int slice_size = min_hop * (kProcessBlockBatch - 1);
+    PitchDetector::Result batch[kProcessBlockBatch];
+    int batch_offsets[kProcessBlockBatch];
+
+    int delivered = 0;
+    int offset = 0;
+    while (offset < num_frames) {
+        const int slice = std::min(slice_size, num_frames - offset);
+        const int room = std::min(kProcessBlockBatch, max_results - delivered);
+        const int count = detector.process_block_interleaved(
+            samples + static_cast<ptrdiff_t>(offset) * channels, slice, channels, weights, batch, room, batch_offsets);
+        for (int i = 0; i < count; ++i, ++delivered) {
+            on_result(batch[i], offset + batch_offsets[i]);
+        }
+        offset += slice;
+    }
+    return delivered;
+}
+
+/** process_interleaved_batched() for mono samples. */
+template <typename OnResult>
+int process_block_batched(PitchDetector& detector,
+                          const float* samples,
+                          int num_samples,
+                          int max_results,
+                          OnResult&& on_result) {
+    return process_interleaved_batched(detector, samples, num_samples, 1, nullptr, max_results,
+                                       std::forward<OnResult>(on_result));
+}
+
+} // namespace ffi
+} // namespace music_life
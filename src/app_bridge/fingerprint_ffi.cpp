@@ -0,0 +1,144 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "fingerprint_index.h"
+
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct MLFingerprintIndexHandle {
+    std::unique_ptr<music_life::FingerprintIndex> index;
+};
+
+namespace {
+
+using music_life::FingerprintIndex;
+using music_life::ffi::emit_log;
+
+static_assert(ML_FINGERPRINT_CURRENT == static_cast<int>(FingerprintIndex::Status::Current) &&
+              ML_FINGERPRINT_ADDED == static_cast<int>(FingerprintIndex::Status::Added) &&
+              ML_FINGERPRINT_UNSUPPORTED == static_cast<int>(FingerprintIndex::Status::Unsupported) &&
+              ML_FINGERPRINT_IO_ERROR == static_cast<int>(FingerprintIndex::Status::IoError),
+              "MLFingerprintStatus must match FingerprintIndex::Status.");
+
+}  // namespace
+
+MLFingerprintIndexHandle* ml_fingerprint_index_create(const char* directory, int threads) noexcept {
+    if (!directory || threads < 0) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* handle = new MLFingerprintIndexHandle{std::make_unique<FingerprintIndex>(directory, threads)};
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_fingerprint_index_create: recordings=%zu segments=%d threads=%d",
+                 handle->index->size(),
+                 handle->index->segment_count(),
+                 handle->index->threads());
+        return handle;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_fingerprint_index_destroy(MLFingerprintIndexHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_fingerprint_index_destroy");
+    delete handle;
+}
+
+int ml_fingerprint_index_add(MLFingerprintIndexHandle* handle,
+                             const char* const* paths,
+                             int count,
+                             int32_t* statuses) noexcept {
+    if (!handle || count < 0 || (count > 0 && !paths)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_add: invalid arguments");
+        return -1;
+    }
+    try {
+        std::vector<std::string> batch;
+        batch.reserve(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i) batch.emplace_back(paths[i] ? paths[i] : "");
+        const std::vector<FingerprintIndex::Status> results = handle->index->add(batch);
+
+        int indexed = 0;
+        int added = 0;
+        for (int i = 0; i < count; ++i) {
+            const FingerprintIndex::Status status = results[static_cast<size_t>(i)];
+            if (statuses) statuses[i] = static_cast<int32_t>(status);
+            if (status == FingerprintIndex::Status::Current || status == FingerprintIndex::Status::Added) ++indexed;
+            if (status == FingerprintIndex::Status::Added) ++added;
+        }
+        emit_log(ML_LOG_LEVEL_DEBUG,
+                 "ml_fingerprint_index_add: count=%d indexed=%d added=%d segments=%d",
+                 count,
+                 indexed,
+                 added,
+                 handle->index->segment_count());
+        return indexed;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_add: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_add: unknown exception");
+        return -1;
+    }
+}
+
+int ml_fingerprint_index_find_similar(MLFingerprintIndexHandle* handle,
+                                      const char* path,
+                                      float min_score,
+                                      MLFingerprintMatch* matches,
+                                      int max_matches,
+                                      char* paths,
+                                      int paths_capacity) noexcept {
+    if (!handle || !path || max_matches < 0 || (max_matches > 0 && !matches) || paths_capacity < 0 ||
+        (paths_capacity > 0 && !paths)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_find_similar: invalid arguments");
+        return -1;
+    }
+    try {
+        std::vector<FingerprintIndex::Match> found;
+        if (!handle->index->find_similar(path, max_matches, min_score, found)) return -1;
+
+        int used = 0;
+        for (size_t i = 0; i < found.size(); ++i) {
+            const FingerprintIndex::Match& match = found[i];
+            MLFingerprintMatch& out = matches[i];
+            out.duplicate_score = match.duplicate_score;
+            out.offset_seconds = match.offset_seconds;
+            out.similarity = match.similarity;
+            const int length = static_cast<int>(match.path.size()) + 1;
+            if (length <= paths_capacity - used) {
+                std::memcpy(paths + used, match.path.c_str(), static_cast<size_t>(length));
+                out.path_offset = used;
+                used += length;
+            } else {
+                out.path_offset = -1;
+            }
+        }
+        return static_cast<int>(found.size());
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_find_similar: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_fingerprint_index_find_similar: unknown exception");
+        return -1;
+    }
+}
+
+int ml_fingerprint_index_size(const MLFingerprintIndexHandle* handle) noexcept {
+    if (!handle) return -1;
+    try {
+        return static_cast<int>(handle->index->size());
+    } catch (...) {
+        return -1;
+    }
+}
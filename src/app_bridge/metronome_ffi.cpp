@@ -0,0 +1,145 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "metronome.h"
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+
+struct MLMetronomeHandle {
+    std::unique_ptr<music_life::Metronome> metronome;
+};
+
+namespace {
+
+using music_life::ffi::emit_log;
+using music_life::ffi::emit_log_rt;
+
+static_assert(sizeof(MLMetronomeClick) == sizeof(music_life::Metronome::ClickEvent) &&
+              offsetof(MLMetronomeClick, tick_in_beat) == offsetof(music_life::Metronome::ClickEvent, tick_in_beat),
+              "MLMetronomeClick must match the Metronome::ClickEvent layout.");
+
+}  // namespace
+
+MLMetronomeHandle* ml_metronome_create(int sample_rate) noexcept {
+    if (sample_rate <= 0) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* handle = new MLMetronomeHandle{std::make_unique<music_life::Metronome>(sample_rate)};
+        emit_log(ML_LOG_LEVEL_INFO, "ml_metronome_create: sample_rate=%d", sample_rate);
+        return handle;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_metronome_destroy(MLMetronomeHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_metronome_destroy");
+    delete handle;
+}
+
+int ml_metronome_load_sound(MLMetronomeHandle* handle, int sound, const float* samples, int num_samples) noexcept {
+    if (!handle || (sound != ML_METRONOME_SOUND_CLICK && sound != ML_METRONOME_SOUND_ACCENT)) return 0;
+    try {
+        handle->metronome->load_sound(sound == ML_METRONOME_SOUND_ACCENT ? music_life::Metronome::Sound::Accent
+                                                                         : music_life::Metronome::Sound::Click,
+                                      samples,
+                                      num_samples);
+        emit_log(ML_LOG_LEVEL_DEBUG, "ml_metronome_load_sound: sound=%d num_samples=%d", sound, num_samples);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_load_sound: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_load_sound: unknown exception");
+        return 0;
+    }
+}
+
+int ml_metronome_set_tempo(MLMetronomeHandle* handle, float bpm) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->metronome->set_tempo(bpm);
+        emit_log(ML_LOG_LEVEL_DEBUG, "ml_metronome_set_tempo: %0.2f", bpm);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_set_tempo: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_set_tempo: unknown exception");
+        return 0;
+    }
+}
+
+int ml_metronome_set_time_signature(MLMetronomeHandle* handle, int beats_per_bar, int subdivision) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->metronome->set_time_signature(beats_per_bar, subdivision);
+        emit_log(ML_LOG_LEVEL_DEBUG,
+                 "ml_metronome_set_time_signature: beats_per_bar=%d subdivision=%d",
+                 beats_per_bar,
+                 subdivision);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_set_time_signature: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_set_time_signature: unknown exception");
+        return 0;
+    }
+}
+
+int ml_metronome_set_volume(MLMetronomeHandle* handle, float volume) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->metronome->set_volume(volume);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_set_volume: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_metronome_set_volume: unknown exception");
+        return 0;
+    }
+}
+
+void ml_metronome_start(MLMetronomeHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_TRACE, "ml_metronome_start");
+    handle->metronome->start();
+}
+
+void ml_metronome_stop(MLMetronomeHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_TRACE, "ml_metronome_stop");
+    handle->metronome->stop();
+}
+
+int ml_metronome_render(MLMetronomeHandle* handle,
+                        float* out,
+                        int num_frames,
+                        MLMetronomeClick* events,
+                        int max_events) noexcept {
+    if (!handle || !out || num_frames < 0 || max_events < 0 || (!events && max_events > 0)) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_metronome_render: invalid arguments");
+        return -1;
+    }
+    try {
+        return handle->metronome->render(out, num_frames,
+                                         reinterpret_cast<music_life::Metronome::ClickEvent*>(events), max_events);
+    } catch (const std::exception& e) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_metronome_render: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_metronome_render: unknown exception");
+        return -1;
+    }
+}
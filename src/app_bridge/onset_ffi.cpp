@@ -0,0 +1,96 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "onset_detector.h"
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+
+struct MLOnsetHandle {
+    std::unique_ptr<music_life::OnsetDetector> detector;
+};
+
+namespace {
+
+using music_life::ffi::emit_log;
+using music_life::ffi::emit_log_rt;
+
+static_assert(sizeof(MLOnsetEvent) == sizeof(music_life::OnsetDetector::Onset) &&
+              offsetof(MLOnsetEvent, strength) == offsetof(music_life::OnsetDetector::Onset, strength),
+              "MLOnsetEvent must match the OnsetDetector::Onset layout.");
+
+}  // namespace
+
+MLOnsetHandle* ml_onset_create(int sample_rate, int frame_size, int hop_size) noexcept {
+    if (sample_rate <= 0 || frame_size < 64 || frame_size > 32768 || hop_size <= 0 || hop_size > frame_size) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_onset_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* handle = new MLOnsetHandle{
+            std::make_unique<music_life::OnsetDetector>(sample_rate, frame_size, hop_size)
+        };
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_onset_create: sample_rate=%d frame_size=%d hop_size=%d",
+                 sample_rate,
+                 frame_size,
+                 hop_size);
+        return handle;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_onset_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_onset_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_onset_destroy(MLOnsetHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_onset_destroy");
+    delete handle;
+}
+
+void ml_onset_reset(MLOnsetHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_TRACE, "ml_onset_reset");
+    handle->detector->reset();
+}
+
+int ml_onset_process(MLOnsetHandle* handle,
+                     const float* samples,
+                     int num_samples,
+                     MLOnsetEvent* out,
+                     int max_out) noexcept {
+    if (!handle || !samples || num_samples < 0 || (!out && max_out > 0) || max_out < 0) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_onset_process: invalid arguments");
+        return -1;
+    }
+
+    try {
+        return handle->detector->process(samples, num_samples,
+                                         reinterpret_cast<music_life::OnsetDetector::Onset*>(out), max_out);
+    } catch (const std::exception& e) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_onset_process: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_onset_process: unknown exception");
+        return -1;
+    }
+}
+
+MLTempoEstimate ml_onset_tempo(const MLOnsetHandle* handle) noexcept {
+    MLTempoEstimate out{};
+    out.last_beat_sample = -1;
+    out.next_beat_sample = -1;
+    if (!handle) return out;
+
+    const music_life::TempoTracker& tempo = handle->detector->tempo();
+    out.bpm                 = tempo.bpm();
+    out.confidence          = tempo.confidence();
+    out.beat_period_samples = tempo.beat_period_samples();
+    out.last_beat_sample    = tempo.last_beat_sample();
+    out.next_beat_sample    = tempo.next_beat_sample();
+    return out;
+}
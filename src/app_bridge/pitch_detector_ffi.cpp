@@ -1,13 +1,15 @@
 #include "pitch_detector_ffi.h"
 
+#include "ffi_internal.h"
 #include "pitch_detector.h"
 
+#include <algorithm>
 #include <atomic>
-#include <cstdarg>
 #include <cmath>
 #include <exception>
 #include <cstdio>
 #include <cstdlib>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <signal.h>
@@ -15,22 +17,17 @@
 
 namespace {
 
-MLLogCallback g_log_callback = nullptr;
 std::once_flag g_crash_handlers_once;
 volatile sig_atomic_t g_fatal_signal_in_progress = 0;
 constexpr int kMaxProcessSamplesMultiplier = 2;
 
-void emit_log(int level, const char* fmt, ...) {
-    char buffer[512];
-    va_list args;
-    va_start(args, fmt);
-    std::vsnprintf(buffer, sizeof(buffer), fmt, args);
-    va_end(args);
-    std::fprintf(stderr, "[music-life] %s\n", buffer);
-    if (g_log_callback) {
-        g_log_callback(level, buffer);
-    }
-}
+using music_life::ffi::emit_log;
+using music_life::ffi::emit_log_rt;
+
+static_assert(static_cast<int>(music_life::NoteEventType::NoteOn) == ML_NOTE_EVENT_ON &&
+              static_cast<int>(music_life::NoteEventType::NoteOff) == ML_NOTE_EVENT_OFF &&
+              static_cast<int>(music_life::NoteEventType::PitchBend) == ML_NOTE_EVENT_BEND,
+              "MLNoteEventType must mirror music_life::NoteEventType.");
 
 void write_signal_message(const char* message, size_t length) {
     const ssize_t written = ::write(STDERR_FILENO, message, length);
@@ -87,51 +84,182 @@ void terminate_handler() {
     } catch (...) {
         emit_log(ML_LOG_LEVEL_ERROR, "native terminate: unknown exception");
     }
+    music_life::ffi::drain_logs();
     std::abort();
 }
 
-}  // namespace
-
-struct MLPitchDetectorHandle {
-    std::unique_ptr<music_life::PitchDetector> detector;
-    int max_process_samples;
-};
-
-MLPitchDetectorHandle* ml_pitch_detector_create(int sample_rate, int frame_size, float threshold) noexcept {
-    return ml_pitch_detector_create_with_reference_pitch(sample_rate, frame_size, threshold, 440.0f);
-}
-
-MLPitchDetectorHandle* ml_pitch_detector_create_with_reference_pitch(int sample_rate,
-                                                                     int frame_size,
-                                                                     float threshold,
-                                                                     float reference_pitch_hz) noexcept {
-    if (sample_rate <= 0 || frame_size <= 1 || frame_size > 32768 || !std::isfinite(threshold) ||
-        threshold < 0.0f || threshold > 1.0f || !std::isfinite(reference_pitch_hz)) {
-        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_create: invalid arguments");
+MLPitchDetectorHandle* create_handle(const MLPitchDetectorConfig& config, const char* name) noexcept {
+    if (config.sample_rate <= 0 || config.frame_size <= 1 || config.frame_size > 32768 ||
+        !std::isfinite(config.threshold) || config.threshold < 0.0f || config.threshold > 1.0f ||
+        !std::isfinite(config.reference_pitch_hz)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "%s: invalid arguments", name);
         return nullptr;
     }
     try {
-        const int max_process_samples = frame_size * kMaxProcessSamplesMultiplier;
+        const int max_process_samples = config.frame_size * kMaxProcessSamplesMultiplier;
         auto* handle = new MLPitchDetectorHandle{
-            std::make_unique<music_life::PitchDetector>(sample_rate, frame_size, threshold, reference_pitch_hz),
-            max_process_samples
+            std::make_unique<music_life::PitchDetector>(config.sample_rate,
+                                                        config.frame_size,
+                                                        config.threshold,
+                                                        config.reference_pitch_hz,
+                                                        config.adaptive_frame_size != 0,
+                                                        config.decimation),
+            max_process_samples,
+            nullptr,
+            nullptr,
+            nullptr,
+            nullptr,
+            0,
+            0
         };
         emit_log(ML_LOG_LEVEL_INFO,
-                 "ml_pitch_detector_create: sample_rate=%d frame_size=%d threshold=%0.3f reference_pitch_hz=%0.2f",
-                 sample_rate,
-                 frame_size,
-                 threshold,
-                 reference_pitch_hz);
+                 "%s: sample_rate=%d frame_size=%d threshold=%0.3f reference_pitch_hz=%0.2f",
+                 name,
+                 config.sample_rate,
+                 config.frame_size,
+                 config.threshold,
+                 config.reference_pitch_hz);
         return handle;
     } catch (const std::exception& e) {
-        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_create: exception: %s", e.what());
+        emit_log(ML_LOG_LEVEL_ERROR, "%s: exception: %s", name, e.what());
         return nullptr;
     } catch (...) {
-        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_create: unknown exception");
+        emit_log(ML_LOG_LEVEL_ERROR, "%s: unknown exception", name);
         return nullptr;
     }
 }
 
+MLPitchResult to_ml_result(const music_life::PitchDetector::Result& result) {
+    MLPitchResult out{};
+    out.pitched      = result.pitched ? 1 : 0;
+    out.frequency    = result.frequency;
+    out.probability  = result.probability;
+    out.midi_note    = result.midi_note;
+    out.cents_offset = result.cents_offset;
+    std::snprintf(out.note_name, sizeof(out.note_name), "%s", result.note_name ? result.note_name : "");
+    return out;
+}
+
+void to_ml_note_stats(const music_life::PracticeStats::NoteStats& stats, MLPracticeNoteStats& out) {
+    static_assert(ML_PRACTICE_HISTOGRAM_BINS == music_life::PracticeStats::kHistogramBins,
+                  "histogram size must match PracticeStats");
+    out.midi_note               = stats.midi_note;
+    out.hops                    = stats.hops;
+    out.seconds                 = stats.seconds;
+    out.mean_cents              = stats.mean_cents;
+    out.stddev_cents            = stats.stddev_cents;
+    out.in_tune_ratio           = stats.in_tune_ratio;
+    out.stability_cents         = stats.stability_cents;
+    out.longest_sustain_seconds = stats.longest_sustain_seconds;
+    out.vibrato_cycles          = stats.vibrato_cycles;
+    out.vibrato_rate_hz         = stats.vibrato_rate_hz;
+    out.vibrato_depth_cents     = stats.vibrato_depth_cents;
+    std::copy(std::begin(stats.histogram), std::end(stats.histogram), out.histogram);
+}
+
+bool valid_channels(int channels) {
+    return channels >= 1 && channels <= music_life::PitchDetector::kMaxChannels;
+}
+
+MLPitchResult process_handle(MLPitchDetectorHandle* handle,
+                             const float* samples,
+                             int num_frames,
+                             int channels,
+                             const float* weights,
+                             const char* name) noexcept {
+    MLPitchResult out{};
+    if (!handle || !samples || num_frames <= 0 || !valid_channels(channels)) return out;
+    if (num_frames > handle->max_process_samples.load(std::memory_order_relaxed)) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "%s: invalid num_samples=%d", name, num_frames);
+        return out;
+    }
+
+    try {
+        const uint64_t analysed_before = handle->detector->frames_analysed();
+        const music_life::PitchDetector::Result result =
+            handle->detector->process_interleaved(samples, num_frames, channels, weights);
+        handle->samples_fed += num_frames;
+        if (handle->detector->frames_analysed() != analysed_before) {
+            music_life::ffi::publish_hop(*handle, result, handle->samples_fed);
+        }
+        out = to_ml_result(result);
+    } catch (const std::exception& e) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "%s: exception: %s", name, e.what());
+        return out;
+    } catch (...) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "%s: unknown exception", name);
+        return out;
+    }
+    return out;
+}
+
+int process_block_handle(MLPitchDetectorHandle* handle,
+                         const float* samples,
+                         int num_frames,
+                         int channels,
+                         const float* weights,
+                         MLPitchBlockResults* results,
+                         const char* name) noexcept {
+    if (!handle || !samples || num_frames < 0 || !valid_channels(channels) || !results || results->capacity < 0) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "%s: invalid arguments", name);
+        return -1;
+    }
+
+    try {
+        int written = 0;
+        music_life::ffi::process_interleaved_batched(
+            *handle->detector, samples, num_frames, channels, weights, results->capacity,
+            [handle, results, &written](const music_life::PitchDetector::Result& r, int end_offset) {
+                music_life::ffi::publish_hop(*handle, r, handle->samples_fed + end_offset);
+                if (results->pitched)       results->pitched[written]       = r.pitched ? 1 : 0;
+                if (results->frequency)     results->frequency[written]     = r.frequency;
+                if (results->probability)   results->probability[written]   = r.probability;
+                if (results->midi_note)     results->midi_note[written]     = r.midi_note;
+                if (results->cents_offset)  results->cents_offset[written]  = r.cents_offset;
+                if (results->sample_offset) results->sample_offset[written] = end_offset;
+                ++written;
+            });
+        handle->samples_fed += num_frames;
+        return written;
+    } catch (const std::exception& e) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "%s: exception: %s", name, e.what());
+        return -1;
+    } catch (...) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "%s: unknown exception", name);
+        return -1;
+    }
+}
+
+}  // namespace
+
+MLPitchDetectorHandle* ml_pitch_detector_create(int sample_rate, int frame_size, float threshold) noexcept {
+    return ml_pitch_detector_create_with_reference_pitch(sample_rate, frame_size, threshold, 440.0f);
+}
+
+MLPitchDetectorHandle* ml_pitch_detector_create_with_reference_pitch(int sample_rate,
+                                                                     int frame_size,
+                                                                     float threshold,
+                                                                     float reference_pitch_hz) noexcept {
+    const MLPitchDetectorConfig config{sample_rate, frame_size, threshold, reference_pitch_hz, 0, 1};
+    return create_handle(config, "ml_pitch_detector_create");
+}
+
+MLPitchDetectorHandle* ml_pitch_detector_create_adaptive(int sample_rate,
+                                                         int frame_size,
+                                                         float threshold,
+                                                         float reference_pitch_hz) noexcept {
+    const MLPitchDetectorConfig config{sample_rate, frame_size, threshold, reference_pitch_hz, 1, 1};
+    return create_handle(config, "ml_pitch_detector_create_adaptive");
+}
+
+MLPitchDetectorHandle* ml_pitch_detector_create_with_config(const MLPitchDetectorConfig* config) noexcept {
+    if (!config) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_create_with_config: invalid arguments");
+        return nullptr;
+    }
+    return create_handle(*config, "ml_pitch_detector_create_with_config");
+}
+
 void ml_pitch_detector_destroy(MLPitchDetectorHandle* handle) noexcept {
     if (!handle) return;
     try {
@@ -149,6 +277,7 @@ void ml_pitch_detector_reset(MLPitchDetectorHandle* handle) noexcept {
     try {
         emit_log(ML_LOG_LEVEL_TRACE, "ml_pitch_detector_reset");
         handle->detector->reset();
+        if (handle->segmenter) handle->segmenter->reset();
     } catch (const std::exception& e) {
         emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_reset: exception: %s", e.what());
     } catch (...) {
@@ -171,34 +300,372 @@ int ml_pitch_detector_set_reference_pitch(MLPitchDetectorHandle* handle, float r
     }
 }
 
+int ml_pitch_detector_set_noise_gate(MLPitchDetectorHandle* handle,
+                                     float open_db,
+                                     float close_db,
+                                     int hangover_hops) noexcept {
+    if (!handle) return 0;
+    try {
+        music_life::PitchDetector::GateConfig config;
+        config.open_db       = open_db;
+        config.close_db      = close_db;
+        config.hangover_hops = hangover_hops;
+        handle->detector->set_noise_gate(config);
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_pitch_detector_set_noise_gate: open_db=%0.1f close_db=%0.1f hangover_hops=%d",
+                 open_db,
+                 close_db,
+                 hangover_hops);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_set_noise_gate: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_set_noise_gate: unknown exception");
+        return 0;
+    }
+}
+
+int ml_pitch_detector_set_input_filter(MLPitchDetectorHandle* handle,
+                                       int dc_block,
+                                       float high_pass_hz,
+                                       float hum_hz,
+                                       int hum_harmonics,
+                                       float gain_db) noexcept {
+    if (!handle) return 0;
+    try {
+        music_life::PitchDetector::FilterConfig config;
+        config.dc_block      = dc_block != 0;
+        config.high_pass_hz  = high_pass_hz;
+        config.hum_hz        = hum_hz;
+        config.hum_harmonics = hum_harmonics;
+        config.gain_db       = gain_db;
+        handle->detector->set_input_filter(config);
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_pitch_detector_set_input_filter: dc_block=%d high_pass_hz=%0.1f hum_hz=%0.1f "
+                 "hum_harmonics=%d gain_db=%0.1f",
+                 dc_block != 0 ? 1 : 0,
+                 high_pass_hz,
+                 hum_hz,
+                 hum_harmonics,
+                 gain_db);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_set_input_filter: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_set_input_filter: unknown exception");
+        return 0;
+    }
+}
+
+int ml_pitch_detector_reconfigure(MLPitchDetectorHandle* handle,
+                                  int frame_size,
+                                  float threshold,
+                                  int adaptive_frame_size,
+                                  int fft_backend) noexcept {
+    if (!handle || frame_size <= 1 || frame_size > 32768 ||
+        fft_backend < ML_FFT_BACKEND_AUTO || fft_backend > ML_FFT_BACKEND_FFTW) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_reconfigure: invalid arguments");
+        return 0;
+    }
+    try {
+        music_life::PitchDetector::AnalysisConfig config;
+        config.frame_size          = frame_size;
+        config.threshold           = threshold;
+        config.adaptive_frame_size = adaptive_frame_size != 0;
+        switch (fft_backend) {
+            case ML_FFT_BACKEND_RADIX2:     config.fft_backend = music_life::FftBackend::Radix2; break;
+            case ML_FFT_BACKEND_ACCELERATE: config.fft_backend = music_life::FftBackend::Accelerate; break;
+            case ML_FFT_BACKEND_FFTW:       config.fft_backend = music_life::FftBackend::Fftw; break;
+            default:                        config.fft_backend = music_life::FftBackend::Auto; break;
+        }
+        handle->detector->reconfigure(config);
+        // Only ever raised, so a callback sized for the old frame stays valid.
+        const int max_process_samples = frame_size * kMaxProcessSamplesMultiplier;
+        if (max_process_samples > handle->max_process_samples.load(std::memory_order_relaxed)) {
+            handle->max_process_samples.store(max_process_samples, std::memory_order_relaxed);
+        }
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_pitch_detector_reconfigure: frame_size=%d threshold=%0.3f adaptive=%d fft_backend=%d",
+                 frame_size,
+                 threshold,
+                 adaptive_frame_size != 0 ? 1 : 0,
+                 fft_backend);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_reconfigure: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_reconfigure: unknown exception");
+        return 0;
+    }
+}
+
+int ml_pitch_detector_set_target(MLPitchDetectorHandle* handle, float target_hz) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->detector->set_target(target_hz);
+        emit_log(ML_LOG_LEVEL_INFO, "ml_pitch_detector_set_target: target_hz=%0.2f", target_hz);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_set_target: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_set_target: unknown exception");
+        return 0;
+    }
+}
+
+float ml_pitch_detector_strobe_phase(const MLPitchDetectorHandle* handle) noexcept {
+    if (!handle) return 0.0f;
+    return handle->detector->strobe_phase();
+}
+
 MLPitchResult ml_pitch_detector_process(MLPitchDetectorHandle* handle, const float* samples, int num_samples) noexcept {
-    MLPitchResult out{};
-    if (!handle || !samples || num_samples <= 0) return out;
-    if (num_samples > handle->max_process_samples) {
-        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_process: invalid num_samples=%d", num_samples);
-        return out;
+    return process_handle(handle, samples, num_samples, 1, nullptr, "ml_pitch_detector_process");
+}
+
+int ml_pitch_detector_process_block(MLPitchDetectorHandle* handle,
+                                    const float* samples,
+                                    int num_samples,
+                                    MLPitchBlockResults* results) noexcept {
+    return process_block_handle(handle, samples, num_samples, 1, nullptr, results, "ml_pitch_detector_process_block");
+}
+
+MLPitchResult ml_pitch_detector_process_interleaved(MLPitchDetectorHandle* handle,
+                                                    const float* samples,
+                                                    int num_frames,
+                                                    int channels,
+                                                    const float* weights) noexcept {
+    return process_handle(handle, samples, num_frames, channels, weights, "ml_pitch_detector_process_interleaved");
+}
+
+int ml_pitch_detector_process_block_interleaved(MLPitchDetectorHandle* handle,
+                                                const float* samples,
+                                                int num_frames,
+                                                int channels,
+                                                const float* weights,
+                                                MLPitchBlockResults* results) noexcept {
+    return process_block_handle(handle, samples, num_frames, channels, weights, results,
+                                "ml_pitch_detector_process_block_interleaved");
+}
+
+int ml_pitch_detector_enable_channel_detection(MLPitchDetectorHandle* handle, int channels) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->detector->enable_channel_detection(channels);
+        emit_log(ML_LOG_LEVEL_INFO, "ml_pitch_detector_enable_channel_detection: channels=%d", channels);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_channel_detection: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_channel_detection: unknown exception");
+        return 0;
+    }
+}
+
+int ml_pitch_detector_process_channels(MLPitchDetectorHandle* handle,
+                                       const float* samples,
+                                       int num_frames,
+                                       MLPitchResult* out,
+                                       int max_out) noexcept {
+    if (!handle || !samples || num_frames <= 0 || !out || max_out < 0 ||
+        handle->detector->channel_count() == 0 || num_frames > handle->max_process_samples.load(std::memory_order_relaxed)) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_process_channels: invalid arguments");
+        return -1;
     }
 
     try {
-        const music_life::PitchDetector::Result result = handle->detector->process(samples, num_samples);
-        out.pitched      = result.pitched ? 1 : 0;
-        out.frequency    = result.frequency;
-        out.probability  = result.probability;
-        out.midi_note    = result.midi_note;
-        out.cents_offset = result.cents_offset;
-        std::snprintf(out.note_name, sizeof(out.note_name), "%s", result.note_name ? result.note_name : "");
+        music_life::PitchDetector::Result results[music_life::PitchDetector::kMaxChannels];
+        const int channels = handle->detector->process_channels(samples, num_frames, results);
+        const int copied = std::min(channels, max_out);
+        for (int c = 0; c < copied; ++c) out[c] = to_ml_result(results[c]);
+        return copied;
     } catch (const std::exception& e) {
-        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_process: exception: %s", e.what());
-        return out;
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_process_channels: exception: %s", e.what());
+        return -1;
     } catch (...) {
-        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_process: unknown exception");
-        return out;
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_process_channels: unknown exception");
+        return -1;
     }
-    return out;
+}
+
+int ml_pitch_detector_enable_note_events(MLPitchDetectorHandle* handle,
+                                         const MLNoteSegmenterConfig* config,
+                                         int capacity) noexcept {
+    if (!handle || capacity <= 0 || capacity > (1 << 16)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_note_events: invalid arguments");
+        return 0;
+    }
+    try {
+        music_life::NoteSegmenter::Config segmenter_config;
+        if (config) {
+            segmenter_config.on_probability  = config->on_probability;
+            segmenter_config.off_probability = config->off_probability;
+            segmenter_config.change_cents    = config->change_cents;
+            segmenter_config.bend_cents      = config->bend_cents;
+            segmenter_config.min_note_hops   = config->min_note_hops;
+            segmenter_config.release_hops    = config->release_hops;
+            segmenter_config.median_window   = config->median_window;
+        }
+        handle->segmenter = std::make_unique<music_life::NoteSegmenter>(segmenter_config);
+        handle->note_events =
+            std::make_unique<music_life::SpscQueue<music_life::NoteSegmenter::Event>>(capacity);
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_pitch_detector_enable_note_events: capacity=%d median_window=%d",
+                 handle->note_events->capacity(),
+                 segmenter_config.median_window);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_note_events: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_note_events: unknown exception");
+        return 0;
+    }
+}
+
+int ml_pitch_detector_read_note_events(MLPitchDetectorHandle* handle, MLNoteEvent* out, int max_out) noexcept {
+    if (!handle || !handle->note_events || !out || max_out <= 0) return 0;
+
+    music_life::NoteSegmenter::Event batch[music_life::ffi::kProcessBlockBatch];
+    int copied = 0;
+    while (copied < max_out) {
+        const int count = handle->note_events->pop(
+            batch, std::min(music_life::ffi::kProcessBlockBatch, max_out - copied));
+        for (int i = 0; i < count; ++i, ++copied) {
+            out[copied].type            = static_cast<int32_t>(batch[i].type);
+            out[copied].midi_note       = batch[i].midi_note;
+            out[copied].cents           = batch[i].cents;
+            out[copied].probability     = batch[i].probability;
+            out[copied].sample_position = batch[i].sample_position;
+        }
+        if (count == 0) break;
+    }
+    return copied;
+}
+
+int ml_pitch_detector_enable_snapshots(MLPitchDetectorHandle* handle, int spectrum_bins) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->detector->enable_snapshots(spectrum_bins);
+        emit_log(ML_LOG_LEVEL_INFO, "ml_pitch_detector_enable_snapshots: spectrum_bins=%d", spectrum_bins);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_snapshots: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_snapshots: unknown exception");
+        return 0;
+    }
+}
+
+int ml_pitch_detector_read_snapshot(MLPitchDetectorHandle* handle,
+                                    MLPitchSnapshotInfo* info,
+                                    float* spectrum,
+                                    int spectrum_capacity,
+                                    float* cmndf,
+                                    int cmndf_capacity) noexcept {
+    if (!handle || !info || (spectrum && spectrum_capacity < 0) || (cmndf && cmndf_capacity < 0)) return -1;
+
+    const music_life::PitchDetector::Snapshot* snapshot = handle->detector->latest_snapshot();
+    if (!snapshot) return 0;
+    info->frame_index          = snapshot->frame_index;
+    info->analysis_sample_rate = snapshot->analysis_sample_rate;
+    info->analysis_frame_size  = snapshot->analysis_frame_size;
+    info->frequency            = snapshot->frequency;
+    info->probability          = snapshot->probability;
+    info->bin_hz               = snapshot->bin_hz;
+    info->spectrum_size        = snapshot->spectrum_size;
+    info->cmndf_size           = snapshot->cmndf_size;
+    if (spectrum) {
+        std::copy_n(snapshot->spectrum.data(), std::min(spectrum_capacity, snapshot->spectrum_size), spectrum);
+    }
+    if (cmndf) {
+        std::copy_n(snapshot->cmndf.data(), std::min(cmndf_capacity, snapshot->cmndf_size), cmndf);
+    }
+    return 1;
+}
+
+uint64_t ml_pitch_detector_note_events_dropped(const MLPitchDetectorHandle* handle) noexcept {
+    if (!handle || !handle->note_events) return 0;
+    return handle->note_events->dropped();
+}
+
+int ml_pitch_detector_enable_practice_stats(MLPitchDetectorHandle* handle,
+                                            float min_probability,
+                                            float in_tune_cents) noexcept {
+    if (!handle) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_practice_stats: invalid arguments");
+        return 0;
+    }
+    try {
+        music_life::PracticeStats::Config config;
+        config.min_probability = min_probability;
+        config.in_tune_cents   = in_tune_cents;
+        auto stats = std::make_unique<music_life::PracticeStats>(handle->detector->sample_rate(), config);
+        music_life::PracticeStats::Summary initial{};
+        stats->summarize(initial);
+        handle->practice_summaries =
+            std::make_unique<music_life::TripleBuffer<music_life::PracticeStats::Summary>>(initial);
+        handle->practice_stats = std::move(stats);
+        handle->practice_hops_unpublished = 0;
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_pitch_detector_enable_practice_stats: min_probability=%0.2f in_tune_cents=%0.1f",
+                 min_probability,
+                 in_tune_cents);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_practice_stats: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_detector_enable_practice_stats: unknown exception");
+        return 0;
+    }
+}
+
+void ml_pitch_detector_reset_practice_stats(MLPitchDetectorHandle* handle) noexcept {
+    if (!handle || !handle->practice_stats) return;
+    handle->practice_stats->reset();
+}
+
+int ml_pitch_detector_read_practice_stats(MLPitchDetectorHandle* handle,
+                                          MLPracticeStats* out,
+                                          MLPracticeNoteStats* notes,
+                                          int max_notes) noexcept {
+    if (!handle || !handle->practice_summaries || !out || max_notes < 0 || (max_notes > 0 && !notes)) {
+        return -1;
+    }
+    handle->practice_summaries->update();
+    const music_life::PracticeStats::Summary& summary = handle->practice_summaries->front();
+    out->hops          = summary.hops;
+    out->total_seconds = summary.total_seconds;
+    out->note_count    = summary.note_count;
+    to_ml_note_stats(summary.overall, out->overall);
+    const int count = std::min(max_notes, summary.note_count);
+    for (int i = 0; i < count; ++i) {
+        to_ml_note_stats(summary.notes[i], notes[i]);
+    }
+    return count;
 }
 
 void ml_pitch_detector_set_log_callback(MLLogCallback callback) noexcept {
-    g_log_callback = callback;
+    music_life::ffi::set_log_callback(callback);
+}
+
+int ml_pitch_detector_drain_logs(void) noexcept {
+    return music_life::ffi::drain_logs();
+}
+
+int ml_pitch_detector_start_log_thread(int interval_ms) noexcept {
+    if (interval_ms <= 0) return 0;
+    return music_life::ffi::start_log_drain_thread(interval_ms) ? 1 : 0;
+}
+
+void ml_pitch_detector_stop_log_thread(void) noexcept {
+    music_life::ffi::stop_log_drain_thread();
 }
 
 void ml_pitch_detector_install_crash_handlers(void) noexcept {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,15 +31,538 @@ typedef struct {
     char  note_name[ML_PITCH_NOTE_NAME_SIZE];
 } MLPitchResult;
 
+/** Caller-owned structure-of-arrays output for ml_pitch_detector_process_block.
+ *  Every non-null array must hold at least `capacity` elements; null arrays
+ *  are skipped.  `sample_offset[i]` is the index in the input block one past
+ *  the last sample of the frame that produced result i. */
+typedef struct {
+    int    capacity;
+    int*   pitched;
+    float* frequency;
+    float* probability;
+    int*   midi_note;
+    float* cents_offset;
+    int*   sample_offset;
+} MLPitchBlockResults;
+
+/** Creation parameters for ml_pitch_detector_create_with_config. */
+typedef struct {
+    int32_t sample_rate;
+    int32_t frame_size;          /**< Analysis frame in input samples */
+    float   threshold;
+    float   reference_pitch_hz;
+    int32_t adaptive_frame_size; /**< Non-zero enables register-driven frame switching */
+    int32_t decimation;          /**< Internal rate reduction in [1, 4]; frame_size must be a multiple */
+} MLPitchDetectorConfig;
+
+/** Native-owned mailbox that lets a consumer observe results by polling shared
+ *  memory instead of making an FFI call per audio block.
+ *
+ *  Producers append samples with ml_pitch_mailbox_write (or write directly into
+ *  ml_pitch_mailbox_samples and call ml_pitch_mailbox_commit); a consumer thread
+ *  calls ml_pitch_mailbox_pump to run detection on everything pending, or
+ *  ml_pitch_mailbox_commit_and_pump does both when they share a thread.  Each
+ *  result n (1-based) is stored in slot (n - 1) % result_capacity and the slot's
+ *  `sequence` is set to 2n once complete (odd while being written).  Readers
+ *  compare MLPitchMailboxHeader.results_published against the last sequence
+ *  they saw, copy the slot and re-check `sequence` to detect overwrites. */
+typedef struct {
+    uint32_t sequence;
+    int32_t  pitched;
+    float    frequency;
+    float    probability;
+    int32_t  midi_note;
+    float    cents_offset;
+    int64_t  end_sample;          /**< Absolute index one past the analysed frame */
+} MLPitchMailboxSlot;
+
+typedef struct {
+    uint64_t results_published;   /**< Atomic; total results published */
+    uint64_t samples_written;     /**< Atomic; producer position in the sample ring */
+    uint64_t samples_consumed;    /**< Atomic; consumer position in the sample ring */
+    uint64_t samples_dropped;     /**< Atomic; samples rejected because the ring was full */
+    uint32_t sample_capacity;     /**< Power of two */
+    uint32_t result_capacity;     /**< Power of two */
+} MLPitchMailboxHeader;
+
+typedef struct MLPitchMailbox MLPitchMailbox;
+
+/** Note segmentation settings; see ml_pitch_detector_enable_note_events. */
+typedef struct {
+    float on_probability;         /**< Confidence needed to start a note */
+    float off_probability;        /**< Confidence needed to sustain a note (<= on_probability) */
+    float change_cents;           /**< Deviation from the held note that starts a note change */
+    float bend_cents;             /**< Minimum cents movement reported as a pitch bend */
+    int   min_note_hops;          /**< Frames a new pitch must persist before note-on */
+    int   release_hops;           /**< Unconfident frames before note-off */
+    int   median_window;          /**< Voiced frames in the pitch median, 1..15 */
+} MLNoteSegmenterConfig;
+
+typedef enum {
+    ML_NOTE_EVENT_ON    = 0,
+    ML_NOTE_EVENT_OFF   = 1,
+    ML_NOTE_EVENT_BEND  = 2,
+} MLNoteEventType;
+
+/** FFT implementations for ml_pitch_detector_reconfigure.  One that is not
+ *  built into this library falls back to RADIX2. */
+typedef enum {
+    ML_FFT_BACKEND_AUTO       = 0,  /**< Platform default, or ML_FFT_BACKEND */
+    ML_FFT_BACKEND_RADIX2     = 1,
+    ML_FFT_BACKEND_ACCELERATE = 2,
+    ML_FFT_BACKEND_FFTW       = 3,
+} MLFftBackend;
+
+typedef struct {
+    int32_t type;                 /**< MLNoteEventType */
+    int32_t midi_note;
+    float   cents;                /**< Median offset from midi_note */
+    float   probability;
+    int64_t sample_position;      /**< Samples fed to the handle since creation */
+} MLNoteEvent;
+
+#define ML_PRACTICE_HISTOGRAM_BINS 20
+
+/** Practice statistics of one MIDI note, or of the whole session. */
+typedef struct {
+    int32_t  midi_note;                /**< -1 for the whole session */
+    uint32_t hops;                     /**< Voiced hops */
+    float    seconds;                  /**< Voiced time */
+    float    mean_cents;
+    float    stddev_cents;
+    float    in_tune_ratio;            /**< Share of hops within in_tune_cents */
+    float    stability_cents;          /**< RMS distance from the sustained pitch */
+    float    longest_sustain_seconds;  /**< Longest sustained tone starting on the note */
+    uint32_t vibrato_cycles;
+    float    vibrato_rate_hz;          /**< Mean over cycles; 0 without vibrato */
+    float    vibrato_depth_cents;      /**< Mean half peak-to-peak over cycles */
+    uint32_t histogram[ML_PRACTICE_HISTOGRAM_BINS];  /**< Hops per 5-cent bin over [-50, 50] cents */
+} MLPracticeNoteStats;
+
+typedef struct {
+    uint64_t            hops;           /**< Every hop, voiced or not */
+    float               total_seconds;
+    int32_t             note_count;     /**< Notes with voiced hops */
+    MLPracticeNoteStats overall;
+} MLPracticeStats;
+
+/** Header of a visualizer snapshot; see ml_pitch_detector_read_snapshot.
+ *  Spectrum bins and CMNDF lags are at analysis_sample_rate: bin i starts at
+ *  i * bin_hz, and CMNDF entry tau is a lag of tau / analysis_sample_rate s. */
+typedef struct {
+    uint64_t frame_index;          /**< Hop count when published; unchanged means no new data */
+    int32_t  analysis_sample_rate;
+    int32_t  analysis_frame_size;  /**< Frame YIN analysed, in analysis samples */
+    float    frequency;            /**< 0 if the hop was unpitched */
+    float    probability;
+    float    bin_hz;
+    int32_t  spectrum_size;        /**< Bins available; min(this, capacity) were copied */
+    int32_t  cmndf_size;           /**< Lags available; min(this, capacity) were copied */
+} MLPitchSnapshotInfo;
+
+typedef struct MLChromaHandle MLChromaHandle;
+
+/** Chord qualities reported in MLChromaResult.chord_quality. */
+typedef enum {
+    ML_CHORD_NONE       = 0,
+    ML_CHORD_MAJOR      = 1,
+    ML_CHORD_MINOR      = 2,
+    ML_CHORD_DOMINANT7  = 3,
+    ML_CHORD_MINOR7     = 4,
+    ML_CHORD_DIMINISHED = 5,
+    ML_CHORD_SUS4       = 6,
+} MLChordQuality;
+
+typedef struct {
+    int   updated;                /**< 1 if at least one hop was analysed */
+    float chroma[12];             /**< Smoothed chroma, C = 0, max-normalised */
+    int   chord_root;             /**< Pitch class, or -1 if no chord */
+    int   chord_quality;          /**< MLChordQuality */
+    float chord_confidence;
+    int   key_tonic;              /**< Pitch class, or -1 if unknown */
+    int   key_minor;
+    float key_confidence;
+} MLChromaResult;
+
+typedef struct MLOnsetHandle MLOnsetHandle;
+
+typedef struct {
+    int64_t sample_position;      /**< Absolute index of the first sample of the attack */
+    float   strength;
+} MLOnsetEvent;
+
+typedef struct {
+    float   bpm;                  /**< 0 until enough history is available */
+    float   confidence;
+    double  beat_period_samples;
+    int64_t last_beat_sample;     /**< -1 if unknown */
+    int64_t next_beat_sample;     /**< -1 if unknown */
+} MLTempoEstimate;
+
+typedef struct MLMetronomeHandle MLMetronomeHandle;
+
+typedef enum {
+    ML_METRONOME_SOUND_CLICK  = 0,
+    ML_METRONOME_SOUND_ACCENT = 1,
+} MLMetronomeSound;
+
+typedef struct {
+    int64_t sample_position;      /**< Absolute output sample index of the click start */
+    int32_t beat_in_bar;
+    int32_t tick_in_beat;
+} MLMetronomeClick;
+
+typedef struct MLTimeStretchHandle MLTimeStretchHandle;
+
+typedef struct MLWaveformCacheHandle MLWaveformCacheHandle;
+
+typedef enum {
+    ML_WAVEFORM_CACHED      = 0,  /**< A current thumbnail was already stored */
+    ML_WAVEFORM_GENERATED   = 1,
+    ML_WAVEFORM_UNSUPPORTED = 2,  /**< Not an uncompressed WAV file */
+    ML_WAVEFORM_IO_ERROR    = 3,
+} MLWaveformStatus;
+
+/** One waveform-preview column; full scale is 32767. */
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t rms;
+} MLWaveformBucket;
+
+/** One step of a warping path: reference hop and take hop. */
+typedef struct {
+    int32_t ref_frame;
+    int32_t take_frame;
+} MLAlignmentStep;
+
+/** Intonation and timing of one reference note against an aligned take. */
+typedef struct {
+    int32_t midi_note;
+    int32_t ref_start;        /**< Reference hops [ref_start, ref_end) */
+    int32_t ref_end;
+    int32_t take_start;       /**< Aligned take hops [take_start, take_end) */
+    int32_t take_end;
+    int32_t voiced_frames;    /**< Aligned pairs with both hops voiced */
+    float   cents_error;      /**< Mean take - ref cents; positive is sharp */
+    float   timing_error;     /**< Onset lateness against the overall tempo, in hops */
+    float   duration_ratio;   /**< Take length over reference length */
+} MLNoteDeviation;
+
+typedef struct MLFingerprintIndexHandle MLFingerprintIndexHandle;
+
+typedef enum {
+    ML_FINGERPRINT_CURRENT     = 0,  /**< Already indexed and unchanged */
+    ML_FINGERPRINT_ADDED       = 1,
+    ML_FINGERPRINT_UNSUPPORTED = 2,  /**< Not an uncompressed WAV file */
+    ML_FINGERPRINT_IO_ERROR    = 3,
+} MLFingerprintStatus;
+
+/** One search result; its path is NUL-terminated at path_offset in the
+ *  caller's path buffer, or path_offset is -1 if it did not fit. */
+typedef struct {
+    float   duplicate_score;   /**< Share of the query's landmarks at one time offset, [0, 1] */
+    float   offset_seconds;    /**< Where the query starts in the match */
+    float   similarity;        /**< Share of the query's chroma words in the match, [0, 1] */
+    int32_t path_offset;
+} MLFingerprintMatch;
+
 MLPitchDetectorHandle* ml_pitch_detector_create(int sample_rate, int frame_size, float threshold) noexcept;
 MLPitchDetectorHandle* ml_pitch_detector_create_with_reference_pitch(int sample_rate, int frame_size, float threshold, float reference_pitch_hz) noexcept;
+/** Like create_with_reference_pitch, but each hop analyses with the shortest
+ *  of frame_size, frame_size/2 and frame_size/4 (not below 256) that resolves
+ *  the current pitch, cutting latency and cost for high notes.  Slow to leave
+ *  the full frame, immediate to return to it. */
+MLPitchDetectorHandle* ml_pitch_detector_create_adaptive(int sample_rate, int frame_size, float threshold, float reference_pitch_hz) noexcept;
+/** Create a detector with every option, including a decimating front end
+ *  that runs YIN at sample_rate / decimation.  Results, hop sizes and sample
+ *  offsets stay in input-rate units.  Returns null on invalid config. */
+MLPitchDetectorHandle* ml_pitch_detector_create_with_config(const MLPitchDetectorConfig* config) noexcept;
 void ml_pitch_detector_destroy(MLPitchDetectorHandle* handle) noexcept;
 void ml_pitch_detector_reset(MLPitchDetectorHandle* handle) noexcept;
 int ml_pitch_detector_set_reference_pitch(MLPitchDetectorHandle* handle, float reference_pitch_hz) noexcept;
+/** Configure the noise gate (frame RMS in dBFS).  Quiet hops skip YIN and
+ *  report unpitched; an open gate stays open for hangover_hops hops below
+ *  close_db.  Requires -120 <= close_db <= open_db <= 0 and hangover_hops in
+ *  [0, 1000].  Safe while audio is running.  Returns 1 on success. */
+int ml_pitch_detector_set_noise_gate(MLPitchDetectorHandle* handle, float open_db, float close_db, int hangover_hops) noexcept;
+/** Input clean-up fused into the detector's ring write: a DC blocker
+ *  (dc_block != 0), a Butterworth high-pass at high_pass_hz (0 or
+ *  [10, 1000]), notches at hum_hz (0 or [20, 500], e.g. 50 or 60) and its
+ *  first hum_harmonics - 1 harmonics ([1, 4]) of width hum_hz / 30, and a
+ *  gain in [-40, 40] dB.  Safe while audio is running; the filter state
+ *  carries over.  Returns 1 on success, 0 on invalid arguments. */
+int ml_pitch_detector_set_input_filter(MLPitchDetectorHandle* handle,
+                                       int dc_block,
+                                       float high_pass_hz,
+                                       float hum_hz,
+                                       int hum_harmonics,
+                                       float gain_db) noexcept;
+/** Change frame size (a multiple of the decimation, <= 32768), threshold,
+ *  adaptive framing and FFT backend (MLFftBackend) while audio is running.
+ *  The new engines are built on the calling thread and swapped in by the
+ *  audio thread at its next hop, carrying the input history over, so the
+ *  stream never stops and the last result stays up; the old engines are
+ *  freed on the next call or on destroy.  Call from one control thread.
+ *  Returns 1 on success, 0 on invalid arguments. */
+int ml_pitch_detector_reconfigure(MLPitchDetectorHandle* handle,
+                                  int frame_size,
+                                  float threshold,
+                                  int adaptive_frame_size,
+                                  int fft_backend) noexcept;
+/** Targeted tuner mode: with target_hz in [20, 4200) the detector skips YIN
+ *  and tracks the target and its harmonics with narrowband demodulators,
+ *  reporting every ~2.7 ms; pitches more than 100 cents away are unpitched.
+ *  0 returns to YIN.  Safe while audio is running.  Returns 1 on success. */
+int ml_pitch_detector_set_target(MLPitchDetectorHandle* handle, float target_hz) noexcept;
+/** Fundamental phase against the target in cycles [0, 1), for a strobe
+ *  display; safe from any thread.  0 for a null handle. */
+float ml_pitch_detector_strobe_phase(const MLPitchDetectorHandle* handle) noexcept;
 MLPitchResult ml_pitch_detector_process(MLPitchDetectorHandle* handle, const float* samples, int num_samples) noexcept;
+/** Process a block of any length, running every hop it spans.  Returns the
+ *  number of results written (at most results->capacity), or -1 on invalid
+ *  arguments.  Hops beyond the capacity are skipped, not queued. */
+int ml_pitch_detector_process_block(MLPitchDetectorHandle* handle,
+                                    const float* samples,
+                                    int num_samples,
+                                    MLPitchBlockResults* results) noexcept;
+/** Interleaved multichannel input of 1..8 channels; num_frames counts
+ *  frames, not samples.  Channels are folded to mono as they are copied
+ *  into the analysis ring: `weights` holds one gain per channel, or is null
+ *  to average them, and a single weight of 1 with the rest 0 selects that
+ *  channel.  Otherwise like ml_pitch_detector_process and
+ *  ml_pitch_detector_process_block, with offsets in frames. */
+MLPitchResult ml_pitch_detector_process_interleaved(MLPitchDetectorHandle* handle,
+                                                    const float* samples,
+                                                    int num_frames,
+                                                    int channels,
+                                                    const float* weights) noexcept;
+int ml_pitch_detector_process_block_interleaved(MLPitchDetectorHandle* handle,
+                                                const float* samples,
+                                                int num_frames,
+                                                int channels,
+                                                const float* weights,
+                                                MLPitchBlockResults* results) noexcept;
+/** Detect each of `channels` (1..8) interleaved channels separately, with
+ *  per-channel state but the handle's shared FFT plans and settings.  Not
+ *  thread-safe with processing: call before audio starts.  Returns 1 on
+ *  success. */
+int ml_pitch_detector_enable_channel_detection(MLPitchDetectorHandle* handle, int channels) noexcept;
+/** Process one interleaved block per channel, like ml_pitch_detector_process,
+ *  and copy the first max_out channel results to out.  Note events are not
+ *  generated.  Returns the number copied, or -1 on invalid arguments or when
+ *  channel detection is not enabled. */
+int ml_pitch_detector_process_channels(MLPitchDetectorHandle* handle,
+                                       const float* samples,
+                                       int num_frames,
+                                       MLPitchResult* out,
+                                       int max_out) noexcept;
+
+/** Enable note-event segmentation on every result produced by process,
+ *  process_block and the mailbox pump.  `config` may be null for defaults.
+ *  Events are queued in a bounded ring of at least `capacity` entries; when it
+ *  is full new events are dropped.  Not thread-safe with processing: call
+ *  before audio starts.  Returns 1 on success. */
+int ml_pitch_detector_enable_note_events(MLPitchDetectorHandle* handle, const MLNoteSegmenterConfig* config, int capacity) noexcept;
+/** Single consumer.  Copies up to max_out queued events, oldest first. */
+int ml_pitch_detector_read_note_events(MLPitchDetectorHandle* handle, MLNoteEvent* out, int max_out) noexcept;
+/** Events dropped because the ring was full. */
+uint64_t ml_pitch_detector_note_events_dropped(const MLPitchDetectorHandle* handle) noexcept;
+
+/** Accumulate practice statistics from every result produced by process,
+ *  process_block and the mailbox pump: per-note intonation histograms,
+ *  cents mean and spread, sustain stability and vibrato rate and depth,
+ *  O(1) per hop in fixed memory.  Hops below min_probability are unvoiced;
+ *  |cents| <= in_tune_cents counts as in tune.  Not thread-safe with
+ *  processing: call before audio starts.  Returns 1 on success. */
+int ml_pitch_detector_enable_practice_stats(MLPitchDetectorHandle* handle,
+                                            float min_probability,
+                                            float in_tune_cents) noexcept;
+/** Start a new session from the next hop.  Safe while audio is running. */
+void ml_pitch_detector_reset_practice_stats(MLPitchDetectorHandle* handle) noexcept;
+/** Single consumer, any thread.  Copies the newest published statistics:
+ *  the session totals to `out` and up to max_notes notes, ascending, to
+ *  `notes`.  Published every 32 hops and at the end of every sustained tone,
+ *  so the session is complete as soon as playing stops.  Returns the number
+ *  of notes copied, or -1 on invalid arguments or when not enabled. */
+int ml_pitch_detector_read_practice_stats(MLPitchDetectorHandle* handle,
+                                          MLPracticeStats* out,
+                                          MLPracticeNoteStats* notes,
+                                          int max_notes) noexcept;
+
+/** Publish the magnitude spectrum (pooled to spectrum_bins, 1..8192) and
+ *  YIN CMNDF of every analysed hop for visualizers, reusing the FFT YIN
+ *  already runs.  The audio thread never blocks on readers.  Not thread-safe
+ *  with processing: call before audio starts.  Returns 1 on success. */
+int ml_pitch_detector_enable_snapshots(MLPitchDetectorHandle* handle, int spectrum_bins) noexcept;
+/** Single consumer, at any rate.  Copies the newest snapshot; null arrays are
+ *  skipped.  Returns 1 if a snapshot was copied, 0 if none was published yet
+ *  (or snapshots are disabled), -1 on invalid arguments. */
+int ml_pitch_detector_read_snapshot(MLPitchDetectorHandle* handle,
+                                    MLPitchSnapshotInfo* info,
+                                    float* spectrum,
+                                    int spectrum_capacity,
+                                    float* cmndf,
+                                    int cmndf_capacity) noexcept;
+
+/** Create a mailbox feeding `handle`.  The mailbox must be destroyed before the
+ *  detector handle.  Capacities are rounded up to powers of two. */
+MLPitchMailbox* ml_pitch_mailbox_create(MLPitchDetectorHandle* handle, int sample_capacity, int result_capacity) noexcept;
+void ml_pitch_mailbox_destroy(MLPitchMailbox* mailbox) noexcept;
+const MLPitchMailboxHeader* ml_pitch_mailbox_header(const MLPitchMailbox* mailbox) noexcept;
+const MLPitchMailboxSlot* ml_pitch_mailbox_results(const MLPitchMailbox* mailbox) noexcept;
+float* ml_pitch_mailbox_samples(MLPitchMailbox* mailbox) noexcept;
+/** Single producer.  Returns the number of samples accepted; the rest are counted as dropped. */
+int ml_pitch_mailbox_write(MLPitchMailbox* mailbox, const float* samples, int num_samples) noexcept;
+/** Single producer.  Publishes samples already written in place at samples_written % sample_capacity. */
+int ml_pitch_mailbox_commit(MLPitchMailbox* mailbox, int num_samples) noexcept;
+/** Single consumer.  Runs every pending hop and returns the number of results published. */
+int ml_pitch_mailbox_pump(MLPitchMailbox* mailbox) noexcept;
+/** Producer and consumer on one thread: commit then pump in a single call.
+ *  Returns the number of results published, or -1 (nothing committed) on
+ *  invalid arguments or when the ring cannot take num_samples. */
+int ml_pitch_mailbox_commit_and_pump(MLPitchMailbox* mailbox, int num_samples) noexcept;
+/** Copy results numbered > after_sequence, oldest first, skipping overwritten
+ *  ones.  Each copied slot's `sequence` holds its result number n. */
+int ml_pitch_mailbox_read(const MLPitchMailbox* mailbox, uint64_t after_sequence, MLPitchMailboxSlot* out, int max_out) noexcept;
+
+/** Streaming chroma / chord / key analyser; frame_size must be in [256, 32768]. */
+MLChromaHandle* ml_chroma_create(int sample_rate, int frame_size, float reference_pitch_hz) noexcept;
+void ml_chroma_destroy(MLChromaHandle* handle) noexcept;
+void ml_chroma_reset(MLChromaHandle* handle) noexcept;
+/** Analyse every hop in the block and return the state after the last one. */
+MLChromaResult ml_chroma_process(MLChromaHandle* handle, const float* samples, int num_samples) noexcept;
+
+/** Spectral-flux onset detector with tempo tracking.  Sample positions are
+ *  absolute, counted from creation or the last reset. */
+MLOnsetHandle* ml_onset_create(int sample_rate, int frame_size, int hop_size) noexcept;
+void ml_onset_destroy(MLOnsetHandle* handle) noexcept;
+void ml_onset_reset(MLOnsetHandle* handle) noexcept;
+/** Analyse every hop in the block.  Returns the number of onsets written to
+ *  `out` (at most max_out), or -1 on invalid arguments. */
+int ml_onset_process(MLOnsetHandle* handle, const float* samples, int num_samples, MLOnsetEvent* out, int max_out) noexcept;
+MLTempoEstimate ml_onset_tempo(const MLOnsetHandle* handle) noexcept;
+
+/** Sample-accurate click renderer.  Setters are safe to call from any thread
+ *  while ml_metronome_render runs on the audio thread; they return 1 on
+ *  success and 0 on invalid arguments. */
+MLMetronomeHandle* ml_metronome_create(int sample_rate) noexcept;
+void ml_metronome_destroy(MLMetronomeHandle* handle) noexcept;
+/** Replace a click sound (MLMetronomeSound).  Not real-time safe: call only
+ *  while ml_metronome_render is not running. */
+int ml_metronome_load_sound(MLMetronomeHandle* handle, int sound, const float* samples, int num_samples) noexcept;
+int ml_metronome_set_tempo(MLMetronomeHandle* handle, float bpm) noexcept;
+int ml_metronome_set_time_signature(MLMetronomeHandle* handle, int beats_per_bar, int subdivision) noexcept;
+int ml_metronome_set_volume(MLMetronomeHandle* handle, float volume) noexcept;
+void ml_metronome_start(MLMetronomeHandle* handle) noexcept;
+void ml_metronome_stop(MLMetronomeHandle* handle) noexcept;
+/** Mix the next num_frames samples of clicks into `out`.  Returns the number
+ *  of clicks started in the block (the first max_events are copied to
+ *  `events`), or -1 on invalid arguments. */
+int ml_metronome_render(MLMetronomeHandle* handle, float* out, int num_frames, MLMetronomeClick* events, int max_events) noexcept;
+
+/** Pitch-preserving time-stretch (WSOLA) for practice playback, interleaved
+ *  float frames of 1 to 8 channels.  write, read and finish belong to one
+ *  thread (the audio thread, or an export loop); set_speed and reset may be
+ *  called from any thread and apply from the next hop. */
+MLTimeStretchHandle* ml_time_stretch_create(int sample_rate, int channels) noexcept;
+void ml_time_stretch_destroy(MLTimeStretchHandle* handle) noexcept;
+/** Playback speed in [0.25, 4]; 0.5 is half speed.  Returns 1 on success. */
+int ml_time_stretch_set_speed(MLTimeStretchHandle* handle, float speed) noexcept;
+/** Start a fresh stream, e.g. after a seek. */
+void ml_time_stretch_reset(MLTimeStretchHandle* handle) noexcept;
+/** Append input frames.  Returns the number accepted (at most
+ *  ml_time_stretch_input_space), or -1 on invalid arguments. */
+int ml_time_stretch_write(MLTimeStretchHandle* handle, const float* in, int num_frames) noexcept;
+/** Produce up to num_frames output frames.  Returns the number written,
+ *  fewer when more input is needed, or -1 on invalid arguments. */
+int ml_time_stretch_read(MLTimeStretchHandle* handle, float* out, int num_frames) noexcept;
+int ml_time_stretch_input_space(const MLTimeStretchHandle* handle) noexcept;
+/** Mark the end of the input; ml_time_stretch_read then drains the tail and
+ *  ml_time_stretch_drained turns 1 once it has all been read. */
+void ml_time_stretch_finish(MLTimeStretchHandle* handle) noexcept;
+int ml_time_stretch_drained(const MLTimeStretchHandle* handle) noexcept;
+/** Output frames produced before the first input frame is heard. */
+int ml_time_stretch_latency(const MLTimeStretchHandle* handle) noexcept;
+
+/** Waveform thumbnails for the recording library, cached on disk in
+ *  `directory` (created if missing).  Each thumbnail holds levels of 4096
+ *  down to 64 peak / RMS buckets.  threads = 0 uses every core but one. */
+MLWaveformCacheHandle* ml_waveform_cache_create(const char* directory, int threads) noexcept;
+void ml_waveform_cache_destroy(MLWaveformCacheHandle* handle) noexcept;
+/** Generate missing or stale thumbnails for `count` recordings on worker
+ *  threads; blocks, so call it off the UI isolate.  statuses (may be null)
+ *  receives one MLWaveformStatus per path.  Returns the number of paths
+ *  with a current thumbnail, or -1 on invalid arguments. */
+int ml_waveform_cache_generate(MLWaveformCacheHandle* handle, const char* const* paths, int count, int32_t* statuses) noexcept;
+/** Copy the finest cached level with at most max_buckets buckets.  O(1):
+ *  one stat and three small reads.  Returns the number of buckets written
+ *  (0 if none fits), or -1 if the recording has no current thumbnail. */
+int ml_waveform_cache_read(MLWaveformCacheHandle* handle, const char* path, int max_buckets, MLWaveformBucket* out) noexcept;
+
+/** Banded dynamic-time-warping alignment of a take against a reference.
+ *  Contours hold `dims` (1 to 12) floats per hop, hop-major: absolute cents
+ *  (100 * MIDI note, NaN when unvoiced) for pitch, or chroma.  band is the
+ *  Sakoe-Chiba half-width in take hops and max_cost the per-dimension
+ *  distance clamp (e.g. 200 cents, or 1 for max-normalised chroma).  Blocks
+ *  and uses every core; call it off the UI isolate.  The path never exceeds
+ *  ref_frames + take_frames - 1 steps.  Copies at most max_steps steps into
+ *  path (which may be null when max_steps is 0) and returns the full path
+ *  length, or -1 on invalid arguments. */
+int ml_align_contours(const float* ref, int ref_frames, const float* take, int take_frames, int dims, int band, float max_cost, MLAlignmentStep* path, int max_steps) noexcept;
+/** Per-note deviations of a take along a path from ml_align_contours on
+ *  pitch contours.  Copies at most max_notes notes and returns the number of
+ *  reference notes, or -1 on invalid arguments. */
+int ml_align_note_deviations(const float* ref_cents, int ref_frames, const float* take_cents, int take_frames, const MLAlignmentStep* path, int path_length, MLNoteDeviation* out, int max_notes) noexcept;
+
+/** Audio fingerprint index of the recording library, stored as
+ *  memory-mapped segment files in `directory` (created if missing).
+ *  threads = 0 uses every core but one for fingerprinting. */
+MLFingerprintIndexHandle* ml_fingerprint_index_create(const char* directory, int threads) noexcept;
+void ml_fingerprint_index_destroy(MLFingerprintIndexHandle* handle) noexcept;
+/** Fingerprint and index `count` recordings that are new or changed;
+ *  blocks, so call it off the UI isolate.  statuses (may be null) receives
+ *  one MLFingerprintStatus per path.  Returns the number of paths now
+ *  indexed, or -1 on invalid arguments. */
+int ml_fingerprint_index_add(MLFingerprintIndexHandle* handle, const char* const* paths, int count, int32_t* statuses) noexcept;
+/** Indexed recordings that duplicate (contain, or are contained in) the
+ *  recording at path or play the same piece, best first, excluding path
+ *  itself.  A match is kept when its duplicate score or similarity reaches
+ *  min_score.  Writes at most max_matches matches and their paths,
+ *  NUL-separated, into `paths` (paths_capacity bytes).  Milliseconds for
+ *  thousands of recordings.  Returns the number of matches written, or -1
+ *  if path is not indexed or on invalid arguments. */
+int ml_fingerprint_index_find_similar(MLFingerprintIndexHandle* handle, const char* path, float min_score, MLFingerprintMatch* matches, int max_matches, char* paths, int paths_capacity) noexcept;
+/** Number of indexed recordings, or -1 for a null handle. */
+int ml_fingerprint_index_size(const MLFingerprintIndexHandle* handle) noexcept;
+
 void ml_pitch_detector_set_log_callback(MLLogCallback callback) noexcept;
+/** Log messages are queued in a lock-free ring and never formatted on the
+ *  calling thread.  Control-path calls (create, destroy, reset, ...) deliver
+ *  queued messages before returning unless the drain thread is running;
+ *  messages from process/process_block/mailbox pump wait for the next drain.
+ *  Returns the number of messages delivered. */
+int ml_pitch_detector_drain_logs(void) noexcept;
+/** Start a background thread that drains the log ring every interval_ms.
+ *  Returns 1 on success (or if already running). */
+int ml_pitch_detector_start_log_thread(int interval_ms) noexcept;
+void ml_pitch_detector_stop_log_thread(void) noexcept;
 void ml_pitch_detector_install_crash_handlers(void) noexcept;
 
+/** 1 if the library was built with per-stage trace points (ML_TRACING). */
+int ml_trace_enabled(void) noexcept;
+/** Label the calling thread in traces and allocate its event ring now, so
+ *  the first trace point on an audio thread does not allocate. */
+void ml_trace_register_thread(const char* name) noexcept;
+/** Drop every buffered trace event. */
+void ml_trace_clear(void) noexcept;
+/** Chrome / Perfetto trace JSON of the buffered per-stage timings of every
+ *  thread.  Copies at most capacity - 1 bytes plus a NUL into out (which may
+ *  be null when capacity is 0) and returns the full length, so a call with
+ *  capacity 0 sizes the buffer.  Builds without trace points return an
+ *  empty trace.  Control path: allocates.  Returns -1 on invalid arguments. */
+int ml_trace_write_json(char* out, int capacity) noexcept;
+
 #ifdef __cplusplus
 }
 #endif
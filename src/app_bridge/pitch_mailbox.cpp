@@ -0,0 +1,245 @@
+#include "pitch_detector_ffi.h"
+
+#include "ffi_internal.h"
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <vector>
+
+namespace {
+
+using music_life::ffi::emit_log;
+using music_life::ffi::emit_log_rt;
+
+// Native mirror of MLPitchMailboxHeader with atomic counters.  Consumers on
+// the other side of the FFI read the same memory through the C layout.
+struct MailboxHeader {
+    std::atomic<uint64_t> results_published;
+    std::atomic<uint64_t> samples_written;
+    std::atomic<uint64_t> samples_consumed;
+    std::atomic<uint64_t> samples_dropped;
+    uint32_t sample_capacity;
+    uint32_t result_capacity;
+};
+
+struct MailboxSlot {
+    std::atomic<uint32_t> sequence;
+    int32_t pitched;
+    float   frequency;
+    float   probability;
+    int32_t midi_note;
+    float   cents_offset;
+    int64_t end_sample;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) &&
+              std::atomic<uint64_t>::is_always_lock_free,
+              "Mailbox counters must be lock-free and layout-compatible with uint64_t.");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+              std::atomic<uint32_t>::is_always_lock_free,
+              "Slot sequence must be lock-free and layout-compatible with uint32_t.");
+static_assert(sizeof(MailboxHeader) == sizeof(MLPitchMailboxHeader) &&
+              offsetof(MailboxHeader, sample_capacity) == offsetof(MLPitchMailboxHeader, sample_capacity),
+              "MailboxHeader must match the MLPitchMailboxHeader layout.");
+static_assert(sizeof(MailboxSlot) == sizeof(MLPitchMailboxSlot) &&
+              offsetof(MailboxSlot, end_sample) == offsetof(MLPitchMailboxSlot, end_sample),
+              "MailboxSlot must match the MLPitchMailboxSlot layout.");
+
+uint32_t round_up_pow2(int value) {
+    uint32_t n = 1;
+    while (n < static_cast<uint32_t>(value)) n <<= 1;
+    return n;
+}
+
+uint32_t slot_sequence(uint64_t n) {
+    return static_cast<uint32_t>(n * 2);
+}
+
+}  // namespace
+
+struct MLPitchMailbox {
+    MLPitchDetectorHandle* handle;
+    MailboxHeader header;
+    std::vector<MailboxSlot> slots;
+    std::vector<float> samples;
+
+    void publish(const music_life::PitchDetector::Result& r, int64_t end_sample) {
+        const uint64_t n = header.results_published.load(std::memory_order_relaxed) + 1;
+        MailboxSlot& slot = slots[static_cast<size_t>((n - 1) & (header.result_capacity - 1))];
+        slot.sequence.store(slot_sequence(n) - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.pitched      = r.pitched ? 1 : 0;
+        slot.frequency    = r.frequency;
+        slot.probability  = r.probability;
+        slot.midi_note    = r.midi_note;
+        slot.cents_offset = r.cents_offset;
+        slot.end_sample   = end_sample;
+        slot.sequence.store(slot_sequence(n), std::memory_order_release);
+        header.results_published.store(n, std::memory_order_release);
+    }
+};
+
+MLPitchMailbox* ml_pitch_mailbox_create(MLPitchDetectorHandle* handle,
+                                        int sample_capacity,
+                                        int result_capacity) noexcept {
+    if (!handle || sample_capacity <= 0 || result_capacity <= 0 ||
+        sample_capacity > (1 << 24) || result_capacity > (1 << 16)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_mailbox_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* mailbox = new MLPitchMailbox{};
+        mailbox->handle = handle;
+        mailbox->header.sample_capacity = round_up_pow2(sample_capacity);
+        mailbox->header.result_capacity = round_up_pow2(result_capacity);
+        mailbox->slots = std::vector<MailboxSlot>(mailbox->header.result_capacity);
+        mailbox->samples.assign(mailbox->header.sample_capacity, 0.0f);
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_pitch_mailbox_create: sample_capacity=%u result_capacity=%u",
+                 mailbox->header.sample_capacity,
+                 mailbox->header.result_capacity);
+        return mailbox;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_mailbox_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_pitch_mailbox_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_pitch_mailbox_destroy(MLPitchMailbox* mailbox) noexcept {
+    if (!mailbox) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_pitch_mailbox_destroy");
+    delete mailbox;
+}
+
+const MLPitchMailboxHeader* ml_pitch_mailbox_header(const MLPitchMailbox* mailbox) noexcept {
+    if (!mailbox) return nullptr;
+    return reinterpret_cast<const MLPitchMailboxHeader*>(&mailbox->header);
+}
+
+const MLPitchMailboxSlot* ml_pitch_mailbox_results(const MLPitchMailbox* mailbox) noexcept {
+    if (!mailbox) return nullptr;
+    return reinterpret_cast<const MLPitchMailboxSlot*>(mailbox->slots.data());
+}
+
+float* ml_pitch_mailbox_samples(MLPitchMailbox* mailbox) noexcept {
+    if (!mailbox) return nullptr;
+    return mailbox->samples.data();
+}
+
+int ml_pitch_mailbox_write(MLPitchMailbox* mailbox, const float* samples, int num_samples) noexcept {
+    if (!mailbox || !samples || num_samples <= 0) return 0;
+
+    MailboxHeader& header = mailbox->header;
+    const uint64_t write = header.samples_written.load(std::memory_order_relaxed);
+    const uint64_t read = header.samples_consumed.load(std::memory_order_acquire);
+    const uint64_t free_space = header.sample_capacity - (write - read);
+    const int accepted = static_cast<int>(std::min<uint64_t>(free_space, static_cast<uint64_t>(num_samples)));
+    if (accepted < num_samples) {
+        header.samples_dropped.fetch_add(static_cast<uint64_t>(num_samples - accepted),
+                                         std::memory_order_relaxed);
+    }
+
+    const uint32_t mask = header.sample_capacity - 1;
+    const int start = static_cast<int>(write & mask);
+    const int first = std::min(accepted, static_cast<int>(header.sample_capacity) - start);
+    std::memcpy(mailbox->samples.data() + start, samples, static_cast<size_t>(first) * sizeof(float));
+    std::memcpy(mailbox->samples.data(), samples + first, static_cast<size_t>(accepted - first) * sizeof(float));
+
+    header.samples_written.store(write + static_cast<uint64_t>(accepted), std::memory_order_release);
+    return accepted;
+}
+
+int ml_pitch_mailbox_commit(MLPitchMailbox* mailbox, int num_samples) noexcept {
+    if (!mailbox || num_samples <= 0) return 0;
+
+    MailboxHeader& header = mailbox->header;
+    const uint64_t write = header.samples_written.load(std::memory_order_relaxed);
+    const uint64_t read = header.samples_consumed.load(std::memory_order_acquire);
+    if (static_cast<uint64_t>(num_samples) > header.sample_capacity - (write - read)) {
+        return 0;
+    }
+    header.samples_written.store(write + static_cast<uint64_t>(num_samples), std::memory_order_release);
+    return num_samples;
+}
+
+int ml_pitch_mailbox_pump(MLPitchMailbox* mailbox) noexcept {
+    if (!mailbox) return 0;
+
+    MailboxHeader& header = mailbox->header;
+    const uint64_t write = header.samples_written.load(std::memory_order_acquire);
+    uint64_t read = header.samples_consumed.load(std::memory_order_relaxed);
+    const uint32_t mask = header.sample_capacity - 1;
+
+    int published = 0;
+    try {
+        while (read < write) {
+            const int start = static_cast<int>(read & mask);
+            const int contiguous = static_cast<int>(
+                std::min<uint64_t>(write - read, header.sample_capacity - static_cast<uint32_t>(start)));
+            const int64_t base = static_cast<int64_t>(read);
+            published += music_life::ffi::process_block_batched(
+                *mailbox->handle->detector, mailbox->samples.data() + start, contiguous, INT_MAX,
+                [mailbox, base](const music_life::PitchDetector::Result& r, int end_offset) {
+                    mailbox->publish(r, base + end_offset);
+                    music_life::ffi::publish_hop(*mailbox->handle, r,
+                                                 mailbox->handle->samples_fed + end_offset);
+                });
+            mailbox->handle->samples_fed += contiguous;
+            read += static_cast<uint64_t>(contiguous);
+            header.samples_consumed.store(read, std::memory_order_release);
+        }
+    } catch (const std::exception& e) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_pitch_mailbox_pump: exception: %s", e.what());
+    } catch (...) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_pitch_mailbox_pump: unknown exception");
+    }
+    return published;
+}
+
+int ml_pitch_mailbox_commit_and_pump(MLPitchMailbox* mailbox, int num_samples) noexcept {
+    if (!mailbox || num_samples < 0) return -1;
+    if (num_samples > 0 && ml_pitch_mailbox_commit(mailbox, num_samples) != num_samples) return -1;
+    return ml_pitch_mailbox_pump(mailbox);
+}
+
+int ml_pitch_mailbox_read(const MLPitchMailbox* mailbox,
+                          uint64_t after_sequence,
+                          MLPitchMailboxSlot* out,
+                          int max_out) noexcept {
+    if (!mailbox || !out || max_out <= 0) return 0;
+
+    const MailboxHeader& header = mailbox->header;
+    const uint64_t published = header.results_published.load(std::memory_order_acquire);
+    uint64_t n = after_sequence + 1;
+    if (published >= header.result_capacity && n <= published - header.result_capacity) {
+        n = published - header.result_capacity + 1;  // Older results were overwritten
+    }
+
+    int copied = 0;
+    for (; n <= published && copied < max_out; ++n) {
+        const MailboxSlot& slot = mailbox->slots[static_cast<size_t>((n - 1) & (header.result_capacity - 1))];
+        const uint32_t expected = slot_sequence(n);
+        if (slot.sequence.load(std::memory_order_acquire) != expected) continue;
+
+        MLPitchMailboxSlot& dst = out[copied];
+        dst.pitched      = slot.pitched;
+        dst.frequency    = slot.frequency;
+        dst.probability  = slot.probability;
+        dst.midi_note    = slot.midi_note;
+        dst.cents_offset = slot.cents_offset;
+        dst.end_sample   = slot.end_sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) continue;
+
+        dst.sequence = static_cast<uint32_t>(n);
+        ++copied;
+    }
+    return copied;
+}
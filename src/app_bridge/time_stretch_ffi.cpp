@@ -0,0 +1,99 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "time_stretcher.h"
+
+#include <exception>
+#include <memory>
+
+struct MLTimeStretchHandle {
+    std::unique_ptr<music_life::TimeStretcher> stretcher;
+};
+
+namespace {
+
+using music_life::ffi::emit_log;
+using music_life::ffi::emit_log_rt;
+
+}  // namespace
+
+MLTimeStretchHandle* ml_time_stretch_create(int sample_rate, int channels) noexcept {
+    if (sample_rate <= 0 || channels < 1 || channels > music_life::TimeStretcher::kMaxChannels) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_time_stretch_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* handle = new MLTimeStretchHandle{std::make_unique<music_life::TimeStretcher>(sample_rate, channels)};
+        emit_log(ML_LOG_LEVEL_INFO,
+                 "ml_time_stretch_create: sample_rate=%d channels=%d frame_size=%d",
+                 sample_rate,
+                 channels,
+                 handle->stretcher->frame_size());
+        return handle;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_time_stretch_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_time_stretch_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_time_stretch_destroy(MLTimeStretchHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_time_stretch_destroy");
+    delete handle;
+}
+
+int ml_time_stretch_set_speed(MLTimeStretchHandle* handle, float speed) noexcept {
+    if (!handle) return 0;
+    try {
+        handle->stretcher->set_speed(speed);
+        return 1;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_time_stretch_set_speed: exception: %s", e.what());
+        return 0;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_time_stretch_set_speed: unknown exception");
+        return 0;
+    }
+}
+
+void ml_time_stretch_reset(MLTimeStretchHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_TRACE, "ml_time_stretch_reset");
+    handle->stretcher->reset();
+}
+
+int ml_time_stretch_write(MLTimeStretchHandle* handle, const float* in, int num_frames) noexcept {
+    if (!handle || (!in && num_frames > 0) || num_frames < 0) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_time_stretch_write: invalid arguments");
+        return -1;
+    }
+    return handle->stretcher->write(in, num_frames);
+}
+
+int ml_time_stretch_read(MLTimeStretchHandle* handle, float* out, int num_frames) noexcept {
+    if (!handle || (!out && num_frames > 0) || num_frames < 0) {
+        emit_log_rt(ML_LOG_LEVEL_ERROR, "ml_time_stretch_read: invalid arguments");
+        return -1;
+    }
+    return handle->stretcher->read(out, num_frames);
+}
+
+int ml_time_stretch_input_space(const MLTimeStretchHandle* handle) noexcept {
+    return handle ? handle->stretcher->input_space() : -1;
+}
+
+void ml_time_stretch_finish(MLTimeStretchHandle* handle) noexcept {
+    if (!handle) return;
+    handle->stretcher->finish();
+}
+
+int ml_time_stretch_drained(const MLTimeStretchHandle* handle) noexcept {
+    return handle && handle->stretcher->drained() ? 1 : 0;
+}
+
+int ml_time_stretch_latency(const MLTimeStretchHandle* handle) noexcept {
+    return handle ? handle->stretcher->latency() : -1;
+}
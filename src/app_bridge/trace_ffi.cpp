@@ -0,0 +1,54 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <string>
+
+namespace {
+
+using music_life::ffi::emit_log;
+
+}  // namespace
+
+int ml_trace_enabled(void) noexcept {
+    return music_life::trace::enabled() ? 1 : 0;
+}
+
+void ml_trace_register_thread(const char* name) noexcept {
+    music_life::trace::register_thread(name);
+}
+
+void ml_trace_clear(void) noexcept {
+    music_life::trace::clear();
+}
+
+int ml_trace_write_json(char* out, int capacity) noexcept {
+    if (capacity < 0 || (!out && capacity > 0)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_trace_write_json: invalid arguments");
+        return -1;
+    }
+    try {
+        const std::string json = music_life::trace::chrome_json();
+        if (json.size() > static_cast<size_t>(INT_MAX)) {
+            emit_log(ML_LOG_LEVEL_ERROR, "ml_trace_write_json: trace too large");
+            return -1;
+        }
+        if (capacity > 0) {
+            const size_t copied = std::min(json.size(), static_cast<size_t>(capacity) - 1);
+            std::memcpy(out, json.data(), copied);
+            out[copied] = '\0';
+        }
+        return static_cast<int>(json.size());
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_trace_write_json: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_trace_write_json: unknown exception");
+        return -1;
+    }
+}
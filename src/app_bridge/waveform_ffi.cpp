@@ -0,0 +1,103 @@
+#include "pitch_detector_ffi.h"
+
+#include "async_log.h"
+#include "waveform_cache.h"
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct MLWaveformCacheHandle {
+    std::unique_ptr<music_life::WaveformCache> cache;
+};
+
+namespace {
+
+using music_life::WaveformCache;
+using music_life::ffi::emit_log;
+
+static_assert(sizeof(MLWaveformBucket) == sizeof(music_life::WaveformBucket) &&
+              offsetof(MLWaveformBucket, rms) == offsetof(music_life::WaveformBucket, rms),
+              "MLWaveformBucket must match the WaveformBucket layout.");
+static_assert(ML_WAVEFORM_CACHED == static_cast<int>(WaveformCache::Status::Cached) &&
+              ML_WAVEFORM_GENERATED == static_cast<int>(WaveformCache::Status::Generated) &&
+              ML_WAVEFORM_UNSUPPORTED == static_cast<int>(WaveformCache::Status::Unsupported) &&
+              ML_WAVEFORM_IO_ERROR == static_cast<int>(WaveformCache::Status::IoError),
+              "MLWaveformStatus must match WaveformCache::Status.");
+
+}  // namespace
+
+MLWaveformCacheHandle* ml_waveform_cache_create(const char* directory, int threads) noexcept {
+    if (!directory || threads < 0) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_waveform_cache_create: invalid arguments");
+        return nullptr;
+    }
+    try {
+        auto* handle = new MLWaveformCacheHandle{std::make_unique<WaveformCache>(directory, threads)};
+        emit_log(ML_LOG_LEVEL_INFO, "ml_waveform_cache_create: threads=%d", handle->cache->threads());
+        return handle;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_waveform_cache_create: exception: %s", e.what());
+        return nullptr;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_waveform_cache_create: unknown exception");
+        return nullptr;
+    }
+}
+
+void ml_waveform_cache_destroy(MLWaveformCacheHandle* handle) noexcept {
+    if (!handle) return;
+    emit_log(ML_LOG_LEVEL_DEBUG, "ml_waveform_cache_destroy");
+    delete handle;
+}
+
+int ml_waveform_cache_generate(MLWaveformCacheHandle* handle,
+                               const char* const* paths,
+                               int count,
+                               int32_t* statuses) noexcept {
+    if (!handle || count < 0 || (count > 0 && !paths)) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_waveform_cache_generate: invalid arguments");
+        return -1;
+    }
+    try {
+        std::vector<std::string> batch;
+        batch.reserve(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i) batch.emplace_back(paths[i] ? paths[i] : "");
+        const std::vector<WaveformCache::Status> results = handle->cache->generate(batch);
+
+        int ready = 0;
+        int generated = 0;
+        for (int i = 0; i < count; ++i) {
+            const WaveformCache::Status status = results[static_cast<size_t>(i)];
+            if (statuses) statuses[i] = static_cast<int32_t>(status);
+            if (status == WaveformCache::Status::Cached || status == WaveformCache::Status::Generated) ++ready;
+            if (status == WaveformCache::Status::Generated) ++generated;
+        }
+        emit_log(ML_LOG_LEVEL_DEBUG,
+                 "ml_waveform_cache_generate: count=%d ready=%d generated=%d",
+                 count,
+                 ready,
+                 generated);
+        return ready;
+    } catch (const std::exception& e) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_waveform_cache_generate: exception: %s", e.what());
+        return -1;
+    } catch (...) {
+        emit_log(ML_LOG_LEVEL_ERROR, "ml_waveform_cache_generate: unknown exception");
+        return -1;
+    }
+}
+
+int ml_waveform_cache_read(MLWaveformCacheHandle* handle,
+                           const char* path,
+                           int max_buckets,
+                           MLWaveformBucket* out) noexcept {
+    if (!handle || !path || max_buckets < 0 || (max_buckets > 0 && !out)) return -1;
+    try {
+        return handle->cache->read_level(path, max_buckets, reinterpret_cast<music_life::WaveformBucket*>(out));
+    } catch (...) {
+        return -1;
+    }
+}
@@ -0,0 +1,828 @@
+#include "fingerprint_index.h"
+
+#include "fft.h"
+#include "recording_file.h"
+#include "resampler.h"
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr double kPi = 3.14159265358979323846;
+
+// Analysis runs on audio decimated to between 8 and 16 kHz.
+static constexpr int    kAnalysisRate = 8000;
+static constexpr int    kFrameSize    = 1024;
+static constexpr int    kChunkFrames  = 4096;   // Frames decoded at a time
+
+// Landmarks: spectral peaks that are the maximum of their neighbourhood
+// (kPeakFrames either side, kPeakHz either side) and well above the frame's
+// mean, each paired with up to kFanOut later peaks within kTargetFrames.
+static constexpr double kMinPeakHz        = 150.0;
+static constexpr double kMaxPeakHz        = 3800.0;
+static constexpr double kPeakHz           = 120.0;
+static constexpr int    kPeakFrames       = 3;
+static constexpr int    kMaxPeaksPerFrame = 3;
+static constexpr float  kPeakAboveMean    = 3.0f;    // Natural log: ~13 dB
+static constexpr float  kMinPeakPower     = 1e-4f;
+static constexpr int    kTargetFrames     = 16;      // ~1 s
+static constexpr double kTargetHz         = 1200.0;
+static constexpr int    kFanOut           = 3;
+static constexpr double kHashHz           = 10.0;    // Landmark frequency quantum
+
+// Chroma words: kChromaFrames frames per block, pitch classes within
+// kChromaRatio of the strongest, at most kMaxChromaClasses of them.
+static constexpr double kMinChromaHz      = 200.0;
+static constexpr double kMaxChromaHz      = 2000.0;
+static constexpr int    kChromaFrames     = 4;
+static constexpr float  kChromaRatio      = 0.5f;
+static constexpr int    kMaxChromaClasses = 4;
+static constexpr float  kMinChromaPower   = 1e-3f;
+
+// Queries: a duplicate needs this many landmarks at one offset.
+static constexpr uint32_t kMinVotes = 4;
+
+static constexpr char     kMagic[4] = {'M', 'L', 'F', 'P'};
+static constexpr uint32_t kVersion  = 1;
+static constexpr const char* kSegmentExtension = ".mlfp";
+
+namespace {
+
+struct SegmentHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t recording_count;
+    uint32_t reserved;
+    uint64_t posting_count;
+    uint64_t landmark_count;
+    uint64_t word_count;
+    uint64_t string_bytes;
+};
+
+struct RecordingEntry {
+    uint64_t file_size;
+    int64_t  mtime;
+    uint64_t content_hash;
+    uint64_t landmark_begin;
+    uint64_t word_begin;
+    uint32_t landmark_count;
+    uint32_t word_count;
+    uint32_t path_offset;
+    uint32_t path_length;
+    float    seconds;
+    uint32_t reserved;
+};
+
+struct Posting {
+    uint32_t hash;
+    uint32_t recording;
+    uint32_t frame;   // Landmark anchor; 0 for chroma words
+};
+
+static_assert(sizeof(SegmentHeader) == 48, "SegmentHeader layout is part of the index format");
+static_assert(sizeof(RecordingEntry) == 64, "RecordingEntry layout is part of the index format");
+static_assert(sizeof(Posting) == 12, "Posting layout is part of the index format");
+static_assert(sizeof(AudioFingerprint::Landmark) == 8, "Landmarks are stored as two uint32 values");
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    return x ^ (x >> 33);
+}
+
+int popcount12(uint32_t mask) {
+    int count = 0;
+    for (; mask; mask &= mask - 1) ++count;
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Fingerprinting
+// ---------------------------------------------------------------------------
+
+// Streaming fingerprint of mono audio: decimation, a Hann-windowed
+// spectrogram (two real frames per complex transform), peak picking over a
+// ring of recent frames and chroma blocks.
+class Fingerprinter {
+public:
+    explicit Fingerprinter(int sample_rate)
+        : sample_rate_(sample_rate)
+        , decimation_(std::min(std::max(sample_rate / kAnalysisRate, 1), 16))
+        , rate_(static_cast<double>(sample_rate) / decimation_)
+        , hop_(static_cast<int>(std::lround(rate_ * AudioFingerprint::kFrameSeconds)))
+        , fft_(kFrameSize)
+    {
+        if (sample_rate < kAnalysisRate) throw std::invalid_argument("sample_rate must be >= 8000");
+        if (decimation_ > 1) resampler_ = std::make_unique<Resampler>(1, decimation_);
+
+        window_.resize(kFrameSize);
+        for (int n = 0; n < kFrameSize; ++n) {
+            window_[static_cast<size_t>(n)] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * n / kFrameSize));
+        }
+        spectrum_.resize(kFrameSize);
+        power_[0].resize(kFrameSize / 2 + 1);
+        power_[1].resize(kFrameSize / 2 + 1);
+
+        const double bin_hz = rate_ / kFrameSize;
+        bin_hz_ = bin_hz;
+        peak_lo_ = static_cast<int>(std::ceil(kMinPeakHz / bin_hz));
+        peak_hi_ = std::min(static_cast<int>(kMaxPeakHz / bin_hz), kFrameSize / 2 - 1);
+        peak_reach_ = static_cast<int>(std::ceil(kPeakHz / bin_hz));
+        const size_t bins = static_cast<size_t>(peak_hi_ - peak_lo_ + 1);
+        for (auto& frame : log_ring_) frame.resize(bins);
+        for (auto& frame : dilated_ring_) frame.resize(bins);
+        time_max_.resize(bins);
+
+        pitch_class_.assign(kFrameSize / 2 + 1, -1);
+        for (int k = 1; k <= kFrameSize / 2; ++k) {
+            const double hz = k * bin_hz;
+            if (hz < kMinChromaHz || hz > kMaxChromaHz) continue;
+            const long midi = std::lround(69.0 + 12.0 * std::log2(hz / 440.0));
+            pitch_class_[static_cast<size_t>(k)] = static_cast<int>(((midi % 12) + 12) % 12);
+        }
+    }
+
+    void push(const float* mono, int n) {
+        if (resampler_) {
+            decimated_.resize(static_cast<size_t>(resampler_->max_output(n)));
+            const int produced = resampler_->process(mono, n, decimated_.data());
+            samples_.insert(samples_.end(), decimated_.begin(), decimated_.begin() + produced);
+        } else {
+            samples_.insert(samples_.end(), mono, mono + n);
+        }
+        input_frames_ += n;
+
+        // Two frames per transform; keep what the next frame still needs.
+        size_t start = 0;
+        while (start + static_cast<size_t>(hop_ + kFrameSize) <= samples_.size()) {
+            analyse_pair(samples_.data() + start, samples_.data() + start + hop_);
+            start += static_cast<size_t>(2 * hop_);
+        }
+        samples_.erase(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(start));
+    }
+
+    AudioFingerprint finish() {
+        if (samples_.size() >= static_cast<size_t>(kFrameSize)) analyse_pair(samples_.data(), nullptr);
+        for (int c = std::max(frames_ - kPeakFrames, 0); c < frames_; ++c) pick_peaks(c);
+
+        AudioFingerprint fingerprint;
+        fingerprint.seconds = static_cast<float>(static_cast<double>(input_frames_) / sample_rate_);
+        for (size_t a = 0; a < peaks_.size(); ++a) {
+            int paired = 0;
+            for (size_t b = a + 1; b < peaks_.size() && paired < kFanOut; ++b) {
+                const int dt = peaks_[b].frame - peaks_[a].frame;
+                if (dt > kTargetFrames) break;
+                if (dt == 0 || std::fabs(peaks_[b].hz - peaks_[a].hz) > kTargetHz) continue;
+                fingerprint.landmarks.push_back({landmark_hash(peaks_[a].hz, peaks_[b].hz, dt),
+                                                 static_cast<uint32_t>(peaks_[a].frame)});
+                ++paired;
+            }
+        }
+        for (size_t i = 2; i < masks_.size(); ++i) {
+            const uint64_t trigram = masks_[i - 2] | static_cast<uint64_t>(masks_[i - 1]) << 12 |
+                                     static_cast<uint64_t>(masks_[i]) << 24;
+            fingerprint.words.push_back(static_cast<uint32_t>(mix64(trigram)) | AudioFingerprint::kWordFlag);
+        }
+        std::sort(fingerprint.words.begin(), fingerprint.words.end());
+        fingerprint.words.erase(std::unique(fingerprint.words.begin(), fingerprint.words.end()),
+                                fingerprint.words.end());
+        return fingerprint;
+    }
+
+private:
+    struct Peak {
+        int    frame;
+        double hz;
+    };
+
+    static constexpr int kRing = 2 * kPeakFrames + 1;
+
+    int    sample_rate_;
+    int    decimation_;
+    double rate_;
+    int    hop_;
+    double bin_hz_ = 0.0;
+    int    peak_lo_ = 0, peak_hi_ = 0, peak_reach_ = 0;
+    Fft    fft_;
+    std::unique_ptr<Resampler> resampler_;
+
+    std::vector<float> window_;
+    std::vector<float> samples_;     // Decimated, not yet fully analysed
+    std::vector<float> decimated_;
+    std::vector<std::complex<float>> spectrum_;
+    std::vector<float> power_[2];
+    int64_t input_frames_ = 0;
+    int     frames_ = 0;
+
+    std::vector<float> log_ring_[kRing];      // Log power over the peak band
+    std::vector<float> dilated_ring_[kRing];  // ... maximum over +-peak_reach_ bins
+    float              mean_ring_[kRing] = {};
+    std::vector<float> time_max_;
+    std::vector<Peak>  peaks_;
+
+    std::vector<int>      pitch_class_;
+    float                 block_[12] = {};
+    int                   block_frames_ = 0;
+    std::vector<uint32_t> masks_;
+
+    static uint32_t landmark_hash(double hz1, double hz2, int dt) {
+        const uint32_t f1 = static_cast<uint32_t>(std::min(std::lround(hz1 / kHashHz), 511L));
+        const long df = std::lround((hz2 - hz1) / kHashHz) + 128;
+        const uint32_t d = static_cast<uint32_t>(std::min(std::max(df, 0L), 255L));
+        return f1 << 12 | d << 4 | static_cast<uint32_t>(dt - 1);
+    }
+
+    void analyse_pair(const float* a, const float* b) {
+        for (int n = 0; n < kFrameSize; ++n) {
+            const float w = window_[static_cast<size_t>(n)];
+            spectrum_[static_cast<size_t>(n)] = {a[n] * w, b ? b[n] * w : 0.0f};
+        }
+        fft_.forward(spectrum_);
+        // Split the transforms of the real and imaginary parts.
+        for (int k = 0; k <= kFrameSize / 2; ++k) {
+            const std::complex<float> z = spectrum_[static_cast<size_t>(k)];
+            const std::complex<float> c = std::conj(spectrum_[static_cast<size_t>((kFrameSize - k) & (kFrameSize - 1))]);
+            power_[0][static_cast<size_t>(k)] = std::norm(0.5f * (z + c));
+            power_[1][static_cast<size_t>(k)] = std::norm(0.5f * (z - c));
+        }
+        analyse_frame(power_[0].data());
+        if (b) analyse_frame(power_[1].data());
+    }
+
+    void analyse_frame(const float* power) {
+        // Chroma block.
+        for (int k = 0; k <= kFrameSize / 2; ++k) {
+            const int pc = pitch_class_[static_cast<size_t>(k)];
+            if (pc >= 0) block_[pc] += power[k];
+        }
+        if (++block_frames_ == kChromaFrames) close_block();
+
+        // Peak ring.
+        const int slot = frames_ % kRing;
+        std::vector<float>& log_power = log_ring_[slot];
+        std::vector<float>& dilated = dilated_ring_[slot];
+        const int bins = peak_hi_ - peak_lo_ + 1;
+        float total = 0.0f;
+        for (int b = 0; b < bins; ++b) {
+            log_power[static_cast<size_t>(b)] = std::log(power[peak_lo_ + b] + 1e-12f);
+            total += log_power[static_cast<size_t>(b)];
+        }
+        mean_ring_[slot] = total / static_cast<float>(bins);
+        for (int b = 0; b < bins; ++b) {
+            float hi = 0.0f, lo = 0.0f;
+            const int from = std::max(b - peak_reach_, 0);
+            simd::min_max(log_power.data() + from, std::min(b + peak_reach_, bins - 1) - from + 1, lo, hi);
+            dilated[static_cast<size_t>(b)] = hi;
+        }
+        ++frames_;
+        if (frames_ > kPeakFrames) pick_peaks(frames_ - 1 - kPeakFrames);
+    }
+
+    void pick_peaks(int centre) {
+        const int bins = peak_hi_ - peak_lo_ + 1;
+        const int first = std::max(centre - kPeakFrames, 0);
+        const int last = std::min(centre + kPeakFrames, frames_ - 1);
+        std::copy(dilated_ring_[first % kRing].begin(), dilated_ring_[first % kRing].end(), time_max_.begin());
+        for (int t = first + 1; t <= last; ++t) {
+            const std::vector<float>& d = dilated_ring_[t % kRing];
+            for (int b = 0; b < bins; ++b) time_max_[static_cast<size_t>(b)] = std::max(time_max_[static_cast<size_t>(b)], d[static_cast<size_t>(b)]);
+        }
+
+        const std::vector<float>& x = log_ring_[centre % kRing];
+        const float floor = std::max(mean_ring_[centre % kRing] + kPeakAboveMean, std::log(kMinPeakPower));
+        Peak found[kMaxPeaksPerFrame];
+        float strength[kMaxPeaksPerFrame];
+        int count = 0;
+        for (int b = 1; b + 1 < bins; ++b) {
+            const float v = x[static_cast<size_t>(b)];
+            if (v < time_max_[static_cast<size_t>(b)] || v <= floor) continue;
+            // Parabolic interpolation of the log spectrum around the peak.
+            const float l = x[static_cast<size_t>(b - 1)], r = x[static_cast<size_t>(b + 1)];
+            const float denom = l - 2.0f * v + r;
+            const double delta = denom < 0.0f ? 0.5 * (l - r) / denom : 0.0;
+            const Peak peak{centre, (peak_lo_ + b + delta) * bin_hz_};
+            if (count < kMaxPeaksPerFrame) {
+                found[count] = peak;
+                strength[count++] = v;
+                continue;
+            }
+            const int weakest = static_cast<int>(std::min_element(strength, strength + count) - strength);
+            if (v > strength[weakest]) {
+                found[weakest] = peak;
+                strength[weakest] = v;
+            }
+        }
+        for (int i = 1; i < count; ++i) {
+            for (int j = i; j > 0 && found[j].hz < found[j - 1].hz; --j) std::swap(found[j], found[j - 1]);
+        }
+        peaks_.insert(peaks_.end(), found, found + count);
+    }
+
+    void close_block() {
+        const float strongest = *std::max_element(block_, block_ + 12);
+        if (strongest >= kMinChromaPower * kChromaFrames) {
+            uint32_t mask = 0;
+            for (int pc = 0; pc < 12; ++pc) {
+                if (block_[pc] >= kChromaRatio * strongest) mask |= 1u << pc;
+            }
+            if (popcount12(mask) <= kMaxChromaClasses && (masks_.empty() || masks_.back() != mask)) {
+                masks_.push_back(mask);
+            }
+        }
+        std::fill(block_, block_ + 12, 0.0f);
+        block_frames_ = 0;
+    }
+};
+
+// Fingerprint of a WAV file; Unsupported / IoError as for the waveform cache.
+FingerprintIndex::Status fingerprint_file(const std::string& path, AudioFingerprint& out) {
+    MappedFile file(path, MappedFile::Access::Sequential);
+    if (!file.ok()) return FingerprintIndex::Status::IoError;
+    WavInfo info{};
+    if (!parse_wav(file.data(), file.size(), info)) return FingerprintIndex::Status::Unsupported;
+    if (info.sample_rate < kAnalysisRate) return FingerprintIndex::Status::Unsupported;
+
+    Fingerprinter fingerprinter(info.sample_rate);
+    std::vector<float> scratch(static_cast<size_t>(kChunkFrames) * info.channels);
+    std::vector<float> mono(kChunkFrames);
+    const std::vector<float> weights(static_cast<size_t>(info.channels), 1.0f / static_cast<float>(info.channels));
+    const size_t frame_bytes = static_cast<size_t>(info.bytes_per_sample) * info.channels;
+    for (int64_t frame = 0; frame < info.frames; frame += kChunkFrames) {
+        const int n = static_cast<int>(std::min<int64_t>(kChunkFrames, info.frames - frame));
+        decode_samples(file.data() + info.data_offset + static_cast<size_t>(frame) * frame_bytes,
+                       info.format, scratch.data(), n * info.channels);
+        simd::deinterleave(scratch.data(), info.channels, weights.data(), 0, mono.data(), n);
+        fingerprinter.push(mono.data(), n);
+    }
+    out = fingerprinter.finish();
+    return FingerprintIndex::Status::Added;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// AudioFingerprint
+// ---------------------------------------------------------------------------
+
+AudioFingerprint AudioFingerprint::compute(const float* samples, int64_t frames, int channels, int sample_rate) {
+    if (channels < 1) throw std::invalid_argument("channels must be >= 1");
+    if (frames > 0 && !samples) throw std::invalid_argument("samples must not be null");
+    Fingerprinter fingerprinter(sample_rate);
+    std::vector<float> mono(kChunkFrames);
+    const std::vector<float> weights(static_cast<size_t>(channels), 1.0f / static_cast<float>(channels));
+    for (int64_t frame = 0; frame < frames; frame += kChunkFrames) {
+        const int n = static_cast<int>(std::min<int64_t>(kChunkFrames, frames - frame));
+        simd::deinterleave(samples + static_cast<size_t>(frame) * channels, channels, weights.data(), 0, mono.data(), n);
+        fingerprinter.push(mono.data(), n);
+    }
+    return fingerprinter.finish();
+}
+
+// ---------------------------------------------------------------------------
+// Segments
+// ---------------------------------------------------------------------------
+
+struct FingerprintIndex::Segment {
+    std::string file;
+    uint32_t    generation = 0;
+    std::unique_ptr<MappedFile> map;
+    const SegmentHeader*  header = nullptr;
+    const RecordingEntry* recordings = nullptr;
+    const Posting*        postings = nullptr;
+    const AudioFingerprint::Landmark* landmarks = nullptr;
+    const uint32_t*       words = nullptr;
+    const char*           strings = nullptr;
+
+    uint32_t recording_count() const { return header->recording_count; }
+
+    std::string path(uint32_t r) const {
+        return std::string(strings + recordings[r].path_offset, recordings[r].path_length);
+    }
+
+    AudioFingerprint fingerprint(uint32_t r) const {
+        const RecordingEntry& e = recordings[r];
+        AudioFingerprint fp;
+        fp.seconds = e.seconds;
+        fp.landmarks.assign(landmarks + e.landmark_begin, landmarks + e.landmark_begin + e.landmark_count);
+        fp.words.assign(words + e.word_begin, words + e.word_begin + e.word_count);
+        return fp;
+    }
+
+    /** Map and validate a segment file; nullptr if it is not one. */
+    static std::shared_ptr<const Segment> open(const std::string& file, uint32_t generation) {
+        auto segment = std::make_shared<Segment>();
+        segment->file = file;
+        segment->generation = generation;
+        segment->map = std::make_unique<MappedFile>(file, MappedFile::Access::Random);
+        const MappedFile& map = *segment->map;
+        if (!map.ok() || map.size() < sizeof(SegmentHeader)) return nullptr;
+
+        const auto* header = reinterpret_cast<const SegmentHeader*>(map.data());
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion) return nullptr;
+        // Bound each count by the file first so the size sum cannot wrap.
+        if (header->posting_count > map.size() || header->landmark_count > map.size() ||
+            header->word_count > map.size() || header->string_bytes > map.size()) {
+            return nullptr;
+        }
+        const uint64_t expected = sizeof(SegmentHeader) + header->recording_count * sizeof(RecordingEntry) +
+                                  header->posting_count * sizeof(Posting) +
+                                  header->landmark_count * sizeof(AudioFingerprint::Landmark) +
+                                  header->word_count * sizeof(uint32_t) + header->string_bytes;
+        if (expected != map.size()) return nullptr;
+
+        const unsigned char* p = map.data() + sizeof(SegmentHeader);
+        segment->header = header;
+        segment->recordings = reinterpret_cast<const RecordingEntry*>(p);
+        p += header->recording_count * sizeof(RecordingEntry);
+        segment->postings = reinterpret_cast<const Posting*>(p);
+        p += header->posting_count * sizeof(Posting);
+        segment->landmarks = reinterpret_cast<const AudioFingerprint::Landmark*>(p);
+        p += header->landmark_count * sizeof(AudioFingerprint::Landmark);
+        segment->words = reinterpret_cast<const uint32_t*>(p);
+        p += header->word_count * sizeof(uint32_t);
+        segment->strings = reinterpret_cast<const char*>(p);
+
+        for (uint32_t r = 0; r < header->recording_count; ++r) {
+            const RecordingEntry& e = segment->recordings[r];
+            if (e.landmark_begin + e.landmark_count > header->landmark_count ||
+                e.word_begin + e.word_count > header->word_count ||
+                static_cast<uint64_t>(e.path_offset) + e.path_length > header->string_bytes) {
+                return nullptr;
+            }
+        }
+        // Queries index the live table by posting recording and binary
+        // search the postings by hash.
+        for (uint64_t i = 0; i < header->posting_count; ++i) {
+            const Posting& posting = segment->postings[i];
+            if (posting.recording >= header->recording_count ||
+                (i > 0 && posting.hash < segment->postings[i - 1].hash)) {
+                return nullptr;
+            }
+        }
+        return segment;
+    }
+};
+
+struct FingerprintIndex::Snapshot {
+    std::vector<std::shared_ptr<const Segment>> segments;     ///< Oldest first
+    std::vector<std::vector<uint8_t>> live;                    ///< Per segment, per recording
+    std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> latest;  ///< Path -> (segment, recording)
+};
+
+struct FingerprintIndex::Pending {
+    std::string      path;
+    FileKey          key;
+    AudioFingerprint fingerprint;
+};
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+FingerprintIndex::FingerprintIndex(std::string directory, int threads)
+    : directory_(std::move(directory))
+    , threads_(threads)
+    , next_generation_(1)
+{
+    if (directory_.empty()) throw std::invalid_argument("directory must not be empty");
+    if (threads < 0) throw std::invalid_argument("threads must be >= 0");
+    if (threads_ == 0) threads_ = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (!std::filesystem::is_directory(directory_, ec)) {
+        throw std::runtime_error("cannot create fingerprint index directory: " + directory_);
+    }
+
+    std::vector<std::shared_ptr<const Segment>> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+        if (entry.path().extension() != kSegmentExtension) continue;
+        const std::string stem = entry.path().stem().string();
+        char* end = nullptr;
+        const unsigned long generation = std::strtoul(stem.c_str(), &end, 16);
+        if (stem.empty() || *end != '\0') continue;
+        if (auto segment = Segment::open(entry.path().string(), static_cast<uint32_t>(generation))) {
+            segments.push_back(std::move(segment));
+        }
+        next_generation_ = std::max(next_generation_, static_cast<uint32_t>(generation) + 1);
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const auto& a, const auto& b) { return a->generation < b->generation; });
+    publish(std::move(segments));
+}
+
+FingerprintIndex::~FingerprintIndex() = default;
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+std::vector<FingerprintIndex::Status> FingerprintIndex::add(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    const std::shared_ptr<const Snapshot> current = snapshot();
+
+    std::vector<Status> statuses(paths.size(), Status::IoError);
+    std::vector<Pending> pending(paths.size());
+    std::atomic<size_t> next{0};
+    const auto work = [&]() {
+        for (size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)) {
+            try {
+                Pending& item = pending[i];
+                item.path = paths[i];
+                if (!file_key(item.path, item.key)) continue;
+                const auto found = current->latest.find(item.path);
+                if (found != current->latest.end()) {
+                    const RecordingEntry& e =
+                        current->segments[found->second.first]->recordings[found->second.second];
+                    if (FileKey{e.file_size, e.mtime, e.content_hash} == item.key) {
+                        statuses[i] = Status::Current;
+                        continue;
+                    }
+                }
+                statuses[i] = fingerprint_file(item.path, item.fingerprint);
+            } catch (...) {
+                statuses[i] = Status::IoError;
+            }
+        }
+    };
+
+    const size_t workers = std::min(static_cast<size_t>(threads_), paths.size());
+    std::vector<std::thread> pool;
+    try {
+        for (size_t t = 1; t < workers; ++t) pool.emplace_back(work);
+    } catch (const std::system_error&) {
+        // Fewer threads than asked for: the ones running share the batch.
+    }
+    work();
+    for (auto& thread : pool) thread.join();
+
+    std::vector<Pending> added;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (statuses[i] == Status::Added) added.push_back(std::move(pending[i]));
+    }
+    if (!added.empty() && !append(added)) {
+        for (Status& status : statuses) {
+            if (status == Status::Added) status = Status::IoError;
+        }
+    }
+    return statuses;
+}
+
+bool FingerprintIndex::store(const std::vector<std::string>& paths, const std::vector<AudioFingerprint>& fingerprints) {
+    if (paths.size() != fingerprints.size()) throw std::invalid_argument("paths and fingerprints must match");
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    std::vector<Pending> items(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        items[i].path = paths[i];
+        if (!file_key(paths[i], items[i].key)) return false;
+        items[i].fingerprint = fingerprints[i];
+    }
+    return items.empty() || append(items);
+}
+
+std::vector<FingerprintIndex::Match> FingerprintIndex::query(const AudioFingerprint& fingerprint,
+                                                             int max_results,
+                                                             float min_score) const {
+    const std::shared_ptr<const Snapshot> current = snapshot();
+    // Keys: segment << 48 | recording << 24 | biased time offset, and
+    // segment << 32 | recording.
+    constexpr int64_t kOffsetBias = int64_t{1} << 23;
+    std::unordered_map<uint64_t, uint32_t> votes;
+    std::unordered_map<uint64_t, uint32_t> shared_words;
+
+    const auto by_hash = [](const Posting& p, uint32_t hash) { return p.hash < hash; };
+    for (size_t s = 0; s < current->segments.size(); ++s) {
+        const Segment& segment = *current->segments[s];
+        const std::vector<uint8_t>& live = current->live[s];
+        const Posting* begin = segment.postings;
+        const Posting* end = begin + segment.header->posting_count;
+
+        for (const AudioFingerprint::Landmark& landmark : fingerprint.landmarks) {
+            for (const Posting* p = std::lower_bound(begin, end, landmark.hash, by_hash);
+                 p != end && p->hash == landmark.hash; ++p) {
+                if (!live[p->recording]) continue;
+                const int64_t offset = static_cast<int64_t>(p->frame) - landmark.frame + kOffsetBias;
+                if (offset < 0 || offset >= 2 * kOffsetBias) continue;
+                ++votes[static_cast<uint64_t>(s) << 48 | static_cast<uint64_t>(p->recording) << 24 |
+                        static_cast<uint64_t>(offset)];
+            }
+        }
+        for (const uint32_t word : fingerprint.words) {
+            for (const Posting* p = std::lower_bound(begin, end, word, by_hash); p != end && p->hash == word; ++p) {
+                if (live[p->recording]) ++shared_words[static_cast<uint64_t>(s) << 32 | p->recording];
+            }
+        }
+    }
+
+    // Best offset per recording, counting the neighbouring offsets too so
+    // a slight rate difference does not split the votes.
+    struct Best {
+        uint32_t votes = 0;
+        int64_t  offset = 0;
+    };
+    std::unordered_map<uint64_t, Best> best;
+    for (const auto& [key, count] : votes) {
+        const auto neighbour = [&](uint64_t k) {
+            const auto it = votes.find(k);
+            return it == votes.end() ? 0u : it->second;
+        };
+        const uint64_t offset = key & ((uint64_t{1} << 24) - 1);
+        const uint32_t total = count + (offset > 0 ? neighbour(key - 1) : 0u) +
+                               (offset + 1 < 2 * kOffsetBias ? neighbour(key + 1) : 0u);
+        Best& b = best[(key >> 48) << 32 | ((key >> 24) & ((uint64_t{1} << 24) - 1))];
+        if (total > b.votes) {
+            b.votes = total;
+            b.offset = static_cast<int64_t>(offset) - kOffsetBias;
+        }
+    }
+    for (const auto& [recording, count] : shared_words) best.emplace(recording, Best{});
+
+    std::vector<Match> matches;
+    const float landmarks = static_cast<float>(std::max<size_t>(fingerprint.landmarks.size(), 1));
+    const float words = static_cast<float>(std::max<size_t>(fingerprint.words.size(), 1));
+    for (const auto& [recording, b] : best) {
+        Match match;
+        const auto word_hits = shared_words.find(recording);
+        match.similarity = word_hits == shared_words.end() ? 0.0f : static_cast<float>(word_hits->second) / words;
+        match.duplicate_score = b.votes >= kMinVotes ? std::min(static_cast<float>(b.votes) / landmarks, 1.0f) : 0.0f;
+        match.offset_seconds = match.duplicate_score > 0.0f
+            ? static_cast<float>(b.offset * AudioFingerprint::kFrameSeconds) : 0.0f;
+        if (std::max(match.duplicate_score, match.similarity) < min_score) continue;
+        match.path = current->segments[recording >> 32]->path(static_cast<uint32_t>(recording & 0xFFFFFFFFu));
+        matches.push_back(std::move(match));
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        const float sa = std::max(a.duplicate_score, a.similarity);
+        const float sb = std::max(b.duplicate_score, b.similarity);
+        return sa != sb ? sa > sb : a.path < b.path;
+    });
+    if (matches.size() > static_cast<size_t>(std::max(max_results, 0))) matches.resize(static_cast<size_t>(std::max(max_results, 0)));
+    return matches;
+}
+
+bool FingerprintIndex::find_similar(const std::string& path, int max_results, float min_score,
+                                    std::vector<Match>& out) const {
+    const std::shared_ptr<const Snapshot> current = snapshot();
+    const auto found = current->latest.find(path);
+    if (found == current->latest.end()) return false;
+    const AudioFingerprint fingerprint = current->segments[found->second.first]->fingerprint(found->second.second);
+    out = query(fingerprint, max_results + 1, min_score);
+    out.erase(std::remove_if(out.begin(), out.end(), [&](const Match& m) { return m.path == path; }), out.end());
+    if (out.size() > static_cast<size_t>(std::max(max_results, 0))) out.resize(static_cast<size_t>(std::max(max_results, 0)));
+    return true;
+}
+
+void FingerprintIndex::compact() {
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    compact_locked();
+}
+
+size_t FingerprintIndex::size() const {
+    return snapshot()->latest.size();
+}
+
+int FingerprintIndex::segment_count() const {
+    return static_cast<int>(snapshot()->segments.size());
+}
+
+// ---------------------------------------------------------------------------
+// Internal
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<const FingerprintIndex::Snapshot> FingerprintIndex::snapshot() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    return snapshot_;
+}
+
+void FingerprintIndex::publish(std::vector<std::shared_ptr<const Segment>> segments) {
+    auto next = std::make_shared<Snapshot>();
+    next->segments = std::move(segments);
+    for (uint32_t s = 0; s < next->segments.size(); ++s) {
+        const Segment& segment = *next->segments[s];
+        next->live.emplace_back(segment.recording_count(), uint8_t{0});
+        for (uint32_t r = 0; r < segment.recording_count(); ++r) next->latest[segment.path(r)] = {s, r};
+    }
+    for (const auto& [path, location] : next->latest) next->live[location.first][location.second] = 1;
+
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    snapshot_ = std::move(next);
+}
+
+bool FingerprintIndex::append(const std::vector<Pending>& items) {
+    std::shared_ptr<const Segment> segment = write_segment(items);
+    if (!segment) return false;
+    std::vector<std::shared_ptr<const Segment>> segments = snapshot()->segments;
+    segments.push_back(std::move(segment));
+    const bool compact_now = segments.size() > static_cast<size_t>(kMaxSegments);
+    publish(std::move(segments));
+    if (compact_now) compact_locked();
+    return true;
+}
+
+std::shared_ptr<const FingerprintIndex::Segment> FingerprintIndex::write_segment(const std::vector<Pending>& items) {
+    SegmentHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.recording_count = static_cast<uint32_t>(items.size());
+
+    std::vector<RecordingEntry> recordings(items.size());
+    std::vector<Posting> postings;
+    std::string strings;
+    for (uint32_t r = 0; r < items.size(); ++r) {
+        const Pending& item = items[r];
+        RecordingEntry& e = recordings[r];
+        e.file_size = item.key.size;
+        e.mtime = item.key.mtime;
+        e.content_hash = item.key.hash;
+        e.landmark_begin = header.landmark_count;
+        e.word_begin = header.word_count;
+        e.landmark_count = static_cast<uint32_t>(item.fingerprint.landmarks.size());
+        e.word_count = static_cast<uint32_t>(item.fingerprint.words.size());
+        e.path_offset = static_cast<uint32_t>(strings.size());
+        e.path_length = static_cast<uint32_t>(item.path.size());
+        e.seconds = item.fingerprint.seconds;
+        strings += item.path;
+        header.landmark_count += e.landmark_count;
+        header.word_count += e.word_count;
+        for (const auto& landmark : item.fingerprint.landmarks) postings.push_back({landmark.hash, r, landmark.frame});
+        for (const uint32_t word : item.fingerprint.words) postings.push_back({word, r, 0});
+    }
+    std::sort(postings.begin(), postings.end(), [](const Posting& a, const Posting& b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.recording != b.recording ? a.recording < b.recording
+                                                                               : a.frame < b.frame;
+    });
+    header.posting_count = postings.size();
+    header.string_bytes = strings.size();
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%08x%s", next_generation_, kSegmentExtension);
+    const std::string file = (std::filesystem::path(directory_) / name).string();
+    const std::string temp_file = file + ".tmp";
+    std::FILE* out = std::fopen(temp_file.c_str(), "wb");
+    if (!out) return nullptr;
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+              std::fwrite(recordings.data(), sizeof(RecordingEntry), recordings.size(), out) == recordings.size() &&
+              std::fwrite(postings.data(), sizeof(Posting), postings.size(), out) == postings.size();
+    for (const Pending& item : items) {
+        const auto& landmarks = item.fingerprint.landmarks;
+        ok = ok && std::fwrite(landmarks.data(), sizeof(AudioFingerprint::Landmark), landmarks.size(), out) == landmarks.size();
+    }
+    for (const Pending& item : items) {
+        const auto& words = item.fingerprint.words;
+        ok = ok && std::fwrite(words.data(), sizeof(uint32_t), words.size(), out) == words.size();
+    }
+    ok = ok && std::fwrite(strings.data(), 1, strings.size(), out) == strings.size();
+    ok = std::fclose(out) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temp_file, file, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(temp_file, ec);
+        return nullptr;
+    }
+    std::shared_ptr<const Segment> segment = Segment::open(file, next_generation_);
+    if (segment) ++next_generation_;
+    return segment;
+}
+
+void FingerprintIndex::compact_locked() {
+    const std::shared_ptr<const Snapshot> current = snapshot();
+    if (current->segments.size() <= 1) return;
+
+    std::vector<Pending> items;
+    items.reserve(current->latest.size());
+    for (size_t s = 0; s < current->segments.size(); ++s) {
+        const Segment& segment = *current->segments[s];
+        for (uint32_t r = 0; r < segment.recording_count(); ++r) {
+            if (!current->live[s][r]) continue;
+            const RecordingEntry& e = segment.recordings[r];
+            items.push_back({segment.path(r), FileKey{e.file_size, e.mtime, e.content_hash}, segment.fingerprint(r)});
+        }
+    }
+
+    std::shared_ptr<const Segment> merged = write_segment(items);
+    if (!merged) return;
+    publish({std::move(merged)});
+    std::error_code ec;
+    for (const auto& segment : current->segments) std::filesystem::remove(segment->file, ec);
+}
+
+} // namespace music_life
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Compact content summary of one recording, for duplicate and same-piece
+ * search.
+ *
+ * Landmarks pair spectral peaks a short time apart: the hash encodes both
+ * frequencies and the gap, and `frame` is the anchor's time, so copies and
+ * excerpts of the same audio share many landmarks at one consistent time
+ * offset.  Chroma words summarise the harmony: each ~0.25 s block keeps the
+ * set of pitch classes near its strongest one, repeats are collapsed (so
+ * tempo does not matter) and every three consecutive sets form a word.
+ * Different takes of the same piece share many words.
+ */
+struct AudioFingerprint {
+    static constexpr double   kFrameSeconds = 0.064;         ///< Landmark time unit
+    static constexpr uint32_t kWordFlag     = 0x80000000u;   ///< Set on chroma words, clear on landmarks
+
+    struct Landmark {
+        uint32_t hash;
+        uint32_t frame;
+    };
+
+    float seconds = 0.0f;
+    std::vector<Landmark> landmarks;   ///< Ascending frame
+    std::vector<uint32_t> words;       ///< Distinct chroma words, ascending
+
+    /** Fingerprint interleaved float samples at any rate from 8 kHz up.
+     *  Throws std::invalid_argument for bad channels or sample_rate. */
+    static AudioFingerprint compute(const float* samples, int64_t frames, int channels, int sample_rate);
+};
+
+/**
+ * On-disk index of recording fingerprints for the recording library.
+ *
+ * The index is a set of immutable segment files in one directory, each
+ * holding the fingerprints of the recordings added in one batch and an
+ * inverted list of (hash, recording, frame) postings sorted by hash.
+ * Segments are memory-mapped, so opening the index and answering a query
+ * read only the pages the query's hashes land on; nothing is decoded again.
+ * add() writes one new segment; a recording added again supersedes its
+ * older entry, and once there are more than kMaxSegments segments they are
+ * merged into one, dropping superseded entries.
+ *
+ * A query looks up every landmark and word of a fingerprint with a binary
+ * search per segment.  Landmark hits vote for (recording, time offset); the
+ * best offset's share of the query's landmarks is the duplicate score.  The
+ * share of the query's words a recording contains is its similarity.
+ *
+ * All methods may be called from any thread: queries read a snapshot of the
+ * segment list, and adds are serialised.
+ *
+ * Usage:
+ *   FingerprintIndex index(app_support_dir + "/fingerprints");
+ *   index.add(new_paths);                               // background isolate
+ *   std::vector<FingerprintIndex::Match> matches;
+ *   index.find_similar(path, 10, 0.3f, matches);        // milliseconds
+ */
+class FingerprintIndex {
+public:
+    static constexpr int kMaxSegments = 8;
+
+    enum class Status {
+        Current,      ///< Already indexed and unchanged
+        Added,        ///< Fingerprinted and stored now
+        Unsupported,  ///< Not an uncompressed WAV file
+        IoError       ///< Missing or unreadable recording, or index not writable
+    };
+
+    struct Match {
+        std::string path;
+        float duplicate_score;   ///< Share of the query's landmarks at the best time offset, [0, 1]
+        float offset_seconds;    ///< Where the query starts in the match at that offset
+        float similarity;        ///< Share of the query's chroma words in the match, [0, 1]
+    };
+
+    /**
+     * @param directory  Index directory; created if missing.
+     * @param threads    Fingerprinting threads for add(); 0 picks the
+     *                   hardware concurrency minus one.
+     * Throws std::invalid_argument for an empty directory or negative threads,
+     * std::runtime_error if the directory cannot be created.
+     */
+    explicit FingerprintIndex(std::string directory, int threads = 0);
+    ~FingerprintIndex();
+
+    FingerprintIndex(const FingerprintIndex&) = delete;
+    FingerprintIndex& operator=(const FingerprintIndex&) = delete;
+
+    /** Fingerprint and store every recording that is new or changed since
+     *  it was indexed; blocks until done.  Statuses follow paths. */
+    std::vector<Status> add(const std::vector<std::string>& paths);
+
+    /** Store fingerprints computed by the caller (e.g. from compressed
+     *  recordings), keyed to each recording as it is now.  False if a
+     *  recording cannot be read or the segment cannot be written. */
+    bool store(const std::vector<std::string>& paths, const std::vector<AudioFingerprint>& fingerprints);
+
+    /** Recordings whose duplicate score or similarity reaches min_score,
+     *  best first, at most max_results. */
+    std::vector<Match> query(const AudioFingerprint& fingerprint, int max_results, float min_score) const;
+
+    /** query() with the stored fingerprint of an indexed recording, leaving
+     *  the recording itself out.  False if path is not indexed. */
+    bool find_similar(const std::string& path, int max_results, float min_score, std::vector<Match>& out) const;
+
+    /** Merge every segment into one, dropping superseded entries. */
+    void compact();
+
+    /** Indexed recordings, superseded entries excluded. */
+    size_t size() const;
+    int segment_count() const;
+    const std::string& directory() const { return directory_; }
+    int threads() const { return threads_; }
+
+private:
+    struct Segment;
+    struct Snapshot;
+    struct Pending;
+
+    std::string directory_;
+    int         threads_;
+    uint32_t    next_generation_;
+
+    mutable std::mutex snapshot_mutex_;   ///< Guards snapshot_
+    std::mutex         write_mutex_;      ///< Serialises add, store and compact
+    std::shared_ptr<const Snapshot> snapshot_;
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+    void publish(std::vector<std::shared_ptr<const Segment>> segments);
+    /** Write items as a new segment and publish it; compacts when there
+     *  are too many segments.  Caller holds write_mutex_. */
+    bool append(const std::vector<Pending>& items);
+    /** Write items to the next generation's segment file and map it. */
+    std::shared_ptr<const Segment> write_segment(const std::vector<Pending>& items);
+    void compact_locked();
+};
+
+} // namespace music_life
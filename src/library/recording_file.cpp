@@ -0,0 +1,187 @@
+#include "recording_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace music_life {
+
+static constexpr size_t kHashedBytes = 4096;   // From each end of the recording
+
+// ---------------------------------------------------------------------------
+// File identity
+// ---------------------------------------------------------------------------
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+bool file_key(const std::string& path, FileKey& key) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    unsigned char block[kHashedBytes];
+    const size_t head = std::fread(block, 1, sizeof(block), file);
+    uint64_t hash = fnv1a(block, head);
+    if (size > 2 * kHashedBytes &&
+        std::fseek(file, -static_cast<long>(kHashedBytes), SEEK_END) == 0) {
+        hash = fnv1a(block, std::fread(block, 1, sizeof(block), file), hash);
+    }
+    std::fclose(file);
+
+    key.size  = static_cast<uint64_t>(size);
+    key.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    key.hash  = fnv1a(&key.size, sizeof(key.size), hash);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// MappedFile
+// ---------------------------------------------------------------------------
+
+MappedFile::MappedFile(const std::string& path, Access access) {
+#if defined(_WIN32)
+    (void)access;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return;
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (!ec) {
+        buffer_.resize(static_cast<size_t>(size));
+        buffer_.resize(std::fread(buffer_.data(), 1, buffer_.size(), file));
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        ok_ = true;
+    }
+    std::fclose(file);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st {};
+    if (::fstat(fd, &st) == 0) {
+        size_ = static_cast<size_t>(st.st_size);
+        ok_ = true;
+        if (size_ > 0) {
+            void* map = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                ok_ = false;
+            } else {
+                ::madvise(map, size_, access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+                data_ = static_cast<const unsigned char*>(map);
+            }
+        }
+    }
+    ::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+    if (data_) ::munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// WAV parsing
+// ---------------------------------------------------------------------------
+
+static uint16_t read_u16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+static uint32_t read_u32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+bool parse_wav(const unsigned char* data, size_t size, WavInfo& info) {
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) return false;
+
+    bool have_format = false;
+    int  audio_format = 0;
+    int  bits = 0;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const unsigned char* chunk = data + pos;
+        const size_t chunk_size = read_u32(chunk + 4);
+        const size_t body = pos + 8;
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && body + 16 <= size) {
+            audio_format     = read_u16(data + body);
+            info.channels    = read_u16(data + body + 2);
+            info.sample_rate = static_cast<int>(read_u32(data + body + 4));
+            bits             = read_u16(data + body + 14);
+            if (audio_format == 0xFFFE && chunk_size >= 26 && body + 26 <= size) {
+                audio_format = read_u16(data + body + 24);  // WAVE_FORMAT_EXTENSIBLE sub-format
+            }
+            have_format = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) return false;
+            if (audio_format == 1 && bits == 8)       info.format = SampleFormat::Unsigned8;
+            else if (audio_format == 1 && bits == 16) info.format = SampleFormat::Int16;
+            else if (audio_format == 1 && bits == 24) info.format = SampleFormat::Int24;
+            else if (audio_format == 1 && bits == 32) info.format = SampleFormat::Int32;
+            else if (audio_format == 3 && bits == 32) info.format = SampleFormat::Float32;
+            else return false;
+            if (info.channels <= 0 || info.sample_rate <= 0) return false;
+            info.bytes_per_sample = bits / 8;
+            info.data_offset = body;
+            // Streaming writers leave the size at 0 or 0xFFFFFFFF: read to the end.
+            const size_t available = size - body;
+            const size_t bytes = chunk_size == 0 || chunk_size > available ? available : chunk_size;
+            info.frames = static_cast<int64_t>(bytes / (static_cast<size_t>(info.bytes_per_sample) * info.channels));
+            return true;
+        }
+        pos = body + chunk_size + (chunk_size & 1);
+    }
+    return false;
+}
+
+void decode_samples(const unsigned char* in, SampleFormat format, float* out, int samples) {
+    switch (format) {
+        case SampleFormat::Unsigned8:
+            for (int i = 0; i < samples; ++i) out[i] = (static_cast<float>(in[i]) - 128.0f) * (1.0f / 128.0f);
+            break;
+        case SampleFormat::Int16:
+            for (int i = 0; i < samples; ++i) {
+                out[i] = static_cast<float>(static_cast<int16_t>(read_u16(in + 2 * i))) * (1.0f / 32768.0f);
+            }
+            break;
+        case SampleFormat::Int24:
+            for (int i = 0; i < samples; ++i) {
+                const unsigned char* p = in + 3 * i;
+                const int32_t v = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 |
+                                                       static_cast<uint32_t>(p[1]) << 16 |
+                                                       static_cast<uint32_t>(p[2]) << 24) >> 8;
+                out[i] = static_cast<float>(v) * (1.0f / 8388608.0f);
+            }
+            break;
+        case SampleFormat::Int32:
+            for (int i = 0; i < samples; ++i) {
+                out[i] = static_cast<float>(static_cast<int32_t>(read_u32(in + 4 * i))) * (1.0f / 2147483648.0f);
+            }
+            break;
+        case SampleFormat::Float32:
+            for (int i = 0; i < samples; ++i) {
+                const uint32_t bits = read_u32(in + 4 * i);
+                std::memcpy(out + i, &bits, sizeof(float));
+            }
+            break;
+    }
+}
+
+} // namespace music_life
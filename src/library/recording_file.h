@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace music_life {
+
+// Helpers shared by the recording-library modules (waveform thumbnails,
+// fingerprint index): file identity, read-only mapping and WAV decoding.
+
+static constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+static constexpr uint64_t kFnvPrime  = 1099511628211ull;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = kFnvOffset);
+
+/** What a derived file (thumbnail, fingerprint) is valid for. */
+struct FileKey {
+    uint64_t size;
+    int64_t  mtime;
+    uint64_t hash;   ///< Of the first and last 4 KiB and the size
+
+    bool operator==(const FileKey& other) const {
+        return size == other.size && mtime == other.mtime && hash == other.hash;
+    }
+};
+
+/** Key of the file at path as it is now; false if it cannot be read. */
+bool file_key(const std::string& path, FileKey& key);
+
+/** Read-only view of a whole file: a memory map where available. */
+class MappedFile {
+public:
+    enum class Access { Sequential, Random };
+
+    MappedFile(const std::string& path, Access access);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return ok_; }
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    bool   ok_ = false;
+#if defined(_WIN32)
+    std::vector<unsigned char> buffer_;
+#endif
+};
+
+enum class SampleFormat { Unsigned8, Int16, Int24, Int32, Float32 };
+
+struct WavInfo {
+    SampleFormat format;
+    int          channels;
+    int          sample_rate;
+    int          bytes_per_sample;
+    size_t       data_offset;
+    int64_t      frames;
+};
+
+/** Locate the sample data of an uncompressed WAV file (8/16/24/32-bit PCM
+ *  or 32-bit float, plain or extensible); false for anything else. */
+bool parse_wav(const unsigned char* data, size_t size, WavInfo& info);
+
+/** Convert `samples` little-endian samples to float in [-1, 1). */
+void decode_samples(const unsigned char* in, SampleFormat format, float* out, int samples);
+
+} // namespace music_life
@@ -0,0 +1,357 @@
+#include "waveform_cache.h"
+
+#include "recording_file.h"
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr char     kMagic[4] = {'M', 'L', 'W', 'F'};
+static constexpr uint32_t kVersion = 1;
+static constexpr int      kChunkFrames = 4096;   // Frames converted to float at a time
+
+namespace {
+
+struct CacheHeader {
+    char     magic[4];
+    uint32_t version;
+    uint64_t file_size;
+    int64_t  mtime;
+    uint64_t content_hash;
+    int64_t  frames;
+    int32_t  sample_rate;
+    int32_t  channels;
+    int32_t  level0_buckets;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(WaveformBucket) == 6, "WaveformBucket is stored as three int16 values");
+static_assert(sizeof(CacheHeader) == 56, "CacheHeader layout is part of the cache format");
+
+int level_count(int level0_buckets) {
+    if (level0_buckets <= 0) return 0;
+    int levels = 1;
+    for (int n = level0_buckets; n > WaveformThumbnail::kMinBuckets; n >>= 1) ++levels;
+    return levels;
+}
+
+size_t level_offset(int level0_buckets, int level) {
+    size_t offset = 0;
+    for (int l = 0; l < level; ++l) offset += static_cast<size_t>(level0_buckets >> l);
+    return offset;
+}
+
+int16_t quantize(float v) {
+    return static_cast<int16_t>(std::lround(std::min(std::max(v, -1.0f), 1.0f) * 32767.0f));
+}
+
+// ---------------------------------------------------------------------------
+// Thumbnail building
+// ---------------------------------------------------------------------------
+
+// Accumulates level 0 from interleaved float blocks, then derives the
+// coarser levels by merging neighbouring buckets.
+class ThumbnailBuilder {
+public:
+    ThumbnailBuilder(int64_t frames, int channels, int sample_rate) {
+        thumbnail_.sample_rate = sample_rate;
+        thumbnail_.channels = channels;
+        thumbnail_.frames = frames;
+        // The largest power of two <= frames, so no bucket is empty.
+        int count = 0;
+        if (frames > 0) {
+            count = 1;
+            while (count < WaveformThumbnail::kMaxBuckets && static_cast<int64_t>(count) * 2 <= frames) count *= 2;
+        }
+        thumbnail_.level0_buckets = count;
+        thumbnail_.buckets.assign(level_offset(count, level_count(count)), WaveformBucket{0, 0, 0});
+        bucket_end_ = count > 0 ? frames / count : 0;
+    }
+
+    void add(const float* x, int num_frames) {
+        const int channels = thumbnail_.channels;
+        while (num_frames > 0 && bucket_ < thumbnail_.level0_buckets) {
+            const int take = static_cast<int>(std::min<int64_t>(num_frames, bucket_end_ - frame_));
+            if (take > 0) {
+                float lo = 0.0f, hi = 0.0f;
+                simd::min_max(x, take * channels, lo, hi);
+                if (count_ == 0) {
+                    lo_ = lo;
+                    hi_ = hi;
+                } else {
+                    lo_ = std::min(lo_, lo);
+                    hi_ = std::max(hi_, hi);
+                }
+                sum_squares_ += simd::dot(x, x, take * channels);
+                count_ += static_cast<int64_t>(take) * channels;
+                x += static_cast<size_t>(take) * channels;
+                num_frames -= take;
+                frame_ += take;
+            }
+            if (frame_ == bucket_end_) close_bucket();
+        }
+    }
+
+    WaveformThumbnail finish() {
+        const int levels = level_count(thumbnail_.level0_buckets);
+        for (int l = 1; l < levels; ++l) {
+            const WaveformBucket* finer = thumbnail_.level(l - 1);
+            WaveformBucket* coarser = thumbnail_.buckets.data() + level_offset(thumbnail_.level0_buckets, l);
+            for (int i = 0; i < thumbnail_.level_size(l); ++i) {
+                const WaveformBucket& a = finer[2 * i];
+                const WaveformBucket& b = finer[2 * i + 1];
+                const double power = 0.5 * (static_cast<double>(a.rms) * a.rms + static_cast<double>(b.rms) * b.rms);
+                coarser[i] = WaveformBucket{std::min(a.min, b.min), std::max(a.max, b.max),
+                                            static_cast<int16_t>(std::lround(std::sqrt(power)))};
+            }
+        }
+        return std::move(thumbnail_);
+    }
+
+private:
+    WaveformThumbnail thumbnail_;
+    int64_t frame_ = 0;
+    int     bucket_ = 0;
+    int64_t bucket_end_ = 0;
+    float   lo_ = 0.0f;
+    float   hi_ = 0.0f;
+    double  sum_squares_ = 0.0;
+    int64_t count_ = 0;
+
+    void close_bucket() {
+        const float rms = count_ > 0 ? static_cast<float>(std::sqrt(sum_squares_ / static_cast<double>(count_))) : 0.0f;
+        thumbnail_.buckets[static_cast<size_t>(bucket_)] = WaveformBucket{quantize(lo_), quantize(hi_), quantize(rms)};
+        ++bucket_;
+        bucket_end_ = thumbnail_.frames * (bucket_ + 1) / thumbnail_.level0_buckets;
+        sum_squares_ = 0.0;
+        count_ = 0;
+    }
+};
+
+// Opens the cache file and checks its header against the recording's key.
+std::FILE* open_current(const std::string& cache_path, const std::string& path, CacheHeader& header) {
+    FileKey key{};
+    if (!file_key(path, key)) return nullptr;
+    std::FILE* file = std::fopen(cache_path.c_str(), "rb");
+    if (!file) return nullptr;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.file_size != key.size || header.mtime != key.mtime || header.content_hash != key.hash ||
+        header.level0_buckets < 0 || header.level0_buckets > WaveformThumbnail::kMaxBuckets) {
+        std::fclose(file);
+        return nullptr;
+    }
+    return file;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// WaveformThumbnail
+// ---------------------------------------------------------------------------
+
+int WaveformThumbnail::levels() const {
+    return level_count(level0_buckets);
+}
+
+const WaveformBucket* WaveformThumbnail::level(int level) const {
+    if (level < 0 || level >= levels()) return nullptr;
+    return buckets.data() + level_offset(level0_buckets, level);
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+WaveformCache::WaveformCache(std::string directory, int threads)
+    : directory_(std::move(directory))
+    , threads_(threads)
+{
+    if (directory_.empty()) throw std::invalid_argument("directory must not be empty");
+    if (threads < 0) throw std::invalid_argument("threads must be >= 0");
+    if (threads_ == 0) threads_ = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (!std::filesystem::is_directory(directory_, ec)) {
+        throw std::runtime_error("cannot create waveform cache directory " + directory_);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+std::vector<WaveformCache::Status> WaveformCache::generate(const std::vector<std::string>& paths) const {
+    std::vector<Status> statuses(paths.size(), Status::IoError);
+    std::atomic<size_t> next{0};
+    const auto work = [&]() {
+        for (size_t i = next.fetch_add(1); i < paths.size(); i = next.fetch_add(1)) {
+            statuses[i] = generate_one(paths[i]);
+        }
+    };
+
+    const size_t workers = std::min(static_cast<size_t>(threads_), paths.size());
+    std::vector<std::thread> pool;
+    try {
+        for (size_t t = 1; t < workers; ++t) pool.emplace_back(work);
+    } catch (const std::system_error&) {
+        // Fewer threads than asked for: the ones running share the batch.
+    }
+    work();
+    for (auto& thread : pool) thread.join();
+    return statuses;
+}
+
+WaveformCache::Status WaveformCache::generate_one(const std::string& path) const {
+    try {
+        const std::string cache_path = cache_file(path);
+        CacheHeader header{};
+        if (std::FILE* cached = open_current(cache_path, path, header)) {
+            std::fclose(cached);
+            return Status::Cached;
+        }
+
+        MappedFile file(path, MappedFile::Access::Sequential);
+        if (!file.ok()) return Status::IoError;
+        WavInfo info{};
+        if (!parse_wav(file.data(), file.size(), info)) return Status::Unsupported;
+
+        ThumbnailBuilder builder(info.frames, info.channels, info.sample_rate);
+        std::vector<float> scratch(static_cast<size_t>(kChunkFrames) * info.channels);
+        const size_t frame_bytes = static_cast<size_t>(info.bytes_per_sample) * info.channels;
+        for (int64_t frame = 0; frame < info.frames; frame += kChunkFrames) {
+            const int n = static_cast<int>(std::min<int64_t>(kChunkFrames, info.frames - frame));
+            decode_samples(file.data() + info.data_offset + static_cast<size_t>(frame) * frame_bytes,
+                    info.format, scratch.data(), n * info.channels);
+            builder.add(scratch.data(), n);
+        }
+        return store(path, builder.finish()) ? Status::Generated : Status::IoError;
+    } catch (...) {
+        return Status::IoError;
+    }
+}
+
+int WaveformCache::read_level(const std::string& path, int max_buckets, WaveformBucket* out) const {
+    CacheHeader header{};
+    std::FILE* file = open_current(cache_file(path), path, header);
+    if (!file) return -1;
+
+    int written = 0;
+    const int levels = level_count(header.level0_buckets);
+    for (int l = 0; l < levels; ++l) {
+        const int size = header.level0_buckets >> l;
+        if (size > max_buckets) continue;
+        const long offset = static_cast<long>(sizeof(CacheHeader) +
+                                              level_offset(header.level0_buckets, l) * sizeof(WaveformBucket));
+        if (out && std::fseek(file, offset, SEEK_SET) == 0 &&
+            std::fread(out, sizeof(WaveformBucket), static_cast<size_t>(size), file) == static_cast<size_t>(size)) {
+            written = size;
+        } else {
+            written = -1;
+        }
+        break;
+    }
+    std::fclose(file);
+    return written;
+}
+
+bool WaveformCache::load(const std::string& path, WaveformThumbnail& out) const {
+    CacheHeader header{};
+    std::FILE* file = open_current(cache_file(path), path, header);
+    if (!file) return false;
+
+    WaveformThumbnail thumbnail;
+    thumbnail.sample_rate = header.sample_rate;
+    thumbnail.channels = header.channels;
+    thumbnail.frames = header.frames;
+    thumbnail.level0_buckets = header.level0_buckets;
+    thumbnail.buckets.resize(level_offset(header.level0_buckets, level_count(header.level0_buckets)));
+    const bool ok = std::fread(thumbnail.buckets.data(), sizeof(WaveformBucket), thumbnail.buckets.size(), file) ==
+                    thumbnail.buckets.size();
+    std::fclose(file);
+    if (ok) out = std::move(thumbnail);
+    return ok;
+}
+
+bool WaveformCache::store(const std::string& path, const WaveformThumbnail& thumbnail) const {
+    FileKey key{};
+    if (!file_key(path, key)) return false;
+    if (thumbnail.level0_buckets < 0 || thumbnail.level0_buckets > WaveformThumbnail::kMaxBuckets ||
+        thumbnail.buckets.size() != level_offset(thumbnail.level0_buckets, thumbnail.levels())) {
+        return false;
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version        = kVersion;
+    header.file_size      = key.size;
+    header.mtime          = key.mtime;
+    header.content_hash   = key.hash;
+    header.frames         = thumbnail.frames;
+    header.sample_rate    = thumbnail.sample_rate;
+    header.channels       = thumbnail.channels;
+    header.level0_buckets = thumbnail.level0_buckets;
+
+    // Write a private temporary and rename it over the old entry, so a
+    // concurrent reader sees either the old or the new thumbnail.
+    const std::string cache_path = cache_file(path);
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%zx.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    const std::string temp_path = cache_path + suffix;
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !thumbnail.buckets.empty()) {
+        ok = std::fwrite(thumbnail.buckets.data(), sizeof(WaveformBucket), thumbnail.buckets.size(), file) ==
+             thumbnail.buckets.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temp_path, cache_path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+WaveformThumbnail WaveformCache::build(const float* samples, int64_t frames, int channels, int sample_rate) {
+    if (channels <= 0 || frames < 0 || (!samples && frames > 0)) {
+        throw std::invalid_argument("build needs channels > 0 and frames >= 0 samples");
+    }
+    ThumbnailBuilder builder(frames, channels, sample_rate);
+    for (int64_t frame = 0; frame < frames; frame += kChunkFrames) {
+        const int n = static_cast<int>(std::min<int64_t>(kChunkFrames, frames - frame));
+        builder.add(samples + static_cast<size_t>(frame) * channels, n);
+    }
+    return builder.finish();
+}
+
+// ---------------------------------------------------------------------------
+// Internal
+// ---------------------------------------------------------------------------
+
+std::string WaveformCache::cache_file(const std::string& path) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mlwf",
+                  static_cast<unsigned long long>(fnv1a(path.data(), path.size())));
+    return directory_ + "/" + name;
+}
+
+} // namespace music_life
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace music_life {
+
+/** One column of a waveform preview, full scale = 32767. */
+struct WaveformBucket {
+    int16_t min;
+    int16_t max;
+    int16_t rms;
+};
+
+/**
+ * Multi-resolution peak / RMS summary of a recording.
+ *
+ * Level 0 splits the recording into up to kMaxBuckets near-equal buckets
+ * (a power of two); each further level halves the count, down to
+ * kMinBuckets.  Every channel contributes to every bucket.
+ */
+struct WaveformThumbnail {
+    static constexpr int kMaxBuckets = 4096;
+    static constexpr int kMinBuckets = 64;
+
+    int     sample_rate = 0;
+    int     channels    = 0;
+    int64_t frames      = 0;
+    int     level0_buckets = 0;              ///< 0 for an empty recording
+    std::vector<WaveformBucket> buckets;     ///< Level 0, then each coarser level
+
+    int levels() const;
+    int level_size(int level) const { return level0_buckets >> level; }
+    const WaveformBucket* level(int level) const;
+};
+
+/**
+ * Batch waveform-thumbnail generator with an on-disk cache, for the
+ * recording library.
+ *
+ * Recordings are read through a memory map and summarised in one pass.
+ * Uncompressed WAV (8/16/24/32-bit PCM, 32-bit float, any channel count) is
+ * decoded natively; other containers report Unsupported so the caller can
+ * decode them elsewhere and pass the samples to build().
+ *
+ * Each thumbnail is stored as one small file in the cache directory, named
+ * after a hash of the recording path.  Its header holds the recording's
+ * size, modification time and a hash of its first and last 4 KiB, so a
+ * replaced or edited recording is regenerated.  read_level() checks that
+ * key with one stat and two small reads and copies a single level: O(1)
+ * per item, cheap enough to call while scrolling.
+ *
+ * All methods are const and may be called from any thread; generate()
+ * spreads the batch over worker threads.
+ *
+ * Usage:
+ *   WaveformCache cache(app_cache_dir + "/waveforms");
+ *   cache.generate(paths);                       // background isolate
+ *   int n = cache.read_level(path, 256, buckets); // per visible row
+ */
+class WaveformCache {
+public:
+    enum class Status {
+        Cached,       ///< A valid thumbnail was already stored
+        Generated,    ///< Computed and stored now
+        Unsupported,  ///< Not an uncompressed WAV file
+        IoError       ///< Missing or unreadable recording, or cache not writable
+    };
+
+    /**
+     * @param directory  Cache directory; created if missing.
+     * @param threads    Worker threads for generate(); 0 picks the hardware
+     *                   concurrency minus one.
+     * Throws std::invalid_argument for an empty directory or negative threads,
+     * std::runtime_error if the directory cannot be created.
+     */
+    explicit WaveformCache(std::string directory, int threads = 0);
+
+    /** Make sure every recording has a current thumbnail.  Blocks until the
+     *  whole batch is done; statuses follow the order of paths. */
+    std::vector<Status> generate(const std::vector<std::string>& paths) const;
+    Status generate_one(const std::string& path) const;
+
+    /**
+     * Copy the finest level with at most max_buckets buckets.
+     *
+     * @return Buckets written; 0 if even the coarsest level is larger or the
+     *         recording is empty, -1 if no current thumbnail is cached.
+     */
+    int read_level(const std::string& path, int max_buckets, WaveformBucket* out) const;
+
+    /** Load every level of a current thumbnail; false if none is cached. */
+    bool load(const std::string& path, WaveformThumbnail& out) const;
+
+    /** Store a thumbnail built from samples decoded by the caller, keyed to
+     *  the recording at path as it is now. */
+    bool store(const std::string& path, const WaveformThumbnail& thumbnail) const;
+
+    /** Thumbnail of interleaved float samples. */
+    static WaveformThumbnail build(const float* samples, int64_t frames, int channels, int sample_rate);
+
+    const std::string& directory() const { return directory_; }
+    int threads() const { return threads_; }
+
+private:
+    std::string directory_;
+    int         threads_;
+
+    std::string cache_file(const std::string& path) const;
+};
+
+} // namespace music_life
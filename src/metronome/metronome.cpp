@@ -0,0 +1,244 @@
+#include "metronome.h"
+
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr float kPi = 3.14159265358979323846f;
+static constexpr float kDefaultBpm = 120.0f;
+static constexpr float kClickSeconds = 0.03f;
+static constexpr float kClickHz  = 1000.0f;
+static constexpr float kAccentHz = 1500.0f;
+static constexpr float kBeatGain        = 0.8f;
+static constexpr float kSubdivisionGain = 0.45f;
+
+static constexpr uint64_t kBeatsShift       = 32;
+static constexpr uint64_t kSubdivisionShift = 40;
+static constexpr uint64_t kRunningBit       = uint64_t{1} << 48;
+static constexpr uint64_t kGenerationShift  = 49;
+
+// ---------------------------------------------------------------------------
+// Packed parameter helpers
+// ---------------------------------------------------------------------------
+
+static uint64_t with_bpm(uint64_t params, float bpm) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &bpm, sizeof(bits));
+    return (params & ~uint64_t{0xFFFFFFFF}) | bits;
+}
+
+static float bpm_of(uint64_t params) {
+    const uint32_t bits = static_cast<uint32_t>(params & 0xFFFFFFFF);
+    float bpm = 0.0f;
+    std::memcpy(&bpm, &bits, sizeof(bpm));
+    return bpm;
+}
+
+static int beats_of(uint64_t params) {
+    return static_cast<int>((params >> kBeatsShift) & 0xFF);
+}
+
+static int subdivision_of(uint64_t params) {
+    return static_cast<int>((params >> kSubdivisionShift) & 0xFF);
+}
+
+static uint64_t generation_of(uint64_t params) {
+    return params >> kGenerationShift;
+}
+
+static std::vector<float> synthesise_click(int sample_rate, float frequency) {
+    std::vector<float> click(static_cast<size_t>(kClickSeconds * static_cast<float>(sample_rate)));
+    const float decay = static_cast<float>(click.size()) / 5.0f;
+    for (size_t i = 0; i < click.size(); ++i) {
+        const float t = static_cast<float>(i);
+        click[i] = std::exp(-t / decay) * std::sin(2.0f * kPi * frequency * t / static_cast<float>(sample_rate));
+    }
+    return click;
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+Metronome::Metronome(int sample_rate)
+    : sample_rate_(sample_rate)
+    , params_(0)
+    , volume_(1.0f)
+    , applied_generation_(0)
+    , was_running_(false)
+    , samples_rendered_(0)
+    , next_tick_(0.0)
+    , beat_in_bar_(0)
+    , tick_in_beat_(0)
+    , voices_{}
+    , active_voices_(0)
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+
+    click_  = synthesise_click(sample_rate_, kClickHz);
+    accent_ = synthesise_click(sample_rate_, kAccentHz);
+    params_.store(with_bpm(uint64_t{4} << kBeatsShift | uint64_t{1} << kSubdivisionShift, kDefaultBpm),
+                  std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Control (any thread)
+// ---------------------------------------------------------------------------
+
+void Metronome::load_sound(Sound sound, const float* samples, int num_samples) {
+    if (!samples || num_samples <= 0) throw std::invalid_argument("sound must not be empty");
+    std::vector<float>& target = sound == Sound::Accent ? accent_ : click_;
+    target.assign(samples, samples + num_samples);
+}
+
+void Metronome::set_tempo(float bpm) {
+    if (!(bpm >= kMinBpm && bpm <= kMaxBpm)) {
+        throw std::invalid_argument("bpm must be in [20, 400]");
+    }
+    update_params([bpm](uint64_t p) { return with_bpm(p, bpm); });
+}
+
+void Metronome::set_time_signature(int beats_per_bar, int subdivision) {
+    if (beats_per_bar < 1 || beats_per_bar > kMaxBeatsPerBar) {
+        throw std::invalid_argument("beats_per_bar must be in [1, 16]");
+    }
+    if (subdivision < 1 || subdivision > kMaxSubdivision) {
+        throw std::invalid_argument("subdivision must be in [1, 4]");
+    }
+    update_params([beats_per_bar, subdivision](uint64_t p) {
+        p &= ~((uint64_t{0xFF} << kBeatsShift) | (uint64_t{0xFF} << kSubdivisionShift));
+        return p | static_cast<uint64_t>(beats_per_bar) << kBeatsShift |
+                   static_cast<uint64_t>(subdivision) << kSubdivisionShift;
+    });
+}
+
+void Metronome::set_volume(float volume) {
+    if (!std::isfinite(volume) || volume < 0.0f) {
+        throw std::invalid_argument("volume must be >= 0");
+    }
+    volume_.store(volume, std::memory_order_relaxed);
+}
+
+void Metronome::start() {
+    update_params([](uint64_t p) {
+        const uint64_t generation = generation_of(p) + 1;
+        const uint64_t low = p & ((uint64_t{1} << kGenerationShift) - 1);
+        return low | kRunningBit | generation << kGenerationShift;
+    });
+}
+
+void Metronome::stop() {
+    update_params([](uint64_t p) { return p & ~kRunningBit; });
+}
+
+float Metronome::bpm() const {
+    return bpm_of(params_.load(std::memory_order_acquire));
+}
+
+int Metronome::beats_per_bar() const {
+    return beats_of(params_.load(std::memory_order_acquire));
+}
+
+int Metronome::subdivision() const {
+    return subdivision_of(params_.load(std::memory_order_acquire));
+}
+
+bool Metronome::running() const {
+    return (params_.load(std::memory_order_acquire) & kRunningBit) != 0;
+}
+
+// ---------------------------------------------------------------------------
+// Rendering (audio thread)
+// ---------------------------------------------------------------------------
+
+void Metronome::start_voice(const std::vector<float>& sound, int delay, float gain) {
+    int slot = active_voices_;
+    if (active_voices_ == kMaxVoices) {
+        // Steal the voice that has played the longest.
+        slot = 0;
+        for (int v = 1; v < kMaxVoices; ++v) {
+            if (voices_[v].position > voices_[slot].position) slot = v;
+        }
+    } else {
+        ++active_voices_;
+    }
+    voices_[slot] = Voice{&sound, 0, delay, gain};
+}
+
+int Metronome::render(float* out, int num_frames, ClickEvent* events, int max_events) {
+    if (num_frames <= 0) return 0;
+
+    const uint64_t params = params_.load(std::memory_order_acquire);
+    const bool running = (params & kRunningBit) != 0;
+    const uint64_t generation = generation_of(params);
+    const int64_t block_start = samples_rendered_;
+    const int64_t block_end = block_start + num_frames;
+
+    if (running && (!was_running_ || generation != applied_generation_)) {
+        applied_generation_ = generation;
+        next_tick_    = static_cast<double>(block_start);
+        beat_in_bar_  = 0;
+        tick_in_beat_ = 0;
+    }
+    was_running_ = running;
+
+    int started = 0;
+    if (running) {
+        const int beats = std::max(1, beats_of(params));
+        const int subdivision = std::max(1, subdivision_of(params));
+        const double samples_per_tick =
+            60.0 * static_cast<double>(sample_rate_) / (static_cast<double>(bpm_of(params)) * subdivision);
+
+        while (true) {
+            const int64_t tick = static_cast<int64_t>(std::llround(next_tick_));
+            if (tick >= block_end) break;
+
+            const bool accent = beat_in_bar_ == 0 && tick_in_beat_ == 0;
+            const float gain = accent ? 1.0f : (tick_in_beat_ == 0 ? kBeatGain : kSubdivisionGain);
+            start_voice(accent ? accent_ : click_, static_cast<int>(std::max<int64_t>(tick - block_start, 0)), gain);
+            if (events != nullptr && started < max_events) {
+                events[started] = ClickEvent{tick, beat_in_bar_, tick_in_beat_};
+            }
+            ++started;
+
+            next_tick_ += samples_per_tick;
+            if (tick_in_beat_ + 1 >= subdivision) {
+                tick_in_beat_ = 0;
+                beat_in_bar_ = beat_in_bar_ + 1 >= beats ? 0 : beat_in_bar_ + 1;
+            } else {
+                ++tick_in_beat_;
+            }
+        }
+    }
+
+    const float volume = volume_.load(std::memory_order_relaxed);
+    for (int v = 0; v < active_voices_;) {
+        Voice& voice = voices_[v];
+        const int length = static_cast<int>(voice.sound->size());
+        const int count = std::min(length - voice.position, num_frames - voice.delay);
+        if (count > 0) {
+            simd::multiply_add(voice.sound->data() + voice.position, voice.gain * volume, out + voice.delay, count);
+            voice.position += count;
+        }
+        voice.delay = 0;
+        if (voice.position >= length) {
+            voices_[v] = voices_[--active_voices_];
+        } else {
+            ++v;
+        }
+    }
+
+    samples_rendered_ = block_end;
+    return started;
+}
+
+} // namespace music_life
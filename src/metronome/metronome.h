@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Sample-accurate metronome that mixes preloaded click sounds into an audio
+ * output buffer.
+ *
+ * Click positions are kept as a fractional absolute sample position, so long
+ * runs never drift and every click starts at the exact sample the tempo map
+ * puts it on, independent of buffer size.  Tempo, time signature and
+ * start/stop are written by the UI thread into a single packed atomic and
+ * picked up by render() at the next tick; the audio thread never locks or
+ * allocates.
+ *
+ * Usage:
+ *   Metronome metronome(48000);
+ *   metronome.set_tempo(96.0f);
+ *   metronome.set_time_signature(3, 1);
+ *   metronome.start();
+ *   // In the audio callback (out is mixed into, not overwritten):
+ *   metronome.render(out, num_frames);
+ */
+class Metronome {
+public:
+    enum class Sound {
+        Click,   ///< Regular beats and subdivisions
+        Accent   ///< First beat of the bar
+    };
+
+    struct ClickEvent {
+        int64_t sample_position; ///< Absolute output sample index of the click start
+        int     beat_in_bar;     ///< 0-based beat within the bar
+        int     tick_in_beat;    ///< 0-based subdivision within the beat
+    };
+
+    static constexpr float kMinBpm = 20.0f;
+    static constexpr float kMaxBpm = 400.0f;
+    static constexpr int   kMaxBeatsPerBar = 16;
+    static constexpr int   kMaxSubdivision = 4;
+
+    /** @param sample_rate  Output sample rate in Hz.  Built-in clicks are synthesised. */
+    explicit Metronome(int sample_rate);
+
+    /**
+     * Replace a click sound.  Not real-time safe: call while render() is not
+     * running (for example before the audio stream starts).
+     */
+    void load_sound(Sound sound, const float* samples, int num_samples);
+
+    /** Thread-safe; takes effect from the next tick. */
+    void set_tempo(float bpm);
+    /** Thread-safe; takes effect from the next tick. */
+    void set_time_signature(int beats_per_bar, int subdivision = 1);
+    /** Thread-safe; linear output gain. */
+    void set_volume(float volume);
+    /** Thread-safe; the first click (an accent) is placed at the start of the next render() call. */
+    void start();
+    /** Thread-safe; clicks already sounding are allowed to ring out. */
+    void stop();
+
+    float bpm() const;
+    int beats_per_bar() const;
+    int subdivision() const;
+    bool running() const;
+
+    /**
+     * Mix clicks for the next num_frames output samples into out.
+     *
+     * @param events      Optional; receives the clicks started in this block.
+     * @param max_events  Capacity of events.
+     * @return Number of clicks started in this block (events beyond
+     *         max_events are not reported but still sound).
+     */
+    int render(float* out, int num_frames, ClickEvent* events = nullptr, int max_events = 0);
+
+    /** Absolute output sample index of the next render() call. */
+    int64_t samples_rendered() const { return samples_rendered_; }
+
+private:
+    struct Voice {
+        const std::vector<float>* sound;
+        int   position;   ///< Next sample of sound to play
+        int   delay;      ///< Samples into the current block before it starts
+        float gain;
+    };
+
+    static constexpr int kMaxVoices = 8;
+
+    int sample_rate_;
+    std::vector<float> click_;
+    std::vector<float> accent_;
+
+    // bpm (float bits) | beats_per_bar << 32 | subdivision << 40 |
+    // running << 48 | start generation << 49
+    std::atomic<uint64_t> params_;
+    std::atomic<float> volume_;
+
+    // Audio-thread state.
+    uint64_t applied_generation_;
+    bool     was_running_;
+    int64_t  samples_rendered_;
+    double   next_tick_;
+    int      beat_in_bar_;
+    int      tick_in_beat_;
+    Voice    voices_[kMaxVoices];
+    int      active_voices_;
+
+    template <typename Update>
+    void update_params(Update&& update) {
+        uint64_t current = params_.load(std::memory_order_relaxed);
+        while (!params_.compare_exchange_weak(current, update(current),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+        }
+    }
+
+    void start_voice(const std::vector<float>& sound, int delay, float gain);
+};
+
+} // namespace music_life
@@ -0,0 +1,241 @@
+#include "biquad_cascade.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE3__)
+#include <pmmintrin.h>
+#endif
+
+namespace music_life {
+
+static constexpr double kPi = 3.14159265358979323846;
+static constexpr int    kBlock = 4;
+static constexpr double kDenormalGuard = 1e-30;
+
+// ---------------------------------------------------------------------------
+// Section design
+// ---------------------------------------------------------------------------
+
+BiquadSection BiquadSection::dc_blocker(double hz, double sample_rate) {
+    BiquadSection s;
+    s.b1 = -1.0f;
+    s.a1 = static_cast<float>(-std::exp(-2.0 * kPi * hz / sample_rate));
+    return s;
+}
+
+BiquadSection BiquadSection::high_pass(double hz, double sample_rate) {
+    const double w0 = 2.0 * kPi * hz / sample_rate;
+    const double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+    const double cw = std::cos(w0);
+    const double a0 = 1.0 + alpha;
+    BiquadSection s;
+    s.b0 = static_cast<float>((1.0 + cw) / 2.0 / a0);
+    s.b1 = static_cast<float>(-(1.0 + cw) / a0);
+    s.b2 = s.b0;
+    s.a1 = static_cast<float>(-2.0 * cw / a0);
+    s.a2 = static_cast<float>((1.0 - alpha) / a0);
+    return s;
+}
+
+BiquadSection BiquadSection::notch(double hz, double q, double sample_rate) {
+    const double w0 = 2.0 * kPi * hz / sample_rate;
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double cw = std::cos(w0);
+    const double a0 = 1.0 + alpha;
+    BiquadSection s;
+    s.b0 = static_cast<float>(1.0 / a0);
+    s.b1 = static_cast<float>(-2.0 * cw / a0);
+    s.b2 = s.b0;
+    s.a1 = s.b1;
+    s.a2 = static_cast<float>((1.0 - alpha) / a0);
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// Cascade
+// ---------------------------------------------------------------------------
+
+BiquadCascade::BiquadCascade()
+    : designs_(Design{})
+    , active_sections_(0)
+    , state_{}
+{
+}
+
+BiquadCascade::Design BiquadCascade::make_design(const BiquadSection* sections, int count) {
+    if (count < 0 || count > kMaxSections || (count > 0 && sections == nullptr)) {
+        throw std::invalid_argument("section count must be in [0, 8]");
+    }
+    Design design;
+    design.sections = count;
+    for (int s = 0; s < count; ++s) {
+        const BiquadSection& c = sections[s];
+        if (!std::isfinite(c.b0) || !std::isfinite(c.b1) || !std::isfinite(c.b2) ||
+            !std::isfinite(c.a1) || !std::isfinite(c.a2)) {
+            throw std::invalid_argument("biquad coefficients must be finite");
+        }
+        // Poles inside the unit circle (the stability triangle).
+        if (!(std::fabs(c.a2) < 1.0f && std::fabs(c.a1) < 1.0f + c.a2)) {
+            throw std::invalid_argument("biquad section must be stable");
+        }
+        design.section[s] = c;
+
+        // Column k: the block's outputs when only input k of x[0..3],
+        // x[-1], x[-2], y[-1], y[-2] is one.
+        for (int k = 0; k < 8; ++k) {
+            double x[kBlock + 2] = {};   // x[-2], x[-1], x[0..3]
+            double y[kBlock + 2] = {};
+            if (k < kBlock) x[k + 2] = 1.0;
+            if (k == 4) x[1] = 1.0;
+            if (k == 5) x[0] = 1.0;
+            if (k == 6) y[1] = 1.0;
+            if (k == 7) y[0] = 1.0;
+            for (int n = 2; n < kBlock + 2; ++n) {
+                y[n] = c.b0 * x[n] + c.b1 * x[n - 1] + static_cast<double>(c.b2) * x[n - 2] -
+                       c.a1 * y[n - 1] - static_cast<double>(c.a2) * y[n - 2];
+                design.block[s][k][n - 2] = y[n];
+            }
+        }
+    }
+    return design;
+}
+
+void BiquadCascade::set(const BiquadSection* sections, int count) {
+    designs_.back() = make_design(sections, count);
+    designs_.publish();
+}
+
+void BiquadCascade::apply_pending_design() {
+    if (!designs_.update()) return;
+    const int sections = designs_.front().sections;
+    if (sections != active_sections_) {
+        std::memset(state_, 0, sizeof(state_));
+        active_sections_ = sections;
+    }
+}
+
+void BiquadCascade::reset() {
+    apply_pending_design();
+    std::memset(state_, 0, sizeof(state_));
+}
+
+int BiquadCascade::active_sections() {
+    apply_pending_design();
+    return active_sections_;
+}
+
+void BiquadCascade::process(const float* in, float* out, int n) {
+    apply_pending_design();
+    if (n <= 0) return;
+    const Design& design = designs_.front();
+    const int sections = design.sections;
+    if (sections == 0) {
+        if (out != in) std::memmove(out, in, static_cast<size_t>(n) * sizeof(float));
+        return;
+    }
+
+    // Lanes are doubles: a notch a few tens of hertz wide has its poles so
+    // close to the unit circle that float rounding in the recursion would
+    // reach the output at around -40 dB.
+    int i = 0;
+#if defined(__aarch64__)
+    float64x2_t inputs[kMaxSections];   // x[-1], x[-2]
+    float64x2_t outputs[kMaxSections];  // y[-1], y[-2]
+    for (int s = 0; s < sections; ++s) {
+        inputs[s] = vld1q_f64(state_[s]);
+        outputs[s] = vld1q_f64(state_[s] + 2);
+    }
+    for (; i + kBlock <= n; i += kBlock) {
+        const float32x4_t block = vld1q_f32(in + i);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(block));   // x[0], x[1]
+        float64x2_t hi = vcvt_high_f64_f32(block);            // x[2], x[3]
+        for (int s = 0; s < sections; ++s) {
+            const double (*m)[kBlock] = design.block[s];
+            const float64x2_t taps[4] = {lo, hi, inputs[s], outputs[s]};
+            float64x2_t ylo = vdupq_n_f64(0.0);
+            float64x2_t yhi = vdupq_n_f64(0.0);
+            for (int k = 0; k < 8; ++k) {
+                const float64x2_t v = taps[k / 2];
+                const float64x2_t x = (k & 1) ? vdupq_laneq_f64(v, 1) : vdupq_laneq_f64(v, 0);
+                ylo = vfmaq_f64(ylo, vld1q_f64(m[k]), x);
+                yhi = vfmaq_f64(yhi, vld1q_f64(m[k] + 2), x);
+            }
+            // New state: x[3], x[2] and y[3], y[2].
+            inputs[s] = vextq_f64(hi, hi, 1);
+            outputs[s] = vextq_f64(yhi, yhi, 1);
+            lo = ylo;
+            hi = yhi;
+        }
+        vst1q_f32(out + i, vcombine_f32(vcvt_f32_f64(lo), vcvt_f32_f64(hi)));
+    }
+    for (int s = 0; s < sections; ++s) {
+        vst1q_f64(state_[s], inputs[s]);
+        vst1q_f64(state_[s] + 2, outputs[s]);
+    }
+#elif defined(__SSE3__)
+    __m128d inputs[kMaxSections];   // x[-1], x[-2]
+    __m128d outputs[kMaxSections];  // y[-1], y[-2]
+    for (int s = 0; s < sections; ++s) {
+        inputs[s] = _mm_loadu_pd(state_[s]);
+        outputs[s] = _mm_loadu_pd(state_[s] + 2);
+    }
+    for (; i + kBlock <= n; i += kBlock) {
+        const __m128 block = _mm_loadu_ps(in + i);
+        __m128d lo = _mm_cvtps_pd(block);                         // x[0], x[1]
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(block, block));   // x[2], x[3]
+        for (int s = 0; s < sections; ++s) {
+            const double (*m)[kBlock] = design.block[s];
+            const __m128d taps[4] = {lo, hi, inputs[s], outputs[s]};
+            __m128d ylo = _mm_setzero_pd();
+            __m128d yhi = _mm_setzero_pd();
+            for (int k = 0; k < 8; ++k) {
+                const __m128d v = taps[k / 2];
+                const __m128d x = (k & 1) ? _mm_unpackhi_pd(v, v) : _mm_unpacklo_pd(v, v);
+                ylo = _mm_add_pd(ylo, _mm_mul_pd(_mm_load_pd(m[k]), x));
+                yhi = _mm_add_pd(yhi, _mm_mul_pd(_mm_load_pd(m[k] + 2), x));
+            }
+            // New state: x[3], x[2] and y[3], y[2].
+            inputs[s] = _mm_shuffle_pd(hi, hi, 1);
+            outputs[s] = _mm_shuffle_pd(yhi, yhi, 1);
+            lo = ylo;
+            hi = yhi;
+        }
+        _mm_storeu_ps(out + i, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+    }
+    for (int s = 0; s < sections; ++s) {
+        _mm_storeu_pd(state_[s], inputs[s]);
+        _mm_storeu_pd(state_[s] + 2, outputs[s]);
+    }
+#endif
+
+    // Scalar tail (and the whole block without SIMD): direct form I.
+    for (; i < n; ++i) {
+        double x = in[i];
+        for (int s = 0; s < sections; ++s) {
+            const BiquadSection& c = design.section[s];
+            double* st = state_[s];
+            const double y = c.b0 * x + c.b1 * st[0] + c.b2 * st[1] - c.a1 * st[2] - c.a2 * st[3];
+            st[1] = st[0];
+            st[0] = x;
+            st[3] = st[2];
+            st[2] = y;
+            x = y;
+        }
+        out[i] = static_cast<float>(x);
+    }
+
+    // A decaying state would otherwise end in denormals, which are slow on
+    // most cores; far below anything audible, so flush it.  A non-finite
+    // input reaches the outputs of its block but must not stay in the state.
+    for (int s = 0; s < sections; ++s) {
+        for (double& v : state_[s]) {
+            if (!std::isfinite(v) || std::fabs(v) < kDenormalGuard) v = 0.0;
+        }
+    }
+}
+
+} // namespace music_life
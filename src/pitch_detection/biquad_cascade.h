@@ -0,0 +1,81 @@
+#pragma once
+
+#include "triple_buffer.h"
+
+namespace music_life {
+
+/** One second-order section, normalised so a0 = 1:
+ *  y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]. */
+struct BiquadSection {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+
+    /** First-order DC blocker, (1 - z^-1) / (1 - R z^-1), corner near hz. */
+    static BiquadSection dc_blocker(double hz, double sample_rate);
+    /** Second-order Butterworth high-pass (RBJ cookbook, Q = 1/sqrt(2)). */
+    static BiquadSection high_pass(double hz, double sample_rate);
+    /** Unity-gain notch (RBJ cookbook) of bandwidth hz / q. */
+    static BiquadSection notch(double hz, double q, double sample_rate);
+};
+
+/**
+ * Cascade of up to kMaxSections biquads with per-stream state, for cleaning
+ * up input on its way into an analysis buffer.
+ *
+ * The cascade runs four samples at a time: each section's recurrence is
+ * unrolled over a block of four, so its outputs are a fixed 4x8 matrix times
+ * the block's inputs and the section's state (two past inputs, two past
+ * outputs), evaluated as SIMD multiply-adds on double lanes (SSE2, AArch64
+ * NEON; scalar elsewhere).  A block passes through every section in
+ * registers before it is stored, so the whole cascade costs one read and
+ * one write per sample, and process() may write in place.
+ *
+ * Coefficients are replaced lock-free: set() (one control thread) builds
+ * the block matrices and publishes them through a triple buffer, and the
+ * next process() picks them up.  The state carries over when the section
+ * count is unchanged and restarts from zero otherwise.
+ */
+class BiquadCascade {
+public:
+    static constexpr int kMaxSections = 8;
+
+    BiquadCascade();
+
+    BiquadCascade(const BiquadCascade&) = delete;
+    BiquadCascade& operator=(const BiquadCascade&) = delete;
+
+    /** Control thread.  count = 0 makes process() a copy.  Throws
+     *  std::invalid_argument unless 0 <= count <= kMaxSections, every
+     *  coefficient is finite and every section is stable. */
+    void set(const BiquadSection* sections, int count);
+
+    /** Processing thread.  Filter n samples of in into out (may alias in). */
+    void process(const float* in, float* out, int n);
+
+    /** Processing thread.  Clear the state, e.g. on a stream restart. */
+    void reset();
+
+    /** Processing thread.  Sections process() runs; 0 when it only copies. */
+    int active_sections();
+
+private:
+    struct Design {
+        int           sections = 0;
+        BiquadSection section[kMaxSections];
+        /// Per section, the contribution of x[0..3], x[-1], x[-2], y[-1]
+        /// and y[-2] to y[0..3] of a block.
+        alignas(16) double block[kMaxSections][8][4];
+    };
+
+    TripleBuffer<Design> designs_;
+    int    active_sections_;               ///< Section count the state belongs to
+    double state_[kMaxSections][4];        ///< x[-1], x[-2], y[-1], y[-2]
+
+    static Design make_design(const BiquadSection* sections, int count);
+    void apply_pending_design();
+};
+
+} // namespace music_life
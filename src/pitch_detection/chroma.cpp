@@ -0,0 +1,319 @@
+#include "chroma.h"
+
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr float kPi = 3.14159265358979323846f;
+static constexpr int   kA4_Midi = 69;
+static constexpr int   kLowestMidi  = 36;  // C2
+static constexpr int   kHighestMidi = 96;  // C7
+static constexpr float kMinReferencePitch = 430.0f;
+static constexpr float kMaxReferencePitch = 450.0f;
+
+// Smoothing per hop.  The chord chroma follows changes within a few hops; the
+// key chroma integrates over several seconds.
+static constexpr float kChordSmoothing = 0.5f;
+static constexpr float kKeySmoothing   = 0.02f;
+
+// Normalised frame energy below which the frame is treated as silence.
+static constexpr float kMinFrameEnergy = 1e-7f;
+// Chord similarity below which no chord is reported.
+static constexpr float kMinChordConfidence = 0.6f;
+
+struct ChordTemplate {
+    ChordQuality quality;
+    int intervals[4];
+    int count;
+};
+
+static const ChordTemplate kChordTemplates[] = {
+    {ChordQuality::Major,      {0, 4, 7, 0},  3},
+    {ChordQuality::Minor,      {0, 3, 7, 0},  3},
+    {ChordQuality::Dominant7,  {0, 4, 7, 10}, 4},
+    {ChordQuality::Minor7,     {0, 3, 7, 10}, 4},
+    {ChordQuality::Diminished, {0, 3, 6, 0},  3},
+    {ChordQuality::Sus4,       {0, 5, 7, 0},  3},
+};
+
+// Krumhansl-Kessler key profiles, tonic first.
+static const float kMajorProfile[ChromaAnalyzer::kPitchClasses] = {
+    6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f
+};
+static const float kMinorProfile[ChromaAnalyzer::kPitchClasses] = {
+    6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f
+};
+
+static int next_power_of_two(int n) {
+    int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Pearson correlation of chroma against profile rotated to the given tonic.
+static float profile_correlation(const std::array<float, ChromaAnalyzer::kPitchClasses>& chroma,
+                                 const float* profile,
+                                 int tonic) {
+    constexpr int n = ChromaAnalyzer::kPitchClasses;
+    float mean_c = 0.0f;
+    float mean_p = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        mean_c += chroma[i];
+        mean_p += profile[i];
+    }
+    mean_c /= n;
+    mean_p /= n;
+
+    float cov = 0.0f;
+    float var_c = 0.0f;
+    float var_p = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        const float dc = chroma[(tonic + i) % n] - mean_c;
+        const float dp = profile[i] - mean_p;
+        cov   += dc * dp;
+        var_c += dc * dc;
+        var_p += dp * dp;
+    }
+    if (var_c <= 0.0f || var_p <= 0.0f) return 0.0f;
+    return cov / std::sqrt(var_c * var_p);
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+ChromaAnalyzer::ChromaAnalyzer(int sample_rate, int frame_size, float reference_pitch_hz)
+    : sample_rate_(sample_rate)
+    , frame_size_(frame_size)
+    , fft_size_(next_power_of_two(std::max(frame_size, 2)))
+    , fft_(fft_size_)
+    , reset_pending_(false)
+    , ring_buffer_(std::max(frame_size, 1))
+    , window_(static_cast<size_t>(std::max(frame_size, 0)))
+    , spectrum_(static_cast<size_t>(fft_size_))
+    , power_(static_cast<size_t>(fft_size_ / 2 + 1), 0.0f)
+    , chord_chroma_{}
+    , key_chroma_{}
+    , samples_ready_(0)
+    , samples_since_last_hop_(0)
+    , last_result_{}
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+    if (frame_size < 256) throw std::invalid_argument("frame_size must be >= 256");
+    if (reference_pitch_hz < kMinReferencePitch || reference_pitch_hz > kMaxReferencePitch) {
+        throw std::invalid_argument("reference_pitch_hz must be in [430, 450]");
+    }
+
+    for (int i = 0; i < frame_size_; ++i) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * kPi * static_cast<float>(i) / static_cast<float>(frame_size_ - 1));
+    }
+
+    // Each semitone owns the bins within +/- 50 cents of its centre, so the
+    // bands partition the spectrum and a bin is never counted twice.
+    const float bin_hz = static_cast<float>(sample_rate_) / static_cast<float>(fft_size_);
+    const int max_bin = fft_size_ / 2 + 1;
+    for (int midi = kLowestMidi; midi <= kHighestMidi; ++midi) {
+        const float centre = reference_pitch_hz * std::pow(2.0f, static_cast<float>(midi - kA4_Midi) / 12.0f);
+        const float lo_hz = centre * std::pow(2.0f, -1.0f / 24.0f);
+        const float hi_hz = centre * std::pow(2.0f, 1.0f / 24.0f);
+        const int lo = std::min(max_bin, static_cast<int>(std::ceil(lo_hz / bin_hz)));
+        const int hi = std::min(max_bin, static_cast<int>(std::ceil(hi_hz / bin_hz)));
+        if (hi > lo) {
+            bands_.push_back({lo, hi, midi % kPitchClasses});
+        }
+    }
+
+    last_result_.chord_root = -1;
+    last_result_.key_tonic  = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void ChromaAnalyzer::reset() {
+    reset_pending_.store(true, std::memory_order_release);
+}
+
+const char* ChromaAnalyzer::chord_suffix(ChordQuality quality) {
+    switch (quality) {
+        case ChordQuality::Major:      return "";
+        case ChordQuality::Minor:      return "m";
+        case ChordQuality::Dominant7:  return "7";
+        case ChordQuality::Minor7:     return "m7";
+        case ChordQuality::Diminished: return "dim";
+        case ChordQuality::Sus4:       return "sus4";
+        case ChordQuality::None:       break;
+    }
+    return "";
+}
+
+ChromaAnalyzer::Result ChromaAnalyzer::process(const float* samples, int num_samples) {
+    apply_pending_reset();
+
+    const int hop_size = frame_size_ / 2;
+    bool updated = false;
+    int offset = 0;
+    while (offset < num_samples) {
+        // Same hop walk as PitchDetector::process_block: stop at every
+        // analysis point so smoothing does not depend on the block size.
+        const int until_due = samples_ready_ < frame_size_
+            ? frame_size_ - samples_ready_
+            : hop_size - samples_since_last_hop_;
+        const int chunk = std::min(num_samples - offset, std::max(until_due, 0));
+
+        ring_buffer_.write(samples + offset, chunk);
+        samples_ready_ = std::min(frame_size_, samples_ready_ + chunk);
+        samples_since_last_hop_ += chunk;
+        offset += chunk;
+
+        if (samples_ready_ < frame_size_ || samples_since_last_hop_ < hop_size) {
+            continue;
+        }
+        samples_since_last_hop_ = 0;
+        analyse_frame();
+        updated = true;
+    }
+
+    Result result = last_result_;
+    result.updated = updated;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Analysis
+// ---------------------------------------------------------------------------
+
+void ChromaAnalyzer::apply_pending_reset() {
+    if (reset_pending_.exchange(false, std::memory_order_acq_rel)) {
+        ring_buffer_.clear();
+        chord_chroma_.fill(0.0f);
+        key_chroma_.fill(0.0f);
+        samples_ready_ = 0;
+        samples_since_last_hop_ = 0;
+        last_result_ = {};
+        last_result_.chord_root = -1;
+        last_result_.key_tonic  = -1;
+    }
+}
+
+void ChromaAnalyzer::analyse_frame() {
+    simd::window_to_complex(ring_buffer_.latest(frame_size_), window_.data(), spectrum_.data(), frame_size_);
+    std::fill(spectrum_.begin() + frame_size_, spectrum_.end(), std::complex<float>(0.0f, 0.0f));
+    fft_.forward(spectrum_);
+    simd::power_spectrum(spectrum_.data(), power_.data(), static_cast<int>(power_.size()));
+
+    std::array<float, kPitchClasses> frame_chroma{};
+    for (const Band& band : bands_) {
+        frame_chroma[band.pitch_class] += simd::sum(power_.data() + band.lo, band.hi - band.lo);
+    }
+
+    float frame_energy = 0.0f;
+    for (float v : frame_chroma) frame_energy += v;
+    frame_energy /= static_cast<float>(frame_size_) * static_cast<float>(frame_size_);
+
+    // Magnitude-compress and L2-normalise so loud and quiet frames weigh the
+    // same in the smoothed chroma; silent frames contribute zeros.
+    if (frame_energy >= kMinFrameEnergy) {
+        float norm = 0.0f;
+        for (float& v : frame_chroma) {
+            v = std::sqrt(v);
+            norm += v * v;
+        }
+        norm = std::sqrt(norm);
+        for (float& v : frame_chroma) v /= norm;
+    } else {
+        frame_chroma.fill(0.0f);
+    }
+
+    for (int i = 0; i < kPitchClasses; ++i) {
+        chord_chroma_[i] += kChordSmoothing * (frame_chroma[i] - chord_chroma_[i]);
+    }
+    if (frame_energy >= kMinFrameEnergy) {
+        for (int i = 0; i < kPitchClasses; ++i) {
+            key_chroma_[i] += kKeySmoothing * (frame_chroma[i] - key_chroma_[i]);
+        }
+    }
+
+    const float peak = *std::max_element(chord_chroma_.begin(), chord_chroma_.end());
+    for (int i = 0; i < kPitchClasses; ++i) {
+        last_result_.chroma[i] = peak > 0.0f ? chord_chroma_[i] / peak : 0.0f;
+    }
+
+    match_chord(frame_energy);
+    match_key();
+}
+
+void ChromaAnalyzer::match_chord(float frame_energy) {
+    last_result_.chord_root       = -1;
+    last_result_.chord_quality    = ChordQuality::None;
+    last_result_.chord_confidence = 0.0f;
+    if (frame_energy < kMinFrameEnergy) return;
+
+    float norm = 0.0f;
+    for (float v : chord_chroma_) norm += v * v;
+    norm = std::sqrt(norm);
+    if (norm <= 0.0f) return;
+
+    // Cosine similarity against binary templates for every root.
+    float best = 0.0f;
+    for (const ChordTemplate& tmpl : kChordTemplates) {
+        const float scale = 1.0f / (norm * std::sqrt(static_cast<float>(tmpl.count)));
+        for (int root = 0; root < kPitchClasses; ++root) {
+            float score = 0.0f;
+            for (int k = 0; k < tmpl.count; ++k) {
+                score += chord_chroma_[(root + tmpl.intervals[k]) % kPitchClasses];
+            }
+            score *= scale;
+            if (score > best) {
+                best = score;
+                last_result_.chord_root    = root;
+                last_result_.chord_quality = tmpl.quality;
+            }
+        }
+    }
+
+    if (best < kMinChordConfidence) {
+        last_result_.chord_root    = -1;
+        last_result_.chord_quality = ChordQuality::None;
+    }
+    last_result_.chord_confidence = best;
+}
+
+void ChromaAnalyzer::match_key() {
+    float total = 0.0f;
+    for (float v : key_chroma_) total += v;
+    if (total <= 0.0f) {
+        last_result_.key_tonic      = -1;
+        last_result_.key_minor      = false;
+        last_result_.key_confidence = 0.0f;
+        return;
+    }
+
+    float best = -2.0f;
+    for (int tonic = 0; tonic < kPitchClasses; ++tonic) {
+        const float major = profile_correlation(key_chroma_, kMajorProfile, tonic);
+        if (major > best) {
+            best = major;
+            last_result_.key_tonic = tonic;
+            last_result_.key_minor = false;
+        }
+        const float minor = profile_correlation(key_chroma_, kMinorProfile, tonic);
+        if (minor > best) {
+            best = minor;
+            last_result_.key_tonic = tonic;
+            last_result_.key_minor = true;
+        }
+    }
+    last_result_.key_confidence = best;
+}
+
+} // namespace music_life
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "fft.h"
+#include "mirrored_ring_buffer.h"
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <vector>
+
+namespace music_life {
+
+enum class ChordQuality {
+    None,
+    Major,
+    Minor,
+    Dominant7,
+    Minor7,
+    Diminished,
+    Sus4
+};
+
+/**
+ * Streaming chromagram, chord and key estimator.
+ *
+ * Shares the Fft backends used by Yin.  Every hop (frame_size / 2 new
+ * samples) a Hann-windowed frame is transformed, its power spectrum is folded
+ * into 12 pitch classes and the smoothed chroma is matched against chord
+ * templates; a slower-moving chroma is correlated with major/minor key
+ * profiles.  All state is fixed-size and allocated at construction.
+ *
+ * Usage:
+ *   ChromaAnalyzer chroma(44100, 4096);
+ *   // In the audio callback:
+ *   ChromaAnalyzer::Result r = chroma.process(buffer, num_samples);
+ *   if (r.chord_root >= 0) { show(r.chord_root, r.chord_quality); }
+ */
+class ChromaAnalyzer {
+public:
+    static constexpr int kPitchClasses = 12;
+
+    struct Result {
+        bool  updated;           ///< true if at least one hop was analysed in this call
+        std::array<float, kPitchClasses> chroma; ///< Smoothed chroma, C = 0, max-normalised
+        int   chord_root;        ///< Pitch class of the chord root, or -1 if none
+        ChordQuality chord_quality;
+        float chord_confidence;  ///< Template similarity [0, 1]
+        int   key_tonic;         ///< Pitch class of the key tonic, or -1 if unknown
+        bool  key_minor;
+        float key_confidence;    ///< Profile correlation [-1, 1]
+    };
+
+    /**
+     * @param sample_rate         Audio sample rate in Hz.
+     * @param frame_size          Analysis frame size in samples.
+     * @param reference_pitch_hz  Frequency of A4 used to place pitch classes.
+     */
+    explicit ChromaAnalyzer(int sample_rate,
+                            int frame_size = 4096,
+                            float reference_pitch_hz = 440.0f);
+
+    /**
+     * Feed a mono block.  Every hop contained in the block is analysed in
+     * order, so smoothing and key tracking do not depend on block size.
+     * Returns the state after the last analysed hop.
+     */
+    Result process(const float* samples, int num_samples);
+
+    /** Request a reset; applied at the start of the next process() call. */
+    void reset();
+
+    int hop_size() const { return frame_size_ / 2; }
+
+    /** Short chord suffix for a quality ("", "m", "7", "m7", "dim", "sus4"). */
+    static const char* chord_suffix(ChordQuality quality);
+
+private:
+    struct Band {
+        int lo;          ///< First FFT bin (inclusive)
+        int hi;          ///< Last FFT bin (exclusive)
+        int pitch_class;
+    };
+
+    int   sample_rate_;
+    int   frame_size_;
+    int   fft_size_;
+    Fft   fft_;
+    std::atomic<bool> reset_pending_;
+    MirroredRingBuffer ring_buffer_;
+
+    std::vector<float> window_;
+    std::vector<std::complex<float>> spectrum_;
+    std::vector<float> power_;
+    std::vector<Band>  bands_;
+
+    std::array<float, kPitchClasses> chord_chroma_;
+    std::array<float, kPitchClasses> key_chroma_;
+
+    int    samples_ready_;
+    int    samples_since_last_hop_;
+    Result last_result_;
+
+    void apply_pending_reset();
+    void analyse_frame();
+    void match_chord(float frame_energy);
+    void match_key();
+};
+
+} // namespace music_life
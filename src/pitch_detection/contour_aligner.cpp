@@ -0,0 +1,402 @@
+#include "contour_aligner.h"
+
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr float kInf = std::numeric_limits<float>::infinity();
+// Stands in for NaN: clamped against a voiced value it costs max_cost, and
+// against itself nothing.
+static constexpr float kUnvoiced = -1e30f;
+// Sub-problems smaller than this (in band cells) stay on the calling thread.
+static constexpr int64_t kMinParallelCells = int64_t{1} << 20;
+
+namespace {
+
+// Run a and b, on two threads when parallel; rethrows the first failure.
+template <typename A, typename B>
+void run_both(bool parallel, A&& a, B&& b) {
+    if (!parallel) {
+        a();
+        b();
+        return;
+    }
+    std::exception_ptr error;
+    std::thread worker;
+    try {
+        worker = std::thread([&] {
+            try {
+                a();
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+    } catch (const std::system_error&) {
+        a();   // No thread to spare: run both here.
+    }
+    try {
+        b();
+    } catch (...) {
+        if (worker.joinable()) worker.join();
+        throw;
+    }
+    if (worker.joinable()) worker.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// One anti-diagonal of the cost matrix, cells lo .. lo + len - 1 (by ref
+// index), with an infinite sentinel either side.
+struct Diagonal {
+    std::vector<float> cells;
+    int lo  = 0;
+    int len = 0;
+
+    const float* at(int i) const { return cells.data() + (i - lo + 1); }
+    bool contains(int i) const { return i >= lo && i < lo + len; }
+};
+
+// The problem seen from one end: forward, or with both contours reversed
+// for the backward sweep.  Contours are planar, [dims][frames].
+struct View {
+    const float* rows;      // Reference hops
+    const float* cols_rev;  // Take hops, last first
+    const int*   jlo;       // Band of take hops per reference hop
+    const int*   jhi;
+};
+
+class Solver {
+public:
+    Solver(const float* ref, int n, const float* take, int m, int dims, int band, float max_cost, int threads);
+
+    void solve(int i0, int j0, int i1, int j1, std::vector<ContourAligner::Step>& out, int depth) const;
+    float cell_cost(int i, int j) const;
+
+private:
+    int   n_, m_, dims_, band_;
+    float max_cost_;
+    int   parallel_depth_;
+    std::vector<float> rows_, rows_rev_, cols_, cols_rev_;
+    std::vector<int>   jlo_, jhi_, jlo_rev_, jhi_rev_;
+    View forward_{}, backward_{};
+
+    void sweep(const View& view, int i0, int j0, int i1, int j1, int k_stop, Diagonal& last, Diagonal& before) const;
+    void solve_direct(int i0, int j0, int i1, int j1, std::vector<ContourAligner::Step>& out) const;
+    int64_t band_cells(int i0, int j0, int i1, int j1) const;
+};
+
+// ---------------------------------------------------------------------------
+// Solver
+// ---------------------------------------------------------------------------
+
+Solver::Solver(const float* ref, int n, const float* take, int m, int dims, int band, float max_cost, int threads)
+    : n_(n), m_(m), dims_(dims), max_cost_(max_cost), parallel_depth_(0)
+{
+    while ((2 << parallel_depth_) <= threads) ++parallel_depth_;
+
+    const size_t rows = static_cast<size_t>(n);
+    const size_t cols = static_cast<size_t>(m);
+    rows_.resize(rows * dims);
+    rows_rev_.resize(rows * dims);
+    cols_.resize(cols * dims);
+    cols_rev_.resize(cols * dims);
+    for (int d = 0; d < dims; ++d) {
+        for (int i = 0; i < n; ++i) {
+            const float v = ref[static_cast<size_t>(i) * dims + d];
+            const float x = std::isnan(v) ? kUnvoiced : v;
+            rows_[d * rows + i] = x;
+            rows_rev_[d * rows + (n - 1 - i)] = x;
+        }
+        for (int j = 0; j < m; ++j) {
+            const float v = take[static_cast<size_t>(j) * dims + d];
+            const float x = std::isnan(v) ? kUnvoiced : v;
+            cols_[d * cols + j] = x;
+            cols_rev_[d * cols + (m - 1 - j)] = x;
+        }
+    }
+
+    // Band around the line from (0, 0) to (n - 1, m - 1), at least as wide
+    // as one reference hop's step along the take so rows overlap.
+    const double slope = n > 1 ? static_cast<double>(m - 1) / (n - 1) : 0.0;
+    band_ = std::max(band, static_cast<int>(std::ceil(slope)));
+    jlo_.resize(rows);
+    jhi_.resize(rows);
+    for (int i = 0; i < n; ++i) {
+        const double centre = n > 1 ? i * slope : 0.0;
+        jlo_[static_cast<size_t>(i)] = std::max(0, static_cast<int>(std::ceil(centre - band_ - 1e-9)));
+        jhi_[static_cast<size_t>(i)] = std::min(m - 1, static_cast<int>(std::floor(centre + band_ + 1e-9)));
+    }
+    if (n == 1) jhi_[0] = m - 1;
+    jlo_rev_.resize(rows);
+    jhi_rev_.resize(rows);
+    for (int i = 0; i < n; ++i) {
+        jlo_rev_[static_cast<size_t>(i)] = m - 1 - jhi_[static_cast<size_t>(n - 1 - i)];
+        jhi_rev_[static_cast<size_t>(i)] = m - 1 - jlo_[static_cast<size_t>(n - 1 - i)];
+    }
+
+    forward_  = {rows_.data(), cols_rev_.data(), jlo_.data(), jhi_.data()};
+    backward_ = {rows_rev_.data(), cols_.data(), jlo_rev_.data(), jhi_rev_.data()};
+}
+
+float Solver::cell_cost(int i, int j) const {
+    float cost = 0.0f;
+    for (int d = 0; d < dims_; ++d) {
+        const float a = rows_[static_cast<size_t>(d) * n_ + i];
+        const float b = cols_[static_cast<size_t>(d) * m_ + j];
+        cost += std::min(std::fabs(a - b), max_cost_);
+    }
+    return cost;
+}
+
+int64_t Solver::band_cells(int i0, int j0, int i1, int j1) const {
+    return static_cast<int64_t>(i1 - i0 + 1) * std::min(j1 - j0 + 1, 2 * band_ + 1);
+}
+
+void Solver::sweep(const View& view, int i0, int j0, int i1, int j1, int k_stop,
+                   Diagonal& last, Diagonal& before) const {
+    // An anti-diagonal crosses the band in at most 2 * band_ + 1 cells (one
+    // more is headroom for rounding at the band edges).
+    const int width = std::min({i1 - i0 + 1, j1 - j0 + 1, 2 * band_ + 2});
+    const size_t capacity = static_cast<size_t>(width) + 2;
+    Diagonal next;
+    next.cells.resize(capacity);
+    last.cells.assign(capacity, kInf);
+    before.cells.assign(capacity, kInf);
+    std::vector<float> cost(static_cast<size_t>(width));
+
+    // Before the first diagonal: (i0, j0) continues from a zero-cost
+    // diagonal predecessor, and nothing else is reachable.
+    before.lo  = i0 - 1;
+    before.len = 1;
+    before.cells[1] = 0.0f;
+    last.lo  = i0;
+    last.len = 0;
+
+    // The band and the block bound each diagonal by ref index; every bound
+    // moves by at most one per diagonal, so reads stay within one sentinel.
+    int first_row = i0;      // Smallest i with i + jhi[i] >= k
+    int last_row  = i0 - 1;  // Largest i with i + jlo[i] <= k
+    for (int k = i0 + j0; k <= k_stop; ++k) {
+        while (first_row <= i1 && first_row + view.jhi[first_row] < k) ++first_row;
+        while (last_row < i1 && last_row + 1 + view.jlo[last_row + 1] <= k) ++last_row;
+        const int lo  = std::max(first_row, k - j1);
+        const int len = std::max(std::min(last_row, k - j0) - lo + 1, 0);
+
+        std::fill(cost.begin(), cost.begin() + len, 0.0f);
+        for (int d = 0; d < dims_; ++d) {
+            simd::clamped_abs_diff_add(view.rows + static_cast<size_t>(d) * n_ + lo,
+                                       view.cols_rev + static_cast<size_t>(d) * m_ + (m_ - 1 - k + lo),
+                                       max_cost_, cost.data(), len);
+        }
+        // Predecessors of (i, k - i): (i - 1, k - i) and (i, k - i - 1) on
+        // the last diagonal, (i - 1, k - i - 1) on the one before.
+        simd::min3_add(last.at(lo - 1), last.at(lo), before.at(lo - 1), cost.data(), next.cells.data() + 1, len);
+        next.cells[0] = kInf;
+        next.cells[static_cast<size_t>(len) + 1] = kInf;
+        next.lo  = lo;
+        next.len = len;
+
+        std::swap(before, last);
+        std::swap(last, next);
+    }
+}
+
+void Solver::solve(int i0, int j0, int i1, int j1, std::vector<ContourAligner::Step>& out, int depth) const {
+    if (i0 == i1 || j0 == j1) {
+        for (int i = i0, j = j0;; i += i < i1, j += j < j1) {
+            out.push_back({i, j});
+            if (i == i1 && j == j1) return;
+        }
+    }
+    if (static_cast<int64_t>(i1 - i0 + 1) * (j1 - j0 + 1) <= ContourAligner::kDirectCells) {
+        solve_direct(i0, j0, i1, j1, out);
+        return;
+    }
+
+    const int k_mid = (i0 + j0 + i1 + j1) / 2;
+    const int k_rev = (n_ - 1) + (m_ - 1) - k_mid;
+    const bool parallel = depth < parallel_depth_ && band_cells(i0, j0, i1, j1) >= kMinParallelCells;
+
+    // Forward costs on k_mid and k_mid - 1, backward costs (from the block's
+    // end, this cell included) on k_mid and k_mid + 1.
+    Diagonal f_mid, f_before, b_mid, b_after;
+    run_both(parallel,
+             [&] { sweep(forward_, i0, j0, i1, j1, k_mid, f_mid, f_before); },
+             [&] { sweep(backward_, n_ - 1 - i1, m_ - 1 - j1, n_ - 1 - i0, m_ - 1 - j0, k_rev, b_mid, b_after); });
+
+    // The best path either visits a cell of k_mid or steps diagonally over it.
+    float best = kInf;
+    int split_i = -1;
+    bool over = false;
+    for (int i = f_mid.lo; i < f_mid.lo + f_mid.len; ++i) {
+        if (!b_mid.contains(n_ - 1 - i)) continue;
+        const float total = *f_mid.at(i) + *b_mid.at(n_ - 1 - i) - cell_cost(i, k_mid - i);
+        if (total < best) {
+            best = total;
+            split_i = i;
+            over = false;
+        }
+    }
+    for (int i = f_before.lo; i < f_before.lo + f_before.len; ++i) {
+        if (!b_after.contains(n_ - 2 - i)) continue;
+        const float total = *f_before.at(i) + *b_after.at(n_ - 2 - i);
+        if (total < best) {
+            best = total;
+            split_i = i;
+            over = true;
+        }
+    }
+    if (split_i < 0) throw std::logic_error("ContourAligner: band is disconnected");
+
+    const int split_j = (over ? k_mid - 1 : k_mid) - split_i;
+    std::vector<ContourAligner::Step> tail;
+    run_both(parallel,
+             [&] { solve(split_i + over, split_j + over, i1, j1, tail, depth + 1); },
+             [&] { solve(i0, j0, split_i, split_j, out, depth + 1); });
+    // A visited cell ends the first half and starts the second.
+    out.insert(out.end(), tail.begin() + (over ? 0 : 1), tail.end());
+}
+
+void Solver::solve_direct(int i0, int j0, int i1, int j1, std::vector<ContourAligner::Step>& out) const {
+    const int rows = i1 - i0 + 1;
+    const int cols = j1 - j0 + 1;
+    std::vector<float> total(static_cast<size_t>(rows) * cols, kInf);
+    const auto at = [&](int r, int c) -> float& { return total[static_cast<size_t>(r) * cols + c]; };
+
+    for (int r = 0; r < rows; ++r) {
+        const int i = i0 + r;
+        const int c_lo = std::max(jlo_[static_cast<size_t>(i)], j0) - j0;
+        const int c_hi = std::min(jhi_[static_cast<size_t>(i)], j1) - j0;
+        for (int c = c_lo; c <= c_hi; ++c) {
+            float prev = r == 0 && c == 0 ? 0.0f : kInf;
+            if (r > 0) prev = std::min(prev, at(r - 1, c));
+            if (c > 0) prev = std::min(prev, at(r, c - 1));
+            if (r > 0 && c > 0) prev = std::min(prev, at(r - 1, c - 1));
+            at(r, c) = prev + cell_cost(i, j0 + c);
+        }
+    }
+
+    // Trace back from the end, preferring the diagonal on ties.
+    const size_t begin = out.size();
+    int r = rows - 1;
+    int c = cols - 1;
+    out.push_back({i0 + r, j0 + c});
+    while (r > 0 || c > 0) {
+        if (r > 0 && c > 0 && at(r - 1, c - 1) <= std::min(at(r - 1, c), at(r, c - 1))) {
+            --r;
+            --c;
+        } else if (c == 0 || (r > 0 && at(r - 1, c) <= at(r, c - 1))) {
+            --r;
+        } else {
+            --c;
+        }
+        out.push_back({i0 + r, j0 + c});
+    }
+    std::reverse(out.begin() + static_cast<std::ptrdiff_t>(begin), out.end());
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+ContourAligner::ContourAligner() : ContourAligner(Config{}) {}
+
+ContourAligner::ContourAligner(const Config& config) : config_(config) {
+    if (config_.band < 1) throw std::invalid_argument("band must be >= 1");
+    if (!(config_.max_cost > 0.0f) || !std::isfinite(config_.max_cost)) {
+        throw std::invalid_argument("max_cost must be positive and finite");
+    }
+    if (config_.threads < 0) throw std::invalid_argument("threads must be >= 0");
+    if (config_.threads == 0) config_.threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+ContourAligner::Alignment ContourAligner::align(const float* ref, int ref_frames,
+                                                const float* take, int take_frames, int dims) const {
+    if (!ref || !take) throw std::invalid_argument("contours must not be null");
+    if (ref_frames < 1 || take_frames < 1) throw std::invalid_argument("contours must not be empty");
+    if (dims < 1 || dims > kMaxDims) throw std::invalid_argument("dims must be in [1, kMaxDims]");
+
+    const Solver solver(ref, ref_frames, take, take_frames, dims, config_.band, config_.max_cost, config_.threads);
+    Alignment alignment;
+    alignment.path.reserve(static_cast<size_t>(ref_frames) + take_frames - 1);
+    solver.solve(0, 0, ref_frames - 1, take_frames - 1, alignment.path, 0);
+    for (const Step& step : alignment.path) alignment.cost += solver.cell_cost(step.ref, step.take);
+    return alignment;
+}
+
+std::vector<ContourAligner::NoteDeviation> ContourAligner::note_deviations(const float* ref_cents, int ref_frames,
+                                                                           const float* take_cents, int take_frames,
+                                                                           const std::vector<Step>& path,
+                                                                           int min_note_frames) {
+    if (!ref_cents || !take_cents || ref_frames < 1 || take_frames < 1) {
+        throw std::invalid_argument("contours must not be null or empty");
+    }
+    if (path.empty() || path.front().ref != 0 || path.front().take != 0 ||
+        path.back().ref != ref_frames - 1 || path.back().take != take_frames - 1) {
+        throw std::invalid_argument("path must run from (0, 0) to the last hop of both contours");
+    }
+    for (size_t s = 1; s < path.size(); ++s) {
+        const int dr = path[s].ref - path[s - 1].ref;
+        const int dt = path[s].take - path[s - 1].take;
+        if (dr < 0 || dr > 1 || dt < 0 || dt > 1 || dr + dt == 0) {
+            throw std::invalid_argument("path steps must advance by at most one hop");
+        }
+    }
+
+    const double tempo = ref_frames > 1 ? static_cast<double>(take_frames - 1) / (ref_frames - 1) : 0.0;
+    std::vector<NoteDeviation> notes;
+    size_t s = 0;   // First path step of the current note
+    int start = 0;
+    while (start < ref_frames) {
+        if (std::isnan(ref_cents[start])) {
+            ++start;
+            continue;
+        }
+        const int midi = static_cast<int>(std::lround(ref_cents[start] / 100.0f));
+        int end = start + 1;
+        while (end < ref_frames && !std::isnan(ref_cents[end]) &&
+               std::fabs(ref_cents[end] - 100.0f * midi) < kNoteChangeCents) {
+            ++end;
+        }
+        if (end - start >= min_note_frames) {
+            while (path[s].ref < start) ++s;
+            NoteDeviation note{};
+            note.midi_note  = midi;
+            note.ref_start  = start;
+            note.ref_end    = end;
+            note.take_start = path[s].take;
+            double error = 0.0;
+            for (; s < path.size() && path[s].ref < end; ++s) {
+                note.take_end = path[s].take + 1;
+                const float take = take_cents[path[s].take];
+                if (std::isnan(take)) continue;
+                error += take - ref_cents[path[s].ref];
+                ++note.voiced_frames;
+            }
+            note.cents_error    = note.voiced_frames > 0 ? static_cast<float>(error / note.voiced_frames) : 0.0f;
+            note.timing_error   = static_cast<float>(note.take_start - start * tempo);
+            note.duration_ratio = static_cast<float>(note.take_end - note.take_start) / (end - start);
+            notes.push_back(note);
+        }
+        start = end;
+    }
+    return notes;
+}
+
+} // namespace music_life
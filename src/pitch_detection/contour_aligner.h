@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Dynamic-time-warping alignment of a practice take against a reference
+ * take, on pitch contours (absolute cents, 100 * MIDI note, one value per
+ * hop, NaN when unvoiced) or chroma contours (ChromaAnalyzer::kPitchClasses
+ * values per hop).
+ *
+ * The distance between two hops is the sum over dimensions of
+ * |ref - take|, each term clamped to max_cost, so an octave error or a
+ * voiced hop against an unvoiced one costs a bounded amount and two unvoiced
+ * hops cost nothing.  Paths stay inside a Sakoe-Chiba band of band take hops
+ * either side of the line joining the first and last hops, widened if the
+ * tempo ratio would otherwise disconnect it.
+ *
+ * Cells on one anti-diagonal do not depend on each other, so the cost
+ * recurrence is evaluated a diagonal at a time with SIMD distance and
+ * minimum kernels, keeping only the last three diagonals.  The path is
+ * recovered Hirschberg-style: a forward and a backward sweep meet on the
+ * middle anti-diagonal, the best crossing splits the problem in two, and
+ * blocks of at most kDirectCells are solved with a full cost matrix.  Work
+ * is about twice one sweep of the band, memory O(band) per worker beyond
+ * the contours.  While sub-problems are large, the two sweeps and then the
+ * two halves run on separate threads.
+ *
+ * Usage:
+ *   ContourAligner aligner;                  // 300 hops: +-3 s at 100 hops/s
+ *   auto alignment = aligner.align(ref, n, take, m, 1);
+ *   auto notes = ContourAligner::note_deviations(ref, n, take, m, alignment.path);
+ */
+class ContourAligner {
+public:
+    static constexpr int     kMaxDims     = 12;
+    static constexpr int64_t kDirectCells = 1 << 14;   ///< Largest block solved with a full matrix
+    static constexpr float   kNoteChangeCents = 70.0f; ///< Distance from a note's centre that ends it
+
+    struct Config {
+        int   band     = 300;     ///< Sakoe-Chiba half-width in take hops, >= 1
+        float max_cost = 200.0f;  ///< Per-dimension distance clamp (cents for pitch)
+        int   threads  = 0;       ///< Worker threads; 0 picks the hardware concurrency
+    };
+
+    struct Step {
+        int32_t ref;
+        int32_t take;
+    };
+
+    struct Alignment {
+        /// From (0, 0) to (ref_frames - 1, take_frames - 1); each step
+        /// advances ref, take or both by one hop.
+        std::vector<Step> path;
+        double cost = 0.0;        ///< Sum of hop distances along the path
+    };
+
+    /** Intonation and timing of one reference note against the take. */
+    struct NoteDeviation {
+        int32_t midi_note;
+        int32_t ref_start;        ///< Reference hops [ref_start, ref_end)
+        int32_t ref_end;
+        int32_t take_start;       ///< Take hops aligned to the note [take_start, take_end)
+        int32_t take_end;
+        int32_t voiced_frames;    ///< Aligned pairs with both hops voiced
+        float   cents_error;      ///< Mean take - ref over those pairs; positive is sharp, 0 if none
+        float   timing_error;     ///< take_start minus the onset the overall tempo predicts, in hops; positive is late
+        float   duration_ratio;   ///< Take length over reference length
+    };
+
+    ContourAligner();
+    /** Throws std::invalid_argument unless band >= 1, max_cost is positive
+     *  and finite and threads >= 0. */
+    explicit ContourAligner(const Config& config);
+
+    /**
+     * Align two contours of `dims` values per hop, hop-major.  NaN values
+     * mark unvoiced hops.  Throws std::invalid_argument for null contours,
+     * empty contours or dims outside [1, kMaxDims].
+     */
+    Alignment align(const float* ref, int ref_frames, const float* take, int take_frames, int dims) const;
+
+    /**
+     * Split the reference pitch contour into notes and measure the take
+     * against each along `path`.  A note is a run of at least
+     * min_note_frames voiced hops within kNoteChangeCents of the semitone
+     * its first hop rounds to.  Throws std::invalid_argument for null
+     * contours or a path that does not fit them.
+     */
+    static std::vector<NoteDeviation> note_deviations(const float* ref_cents, int ref_frames,
+                                                      const float* take_cents, int take_frames,
+                                                      const std::vector<Step>& path,
+                                                      int min_note_frames = 3);
+
+    const Config& config() const { return config_; }
+
+private:
+    Config config_;
+};
+
+} // namespace music_life
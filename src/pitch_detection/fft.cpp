@@ -0,0 +1,411 @@
+#include "fft.h"
+
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE3__)
+#include <pmmintrin.h>
+#endif
+#if defined(ML_HAS_ACCELERATE)
+#include <Accelerate/Accelerate.h>
+#endif
+#if defined(ML_HAS_FFTW)
+#include <fftw3.h>
+#endif
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Backend selection and transforms (anonymous namespace)
+// ---------------------------------------------------------------------------
+
+namespace {
+
+static_assert(sizeof(std::complex<float>) == sizeof(float) * 2,
+              "SIMD complex operations require tightly packed std::complex<float>.");
+
+const char* backend_to_name(FftBackend backend) {
+    switch (backend) {
+        case FftBackend::Radix2: return "radix2";
+        case FftBackend::Accelerate: return "accelerate";
+        case FftBackend::Fftw: return "fftw";
+        default: return "auto";
+    }
+}
+
+bool backend_available(FftBackend backend) {
+    switch (backend) {
+        case FftBackend::Accelerate:
+#if defined(ML_HAS_ACCELERATE)
+            return true;
+#else
+            return false;
+#endif
+        case FftBackend::Fftw:
+#if defined(ML_HAS_FFTW)
+            return true;
+#else
+            return false;
+#endif
+        case FftBackend::Radix2:
+        case FftBackend::Auto:
+        default:
+            return true;
+    }
+}
+
+FftBackend parse_requested_backend() {
+    const char* env = std::getenv("ML_FFT_BACKEND");
+    if (env == nullptr || *env == '\0') {
+        return FftBackend::Auto;
+    }
+    const std::string value(env);
+    if (value == "radix2" || value == "manual") return FftBackend::Radix2;
+    if (value == "accelerate") return FftBackend::Accelerate;
+    if (value == "fftw") return FftBackend::Fftw;
+    return FftBackend::Auto;
+}
+
+FftBackend resolve_backend(FftBackend requested) {
+    if (requested == FftBackend::Auto) requested = parse_requested_backend();
+    if (requested != FftBackend::Auto) {
+        return backend_available(requested) ? requested : FftBackend::Radix2;
+    }
+#if defined(ML_HAS_ACCELERATE)
+    return FftBackend::Accelerate;
+#elif defined(ML_HAS_FFTW)
+    return FftBackend::Fftw;
+#else
+    return FftBackend::Radix2;
+#endif
+}
+
+// In-place Cooley-Tukey radix-2 DIT FFT.  n must be a power of two.
+void fft_stage_len2(std::vector<std::complex<float>>& x) {
+    const int n = static_cast<int>(x.size());
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 1 < n; i += 2) {
+        const float32x4_t uv = vld1q_f32(reinterpret_cast<const float*>(x.data() + i));
+        const float32x2_t u = vget_low_f32(uv);
+        const float32x2_t v = vget_high_f32(uv);
+        vst1_f32(reinterpret_cast<float*>(x.data() + i), vadd_f32(u, v));
+        vst1_f32(reinterpret_cast<float*>(x.data() + i + 1), vsub_f32(u, v));
+    }
+#elif defined(__SSE3__)
+    for (; i + 1 < n; i += 2) {
+        const __m128 uv = _mm_loadu_ps(reinterpret_cast<const float*>(x.data() + i));
+        const __m128 u = _mm_movelh_ps(uv, uv);
+        const __m128 v = _mm_movehl_ps(uv, uv);
+        const __m128 sum = _mm_add_ps(u, v);
+        const __m128 diff = _mm_sub_ps(u, v);
+        x[static_cast<size_t>(i)] = {
+            _mm_cvtss_f32(sum),
+            _mm_cvtss_f32(_mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)))
+        };
+        x[static_cast<size_t>(i + 1)] = {
+            _mm_cvtss_f32(diff),
+            _mm_cvtss_f32(_mm_shuffle_ps(diff, diff, _MM_SHUFFLE(1, 1, 1, 1)))
+        };
+    }
+#endif
+    for (; i + 1 < n; i += 2) {
+        const std::complex<float> u = x[static_cast<size_t>(i)];
+        const std::complex<float> v = x[static_cast<size_t>(i + 1)];
+        x[static_cast<size_t>(i)] = u + v;
+        x[static_cast<size_t>(i + 1)] = u - v;
+    }
+}
+
+void fft_inplace_radix2(std::vector<std::complex<float>>& x,
+                        const std::vector<std::complex<float>>& twiddle) {
+    const int n = static_cast<int>(x.size());
+
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(x[i], x[j]);
+    }
+
+    // Butterfly passes – twiddle factor for butterfly j in stage len is
+    // W_len^j = W_n^(j*n/len) = twiddle[j * (n/len)].
+    // No transcendental calls in the hot path.
+    fft_stage_len2(x);
+    for (int len = 4; len <= n; len <<= 1) {
+        const int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < len / 2; ++j) {
+                const std::complex<float> w = twiddle[j * step];
+                const std::complex<float> u = x[i + j];
+                const std::complex<float> v = x[i + j + len / 2] * w;
+                x[i + j]           = u + v;
+                x[i + j + len / 2] = u - v;
+            }
+        }
+    }
+}
+
+// In-place IFFT via conjugate trick.
+void ifft_inplace_radix2(std::vector<std::complex<float>>& x,
+                         const std::vector<std::complex<float>>& twiddle) {
+    for (auto& c : x) c = std::conj(c);
+    fft_inplace_radix2(x, twiddle);
+    const float inv_n = 1.0f / static_cast<float>(x.size());
+    for (auto& c : x) c = std::conj(c) * inv_n;
+}
+
+#if defined(ML_HAS_ACCELERATE)
+void fft_inplace_accelerate(std::vector<std::complex<float>>& x,
+                            vDSP_DFT_Setup setup,
+                            std::vector<float>& in_real,
+                            std::vector<float>& in_imag,
+                            std::vector<float>& out_real,
+                            std::vector<float>& out_imag) {
+    const int n = static_cast<int>(x.size());
+    for (int i = 0; i < n; ++i) {
+        in_real[static_cast<size_t>(i)] = x[static_cast<size_t>(i)].real();
+        in_imag[static_cast<size_t>(i)] = x[static_cast<size_t>(i)].imag();
+    }
+    vDSP_DFT_Execute(setup,
+                     in_real.data(),
+                     in_imag.data(),
+                     out_real.data(),
+                     out_imag.data());
+    for (int i = 0; i < n; ++i) {
+        x[static_cast<size_t>(i)] = {out_real[static_cast<size_t>(i)], out_imag[static_cast<size_t>(i)]};
+    }
+}
+#endif
+
+#if defined(ML_HAS_FFTW)
+void fft_inplace_fftw(std::vector<std::complex<float>>& x, void* fftw_plan) {
+    fftwf_complex* data = reinterpret_cast<fftwf_complex*>(x.data());
+    fftwf_execute_dft(static_cast<fftwf_plan>(fftw_plan), data, data);
+}
+#endif
+
+void fft_inplace(std::vector<std::complex<float>>& x,
+                 const std::vector<std::complex<float>>& twiddle,
+                 FftBackend backend,
+                 void* accelerate_setup,
+                 void* fftw_plan,
+                 std::vector<float>* accelerate_in_real,
+                 std::vector<float>* accelerate_in_imag,
+                 std::vector<float>* accelerate_out_real,
+                 std::vector<float>* accelerate_out_imag) {
+    (void)accelerate_setup;
+    (void)fftw_plan;
+    (void)accelerate_in_real;
+    (void)accelerate_in_imag;
+    (void)accelerate_out_real;
+    (void)accelerate_out_imag;
+    switch (backend) {
+        case FftBackend::Accelerate:
+#if defined(ML_HAS_ACCELERATE)
+            fft_inplace_accelerate(x,
+                                   static_cast<vDSP_DFT_Setup>(accelerate_setup),
+                                   *accelerate_in_real,
+                                   *accelerate_in_imag,
+                                   *accelerate_out_real,
+                                   *accelerate_out_imag);
+            return;
+#else
+            break;
+#endif
+        case FftBackend::Fftw:
+#if defined(ML_HAS_FFTW)
+            fft_inplace_fftw(x, fftw_plan);
+            return;
+#else
+            break;
+#endif
+        case FftBackend::Radix2:
+        case FftBackend::Auto:
+        default:
+            fft_inplace_radix2(x, twiddle);
+            return;
+    }
+    fft_inplace_radix2(x, twiddle);
+}
+
+void ifft_inplace(std::vector<std::complex<float>>& x,
+                  const std::vector<std::complex<float>>& twiddle,
+                  FftBackend backend,
+                  void* accelerate_setup,
+                  void* fftw_plan,
+                  std::vector<float>* accelerate_in_real,
+                  std::vector<float>* accelerate_in_imag,
+                  std::vector<float>* accelerate_out_real,
+                  std::vector<float>* accelerate_out_imag) {
+    (void)accelerate_setup;
+    (void)fftw_plan;
+    (void)accelerate_in_real;
+    (void)accelerate_in_imag;
+    (void)accelerate_out_real;
+    (void)accelerate_out_imag;
+    switch (backend) {
+        case FftBackend::Accelerate:
+#if defined(ML_HAS_ACCELERATE)
+            fft_inplace_accelerate(x,
+                                   static_cast<vDSP_DFT_Setup>(accelerate_setup),
+                                   *accelerate_in_real,
+                                   *accelerate_in_imag,
+                                   *accelerate_out_real,
+                                   *accelerate_out_imag);
+            for (auto& c : x) c /= static_cast<float>(x.size());
+            return;
+#else
+            break;
+#endif
+        case FftBackend::Fftw:
+#if defined(ML_HAS_FFTW)
+            fft_inplace_fftw(x, fftw_plan);
+            for (auto& c : x) c /= static_cast<float>(x.size());
+            return;
+#else
+            break;
+#endif
+        case FftBackend::Radix2:
+        case FftBackend::Auto:
+        default:
+            ifft_inplace_radix2(x, twiddle);
+            return;
+    }
+    ifft_inplace_radix2(x, twiddle);
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+Fft::Fft(int size, FftBackend backend)
+    : size_(size)
+    , twiddle_(size > 0 ? size / 2 : 0)
+    , backend_(resolve_backend(backend))
+    , accelerate_forward_setup_(nullptr)
+    , accelerate_inverse_setup_(nullptr)
+    , fftw_forward_plan_(nullptr)
+    , fftw_inverse_plan_(nullptr)
+    , fftw_plan_buffer_(size > 0 ? size : 0, {0.0f, 0.0f})
+    , accelerate_in_real_(size > 0 ? size : 0, 0.0f)
+    , accelerate_in_imag_(size > 0 ? size : 0, 0.0f)
+    , accelerate_out_real_(size > 0 ? size : 0, 0.0f)
+    , accelerate_out_imag_(size > 0 ? size : 0, 0.0f)
+{
+    if (size < 2 || (size & (size - 1)) != 0) {
+        throw std::invalid_argument("FFT size must be a power of two >= 2");
+    }
+
+    // Pre-compute twiddle factors: twiddle_[k] = exp(-2pi*i*k / size_).
+    // These are computed once here so the real-time audio path is free of
+    // any std::cos / std::sin calls during FFT butterfly passes.
+    const float two_pi_over_n =
+        -2.0f * static_cast<float>(M_PI) / static_cast<float>(size_);
+    for (int k = 0; k < size_ / 2; ++k) {
+        const float ang = two_pi_over_n * static_cast<float>(k);
+        twiddle_[k] = {std::cos(ang), std::sin(ang)};
+    }
+
+#if defined(ML_HAS_ACCELERATE)
+    if (backend_ == FftBackend::Accelerate) {
+        accelerate_forward_setup_ = static_cast<void*>(vDSP_DFT_zop_CreateSetup(
+            nullptr, static_cast<vDSP_Length>(size_), vDSP_DFT_FORWARD));
+        accelerate_inverse_setup_ = static_cast<void*>(vDSP_DFT_zop_CreateSetup(
+            nullptr, static_cast<vDSP_Length>(size_), vDSP_DFT_INVERSE));
+        if (accelerate_forward_setup_ == nullptr || accelerate_inverse_setup_ == nullptr) {
+            if (accelerate_forward_setup_ != nullptr) {
+                vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_forward_setup_));
+                accelerate_forward_setup_ = nullptr;
+            }
+            if (accelerate_inverse_setup_ != nullptr) {
+                vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_inverse_setup_));
+                accelerate_inverse_setup_ = nullptr;
+            }
+            backend_ = FftBackend::Radix2;
+        }
+    }
+#endif
+
+#if defined(ML_HAS_FFTW)
+    if (backend_ == FftBackend::Fftw) {
+        fftwf_complex* plan_data = reinterpret_cast<fftwf_complex*>(fftw_plan_buffer_.data());
+        fftw_forward_plan_ = static_cast<void*>(fftwf_plan_dft_1d(
+            size_, plan_data, plan_data, FFTW_FORWARD, FFTW_MEASURE));
+        fftw_inverse_plan_ = static_cast<void*>(fftwf_plan_dft_1d(
+            size_, plan_data, plan_data, FFTW_BACKWARD, FFTW_MEASURE));
+        if (fftw_forward_plan_ == nullptr || fftw_inverse_plan_ == nullptr) {
+            if (fftw_forward_plan_ != nullptr) {
+                fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_forward_plan_));
+                fftw_forward_plan_ = nullptr;
+            }
+            if (fftw_inverse_plan_ != nullptr) {
+                fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_inverse_plan_));
+                fftw_inverse_plan_ = nullptr;
+            }
+            backend_ = FftBackend::Radix2;
+        }
+    }
+#endif
+}
+
+Fft::~Fft() {
+#if defined(ML_HAS_ACCELERATE)
+    if (accelerate_forward_setup_ != nullptr) {
+        vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_forward_setup_));
+    }
+    if (accelerate_inverse_setup_ != nullptr) {
+        vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_inverse_setup_));
+    }
+#endif
+#if defined(ML_HAS_FFTW)
+    if (fftw_forward_plan_ != nullptr) {
+        fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_forward_plan_));
+    }
+    if (fftw_inverse_plan_ != nullptr) {
+        fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_inverse_plan_));
+    }
+#endif
+}
+
+const char* Fft::backend_name() const {
+    return backend_to_name(backend_);
+}
+
+// ---------------------------------------------------------------------------
+// Transforms
+// ---------------------------------------------------------------------------
+
+void Fft::forward(std::vector<std::complex<float>>& x) const {
+    fft_inplace(x,
+                twiddle_,
+                backend_,
+                accelerate_forward_setup_,
+                fftw_forward_plan_,
+                &accelerate_in_real_,
+                &accelerate_in_imag_,
+                &accelerate_out_real_,
+                &accelerate_out_imag_);
+}
+
+void Fft::inverse(std::vector<std::complex<float>>& x) const {
+    ifft_inplace(x,
+                 twiddle_,
+                 backend_,
+                 accelerate_inverse_setup_,
+                 fftw_inverse_plan_,
+                 &accelerate_in_real_,
+                 &accelerate_in_imag_,
+                 &accelerate_out_real_,
+                 &accelerate_out_imag_);
+}
+
+} // namespace music_life
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+namespace music_life {
+
+enum class FftBackend {
+    Auto,
+    Radix2,
+    Accelerate,
+    Fftw
+};
+
+/**
+ * In-place complex FFT of a fixed power-of-two size.
+ *
+ * Selects Accelerate (Apple), FFTW or the built-in radix-2 implementation at
+ * construction (overridable with the ML_FFT_BACKEND environment variable, or
+ * per instance with an explicit backend) and owns the corresponding plans and pre-computed twiddle factors, so the
+ * real-time path never allocates or calls std::cos / std::sin.
+ *
+ * transform() is not reentrant: backend scratch buffers are shared, so each
+ * real-time thread needs its own Fft instance.
+ */
+class Fft {
+public:
+    /**
+     * @param size     Transform length; must be a power of two.
+     * @param backend  Auto follows ML_FFT_BACKEND and the platform default;
+     *                 a backend that is not built in falls back to Radix2.
+     */
+    explicit Fft(int size, FftBackend backend = FftBackend::Auto);
+    ~Fft();
+
+    Fft(const Fft&) = delete;
+    Fft& operator=(const Fft&) = delete;
+
+    /** Forward transform of x (x.size() == size()). */
+    void forward(std::vector<std::complex<float>>& x) const;
+
+    /** Inverse transform of x, scaled by 1 / size(). */
+    void inverse(std::vector<std::complex<float>>& x) const;
+
+    int size() const { return size_; }
+    FftBackend backend() const { return backend_; }
+    const char* backend_name() const;
+
+    /** twiddles()[k] = exp(-2*pi*i*k / size()) for k in [0, size() / 2). */
+    const std::vector<std::complex<float>>& twiddles() const { return twiddle_; }
+
+private:
+    int size_;
+    std::vector<std::complex<float>> twiddle_;
+    FftBackend backend_;
+
+    void* accelerate_forward_setup_;
+    void* accelerate_inverse_setup_;
+    void* fftw_forward_plan_;
+    void* fftw_inverse_plan_;
+    std::vector<std::complex<float>> fftw_plan_buffer_;
+    mutable std::vector<float> accelerate_in_real_;
+    mutable std::vector<float> accelerate_in_imag_;
+    mutable std::vector<float> accelerate_out_real_;
+    mutable std::vector<float> accelerate_out_imag_;
+};
+
+} // namespace music_life
@@ -0,0 +1,244 @@
+#include "mirrored_ring_buffer.h"
+#include "biquad_cascade.h"
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <unistd.h>
+#define ML_MIRRORED_RING_MACH 1
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(SYS_memfd_create)
+#define ML_MIRRORED_RING_MEMFD 1
+#endif
+#endif
+
+namespace music_life {
+
+namespace {
+
+#if defined(ML_MIRRORED_RING_MEMFD)
+constexpr unsigned int kMemfdCloexec = 0x0001U;  // MFD_CLOEXEC
+#endif
+
+size_t round_up_to_pages(size_t bytes) {
+#if defined(ML_MIRRORED_RING_MACH) || defined(ML_MIRRORED_RING_MEMFD)
+    const long page = ::sysconf(_SC_PAGESIZE);
+    const size_t page_size = page > 0 ? static_cast<size_t>(page) : 4096;
+    return ((bytes + page_size - 1) / page_size) * page_size;
+#else
+    return bytes;
+#endif
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Construction / destruction
+// ---------------------------------------------------------------------------
+
+MirroredRingBuffer::MirroredRingBuffer(int min_capacity, bool allow_mirroring)
+    : data_(nullptr)
+    , capacity_(0)
+    , write_pos_(0)
+    , mirrored_(false)
+    , mapping_bytes_(0)
+{
+    if (min_capacity <= 0) throw std::invalid_argument("min_capacity must be > 0");
+
+    if (allow_mirroring && map_mirrored(min_capacity)) {
+        mirrored_ = true;
+        return;
+    }
+
+    // Write-twice fallback: samples land in both halves so that any window of
+    // up to capacity_ samples is contiguous starting in the first half.
+    capacity_ = min_capacity;
+    fallback_.assign(static_cast<size_t>(capacity_) * 2, 0.0f);
+    data_ = fallback_.data();
+}
+
+MirroredRingBuffer::~MirroredRingBuffer() {
+    if (mirrored_) {
+        unmap_mirrored();
+    }
+}
+
+bool MirroredRingBuffer::map_mirrored(int min_capacity) {
+#if defined(ML_MIRRORED_RING_MACH)
+    const size_t bytes = round_up_to_pages(static_cast<size_t>(min_capacity) * sizeof(float));
+    const mach_port_t task = mach_task_self();
+
+    vm_address_t base = 0;
+    if (vm_allocate(task, &base, bytes * 2, VM_FLAGS_ANYWHERE) != KERN_SUCCESS) {
+        return false;
+    }
+    if (vm_deallocate(task, base + bytes, bytes) != KERN_SUCCESS) {
+        vm_deallocate(task, base, bytes * 2);
+        return false;
+    }
+    vm_address_t mirror = base + bytes;
+    vm_prot_t cur_protection = VM_PROT_NONE;
+    vm_prot_t max_protection = VM_PROT_NONE;
+    const kern_return_t remapped = vm_remap(task, &mirror, bytes, 0, VM_FLAGS_FIXED,
+                                            task, base, FALSE,
+                                            &cur_protection, &max_protection,
+                                            VM_INHERIT_DEFAULT);
+    if (remapped != KERN_SUCCESS || mirror != base + bytes) {
+        if (remapped == KERN_SUCCESS) {
+            vm_deallocate(task, mirror, bytes);
+        }
+        vm_deallocate(task, base, bytes);
+        return false;
+    }
+
+    data_ = reinterpret_cast<float*>(base);
+    mapping_bytes_ = bytes;
+    capacity_ = static_cast<int>(bytes / sizeof(float));
+    return true;
+#elif defined(ML_MIRRORED_RING_MEMFD)
+    const size_t bytes = round_up_to_pages(static_cast<size_t>(min_capacity) * sizeof(float));
+    const int fd = static_cast<int>(::syscall(SYS_memfd_create, "music_life_ring", kMemfdCloexec));
+    if (fd < 0) {
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Reserve a 2x region first so both halves are guaranteed to be adjacent.
+    void* base = ::mmap(nullptr, bytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    auto* bytes_base = static_cast<unsigned char*>(base);
+    void* lower = ::mmap(bytes_base, bytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, fd, 0);
+    void* upper = lower == MAP_FAILED
+        ? MAP_FAILED
+        : ::mmap(bytes_base + bytes, bytes, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, fd, 0);
+    ::close(fd);
+    if (lower != bytes_base || upper != bytes_base + bytes) {
+        ::munmap(base, bytes * 2);
+        return false;
+    }
+
+    data_ = static_cast<float*>(base);
+    mapping_bytes_ = bytes;
+    capacity_ = static_cast<int>(bytes / sizeof(float));
+    return true;
+#else
+    (void)min_capacity;
+    (void)round_up_to_pages;
+    return false;
+#endif
+}
+
+void MirroredRingBuffer::unmap_mirrored() {
+#if defined(ML_MIRRORED_RING_MACH)
+    vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(data_), mapping_bytes_ * 2);
+#elif defined(ML_MIRRORED_RING_MEMFD)
+    ::munmap(data_, mapping_bytes_ * 2);
+#endif
+    data_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void MirroredRingBuffer::write(const float* samples, int num_samples, BiquadCascade* filter) {
+    // Only the newest capacity_ samples can survive; skip the rest up front.
+    // A filter has to see every sample, so then nothing is skipped.
+    if (num_samples > capacity_ && filter == nullptr) {
+        const int skipped = num_samples - capacity_;
+        samples += skipped;
+        write_pos_ = static_cast<int>((static_cast<long long>(write_pos_) + skipped) % capacity_);
+        num_samples = capacity_;
+    }
+
+    int input_offset = 0;
+    int remaining = num_samples;
+    while (remaining > 0) {
+        // In mirrored mode a chunk may run past capacity_ into the mirror,
+        // which aliases the start of the ring, so one copy always suffices.
+        // The fallback copies in wrap-sized chunks and writes each twice.
+        // The filter writes its output straight into the ring.
+        const int chunk = mirrored_ ? std::min(remaining, capacity_) : std::min(remaining, capacity_ - write_pos_);
+        const size_t chunk_bytes = static_cast<size_t>(chunk) * sizeof(float);
+        if (filter != nullptr) {
+            filter->process(samples + input_offset, data_ + write_pos_, chunk);
+        } else {
+            std::memcpy(data_ + write_pos_, samples + input_offset, chunk_bytes);
+        }
+        if (!mirrored_) {
+            std::memcpy(data_ + write_pos_ + capacity_, data_ + write_pos_, chunk_bytes);
+        }
+        write_pos_ += chunk;
+        if (write_pos_ >= capacity_) {
+            write_pos_ -= capacity_;
+        }
+        input_offset += chunk;
+        remaining -= chunk;
+    }
+}
+
+void MirroredRingBuffer::write_interleaved(const float* samples,
+                                           int num_frames,
+                                           int channels,
+                                           const float* weights,
+                                           int channel,
+                                           BiquadCascade* filter) {
+    if (num_frames > capacity_ && filter == nullptr) {
+        const int skipped = num_frames - capacity_;
+        samples += static_cast<ptrdiff_t>(skipped) * channels;
+        write_pos_ = static_cast<int>((static_cast<long long>(write_pos_) + skipped) % capacity_);
+        num_frames = capacity_;
+    }
+
+    int remaining = num_frames;
+    while (remaining > 0) {
+        // Same chunking as write(); the fallback mirrors the folded samples
+        // from the first half rather than folding twice.  A filter runs in
+        // place on the folded chunk while it is still in cache.
+        const int chunk = mirrored_ ? std::min(remaining, capacity_) : std::min(remaining, capacity_ - write_pos_);
+        simd::deinterleave(samples, channels, weights, channel, data_ + write_pos_, chunk);
+        if (filter != nullptr) {
+            filter->process(data_ + write_pos_, data_ + write_pos_, chunk);
+        }
+        if (!mirrored_) {
+            std::memcpy(data_ + write_pos_ + capacity_, data_ + write_pos_, static_cast<size_t>(chunk) * sizeof(float));
+        }
+        write_pos_ += chunk;
+        if (write_pos_ >= capacity_) {
+            write_pos_ -= capacity_;
+        }
+        samples += static_cast<ptrdiff_t>(chunk) * channels;
+        remaining -= chunk;
+    }
+}
+
+const float* MirroredRingBuffer::latest(int num_samples) const {
+    const int start = write_pos_ >= num_samples
+        ? write_pos_ - num_samples
+        : write_pos_ - num_samples + capacity_;
+    return data_ + start;
+}
+
+void MirroredRingBuffer::clear() {
+    // Zeroing the first half also zeroes the mirror in mapped mode.
+    const int span = mirrored_ ? capacity_ : capacity_ * 2;
+    std::fill(data_, data_ + span, 0.0f);
+    write_pos_ = 0;
+}
+
+} // namespace music_life
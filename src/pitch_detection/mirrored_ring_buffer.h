@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace music_life {
+
+class BiquadCascade;
+
+/**
+ * Single-producer float ring buffer whose most recent samples are always
+ * addressable as one contiguous span.
+ *
+ * Where the platform allows it (Linux, Android, iOS/macOS) the same physical
+ * pages are mapped twice back-to-back in virtual memory, so a read that runs
+ * past the end of the ring transparently continues at its start.  Elsewhere,
+ * or if the mapping fails at runtime, a heap buffer of twice the capacity is
+ * used and every sample is written to both halves instead.
+ *
+ * Either way latest(n) returns a pointer that can be handed straight to
+ * Yin::detect() without assembling a separate frame buffer.
+ */
+class MirroredRingBuffer {
+public:
+    /**
+     * @param min_capacity     Minimum number of samples the ring must hold.
+     *                         The mirrored mapping rounds this up to a whole
+     *                         number of pages.
+     * @param allow_mirroring  Pass false to force the write-twice fallback.
+     */
+    explicit MirroredRingBuffer(int min_capacity, bool allow_mirroring = true);
+    ~MirroredRingBuffer();
+
+    MirroredRingBuffer(const MirroredRingBuffer&) = delete;
+    MirroredRingBuffer& operator=(const MirroredRingBuffer&) = delete;
+
+    /** Append num_samples samples, overwriting the oldest data.  With a
+     *  filter, the samples pass through it on their way into the ring, so
+     *  filtering costs no separate pass; every sample is then filtered,
+     *  even those an oversized write overwrites again. */
+    void write(const float* samples, int num_samples, BiquadCascade* filter = nullptr);
+
+    /**
+     * Append num_frames frames of interleaved input, folded to mono by
+     * simd::deinterleave() straight into the ring: a weighted downmix, or
+     * with null weights the given channel alone.  No intermediate buffer.
+     * A filter runs in place on each folded chunk.
+     */
+    void write_interleaved(const float* samples, int num_frames, int channels, const float* weights, int channel,
+                           BiquadCascade* filter = nullptr);
+
+    /**
+     * Pointer to the most recent num_samples samples in chronological order.
+     * num_samples must not exceed capacity().  The span stays valid until the
+     * next write() or clear().
+     */
+    const float* latest(int num_samples) const;
+
+    /** Zero the contents and rewind the write position. */
+    void clear();
+
+    int  capacity() const { return capacity_; }
+    bool is_mirrored() const { return mirrored_; }
+
+private:
+    float* data_;
+    int    capacity_;
+    int    write_pos_;
+    bool   mirrored_;
+    size_t mapping_bytes_;   ///< Size of one half of the mirrored mapping
+    std::vector<float> fallback_;
+
+    bool map_mirrored(int min_capacity);
+    void unmap_mirrored();
+};
+
+} // namespace music_life
@@ -0,0 +1,173 @@
+#include "note_segmenter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+NoteSegmenter::NoteSegmenter()
+    : NoteSegmenter(Config{})
+{
+}
+
+NoteSegmenter::NoteSegmenter(const Config& config)
+    : config_(config)
+    , reset_pending_(false)
+    , pitch_window_{}
+    , pitch_count_(0)
+    , pitch_pos_(0)
+    , active_note_(-1)
+    , last_bend_cents_(0.0f)
+    , quiet_hops_(0)
+    , quiet_start_sample_(0)
+    , candidate_note_(-1)
+    , candidate_hops_(0)
+    , candidate_start_sample_(0)
+{
+    if (!(config.on_probability >= 0.0f && config.on_probability <= 1.0f) ||
+        !(config.off_probability >= 0.0f && config.off_probability <= config.on_probability)) {
+        throw std::invalid_argument("probabilities must satisfy 0 <= off_probability <= on_probability <= 1");
+    }
+    if (!(config.change_cents > 0.0f) || !(config.bend_cents > 0.0f)) {
+        throw std::invalid_argument("change_cents and bend_cents must be > 0");
+    }
+    if (config.min_note_hops < 1 || config.release_hops < 1) {
+        throw std::invalid_argument("min_note_hops and release_hops must be >= 1");
+    }
+    if (config.median_window < 1 || config.median_window > kMaxMedianWindow) {
+        throw std::invalid_argument("median_window must be in [1, 15]");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void NoteSegmenter::reset() {
+    reset_pending_.store(true, std::memory_order_release);
+}
+
+int NoteSegmenter::push(const PitchDetector::Result& result, int64_t end_sample, Event* out) {
+    apply_pending_reset();
+
+    const bool pitched = result.pitched && std::isfinite(result.cents_offset);
+    const float probability = result.probability;
+
+    if (active_note_ < 0) {
+        if (!pitched || probability < config_.on_probability) {
+            pitch_count_ = 0;
+            clear_candidate();
+            return 0;
+        }
+    } else if (!pitched || probability < config_.off_probability) {
+        // Release hysteresis: a short dropout does not end the note.
+        if (quiet_hops_ == 0) quiet_start_sample_ = end_sample;
+        if (++quiet_hops_ < config_.release_hops) return 0;
+
+        out[0] = Event{NoteEventType::NoteOff, active_note_, last_bend_cents_, probability, quiet_start_sample_};
+        active_note_ = -1;
+        quiet_hops_  = 0;
+        pitch_count_ = 0;
+        clear_candidate();
+        return 1;
+    }
+    quiet_hops_ = 0;
+
+    pitch_window_[pitch_pos_] = static_cast<float>(result.midi_note) + result.cents_offset / 100.0f;
+    pitch_pos_ = (pitch_pos_ + 1) % config_.median_window;
+    pitch_count_ = std::min(pitch_count_ + 1, config_.median_window);
+
+    const float pitch = median_pitch();
+    const int nearest = static_cast<int>(std::lround(pitch));
+
+    if (active_note_ >= 0) {
+        const float deviation = (pitch - static_cast<float>(active_note_)) * 100.0f;
+        if (std::fabs(deviation) <= config_.change_cents) {
+            clear_candidate();
+            if (std::fabs(deviation - last_bend_cents_) < config_.bend_cents) return 0;
+            last_bend_cents_ = deviation;
+            out[0] = Event{NoteEventType::PitchBend, active_note_, deviation, probability, end_sample};
+            return 1;
+        }
+    }
+
+    // A new pitch must persist for min_note_hops frames before it is reported.
+    if (nearest != candidate_note_) {
+        candidate_note_ = nearest;
+        candidate_hops_ = 0;
+        candidate_start_sample_ = end_sample;
+    }
+    if (++candidate_hops_ < config_.min_note_hops) return 0;
+
+    int count = 0;
+    if (active_note_ >= 0) {
+        out[count++] = Event{NoteEventType::NoteOff, active_note_, last_bend_cents_, probability,
+                             candidate_start_sample_};
+    }
+    active_note_     = nearest;
+    last_bend_cents_ = (pitch - static_cast<float>(nearest)) * 100.0f;
+    out[count++] = Event{NoteEventType::NoteOn, active_note_, last_bend_cents_, probability, candidate_start_sample_};
+    clear_candidate();
+    return count;
+}
+
+int NoteSegmenter::flush(int64_t end_sample, Event* out) {
+    apply_pending_reset();
+    if (active_note_ < 0) return 0;
+
+    out[0] = Event{NoteEventType::NoteOff, active_note_, last_bend_cents_, 0.0f, end_sample};
+    active_note_ = -1;
+    quiet_hops_  = 0;
+    pitch_count_ = 0;
+    clear_candidate();
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+void NoteSegmenter::apply_pending_reset() {
+    if (reset_pending_.exchange(false, std::memory_order_acq_rel)) {
+        pitch_count_     = 0;
+        pitch_pos_       = 0;
+        active_note_     = -1;
+        last_bend_cents_ = 0.0f;
+        quiet_hops_      = 0;
+        clear_candidate();
+    }
+}
+
+float NoteSegmenter::median_pitch() const {
+    // The window holds the most recent pitch_count_ entries ending at pitch_pos_.
+    float sorted[kMaxMedianWindow];
+    for (int i = 0; i < pitch_count_; ++i) {
+        const int index = (pitch_pos_ - 1 - i + config_.median_window) % config_.median_window;
+        sorted[i] = pitch_window_[index];
+    }
+    // Insertion sort on the stack; the window holds at most kMaxMedianWindow values.
+    for (int i = 1; i < pitch_count_; ++i) {
+        const float value = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > value) {
+            sorted[j + 1] = sorted[j];
+            --j;
+        }
+        sorted[j + 1] = value;
+    }
+    if (pitch_count_ % 2 == 1) return sorted[pitch_count_ / 2];
+    return 0.5f * (sorted[pitch_count_ / 2 - 1] + sorted[pitch_count_ / 2]);
+}
+
+void NoteSegmenter::clear_candidate() {
+    candidate_note_ = -1;
+    candidate_hops_ = 0;
+    candidate_start_sample_ = 0;
+}
+
+} // namespace music_life
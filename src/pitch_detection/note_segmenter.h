@@ -0,0 +1,100 @@
+#pragma once
+
+#include "pitch_detector.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace music_life {
+
+enum class NoteEventType {
+    NoteOn,
+    NoteOff,
+    PitchBend
+};
+
+/**
+ * Turns the per-hop PitchDetector::Result stream into note events.
+ *
+ * A note starts once min_note_hops consecutive confident frames agree on a
+ * semitone (on_probability), is held while frames stay above the lower
+ * off_probability, and ends after release_hops unconfident frames.  Pitch is
+ * median-filtered over the last median_window voiced frames; the held note
+ * changes only when the median moves more than change_cents away from it for
+ * min_note_hops frames, and pitch bends are reported when the median cents
+ * move by at least bend_cents.  No allocation after construction.
+ *
+ * Usage:
+ *   NoteSegmenter segmenter;
+ *   NoteSegmenter::Event events[NoteSegmenter::kMaxEventsPerHop];
+ *   int n = segmenter.push(result, end_sample, events);
+ */
+class NoteSegmenter {
+public:
+    static constexpr int kMaxEventsPerHop = 2;
+    static constexpr int kMaxMedianWindow = 15;
+
+    struct Config {
+        float on_probability  = 0.85f; ///< Confidence needed to start a note
+        float off_probability = 0.6f;  ///< Confidence needed to sustain a note
+        float change_cents    = 70.0f; ///< Deviation from the held note that starts a note change
+        float bend_cents      = 10.0f; ///< Minimum cents movement reported as a pitch bend
+        int   min_note_hops   = 3;     ///< Frames a new pitch must persist before note-on
+        int   release_hops    = 2;     ///< Unconfident frames before note-off
+        int   median_window   = 5;     ///< Voiced frames in the pitch median [1, kMaxMedianWindow]
+    };
+
+    struct Event {
+        NoteEventType type;
+        int     midi_note;
+        float   cents;           ///< Median offset from midi_note in cents
+        float   probability;
+        int64_t sample_position; ///< End sample of the frame that supports the event
+    };
+
+    NoteSegmenter();
+    explicit NoteSegmenter(const Config& config);
+
+    /**
+     * Add one hop.
+     *
+     * @param result      Frame result from PitchDetector.
+     * @param end_sample  Absolute index one past the frame's last sample.
+     * @param out         Receives up to kMaxEventsPerHop events.
+     * @return Number of events written.
+     */
+    int push(const PitchDetector::Result& result, int64_t end_sample, Event* out);
+
+    /** End the held note, if any, at end_sample.  Returns 0 or 1 events. */
+    int flush(int64_t end_sample, Event* out);
+
+    /** Request a reset; applied at the start of the next push() call. */
+    void reset();
+
+    const Config& config() const { return config_; }
+    /** MIDI note currently held, or -1. */
+    int active_note() const { return active_note_; }
+
+private:
+    Config config_;
+    std::atomic<bool> reset_pending_;
+
+    float   pitch_window_[kMaxMedianWindow];
+    int     pitch_count_;
+    int     pitch_pos_;
+
+    int     active_note_;
+    float   last_bend_cents_;
+    int     quiet_hops_;
+    int64_t quiet_start_sample_;
+
+    int     candidate_note_;
+    int     candidate_hops_;
+    int64_t candidate_start_sample_;
+
+    void  apply_pending_reset();
+    float median_pitch() const;
+    void  clear_candidate();
+};
+
+} // namespace music_life
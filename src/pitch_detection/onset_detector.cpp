@@ -0,0 +1,215 @@
+#include "onset_detector.h"
+
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr float kPi = 3.14159265358979323846f;
+static constexpr float kLogCompression     = 100.0f;  // gamma in log(1 + gamma * |X|)
+static constexpr float kThresholdMultiplier = 1.5f;
+static constexpr float kThresholdOffset    = 0.01f;
+static constexpr float kMinOnsetGapSeconds = 0.05f;
+// Attack refinement: the attack starts where |x| first reaches this fraction
+// of the frame peak, allowing gaps up to kAttackGapSamples (zero crossings).
+static constexpr float kAttackFraction   = 0.1f;
+static constexpr int   kAttackGapSamples = 32;
+
+static int next_power_of_two(int n) {
+    int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+OnsetDetector::OnsetDetector(int sample_rate, int frame_size, int hop_size)
+    : sample_rate_(sample_rate)
+    , frame_size_(frame_size)
+    , hop_size_(hop_size)
+    , fft_size_(next_power_of_two(std::max(frame_size, 2)))
+    , min_onset_gap_(static_cast<int>(kMinOnsetGapSeconds * static_cast<float>(std::max(sample_rate, 0))))
+    , fft_(fft_size_)
+    , reset_pending_(false)
+    , ring_buffer_(std::max(frame_size, 1))
+    , window_(static_cast<size_t>(std::max(frame_size, 0)))
+    , spectrum_(static_cast<size_t>(fft_size_))
+    , magnitude_(static_cast<size_t>(fft_size_ / 2 + 1), 0.0f)
+    , previous_magnitude_(static_cast<size_t>(fft_size_ / 2 + 1), 0.0f)
+    , flux_history_{}
+    , flux_history_pos_(0)
+    , flux_prev_(0.0f)
+    , flux_prev2_(0.0f)
+    , threshold_prev_(0.0f)
+    , samples_ready_(0)
+    , samples_since_last_hop_(0)
+    , samples_processed_(0)
+    , last_onset_sample_(-1)
+    , tempo_(std::max(sample_rate, 1), std::max(hop_size, 1))
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+    if (frame_size < 64) throw std::invalid_argument("frame_size must be >= 64");
+    if (hop_size <= 0 || hop_size > frame_size) throw std::invalid_argument("hop_size must be in (0, frame_size]");
+
+    for (int i = 0; i < frame_size_; ++i) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * kPi * static_cast<float>(i) / static_cast<float>(frame_size_ - 1));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void OnsetDetector::reset() {
+    reset_pending_.store(true, std::memory_order_release);
+}
+
+int OnsetDetector::process(const float* samples, int num_samples, Onset* out, int max_out) {
+    apply_pending_reset();
+
+    int written = 0;
+    int offset = 0;
+    while (offset < num_samples) {
+        const int until_due = samples_ready_ < frame_size_
+            ? frame_size_ - samples_ready_
+            : hop_size_ - samples_since_last_hop_;
+        const int chunk = std::min(num_samples - offset, std::max(until_due, 0));
+
+        ring_buffer_.write(samples + offset, chunk);
+        samples_ready_ = std::min(frame_size_, samples_ready_ + chunk);
+        samples_since_last_hop_ += chunk;
+        samples_processed_ += chunk;
+        offset += chunk;
+
+        if (samples_ready_ < frame_size_ || samples_since_last_hop_ < hop_size_) {
+            continue;
+        }
+        samples_since_last_hop_ = 0;
+
+        Onset onset{};
+        if (analyse_frame(onset) && written < max_out) {
+            out[written++] = onset;
+        }
+    }
+    return written;
+}
+
+// ---------------------------------------------------------------------------
+// Analysis
+// ---------------------------------------------------------------------------
+
+void OnsetDetector::apply_pending_reset() {
+    if (reset_pending_.exchange(false, std::memory_order_acq_rel)) {
+        ring_buffer_.clear();
+        std::fill(previous_magnitude_.begin(), previous_magnitude_.end(), 0.0f);
+        flux_history_.fill(0.0f);
+        flux_history_pos_       = 0;
+        flux_prev_              = 0.0f;
+        flux_prev2_             = 0.0f;
+        threshold_prev_         = 0.0f;
+        samples_ready_          = 0;
+        samples_since_last_hop_ = 0;
+        samples_processed_      = 0;
+        last_onset_sample_      = -1;
+        tempo_.reset();
+    }
+}
+
+float OnsetDetector::compute_flux() {
+    simd::window_to_complex(ring_buffer_.latest(frame_size_), window_.data(), spectrum_.data(), frame_size_);
+    std::fill(spectrum_.begin() + frame_size_, spectrum_.end(), std::complex<float>(0.0f, 0.0f));
+    fft_.forward(spectrum_);
+
+    const int bins = static_cast<int>(magnitude_.size());
+    simd::power_spectrum(spectrum_.data(), magnitude_.data(), bins);
+    // Scale so a full-scale sinusoid peaks near 1 regardless of frame size.
+    const float scale = 4.0f / static_cast<float>(frame_size_);
+    for (int k = 0; k < bins; ++k) {
+        magnitude_[k] = std::log1p(kLogCompression * scale * std::sqrt(magnitude_[k]));
+    }
+
+    const float flux = simd::rectified_diff_sum(magnitude_.data(), previous_magnitude_.data(), bins) /
+                       static_cast<float>(bins);
+    magnitude_.swap(previous_magnitude_);
+    return flux;
+}
+
+float OnsetDetector::flux_median() const {
+    std::array<float, kFluxHistory> sorted = flux_history_;
+    auto mid = sorted.begin() + kFluxHistory / 2;
+    std::nth_element(sorted.begin(), mid, sorted.end());
+    return *mid;
+}
+
+bool OnsetDetector::analyse_frame(Onset& onset) {
+    const float flux = compute_flux();
+
+    // The previous hop is an onset if it peaked above its threshold.
+    bool found = false;
+    int64_t onset_sample = -1;
+    if (flux_prev_ > threshold_prev_ && flux_prev_ >= flux_prev2_ && flux_prev_ > flux) {
+        onset_sample = locate_attack();
+        if (onset_sample >= 0) {
+            onset.sample_position = onset_sample;
+            onset.strength        = flux_prev_ - threshold_prev_;
+            last_onset_sample_    = onset_sample;
+            found = true;
+        }
+    }
+
+    const float median = flux_median();
+    flux_history_[flux_history_pos_] = flux;
+    flux_history_pos_ = (flux_history_pos_ + 1) % kFluxHistory;
+    flux_prev2_     = flux_prev_;
+    flux_prev_      = flux;
+    threshold_prev_ = kThresholdMultiplier * median + kThresholdOffset;
+
+    tempo_.push(std::max(flux - median, 0.0f), samples_processed_, onset_sample);
+    return found;
+}
+
+int64_t OnsetDetector::locate_attack() const {
+    const float* frame = ring_buffer_.latest(frame_size_);
+    const int64_t frame_start = samples_processed_ - frame_size_;
+
+    int lo = 0;
+    if (last_onset_sample_ >= 0) {
+        const int64_t earliest = last_onset_sample_ + min_onset_gap_;
+        if (earliest >= samples_processed_) return -1;
+        lo = static_cast<int>(std::max<int64_t>(0, earliest - frame_start));
+    }
+
+    int peak_index = lo;
+    float peak = 0.0f;
+    for (int i = lo; i < frame_size_; ++i) {
+        const float a = std::fabs(frame[i]);
+        if (a > peak) {
+            peak = a;
+            peak_index = i;
+        }
+    }
+    if (peak <= 0.0f) return -1;
+
+    // Walk back from the peak while the signal stays above the attack level.
+    const float level = kAttackFraction * peak;
+    int attack = peak_index;
+    for (int i = peak_index; i >= lo; --i) {
+        if (std::fabs(frame[i]) >= level) {
+            attack = i;
+        } else if (attack - i > kAttackGapSamples) {
+            break;
+        }
+    }
+    return frame_start + attack;
+}
+
+} // namespace music_life
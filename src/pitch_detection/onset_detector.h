@@ -0,0 +1,101 @@
+#pragma once
+
+#include "fft.h"
+#include "mirrored_ring_buffer.h"
+#include "tempo_tracker.h"
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Streaming spectral-flux onset detector with an attached TempoTracker.
+ *
+ * Every hop the newest frame is Hann-windowed and transformed with the shared
+ * Fft; the half-wave rectified increase in log-compressed magnitude is the
+ * onset function.  A hop is reported as an onset when its flux is a local
+ * maximum above an adaptive threshold (a multiple of the running median), so
+ * detection runs one hop behind the audio.  The reported position is refined
+ * to the first sample of the attack inside the analysed frame.
+ *
+ * Sample positions are absolute: counted from construction or the last reset.
+ *
+ * Usage:
+ *   OnsetDetector onsets(44100);
+ *   OnsetDetector::Onset found[8];
+ *   int n = onsets.process(buffer, num_samples, found, 8);
+ *   float bpm = onsets.tempo().bpm();
+ */
+class OnsetDetector {
+public:
+    struct Onset {
+        int64_t sample_position; ///< Absolute index of the first sample of the attack
+        float   strength;        ///< Flux above the adaptive threshold
+    };
+
+    /**
+     * @param sample_rate  Audio sample rate in Hz.
+     * @param frame_size   Analysis frame size in samples.
+     * @param hop_size     Samples between analyses; at most frame_size.
+     */
+    explicit OnsetDetector(int sample_rate, int frame_size = 1024, int hop_size = 256);
+
+    /**
+     * Feed a mono block and analyse every hop it completes.
+     *
+     * @return Number of onsets written to out (at most max_out); further
+     *         onsets in the same block still update the tempo tracker.
+     */
+    int process(const float* samples, int num_samples, Onset* out, int max_out);
+
+    /** Request a reset; applied at the start of the next process() call. */
+    void reset();
+
+    const TempoTracker& tempo() const { return tempo_; }
+    int frame_size() const { return frame_size_; }
+    int hop_size() const { return hop_size_; }
+    int64_t samples_processed() const { return samples_processed_; }
+
+private:
+    static constexpr int kFluxHistory = 16;
+
+    int   sample_rate_;
+    int   frame_size_;
+    int   hop_size_;
+    int   fft_size_;
+    int   min_onset_gap_;
+    Fft   fft_;
+    std::atomic<bool> reset_pending_;
+    MirroredRingBuffer ring_buffer_;
+
+    std::vector<float> window_;
+    std::vector<std::complex<float>> spectrum_;
+    std::vector<float> magnitude_;
+    std::vector<float> previous_magnitude_;
+
+    std::array<float, kFluxHistory> flux_history_;
+    int   flux_history_pos_;
+    float flux_prev_;
+    float flux_prev2_;
+    float threshold_prev_;
+
+    int     samples_ready_;
+    int     samples_since_last_hop_;
+    int64_t samples_processed_;
+    int64_t last_onset_sample_;
+
+    TempoTracker tempo_;
+
+    void apply_pending_reset();
+    /** Analyse the newest frame; returns true and fills onset if one is confirmed. */
+    bool analyse_frame(Onset& onset);
+    float compute_flux();
+    float flux_median() const;
+    int64_t locate_attack() const;
+};
+
+} // namespace music_life
@@ -1,9 +1,13 @@
 #include "pitch_detector.h"
+#include "simd_utils.h"
+#include "trace.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <stdexcept>
+#include <thread>
 
 namespace music_life {
 
@@ -20,6 +24,46 @@ static constexpr float kMaxFrequency = 4200.0f; // Hz
 static constexpr float kMinReferencePitch = 430.0f;
 static constexpr float kMaxReferencePitch = 450.0f;
 
+// Adaptive frame size: shortest engine frame, the confidence needed to leave
+// the full frame, the pitch margin over an engine's lowest resolvable
+// frequency, and the hops a shorter frame must be requested before switching.
+static constexpr int   kMinAdaptiveFrameSize = 256;
+static constexpr int   kMaxAdaptiveEngines   = 3;
+static constexpr float kAdaptiveMinProbability = 0.8f;
+static constexpr float kAdaptiveFrequencyMargin = 2.0f;
+static constexpr int   kAdaptiveSwitchHops = 2;
+
+// Longest reconfigure() waits for a running stream to swap in its engines.
+static constexpr int   kSwapWaitMs = 50;
+
+// Noise gate: frames at or below kGateFloorMeanSquare (-80 dBFS, the level YIN
+// itself rejects) are never analysed.  The running frame energy is recomputed
+// exactly every kEnergyRefreshFrames frames to bound floating-point drift.
+static constexpr float kGateFloorMeanSquare = 1.0e-8f;
+static constexpr float kGateMinDb = -120.0f;
+static constexpr int   kGateMaxHangoverHops = 1000;
+static constexpr int   kEnergyRefreshFrames = 64;
+
+// Decimating front end: supported factors and input samples filtered per pass.
+static constexpr int   kMaxDecimation = 4;
+static constexpr int   kIngestChunk   = 1024;
+
+static constexpr int   kMaxSnapshotBins = 8192;
+
+// Input filters: accepted ranges, and the DC blocker's corner.
+static constexpr float kDcBlockHz        = 5.0f;
+static constexpr float kMinHighPassHz    = 10.0f;
+static constexpr float kMaxHighPassHz    = 1000.0f;
+static constexpr float kMinHumHz         = 20.0f;
+static constexpr float kMaxHumHz         = 500.0f;
+static constexpr int   kMaxHumHarmonics  = 4;
+static constexpr float kMinHumQ          = 1.0f;
+static constexpr float kMaxHumQ          = 200.0f;
+static constexpr float kMaxFilterGainDb  = 40.0f;
+
+// Targeted tuner mode: strobe estimates converted per process_target() pass.
+static constexpr int   kStrobeBatch = 32;
+
 static const char* const kNoteTable[128] = {
     "C-1","C#-1","D-1","D#-1","E-1","F-1","F#-1","G-1","G#-1","A-1","A#-1","B-1",
     "C0", "C#0", "D0", "D#0", "E0", "F0", "F#0", "G0", "G#0", "A0", "A#0", "B0",
@@ -38,31 +82,186 @@ static const char* const kNoteTable[128] = {
 // Construction / destruction
 // ---------------------------------------------------------------------------
 
-PitchDetector::PitchDetector(int sample_rate, int frame_size, float threshold, float reference_pitch_hz)
+PitchDetector::PitchDetector(int sample_rate,
+                             int frame_size,
+                             float threshold,
+                             float reference_pitch_hz,
+                             bool adaptive_frame_size,
+                             int decimation)
+    : PitchDetector(sample_rate, frame_size, reference_pitch_hz, decimation, nullptr)
+{
+    engines_ = make_engines(sample_rate / decimation, frame_size_, threshold, adaptive_frame_size, FftBackend::Auto);
+    config_.frame_size          = frame_size;
+    config_.threshold           = threshold;
+    config_.adaptive_frame_size = adaptive_frame_size;
+}
+
+PitchDetector::PitchDetector(int sample_rate,
+                             int frame_size,
+                             float reference_pitch_hz,
+                             int decimation,
+                             const PitchDetector* engines_from)
     : sample_rate_(sample_rate)
-    , frame_size_(frame_size)
+    , decimation_(decimation)
+    , frame_size_(decimation >= 1 ? frame_size / decimation : frame_size)
     , reference_pitch_hz_(reference_pitch_hz)
-    , yin_(std::make_unique<Yin>(sample_rate, frame_size, threshold))
+    , active_engine_(0)
+    , shorter_votes_(0)
     , reset_pending_(false)
-    , ring_buffer_(frame_size * 2, 0.0f)
-    , frame_buffer_(frame_size, 0.0f)
-    , yin_workspace_(frame_size / 2, 0.0f)
-    , write_pos_(0)
+    , ring_buffer_(std::make_unique<MirroredRingBuffer>(std::max(frame_size_, 1)))
     , samples_ready_(0)
     , samples_since_last_process_(0)
+    , frames_analysed_(0)
+    , frame_energy_(0.0)
+    , frame_nonfinite_(0)
+    , samples_since_energy_refresh_(0)
+    , gate_open_mean_square_(kGateFloorMeanSquare)
+    , gate_close_mean_square_(kGateFloorMeanSquare)
+    , gate_hangover_hops_(0)
+    , gate_open_(false)
+    , gate_hangover_left_(0)
+    , frames_gated_(0)
     , last_result_{}
+    , snapshot_bins_(0)
+    , strobe_(sample_rate > 0 ? sample_rate : 1)
+    , target_hz_(0.0f)
+    , active_target_hz_(0.0f)
+    , strobe_phase_(0.0f)
+    , pending_analysis_(nullptr)
+    , retired_analysis_(nullptr)
 {
     if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
     if (frame_size  <= 1) throw std::invalid_argument("frame_size must be > 1");
+    if (decimation < 1 || decimation > kMaxDecimation) {
+        throw std::invalid_argument("decimation must be in [1, 4]");
+    }
+    if (frame_size % decimation != 0 || frame_size_ <= 1) {
+        throw std::invalid_argument("frame_size must be a multiple of decimation, leaving > 1 sample");
+    }
     if (reference_pitch_hz < kMinReferencePitch || reference_pitch_hz > kMaxReferencePitch) {
         throw std::invalid_argument("reference_pitch_hz must be in [432, 445]");
     }
+
+    if (decimation > 1) {
+        decimator_ = std::make_unique<Resampler>(1, decimation);
+        decimated_.assign(static_cast<size_t>(decimator_->max_output(kIngestChunk)), 0.0f);
+    }
+    folded_.assign(static_cast<size_t>(kIngestChunk), 0.0f);
+
+    // A channel detector borrows the Yin instances (plans and FFT scratch)
+    // but needs its own CMNDF workspace.
+    if (engines_from != nullptr) {
+        for (const Engine& engine : engines_from->engines_) {
+            engines_.push_back(Engine{engine.yin, std::vector<float>(engine.workspace.size(), 0.0f),
+                                      engine.frame_size, engine.min_frequency});
+        }
+    }
+}
+
+PitchDetector::~PitchDetector() {
+    delete pending_analysis_.load(std::memory_order_acquire);
+    reclaim_retired_analysis();
+}
+
+std::vector<PitchDetector::Engine> PitchDetector::make_engines(int analysis_rate,
+                                                               int frame_size,
+                                                               float threshold,
+                                                               bool adaptive_frame_size,
+                                                               FftBackend fft_backend) {
+    // All engines share the ring: a shorter frame is a suffix of the longest.
+    std::vector<Engine> engines;
+    for (int size = frame_size; size > 1; size /= 2) {
+        engines.push_back(Engine{
+            std::make_shared<Yin>(analysis_rate, size, threshold, fft_backend),
+            std::vector<float>(static_cast<size_t>(size / 2), 0.0f),
+            size,
+            static_cast<float>(analysis_rate) / static_cast<float>(size / 2)
+        });
+        if (!adaptive_frame_size || static_cast<int>(engines.size()) == kMaxAdaptiveEngines ||
+            size / 2 < kMinAdaptiveFrameSize) {
+            break;
+        }
+    }
+    return engines;
 }
 
 // ---------------------------------------------------------------------------
 // Public API
 // ---------------------------------------------------------------------------
 
+void PitchDetector::reconfigure(const AnalysisConfig& config) {
+    if (config.frame_size <= 1 || config.frame_size % decimation_ != 0 || config.frame_size / decimation_ <= 1) {
+        throw std::invalid_argument("frame_size must be a multiple of decimation, leaving > 1 sample");
+    }
+    if (!(config.threshold >= 0.0f && config.threshold <= 1.0f)) {
+        throw std::invalid_argument("threshold must be in [0, 1]");
+    }
+
+    const int frame_size = config.frame_size / decimation_;
+    auto analysis = std::make_unique<Analysis>();
+    analysis->engines = make_engines(analysis_sample_rate(), frame_size, config.threshold,
+                                     config.adaptive_frame_size, config.fft_backend);
+    analysis->ring = std::make_unique<MirroredRingBuffer>(frame_size);
+    analysis->frame_size = frame_size;
+    if (snapshots_) {
+        for (Engine& engine : analysis->engines) engine.yin->set_full_cmndf(true);
+    }
+
+    // Channel detectors run on the same Yin instances with their own rings.
+    for (auto& detector : channel_detectors_) {
+        auto channel = std::make_unique<Analysis>();
+        for (const Engine& engine : analysis->engines) {
+            channel->engines.push_back(Engine{engine.yin, std::vector<float>(engine.workspace.size(), 0.0f),
+                                              engine.frame_size, engine.min_frequency});
+        }
+        channel->ring = std::make_unique<MirroredRingBuffer>(frame_size);
+        channel->frame_size = frame_size;
+        detector->publish_analysis(std::move(channel));
+        detector->config_ = config;
+    }
+
+    publish_analysis(std::move(analysis));
+    config_ = config;
+
+    // Free the swapped-out engines now rather than at the next call.  A
+    // stream that is stopped never takes the new set, so the wait is
+    // bounded; whatever is swapped out after it is freed by the next
+    // reconfigure() or the destructor.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kSwapWaitMs);
+    while (!analysis_swapped() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    reclaim_retired_analysis();
+    for (auto& detector : channel_detectors_) detector->reclaim_retired_analysis();
+}
+
+void PitchDetector::publish_analysis(std::unique_ptr<Analysis> analysis) {
+    // A set the processing thread never took is simply replaced.
+    delete pending_analysis_.exchange(analysis.release(), std::memory_order_acq_rel);
+    reclaim_retired_analysis();
+}
+
+bool PitchDetector::analysis_swapped() const {
+    // Taken, and the set it replaced pushed back; channel detectors too.
+    if (pending_analysis_.load(std::memory_order_acquire) != nullptr ||
+        retired_analysis_.load(std::memory_order_acquire) == nullptr) {
+        return false;
+    }
+    for (const auto& detector : channel_detectors_) {
+        if (!detector->analysis_swapped()) return false;
+    }
+    return true;
+}
+
+void PitchDetector::reclaim_retired_analysis() {
+    Analysis* retired = retired_analysis_.exchange(nullptr, std::memory_order_acquire);
+    while (retired != nullptr) {
+        Analysis* next = retired->next_retired;
+        delete retired;
+        retired = next;
+    }
+}
+
 void PitchDetector::reset() {
     reset_pending_.store(true, std::memory_order_release);
 }
@@ -74,83 +273,590 @@ void PitchDetector::set_reference_pitch(float reference_pitch_hz) {
     reference_pitch_hz_.store(reference_pitch_hz, std::memory_order_relaxed);
 }
 
+void PitchDetector::enable_snapshots(int spectrum_bins) {
+    if (spectrum_bins < 1 || spectrum_bins > kMaxSnapshotBins) {
+        throw std::invalid_argument("spectrum_bins must be in [1, 8192]");
+    }
+    // Engine 0 has the longest frame and so the most FFT bins and lags.
+    const Engine& longest = engines_.front();
+    Snapshot initial;
+    initial.spectrum.assign(static_cast<size_t>(std::min(spectrum_bins, longest.yin->fft_size() / 2)), 0.0f);
+    initial.cmndf.assign(longest.workspace.size(), 0.0f);
+    snapshots_ = std::make_unique<TripleBuffer<Snapshot>>(initial);
+    for (Engine& engine : engines_) engine.yin->set_full_cmndf(true);
+    snapshot_bins_ = spectrum_bins;
+}
+
+const PitchDetector::Snapshot* PitchDetector::latest_snapshot() {
+    if (!snapshots_) return nullptr;
+    snapshots_->update();
+    return snapshots_->front().frame_index != 0 ? &snapshots_->front() : nullptr;
+}
+
+void PitchDetector::enable_channel_detection(int channels) {
+    if (channels < 1 || channels > kMaxChannels) {
+        throw std::invalid_argument("channels must be in [1, 8]");
+    }
+    std::vector<std::unique_ptr<PitchDetector>> detectors;
+    for (int c = 0; c < channels; ++c) {
+        detectors.push_back(std::unique_ptr<PitchDetector>(new PitchDetector(
+            sample_rate_, frame_size(), reference_pitch_hz_.load(std::memory_order_relaxed), decimation_, this)));
+    }
+    for (auto& detector : detectors) detector->set_input_filter(filter_config_);
+    channel_detectors_ = std::move(detectors);
+}
+
+void PitchDetector::set_target(float target_hz) {
+    const bool valid = target_hz == 0.0f ||
+        (target_hz >= kMinFrequency && target_hz < kMaxFrequency &&
+         target_hz < 0.5f * static_cast<float>(sample_rate_));
+    if (!valid) {
+        throw std::invalid_argument("target_hz must be 0 or in [20, 4200) below sample_rate / 2");
+    }
+    target_hz_.store(target_hz, std::memory_order_relaxed);
+}
+
+void PitchDetector::set_input_filter(const FilterConfig& config) {
+    const float nyquist = 0.5f * static_cast<float>(analysis_sample_rate());
+    if (!(config.high_pass_hz == 0.0f ||
+          (config.high_pass_hz >= kMinHighPassHz && config.high_pass_hz <= kMaxHighPassHz &&
+           config.high_pass_hz < nyquist))) {
+        throw std::invalid_argument("high_pass_hz must be 0 or in [10, 1000] below the analysis Nyquist rate");
+    }
+    if (!(config.hum_hz == 0.0f ||
+          (config.hum_hz >= kMinHumHz && config.hum_hz <= kMaxHumHz && config.hum_hz < nyquist))) {
+        throw std::invalid_argument("hum_hz must be 0 or in [20, 500] below the analysis Nyquist rate");
+    }
+    if (config.hum_harmonics < 1 || config.hum_harmonics > kMaxHumHarmonics) {
+        throw std::invalid_argument("hum_harmonics must be in [1, 4]");
+    }
+    if (!(config.hum_q >= kMinHumQ && config.hum_q <= kMaxHumQ)) {
+        throw std::invalid_argument("hum_q must be in [1, 200]");
+    }
+    if (!(std::fabs(config.gain_db) <= kMaxFilterGainDb)) {
+        throw std::invalid_argument("gain_db must be in [-40, 40]");
+    }
+
+    const double rate = static_cast<double>(analysis_sample_rate());
+    BiquadSection sections[BiquadCascade::kMaxSections];
+    int count = 0;
+    if (config.dc_block) sections[count++] = BiquadSection::dc_blocker(kDcBlockHz, rate);
+    if (config.high_pass_hz > 0.0f) sections[count++] = BiquadSection::high_pass(config.high_pass_hz, rate);
+    if (config.hum_hz > 0.0f) {
+        for (int h = 1; h <= config.hum_harmonics && config.hum_hz * static_cast<float>(h) < nyquist; ++h) {
+            sections[count++] = BiquadSection::notch(static_cast<double>(config.hum_hz) * h, config.hum_q, rate);
+        }
+    }
+    // The gain costs nothing folded into the first stage's numerator.
+    if (config.gain_db != 0.0f) {
+        const float gain = std::pow(10.0f, config.gain_db / 20.0f);
+        if (count == 0) ++count;
+        sections[0].b0 *= gain;
+        sections[0].b1 *= gain;
+        sections[0].b2 *= gain;
+    }
+    input_filter_.set(sections, count);
+
+    for (auto& detector : channel_detectors_) detector->set_input_filter(config);
+    filter_config_ = config;
+}
+
+void PitchDetector::set_noise_gate(const GateConfig& config) {
+    if (!(config.close_db >= kGateMinDb && config.close_db <= config.open_db && config.open_db <= 0.0f)) {
+        throw std::invalid_argument("noise gate levels must satisfy -120 <= close_db <= open_db <= 0");
+    }
+    if (config.hangover_hops < 0 || config.hangover_hops > kGateMaxHangoverHops) {
+        throw std::invalid_argument("hangover_hops must be in [0, 1000]");
+    }
+    gate_open_mean_square_.store(std::pow(10.0f, config.open_db / 10.0f), std::memory_order_relaxed);
+    gate_close_mean_square_.store(std::pow(10.0f, config.close_db / 10.0f), std::memory_order_relaxed);
+    gate_hangover_hops_.store(config.hangover_hops, std::memory_order_relaxed);
+}
+
+PitchDetector::GateConfig PitchDetector::noise_gate() const {
+    GateConfig config;
+    config.open_db       = 10.0f * std::log10(gate_open_mean_square_.load(std::memory_order_relaxed));
+    config.close_db      = 10.0f * std::log10(gate_close_mean_square_.load(std::memory_order_relaxed));
+    config.hangover_hops = gate_hangover_hops_.load(std::memory_order_relaxed);
+    return config;
+}
+
 PitchDetector::Result PitchDetector::process(const float* samples, int num_samples) {
-    if (reset_pending_.exchange(false, std::memory_order_acq_rel)) {
-        std::fill(ring_buffer_.begin(), ring_buffer_.end(), 0.0f);
-        write_pos_     = 0;
-        samples_ready_ = 0;
-        samples_since_last_process_ = 0;
-        last_result_   = {};
+    return process_input(Input{samples, 1, nullptr, 0}, num_samples);
+}
+
+int PitchDetector::process_block(const float* samples,
+                                 int num_samples,
+                                 Result* out,
+                                 int max_out,
+                                 int* end_offsets) {
+    return process_block_input(Input{samples, 1, nullptr, 0}, num_samples, out, max_out, end_offsets);
+}
+
+PitchDetector::Result PitchDetector::process_interleaved(const float* samples,
+                                                         int num_frames,
+                                                         int channels,
+                                                         const float* weights) {
+    float average[kMaxChannels];
+    return process_input(make_input(samples, channels, weights, average), num_frames);
+}
+
+int PitchDetector::process_block_interleaved(const float* samples,
+                                             int num_frames,
+                                             int channels,
+                                             const float* weights,
+                                             Result* out,
+                                             int max_out,
+                                             int* end_offsets) {
+    float average[kMaxChannels];
+    return process_block_input(make_input(samples, channels, weights, average), num_frames, out, max_out, end_offsets);
+}
+
+int PitchDetector::process_channels(const float* samples, int num_frames, Result* out) {
+    // Consumes a pending reset and forwards it to every channel.
+    apply_pending_reset();
+
+    const int channels = channel_count();
+    const float reference_pitch_hz = reference_pitch_hz_.load(std::memory_order_relaxed);
+    const float open_mean_square   = gate_open_mean_square_.load(std::memory_order_relaxed);
+    const float close_mean_square  = gate_close_mean_square_.load(std::memory_order_relaxed);
+    const int   hangover_hops      = gate_hangover_hops_.load(std::memory_order_relaxed);
+    const float target_hz          = target_hz_.load(std::memory_order_relaxed);
+    for (int c = 0; c < channels; ++c) {
+        PitchDetector& detector = *channel_detectors_[static_cast<size_t>(c)];
+        detector.reference_pitch_hz_.store(reference_pitch_hz, std::memory_order_relaxed);
+        detector.gate_open_mean_square_.store(open_mean_square, std::memory_order_relaxed);
+        detector.gate_close_mean_square_.store(close_mean_square, std::memory_order_relaxed);
+        detector.gate_hangover_hops_.store(hangover_hops, std::memory_order_relaxed);
+        detector.target_hz_.store(target_hz, std::memory_order_relaxed);
+        out[c] = detector.process_input(Input{samples, channels, nullptr, c}, num_frames);
+    }
+    return channels;
+}
+
+PitchDetector::Input PitchDetector::make_input(const float* samples, int channels, const float* weights, float* average) {
+    if (channels < 1 || channels > kMaxChannels) {
+        throw std::invalid_argument("channels must be in [1, 8]");
+    }
+    if (weights == nullptr) {
+        if (channels == 1) return Input{samples, 1, nullptr, 0};
+        std::fill(average, average + channels, 1.0f / static_cast<float>(channels));
+        return Input{samples, channels, average, 0};
+    }
+
+    int nonzero = 0;
+    int selected = 0;
+    for (int c = 0; c < channels; ++c) {
+        if (weights[c] != 0.0f) {
+            ++nonzero;
+            selected = c;
+        }
+    }
+    if (nonzero == 1 && weights[selected] == 1.0f) return Input{samples, channels, nullptr, selected};
+    return Input{samples, channels, weights, 0};
+}
+
+PitchDetector::Result PitchDetector::process_input(const Input& input, int num_frames) {
+    ML_TRACE_SCOPE("pitch.process");
+    apply_pending_reset();
+    apply_pending_analysis();
+    apply_pending_target();
+    if (active_target_hz_ > 0.0f) {
+        process_target(input, num_frames, nullptr, 0, nullptr);
+        return last_result_;
     }
 
-    const int ring_size = frame_size_ * 2;
     const bool was_warm = samples_ready_ == frame_size_;
 
-    // Feed incoming samples into the ring buffer in contiguous chunks to avoid
-    // a modulo operation for every sample in the audio callback.
-    int input_offset = 0;
-    int remaining = num_samples;
-    while (remaining > 0) {
-        const int chunk = std::min(remaining, ring_size - write_pos_);
-        std::memcpy(ring_buffer_.data() + write_pos_,
-                    samples + input_offset,
-                    static_cast<size_t>(chunk) * sizeof(float));
-        write_pos_ += chunk;
-        if (write_pos_ == ring_size) {
-            write_pos_ = 0;
-        }
-        input_offset += chunk;
-        remaining -= chunk;
-    }
-    samples_ready_ = std::min(frame_size_, samples_ready_ + num_samples);
-    samples_since_last_process_ += num_samples;
+    const int produced = ingest(input, num_frames);
+    samples_ready_ = std::min(frame_size_, samples_ready_ + produced);
+    samples_since_last_process_ += produced;
 
     // Not enough samples yet
     if (samples_ready_ < frame_size_) {
         return last_result_;
     }
 
-    // Hop hasn't elapsed (50% overlap): only run YIN every frame_size/2 new samples
-    const int hop_size = frame_size_ / 2;
+    // Hop hasn't elapsed (50% overlap): only run YIN every active_frame/2 new samples
+    const int hop_size = analysis_hop();
     if (samples_since_last_process_ < hop_size) {
         return last_result_;
     }
     samples_since_last_process_ = was_warm ? (samples_since_last_process_ - hop_size) : 0;
 
-    // Assemble a contiguous frame from the ring buffer
-    int start = (write_pos_ - frame_size_ + ring_size) % ring_size;
-    const int first_chunk = std::min(frame_size_, ring_size - start);
-    std::memcpy(frame_buffer_.data(), ring_buffer_.data() + start, first_chunk * sizeof(float));
-    if (first_chunk < frame_size_) {
-        std::memcpy(frame_buffer_.data() + first_chunk,
-                    ring_buffer_.data(),
-                    (frame_size_ - first_chunk) * sizeof(float));
+    return analyse_frame();
+}
+
+int PitchDetector::process_block_input(const Input& input,
+                                       int num_frames,
+                                       Result* out,
+                                       int max_out,
+                                       int* end_offsets) {
+    ML_TRACE_SCOPE("pitch.process_block");
+    apply_pending_reset();
+    apply_pending_analysis();
+    apply_pending_target();
+    if (active_target_hz_ > 0.0f) {
+        return process_target(input, num_frames, out, max_out, end_offsets);
+    }
+
+    int written = 0;
+    int offset = 0;
+    while (offset < num_frames) {
+        // Advance exactly to the next analysis point so that every hop sees
+        // the frame ending at its own sample, not at the end of the block.
+        // The hop is re-read each step because adaptive mode may change it.
+        // Counts are at the decimated rate; chunk is the input that completes
+        // exactly until_due decimated samples.  A reconfigure() lands here,
+        // between hops.
+        apply_pending_analysis();
+        const int hop_size = analysis_hop();
+        const int until_due = samples_ready_ < frame_size_
+            ? frame_size_ - samples_ready_
+            : hop_size - samples_since_last_process_;
+        int needed = std::max(until_due, 0);
+        if (decimator_ && needed > 0) {
+            needed = decimator_->inputs_until_next_output() + (needed - 1) * decimation_;
+        }
+        const int chunk = std::min(num_frames - offset, needed);
+
+        const int produced = ingest(input.from(offset), chunk);
+        samples_ready_ = std::min(frame_size_, samples_ready_ + produced);
+        samples_since_last_process_ += produced;
+        offset += chunk;
+
+        if (samples_ready_ < frame_size_ || samples_since_last_process_ < hop_size) {
+            continue;
+        }
+        samples_since_last_process_ = 0;
+        if (written >= max_out) {
+            // Out of room: keep hop timing consistent but skip the analysis.
+            continue;
+        }
+
+        out[written] = analyse_frame();
+        if (end_offsets != nullptr) {
+            end_offsets[written] = offset;
+        }
+        ++written;
+    }
+    return written;
+}
+
+void PitchDetector::apply_pending_reset() {
+    if (reset_pending_.exchange(false, std::memory_order_acq_rel)) {
+        clear_analysis_state();
+        if (active_target_hz_ > 0.0f) strobe_.retune(active_target_hz_);
+        for (auto& detector : channel_detectors_) detector->reset();
+    }
+}
+
+void PitchDetector::apply_pending_analysis() {
+    if (pending_analysis_.load(std::memory_order_relaxed) == nullptr) return;
+    Analysis* next = pending_analysis_.exchange(nullptr, std::memory_order_acq_rel);
+    if (next == nullptr) return;
+
+    // Carry the newest history across; only what the old frame had filled
+    // counts as ready.  Everything else about the stream (last result, gate,
+    // tuner, decimator) continues untouched, so the swap is seamless.
+    const int carried = std::min(samples_ready_, next->frame_size);
+    next->ring->write(ring_buffer_->latest(carried), carried);
+    std::swap(engines_, next->engines);
+    std::swap(ring_buffer_, next->ring);
+    std::swap(frame_size_, next->frame_size);
+    samples_ready_ = carried;
+    active_engine_ = 0;
+    shorter_votes_ = 0;
+    samples_since_last_process_ = std::min(samples_since_last_process_, analysis_hop());
+    refresh_frame_energy();
+
+    // The old state goes back for the control thread to free.  Only this
+    // thread pushes and the control thread takes the whole list, so the
+    // push never waits on it and a set published meanwhile is still taken
+    // at the next hop.
+    next->next_retired = retired_analysis_.load(std::memory_order_relaxed);
+    while (!retired_analysis_.compare_exchange_weak(next->next_retired, next, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+    }
+}
+
+void PitchDetector::apply_pending_target() {
+    const float target_hz = target_hz_.load(std::memory_order_relaxed);
+    if (target_hz == active_target_hz_) return;
+
+    // Entering either mode starts it from a clean state: YIN needs a fresh
+    // frame, the strobe filters need to settle on the new target.
+    active_target_hz_ = target_hz;
+    last_result_ = {};
+    if (target_hz > 0.0f) {
+        strobe_.retune(target_hz);
+    } else {
+        clear_analysis_state();
+    }
+}
+
+int PitchDetector::process_target(const Input& input,
+                                  int num_frames,
+                                  Result* out,
+                                  int max_out,
+                                  int* end_offsets) {
+    if (input.samples == nullptr || num_frames <= 0) return 0;
+
+    // kStrobeBatch hops of input can complete at most kStrobeBatch estimates;
+    // interleaved input is also bounded by the fold buffer.
+    int slice_size = strobe_.hop_size() * kStrobeBatch;
+    if (!input.is_mono()) slice_size = std::min(slice_size, kIngestChunk);
+    StrobeTuner::Estimate estimates[kStrobeBatch];
+    int estimate_ends[kStrobeBatch];
+
+    int written = 0;
+    for (int offset = 0; offset < num_frames; offset += slice_size) {
+        const int slice = std::min(slice_size, num_frames - offset);
+        const float* mono = fold(input.from(offset), slice);
+        const int count = strobe_.process(mono, slice, estimates, kStrobeBatch, estimate_ends);
+        for (int i = 0; i < count; ++i) {
+            ++frames_analysed_;
+            last_result_ = estimates[i].pitched ? make_result(estimates[i].frequency, estimates[i].probability)
+                                                : make_result(-1.0f, 0.0f);
+            if (written < max_out) {
+                out[written] = last_result_;
+                if (end_offsets != nullptr) end_offsets[written] = offset + estimate_ends[i];
+                ++written;
+            }
+        }
+    }
+    strobe_phase_.store(strobe_.latest().phase, std::memory_order_relaxed);
+    return written;
+}
+
+void PitchDetector::clear_analysis_state() {
+    ring_buffer_->clear();
+    samples_ready_ = 0;
+    samples_since_last_process_ = 0;
+    last_result_   = {};
+    active_engine_ = 0;
+    shorter_votes_ = 0;
+    frame_energy_  = 0.0;
+    frame_nonfinite_ = 0;
+    samples_since_energy_refresh_ = 0;
+    gate_open_     = false;
+    gate_hangover_left_ = 0;
+    if (decimator_) decimator_->reset();
+    input_filter_.reset();
+}
+
+const float* PitchDetector::fold(const Input& input, int num_frames) {
+    if (input.is_mono()) return input.samples;
+    simd::deinterleave(input.samples, input.channels, input.weights, input.channel, folded_.data(), num_frames);
+    return folded_.data();
+}
+
+int PitchDetector::ingest(const Input& input, int num_frames) {
+    ML_TRACE_SCOPE("pitch.ingest");
+    if (!decimator_) {
+        write_samples(input, num_frames);
+        return std::max(num_frames, 0);
+    }
+    int produced = 0;
+    for (int offset = 0; offset < num_frames; offset += kIngestChunk) {
+        const int chunk = std::min(kIngestChunk, num_frames - offset);
+        const int count = decimator_->process(fold(input.from(offset), chunk), chunk, decimated_.data());
+        write_samples(Input{decimated_.data(), 1, nullptr, 0}, count);
+        produced += count;
+    }
+    return produced;
+}
+
+void PitchDetector::write_samples(const Input& input, int num_samples) {
+    if (num_samples <= 0) return;
+    BiquadCascade* filter = input_filter_.active_sections() > 0 ? &input_filter_ : nullptr;
+    const auto write_ring = [this, &input, num_samples, filter]() {
+        if (input.is_mono()) {
+            ring_buffer_->write(input.samples, num_samples, filter);
+        } else {
+            ring_buffer_->write_interleaved(input.samples, num_samples, input.channels, input.weights, input.channel,
+                                            filter);
+        }
+    };
+    if (num_samples >= frame_size_) {
+        write_ring();
+        refresh_frame_energy();
+        return;
+    }
+
+    // The oldest num_samples of the frame window leave it with this write,
+    // and the entering samples are measured in the ring once folded.  A
+    // non-finite dot product means a non-finite sample (or overflow), so
+    // only then fall back to the per-sample scan.
+    const float* leaving = ring_buffer_->latest(frame_size_);
+    const float leaving_energy = simd::dot(leaving, leaving, num_samples);
+    if (std::isfinite(leaving_energy)) {
+        frame_energy_ -= static_cast<double>(leaving_energy);
+    } else {
+        for (int i = 0; i < num_samples; ++i) {
+            if (std::isfinite(leaving[i])) {
+                frame_energy_ -= static_cast<double>(leaving[i]) * static_cast<double>(leaving[i]);
+            } else {
+                --frame_nonfinite_;
+            }
+        }
+    }
+
+    write_ring();
+
+    const float* entering = ring_buffer_->latest(num_samples);
+    const float entering_energy = simd::dot(entering, entering, num_samples);
+    if (std::isfinite(entering_energy)) {
+        frame_energy_ += static_cast<double>(entering_energy);
+    } else {
+        for (int i = 0; i < num_samples; ++i) {
+            if (std::isfinite(entering[i])) {
+                frame_energy_ += static_cast<double>(entering[i]) * static_cast<double>(entering[i]);
+            } else {
+                ++frame_nonfinite_;
+            }
+        }
+    }
+
+    samples_since_energy_refresh_ += num_samples;
+    if (samples_since_energy_refresh_ >= kEnergyRefreshFrames * frame_size_) {
+        refresh_frame_energy();
+    }
+}
+
+void PitchDetector::refresh_frame_energy() {
+    const float* frame = ring_buffer_->latest(frame_size_);
+    double energy = 0.0;
+    int nonfinite = 0;
+    for (int i = 0; i < frame_size_; ++i) {
+        if (std::isfinite(frame[i])) {
+            energy += static_cast<double>(frame[i]) * static_cast<double>(frame[i]);
+        } else {
+            ++nonfinite;
+        }
+    }
+    frame_energy_    = energy;
+    frame_nonfinite_ = nonfinite;
+    samples_since_energy_refresh_ = 0;
+}
+
+bool PitchDetector::update_gate() {
+    const double mean_square = frame_energy_ / static_cast<double>(frame_size_);
+    if (frame_nonfinite_ > 0 || mean_square <= kGateFloorMeanSquare) {
+        gate_open_ = false;
+        gate_hangover_left_ = 0;
+        return false;
+    }
+
+    const int hangover = gate_hangover_hops_.load(std::memory_order_relaxed);
+    if (mean_square >= gate_open_mean_square_.load(std::memory_order_relaxed)) {
+        gate_open_ = true;
+        gate_hangover_left_ = hangover;
+    } else if (gate_open_) {
+        if (mean_square >= gate_close_mean_square_.load(std::memory_order_relaxed)) {
+            gate_hangover_left_ = hangover;
+        } else if (gate_hangover_left_ > 0) {
+            --gate_hangover_left_;
+        } else {
+            gate_open_ = false;
+        }
+    }
+    return gate_open_;
+}
+
+PitchDetector::Result PitchDetector::analyse_frame() {
+    ML_TRACE_SCOPE("pitch.analyse");
+    ++frames_analysed_;
+    float freq = -1.0f;
+    float prob = 0.0f;
+    const bool analysed = update_gate();
+    if (analysed) {
+        // Run YIN directly on the ring: the latest frame is contiguous, and
+        // the gate has already checked its energy and finiteness.
+        Engine& engine = engines_[active_engine_];
+        freq = engine.yin->detect_prevalidated(ring_buffer_->latest(engine.frame_size), engine.workspace);
+        prob = engine.yin->probability();
+    } else {
+        ++frames_gated_;
+    }
+    const Result result = make_result(freq, prob);
+    last_result_ = result;
+    if (analysed && snapshots_) publish_snapshot(engines_[active_engine_], result);
+    select_engine(result);
+    return result;
+}
+
+void PitchDetector::select_engine(const Result& result) {
+    if (engines_.size() == 1) return;
+
+    // Losing the pitch or confidence: go straight back to the full frame so a
+    // new low note is never missed.
+    if (!result.pitched || result.probability < kAdaptiveMinProbability) {
+        active_engine_ = 0;
+        shorter_votes_ = 0;
+        return;
     }
 
-    // Run YIN detection
-    float freq = yin_->detect(frame_buffer_.data(), yin_workspace_);
-    float prob = yin_->probability();
+    int target = 0;
+    for (int i = static_cast<int>(engines_.size()) - 1; i > 0; --i) {
+        if (result.frequency >= kAdaptiveFrequencyMargin * engines_[i].min_frequency) {
+            target = i;
+            break;
+        }
+    }
+
+    if (target < active_engine_) {
+        active_engine_ = target;
+        shorter_votes_ = 0;
+    } else if (target > active_engine_) {
+        if (++shorter_votes_ >= kAdaptiveSwitchHops) {
+            active_engine_ = target;
+            shorter_votes_ = 0;
+        }
+    } else {
+        shorter_votes_ = 0;
+    }
+}
+
+PitchDetector::Result PitchDetector::make_result(float frequency, float probability) const {
     const float reference_pitch_hz = reference_pitch_hz_.load(std::memory_order_relaxed);
 
     Result result{};
-    if (std::isfinite(freq) && freq > kMinFrequency && freq < kMaxFrequency) {
+    if (std::isfinite(frequency) && frequency > kMinFrequency && frequency < kMaxFrequency) {
         result.pitched     = true;
-        result.frequency   = freq;
-        result.probability = prob;
-        result.midi_note   = frequency_to_midi(freq, reference_pitch_hz);
+        result.frequency   = frequency;
+        result.probability = probability;
+        result.midi_note   = frequency_to_midi(frequency, reference_pitch_hz);
         float nearest_freq = midi_to_frequency(result.midi_note, reference_pitch_hz);
-        result.cents_offset = cents_between(nearest_freq, freq);
+        result.cents_offset = cents_between(nearest_freq, frequency);
         result.note_name   = midi_to_note_name(result.midi_note);
     } else {
         result.pitched     = false;
         result.frequency   = 0.0f;
         result.probability = 0.0f;
     }
-
-    last_result_ = result;
     return result;
 }
 
+void PitchDetector::publish_snapshot(const Engine& engine, const Result& result) {
+    ML_TRACE_SCOPE("pitch.snapshot");
+    Snapshot& snapshot = snapshots_->back();
+    const int analysis_rate = analysis_sample_rate();
+    snapshot.frame_index          = frames_analysed_;
+    snapshot.analysis_sample_rate = analysis_rate;
+    snapshot.analysis_frame_size  = engine.frame_size;
+    snapshot.frequency            = result.frequency;
+    snapshot.probability          = result.probability;
+    // Buffers are sized for the frame at enable_snapshots(); a longer frame
+    // from reconfigure() is cut to them.
+    const int bins = std::min(snapshot_bins_, static_cast<int>(snapshot.spectrum.size()));
+    snapshot.spectrum_size        = engine.yin->magnitude_spectrum(snapshot.spectrum.data(), bins);
+    snapshot.bin_hz               = 0.5f * static_cast<float>(analysis_rate) / static_cast<float>(snapshot.spectrum_size);
+    snapshot.cmndf_size           = static_cast<int>(std::min(engine.workspace.size(), snapshot.cmndf.size()));
+    std::memcpy(snapshot.cmndf.data(), engine.workspace.data(), static_cast<size_t>(snapshot.cmndf_size) * sizeof(float));
+    snapshots_->publish();
+}
+
 // ---------------------------------------------------------------------------
 // Private helpers
 // ---------------------------------------------------------------------------
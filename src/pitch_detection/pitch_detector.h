@@ -1,9 +1,17 @@
 #pragma once
 
+#include "biquad_cascade.h"
+#include "mirrored_ring_buffer.h"
+#include "resampler.h"
+#include "strobe_tuner.h"
+#include "triple_buffer.h"
 #include "yin.h"
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace music_life {
 
@@ -31,17 +39,115 @@ public:
         const char* note_name; ///< e.g. "A4", "C#3"
     };
 
+    /**
+     * Noise gate / voice-activity detector run before every analysis.  Levels
+     * are frame RMS in dBFS, measured from a running sum of squares that is
+     * updated as samples arrive, so a gated hop costs O(hop) and never
+     * reaches YIN.  Frames quieter than -80 dBFS or holding non-finite
+     * samples are always gated.  The defaults gate only those frames.
+     */
+    struct GateConfig {
+        float open_db       = -80.0f; ///< Level at or above which the gate opens
+        float close_db      = -80.0f; ///< Level below which an open gate starts to close (<= open_db)
+        int   hangover_hops = 0;      ///< Hops an open gate stays open below close_db
+    };
+
+    /**
+     * Clean-up filters applied to the input as it enters the analysis ring,
+     * at analysis_sample_rate(): a DC blocker, a high-pass for handling
+     * rumble, notches at the mains frequency and its harmonics, and a gain.
+     * They run as one BiquadCascade fused into the ring write, so the
+     * platform layers need no filter passes of their own.  The defaults
+     * disable every stage.
+     */
+    struct FilterConfig {
+        bool  dc_block      = false;  ///< First-order DC blocker, corner at 5 Hz
+        float high_pass_hz  = 0.0f;   ///< Second-order Butterworth corner; 0 disables
+        float hum_hz        = 0.0f;   ///< Mains frequency, e.g. 50 or 60; 0 disables the notches
+        int   hum_harmonics = 3;      ///< Notches at hum_hz * 1 .. hum_harmonics
+        float hum_q         = 30.0f;  ///< Notch centre over bandwidth
+        float gain_db       = 0.0f;
+    };
+
+    /**
+     * Intermediate data of one analysed hop, for spectrum and YIN-dip
+     * displays.  Spectrum and lags are at analysis_sample_rate(): CMNDF
+     * entry tau is the lag of tau analysis samples.
+     */
+    struct Snapshot {
+        uint64_t frame_index = 0;         ///< frames_analysed() after the hop
+        int   analysis_sample_rate = 0;
+        int   analysis_frame_size = 0;    ///< Frame YIN analysed, in analysis samples
+        float frequency = 0.0f;           ///< Pitch reported for the hop; 0 if unpitched
+        float probability = 0.0f;
+        float bin_hz = 0.0f;              ///< Width of one spectrum bin
+        int   spectrum_size = 0;
+        int   cmndf_size = 0;
+        std::vector<float> spectrum;      ///< Peak-pooled magnitudes; first spectrum_size valid
+        std::vector<float> cmndf;         ///< YIN d'(tau); first cmndf_size valid
+    };
+
     /**
      * @param sample_rate   Audio sample rate in Hz.
      * @param frame_size    Analysis frame size in samples (power of 2 recommended).
      * @param threshold     YIN threshold [0,1] – lower values = stricter detection.
+     * @param adaptive_frame_size  If true, YIN engines at frame_size / 2 and
+     *                      frame_size / 4 (down to 256 samples) are
+     *                      preallocated, and each hop analyses with the
+     *                      shortest frame that still resolves the current
+     *                      pitch.  Frame and hop shrink for high notes; any
+     *                      loss of confidence returns to the full frame.
+     * @param decimation    Internal rate reduction in [1, 4].  Input is
+     *                      low-pass filtered and decimated by a polyphase
+     *                      Resampler as it enters the ring, and YIN runs at
+     *                      sample_rate / decimation on frame_size / decimation
+     *                      samples, cutting FFT size and per-hop cost by the
+     *                      same factor.  YIN needs a period of about five
+     *                      samples, so the highest note must stay below
+     *                      sample_rate / (5 * decimation), e.g. 2.4 kHz at
+     *                      48 kHz / 4.  frame_size must be a multiple of
+     *                      decimation.
      */
     explicit PitchDetector(int sample_rate,
                            int frame_size = 2048,
                            float threshold = 0.10f,
-                           float reference_pitch_hz = 440.0f);
+                           float reference_pitch_hz = 440.0f,
+                           bool adaptive_frame_size = false,
+                           int decimation = 1);
+
+    ~PitchDetector();
 
-    ~PitchDetector() = default;
+    PitchDetector(const PitchDetector&) = delete;
+    PitchDetector& operator=(const PitchDetector&) = delete;
+
+    /** Analysis settings that reconfigure() can change while running. */
+    struct AnalysisConfig {
+        int        frame_size          = 2048;   ///< Input samples; a multiple of decimation()
+        float      threshold           = 0.10f;  ///< YIN threshold [0, 1]
+        bool       adaptive_frame_size = false;
+        FftBackend fft_backend         = FftBackend::Auto;
+    };
+
+    /**
+     * Replace the YIN engines without stopping the stream.  Everything that
+     * allocates (engines, FFT plans, a ring sized for the new frame) is
+     * built here on the calling thread and handed over lock-free; the
+     * processing thread swaps it in whole at its next hop, copying across
+     * the newest min(old, new) frame of input history and keeping the last
+     * result, gate, reference pitch and tuner state.  A frame no longer than
+     * the history already held analyses at the next hop; a longer one holds
+     * the last result until it has filled.  The engines swapped out are
+     * freed here once a running stream has taken the new ones (waiting at
+     * most 50 ms), else by the next reconfigure() or the destructor;
+     * never on the processing thread.  Sample rate and decimation are fixed.
+     *
+     * One control thread; channel detectors follow.  Throws
+     * std::invalid_argument unless frame_size is a multiple of decimation()
+     * leaving > 1 sample and threshold is in [0, 1].
+     */
+    void reconfigure(const AnalysisConfig& config);
+    /** Settings of the latest reconfigure(), or of construction. */
+    const AnalysisConfig& analysis_config() const { return config_; }
 
     /**
      * Process a mono audio buffer.
@@ -56,26 +162,274 @@ public:
      */
     Result process(const float* samples, int num_samples);
 
+    /**
+     * Process a block of any length and report every hop that falls inside it.
+     *
+     * Unlike process(), which analyses at most once per call, the block is fed
+     * hop by hop so each analysis sees the frame ending at its own position in
+     * the block.  Hops beyond max_out keep the hop timing intact but are not
+     * analysed.
+     *
+     * @param samples      Mono float samples [-1, 1].
+     * @param num_samples  Number of samples in the block (no upper limit).
+     * @param out          Receives up to max_out results in chronological order.
+     * @param max_out      Capacity of out (and end_offsets).
+     * @param end_offsets  Optional; receives, per result, the index in samples
+     *                     one past the last sample of the analysed frame.
+     * @return             Number of results written.
+     */
+    int process_block(const float* samples,
+                      int num_samples,
+                      Result* out,
+                      int max_out,
+                      int* end_offsets = nullptr);
+
+    /** Most channels the interleaved entry points accept. */
+    static constexpr int kMaxChannels = 8;
+
+    /**
+     * process() / process_block() for interleaved multichannel input, such
+     * as stereo or 4-channel USB interfaces and multi-input routes.  Frames
+     * are folded to mono while they are copied into the analysis ring (or
+     * the decimator and tuner staging), so there is no separate
+     * de-interleave pass and no allocation.  Sizes and offsets are in frames.
+     *
+     * @param weights  `channels` downmix gains; null averages all channels.
+     *                 A single non-zero weight of exactly 1 selects that
+     *                 channel and never reads the others, so a faulty input
+     *                 elsewhere cannot gate the frame.
+     * Throws std::invalid_argument unless 1 <= channels <= kMaxChannels.
+     */
+    Result process_interleaved(const float* samples, int num_frames, int channels, const float* weights = nullptr);
+    int    process_block_interleaved(const float* samples,
+                                     int num_frames,
+                                     int channels,
+                                     const float* weights,
+                                     Result* out,
+                                     int max_out,
+                                     int* end_offsets = nullptr);
+
+    /**
+     * Detect every channel of an interleaved input separately.  Each channel
+     * gets its own ring, noise gate, adaptive frame and tuner state, but all
+     * of them run on this detector's YIN engines, so the FFT plans and
+     * scratch are shared; channels are analysed in turn on the calling
+     * thread.  Reference pitch, gate, target and reset() follow this
+     * detector; snapshots cover the mono and downmix paths only.
+     * Allocates: call before processing starts.  Throws
+     * std::invalid_argument unless 1 <= channels <= kMaxChannels.
+     */
+    void enable_channel_detection(int channels);
+    /** Channels set by enable_channel_detection(); 0 if disabled. */
+    int  channel_count() const { return static_cast<int>(channel_detectors_.size()); }
+    /**
+     * process() for each channel: reads num_frames frames of channel_count()
+     * interleaved channels and writes one result per channel to out.
+     * @return channel_count().
+     */
+    int  process_channels(const float* samples, int num_frames, Result* out);
+    /** State of one channel's detection, e.g. for frames_analysed(). */
+    const PitchDetector& channel(int index) const { return *channel_detectors_[static_cast<size_t>(index)]; }
+
+    // Sizes below are in input samples, whatever the decimation.
+
+    /** Number of new samples before the next analysis (half the active frame,
+     *  or strobe_hop_size() while a target is set). */
+    int hop_size() const { return active_target_hz_ > 0.0f ? strobe_.hop_size() : analysis_hop() * decimation_; }
+    /** Smallest hop_size() this detector can switch to without a target. */
+    int min_hop_size() const { return engines_.back().frame_size / 2 * decimation_; }
+    /** Hop of the targeted tuner mode; see set_target(). */
+    int strobe_hop_size() const { return strobe_.hop_size(); }
+    /** Largest analysis frame; the ring always holds this many samples.
+     *  Follows reconfigure() once the processing thread has swapped. */
+    int frame_size() const { return frame_size_ * decimation_; }
+    /** Frame size used for the next analysis. */
+    int active_frame_size() const { return engines_[active_engine_].frame_size * decimation_; }
+    int decimation() const { return decimation_; }
+    int sample_rate() const { return sample_rate_; }
+    /** Rate YIN runs at: sample_rate / decimation. */
+    int analysis_sample_rate() const { return sample_rate_ / decimation_; }
+    /** Total hops that produced a result, gated or not, since construction;
+     *  lets callers tell a fresh result from a repeated one. */
+    uint64_t frames_analysed() const { return frames_analysed_; }
+    /** Hops among frames_analysed() that the noise gate kept from YIN. */
+    uint64_t frames_gated() const { return frames_gated_; }
+    /** Gate state after the most recent hop. */
+    bool gate_open() const { return gate_open_; }
+
+    /**
+     * Replace the input filters.  The coefficients are designed on the
+     * calling thread and handed over through a triple buffer; the processing
+     * thread picks them up at its next write into the ring without waiting
+     * or allocating, and keeps the filter state when the number of stages is
+     * unchanged.  The noise gate measures the filtered input.  Target mode
+     * bypasses the filters.  One control thread; channel detectors follow.
+     * Throws std::invalid_argument unless high_pass_hz is 0 or in [10, 1000],
+     * hum_hz is 0 or in [20, 500], hum_harmonics is in [1, 4], hum_q is in
+     * [1, 200], gain_db is in [-40, 40], and high_pass_hz and hum_hz are
+     * below analysis_sample_rate() / 2; harmonic notches above that are left
+     * out.
+     */
+    void set_input_filter(const FilterConfig& config);
+    /** Settings of the latest set_input_filter(). */
+    const FilterConfig& input_filter() const { return filter_config_; }
+
+    /** Safe to call while another thread processes; applies from the next hop.
+     *  Throws std::invalid_argument unless -120 <= close_db <= open_db <= 0
+     *  and 0 <= hangover_hops <= 1000. */
+    void set_noise_gate(const GateConfig& config);
+    GateConfig noise_gate() const;
+
+    /**
+     * Publish a Snapshot for every hop YIN analyses (gated hops publish
+     * nothing), through a triple buffer that a UI thread polls with
+     * latest_snapshot().  The spectrum is the FFT YIN already computed,
+     * pooled to spectrum_bins; the audio thread only pools and copies, and
+     * never waits for the reader.  Allocates: call before processing starts.
+     * Throws std::invalid_argument unless 1 <= spectrum_bins <= 8192.
+     */
+    void enable_snapshots(int spectrum_bins);
+
+    /**
+     * Single consumer, any thread.  Newest snapshot, or nullptr if none was
+     * published yet.  The returned data stays valid and unchanged until the
+     * next call; compare frame_index to tell a new snapshot from a repeat.
+     */
+    const Snapshot* latest_snapshot();
+
+    /**
+     * Targeted tuner mode for a selected string or note.  While a target is
+     * set, process() and process_block() skip YIN and run a StrobeTuner on
+     * the input: a SIMD bank of demodulators at the target and its first
+     * harmonics, reporting every strobe_hop_size() samples (about 2.7 ms)
+     * with sub-0.1-cent resolution on a steady tone, for a fraction of the
+     * cost of a YIN hop.  Pitches more than 100 cents from the target are
+     * reported unpitched.  The noise gate, adaptive frame size, decimation
+     * and snapshots apply to YIN only.
+     *
+     * Safe to call while another thread processes; applies from the next
+     * call, which restarts the state of the mode it enters.  0 returns to
+     * YIN.  Throws std::invalid_argument unless target_hz is 0 or in
+     * [20, 4200) and below sample_rate / 2.
+     */
+    void  set_target(float target_hz);
+    float target() const { return target_hz_.load(std::memory_order_relaxed); }
+    /** Fundamental phase against the target after the latest strobe hop, in
+     *  cycles [0, 1); it turns at the tuning error, like a strobe disc.
+     *  Safe to read from any thread. */
+    float strobe_phase() const { return strobe_phase_.load(std::memory_order_relaxed); }
+
     /** Reset internal state (call on stream restart). */
     void reset();
     void set_reference_pitch(float reference_pitch_hz);
 
 private:
     int   sample_rate_;
-    int   frame_size_;
+    int   decimation_;
+    int   frame_size_;       ///< Largest analysis frame at the decimated rate
     std::atomic<float> reference_pitch_hz_;
-    std::unique_ptr<Yin> yin_;
+
+    struct Engine {
+        std::shared_ptr<Yin> yin;            ///< Shared with channel_detectors_
+        std::vector<float>   workspace;
+        int                  frame_size;
+        float                min_frequency;  ///< Lowest pitch whose period fits the YIN window
+    };
+    std::vector<Engine> engines_;       ///< Longest frame first; one entry unless adaptive
+    int                 active_engine_;
+    int                 shorter_votes_; ///< Consecutive hops that asked for a shorter frame
 
     std::atomic<bool>  reset_pending_;  ///< Set by reset(); consumed lock-free by process()
-    std::vector<float> ring_buffer_;
-    std::vector<float> frame_buffer_;
-    std::vector<float> yin_workspace_;
-    int                write_pos_;
+    std::unique_ptr<Resampler> decimator_;  ///< Null when decimation_ == 1
+    std::vector<float> decimated_;      ///< Decimator output for one ingest chunk
+    std::vector<float> folded_;         ///< Interleaved input folded to mono for the decimator or tuner
+    std::unique_ptr<MirroredRingBuffer> ring_buffer_;  ///< Latest frame is always contiguous; no frame copy
     int                samples_ready_;
     int                samples_since_last_process_;
+    uint64_t           frames_analysed_;
+
+    // Running energy of the newest frame_size_ samples; non-finite samples
+    // are counted instead of summed so they can leave the window again.
+    double             frame_energy_;
+    int                frame_nonfinite_;
+    int                samples_since_energy_refresh_;
+
+    std::atomic<float> gate_open_mean_square_;
+    std::atomic<float> gate_close_mean_square_;
+    std::atomic<int>   gate_hangover_hops_;
+    bool               gate_open_;
+    int                gate_hangover_left_;
+    uint64_t           frames_gated_;
 
     Result last_result_;
 
+    std::unique_ptr<TripleBuffer<Snapshot>> snapshots_;  ///< Null unless enable_snapshots()
+    int                snapshot_bins_;
+
+    StrobeTuner        strobe_;
+    std::atomic<float> target_hz_;         ///< Set by set_target(); 0 runs YIN
+    float              active_target_hz_;  ///< Target the processing thread is running
+    std::atomic<float> strobe_phase_;
+
+    std::vector<std::unique_ptr<PitchDetector>> channel_detectors_;  ///< Empty unless enable_channel_detection()
+
+    BiquadCascade      input_filter_;      ///< Fused into write_samples(); state is per detector
+    FilterConfig       filter_config_;     ///< Control thread only
+
+    /** Engines and ring built by reconfigure(); after the swap, the state
+     *  they replaced. */
+    struct Analysis {
+        std::vector<Engine> engines;
+        std::unique_ptr<MirroredRingBuffer> ring;
+        int frame_size;  ///< Decimated
+        Analysis* next_retired = nullptr;  ///< Link in retired_analysis_
+    };
+    AnalysisConfig        config_;            ///< Control thread only
+    std::atomic<Analysis*> pending_analysis_;  ///< Owned; taken by the processing thread at a hop
+    std::atomic<Analysis*> retired_analysis_;  ///< Owned list; swapped-out state awaiting the control thread
+
+    /** Input as the ingest path sees it; mono when channels == 1 without weights. */
+    struct Input {
+        const float* samples;
+        int          channels;
+        const float* weights;  ///< Downmix gains; null reads `channel` alone
+        int          channel;
+
+        bool  is_mono() const { return channels == 1 && weights == nullptr; }
+        Input from(int frame) const {
+            return Input{samples + static_cast<ptrdiff_t>(frame) * channels, channels, weights, channel};
+        }
+    };
+
+    /** Shared by the public constructor and channel detectors; engines are
+     *  built by the caller, or shared with `engines_from` when non-null. */
+    PitchDetector(int sample_rate, int frame_size, float reference_pitch_hz, int decimation,
+                  const PitchDetector* engines_from);
+
+    static std::vector<Engine> make_engines(int analysis_rate, int frame_size, float threshold,
+                                            bool adaptive_frame_size, FftBackend fft_backend);
+    void   publish_analysis(std::unique_ptr<Analysis> analysis);
+    bool   analysis_swapped() const;
+    void   reclaim_retired_analysis();
+    void   apply_pending_analysis();
+    static Input make_input(const float* samples, int channels, const float* weights, float* average);
+    Result process_input(const Input& input, int num_frames);
+    int    process_block_input(const Input& input, int num_frames, Result* out, int max_out, int* end_offsets);
+    const float* fold(const Input& input, int num_frames);
+    void   apply_pending_reset();
+    void   apply_pending_target();
+    void   clear_analysis_state();
+    int    process_target(const Input& input, int num_frames, Result* out, int max_out, int* end_offsets);
+    Result make_result(float frequency, float probability) const;
+    int    ingest(const Input& input, int num_frames);
+    void   write_samples(const Input& input, int num_frames);
+    void   refresh_frame_energy();
+    bool   update_gate();
+    Result analyse_frame();
+    void   select_engine(const Result& result);
+    void   publish_snapshot(const Engine& engine, const Result& result);
+    int    analysis_hop() const { return engines_[active_engine_].frame_size / 2; }
+
     int   frequency_to_midi(float frequency, float reference_pitch_hz) const;
     float midi_to_frequency(int midi_note, float reference_pitch_hz) const;
     static float cents_between(float f1, float f2);
@@ -0,0 +1,207 @@
+#include "practice_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+// Time constant of the running average taken as the sustained pitch; long
+// next to a vibrato period, short next to a held note.
+static constexpr double kTrendSeconds = 0.25;
+static constexpr float  kHistogramCents = 100.0f;  // Span of the histogram
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+PracticeStats::PracticeStats(int sample_rate)
+    : PracticeStats(sample_rate, Config{})
+{
+}
+
+PracticeStats::PracticeStats(int sample_rate, const Config& config)
+    : sample_rate_(sample_rate)
+    , config_(config)
+    , reset_pending_(false)
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+    if (!(config.min_probability >= 0.0f && config.min_probability <= 1.0f)) {
+        throw std::invalid_argument("min_probability must be in [0, 1]");
+    }
+    if (!(config.in_tune_cents > 0.0f && config.in_tune_cents <= 50.0f)) {
+        throw std::invalid_argument("in_tune_cents must be in (0, 50]");
+    }
+    if (!(config.min_vibrato_hz > 0.0f && config.min_vibrato_hz < config.max_vibrato_hz) ||
+        !(config.min_vibrato_cents > 0.0f)) {
+        throw std::invalid_argument("vibrato band must satisfy 0 < min_vibrato_hz < max_vibrato_hz, min_vibrato_cents > 0");
+    }
+    clear();
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void PracticeStats::reset() {
+    reset_pending_.store(true, std::memory_order_release);
+}
+
+void PracticeStats::push(const PitchDetector::Result& result, int64_t end_sample) {
+    apply_pending_reset();
+
+    const bool continuous = last_end_sample_ >= 0 && end_sample > last_end_sample_ &&
+        static_cast<double>(end_sample - last_end_sample_) <= kMaxHopSeconds * static_cast<double>(sample_rate_);
+    double hop_seconds = last_hop_seconds_;
+    if (continuous) {
+        hop_seconds = static_cast<double>(end_sample - last_end_sample_) / static_cast<double>(sample_rate_);
+        last_hop_seconds_ = hop_seconds;
+        total_seconds_ += hop_seconds;
+    }
+    last_end_sample_ = end_sample;
+    ++hops_;
+
+    const bool voiced = result.pitched && result.probability >= config_.min_probability &&
+        std::isfinite(result.cents_offset) && result.midi_note >= 0 && result.midi_note < kNotes;
+    if (!voiced || !continuous) end_run();
+    if (!voiced) return;
+
+    const int    note  = result.midi_note;
+    const double cents = static_cast<double>(result.cents_offset);
+    const double pitch = static_cast<double>(note) * 100.0 + cents;
+    if (in_run_ && std::fabs(pitch - last_pitch_cents_) > kMaxGlideCents) end_run();
+    if (!in_run_) {
+        in_run_            = true;
+        run_note_          = note;
+        run_seconds_       = 0.0;
+        trend_cents_       = pitch;
+        rising_            = false;
+        last_rise_seconds_ = -1.0;
+        peak_cents_        = 0.0;
+        trough_cents_      = 0.0;
+    }
+    last_pitch_cents_ = pitch;
+    run_seconds_ += hop_seconds;
+    trend_cents_ += (1.0 - std::exp(-hop_seconds / kTrendSeconds)) * (pitch - trend_cents_);
+    const double deviation = pitch - trend_cents_;
+
+    const bool in_tune = std::fabs(result.cents_offset) <= config_.in_tune_cents;
+    const int  bin = std::clamp(static_cast<int>(std::floor((result.cents_offset + 0.5f * kHistogramCents) *
+                                                            (kHistogramBins / kHistogramCents))),
+                                0, kHistogramBins - 1);
+    for (Accumulator* acc : {&notes_[note], &overall_}) {
+        ++acc->hops;
+        acc->seconds += hop_seconds;
+        const double delta = cents - acc->mean_cents;
+        acc->mean_cents += delta / static_cast<double>(acc->hops);
+        acc->m2_cents   += delta * (cents - acc->mean_cents);
+        acc->deviation_squared += deviation * deviation;
+        if (in_tune) ++acc->in_tune;
+        ++acc->histogram[bin];
+    }
+    track_vibrato(deviation, note);
+}
+
+void PracticeStats::summarize(Summary& out) const {
+    out.hops          = hops_;
+    out.total_seconds = static_cast<float>(total_seconds_);
+    summarize_note(overall_, -1, in_run_ ? run_seconds_ : 0.0, out.overall);
+    out.note_count = 0;
+    for (int note = 0; note < kNotes; ++note) {
+        if (notes_[note].hops == 0) continue;
+        const double current = in_run_ && run_note_ == note ? run_seconds_ : 0.0;
+        summarize_note(notes_[note], note, current, out.notes[out.note_count++]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+void PracticeStats::apply_pending_reset() {
+    if (reset_pending_.exchange(false, std::memory_order_acq_rel)) clear();
+}
+
+void PracticeStats::clear() {
+    std::memset(notes_, 0, sizeof(notes_));
+    std::memset(&overall_, 0, sizeof(overall_));
+    hops_              = 0;
+    total_seconds_     = 0.0;
+    last_end_sample_   = -1;
+    last_hop_seconds_  = 0.0;
+    in_run_            = false;
+    run_note_          = -1;
+    run_seconds_       = 0.0;
+    last_pitch_cents_  = 0.0;
+    trend_cents_       = 0.0;
+    rising_            = false;
+    last_rise_seconds_ = -1.0;
+    peak_cents_        = 0.0;
+    trough_cents_      = 0.0;
+}
+
+void PracticeStats::end_run() {
+    if (!in_run_) return;
+    Accumulator& note = notes_[run_note_];
+    note.longest_run_seconds     = std::max(note.longest_run_seconds, run_seconds_);
+    overall_.longest_run_seconds = std::max(overall_.longest_run_seconds, run_seconds_);
+    in_run_ = false;
+}
+
+void PracticeStats::track_vibrato(double deviation, int midi_note) {
+    // Crossings need half the smallest depth in either direction, so noise
+    // around the average does not count as cycles.
+    const double hysteresis = 0.5 * static_cast<double>(config_.min_vibrato_cents);
+    peak_cents_   = std::max(peak_cents_, deviation);
+    trough_cents_ = std::min(trough_cents_, deviation);
+    if (deviation < -hysteresis) {
+        rising_ = false;
+        return;
+    }
+    if (rising_ || deviation <= hysteresis) return;
+
+    // Rising crossing: one full cycle since the previous one.
+    rising_ = true;
+    if (last_rise_seconds_ >= 0.0) {
+        const double period = run_seconds_ - last_rise_seconds_;
+        const double depth  = 0.5 * (peak_cents_ - trough_cents_);
+        const double rate   = period > 0.0 ? 1.0 / period : 0.0;
+        if (rate >= config_.min_vibrato_hz && rate <= config_.max_vibrato_hz && depth >= config_.min_vibrato_cents) {
+            for (Accumulator* acc : {&notes_[midi_note], &overall_}) {
+                ++acc->vibrato_cycles;
+                acc->vibrato_rate_sum  += rate;
+                acc->vibrato_depth_sum += depth;
+            }
+        }
+    }
+    last_rise_seconds_ = run_seconds_;
+    peak_cents_   = deviation;
+    trough_cents_ = deviation;
+}
+
+void PracticeStats::summarize_note(const Accumulator& acc,
+                                   int midi_note,
+                                   double current_run_seconds,
+                                   NoteStats& out) const {
+    const double hops = static_cast<double>(std::max<uint64_t>(acc.hops, 1));
+    out.midi_note               = midi_note;
+    out.hops                    = static_cast<uint32_t>(std::min<uint64_t>(acc.hops, UINT32_MAX));
+    out.seconds                 = static_cast<float>(acc.seconds);
+    out.mean_cents              = static_cast<float>(acc.mean_cents);
+    out.stddev_cents            = static_cast<float>(std::sqrt(acc.m2_cents / hops));
+    out.in_tune_ratio           = static_cast<float>(static_cast<double>(acc.in_tune) / hops);
+    out.stability_cents         = static_cast<float>(std::sqrt(acc.deviation_squared / hops));
+    out.longest_sustain_seconds = static_cast<float>(std::max(acc.longest_run_seconds, current_run_seconds));
+    out.vibrato_cycles          = acc.vibrato_cycles;
+    const double cycles = static_cast<double>(std::max<uint32_t>(acc.vibrato_cycles, 1));
+    out.vibrato_rate_hz         = static_cast<float>(acc.vibrato_rate_sum / cycles);
+    out.vibrato_depth_cents     = static_cast<float>(acc.vibrato_depth_sum / cycles);
+    std::memcpy(out.histogram, acc.histogram, sizeof(out.histogram));
+}
+
+} // namespace music_life
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "pitch_detector.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace music_life {
+
+/**
+ * Practice-session statistics accumulated from the PitchDetector::Result
+ * stream as it is produced: per-note intonation histograms, cents mean and
+ * spread, sustain stability and vibrato rate and depth.
+ *
+ * Hops below min_probability are unvoiced.  Consecutive voiced hops whose
+ * pitch moves less than kMaxGlideCents per hop form a run, one sustained
+ * tone.  Within a run pitch is followed in absolute cents (midi_note * 100 +
+ * cents_offset), so a vibrato that crosses a semitone boundary stays one
+ * tone, and a slow running average of it is the sustained pitch.  Stability
+ * is the RMS distance from that average; a vibrato cycle is counted at each
+ * rising crossing of it whose rate and depth fall in the configured band.
+ *
+ * push() is O(1) with fixed memory (one accumulator per MIDI note, running
+ * Welford moments), so a session of any length is summarised as soon as its
+ * last hop is pushed.  summarize() is O(kNotes): call it now and then, not
+ * every hop.  No allocation after construction.
+ *
+ * Usage:
+ *   PracticeStats stats(48000);
+ *   stats.push(result, end_sample);   // every hop
+ *   stats.summarize(summary);         // any time, same thread
+ */
+class PracticeStats {
+public:
+    static constexpr int   kNotes          = 128;
+    static constexpr int   kHistogramBins  = 20;      ///< 5-cent bins over [-50, 50] cents
+    static constexpr float kMaxGlideCents  = 50.0f;   ///< Larger hop-to-hop moves start a new run
+    static constexpr float kMaxHopSeconds  = 0.25f;   ///< Longer gaps between hops end the run
+
+    struct Config {
+        float min_probability   = 0.8f;   ///< Confidence for a hop to count as voiced
+        float in_tune_cents     = 10.0f;  ///< Largest |cents_offset| counted as in tune
+        float min_vibrato_hz    = 3.0f;
+        float max_vibrato_hz    = 10.0f;
+        float min_vibrato_cents = 5.0f;   ///< Smallest depth (half peak-to-peak) counted as vibrato
+    };
+
+    struct NoteStats {
+        int      midi_note;                ///< -1 for the whole-session entry
+        uint32_t hops;                     ///< Voiced hops
+        float    seconds;                  ///< Voiced time
+        float    mean_cents;
+        float    stddev_cents;
+        float    in_tune_ratio;            ///< Share of hops within in_tune_cents
+        float    stability_cents;          ///< RMS distance from the sustained pitch
+        float    longest_sustain_seconds;  ///< Longest run that started on this note
+        uint32_t vibrato_cycles;
+        float    vibrato_rate_hz;          ///< Mean over cycles; 0 without vibrato
+        float    vibrato_depth_cents;      ///< Mean half peak-to-peak over cycles
+        uint32_t histogram[kHistogramBins];
+    };
+
+    struct Summary {
+        uint64_t  hops;            ///< Every hop pushed, voiced or not
+        float     total_seconds;   ///< Time covered by the hops, gaps excluded
+        NoteStats overall;         ///< Every voiced hop; midi_note is -1
+        int       note_count;      ///< Entries of notes in use
+        NoteStats notes[kNotes];   ///< Notes with voiced hops, ascending MIDI note
+    };
+
+    /** Throws std::invalid_argument unless sample_rate > 0, probabilities
+     *  and in_tune_cents are in range and min_vibrato_hz < max_vibrato_hz. */
+    explicit PracticeStats(int sample_rate);
+    PracticeStats(int sample_rate, const Config& config);
+
+    /**
+     * Add one hop.
+     *
+     * @param result      Frame result from PitchDetector.
+     * @param end_sample  Absolute index one past the frame's last sample; the
+     *                    distance to the previous hop is the hop's duration.
+     */
+    void push(const PitchDetector::Result& result, int64_t end_sample);
+
+    /** Statistics of every hop so far, including the run in progress. */
+    void summarize(Summary& out) const;
+
+    /** Request a fresh session; applied at the start of the next push(). */
+    void reset();
+
+    const Config& config() const { return config_; }
+    /** True while a sustained tone is being tracked. */
+    bool in_run() const { return in_run_; }
+
+private:
+    struct Accumulator {
+        uint64_t hops;
+        uint64_t in_tune;
+        double   seconds;
+        double   mean_cents;
+        double   m2_cents;           ///< Welford sum of squared deviations
+        double   deviation_squared;  ///< Sum of squared distances from the sustained pitch
+        double   longest_run_seconds;
+        uint32_t vibrato_cycles;
+        double   vibrato_rate_sum;
+        double   vibrato_depth_sum;
+        uint32_t histogram[kHistogramBins];
+    };
+
+    int               sample_rate_;
+    Config            config_;
+    std::atomic<bool> reset_pending_;
+
+    Accumulator notes_[kNotes];
+    Accumulator overall_;
+    uint64_t    hops_;
+    double      total_seconds_;
+    int64_t     last_end_sample_;   ///< -1 before the first hop
+    double      last_hop_seconds_;  ///< Duration given to a hop that follows a gap
+
+    // Run in progress.
+    bool   in_run_;
+    int    run_note_;
+    double run_seconds_;
+    double last_pitch_cents_;
+    double trend_cents_;
+    bool   rising_;
+    double last_rise_seconds_;      ///< Run time of the previous rising crossing; < 0 if none
+    double peak_cents_;
+    double trough_cents_;
+
+    void apply_pending_reset();
+    void clear();
+    void end_run();
+    void track_vibrato(double deviation, int midi_note);
+    void summarize_note(const Accumulator& acc, int midi_note, double current_run_seconds, NoteStats& out) const;
+};
+
+} // namespace music_life
@@ -0,0 +1,114 @@
+#include "resampler.h"
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr int    kMaxFactor          = 16;
+static constexpr int    kTapsPerDecimation  = 16;
+static constexpr double kPassbandFraction   = 0.9;
+static constexpr double kPi                 = 3.14159265358979323846;
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+Resampler::Resampler(int up, int down, int taps_per_phase)
+    : up_(up)
+    , down_(down)
+    , taps_(taps_per_phase)
+    , next_input_(0)
+    , phase_(0)
+{
+    if (up < 1 || up > kMaxFactor || down < 1 || down > kMaxFactor) {
+        throw std::invalid_argument("up and down must be in [1, 16]");
+    }
+    if (taps_per_phase < 0) throw std::invalid_argument("taps_per_phase must be >= 0");
+    if (taps_ == 0) {
+        taps_ = kTapsPerDecimation * ((down + up - 1) / up);
+    }
+
+    // Prototype low-pass at the upsampled rate, cut off at the lower Nyquist
+    // rate and scaled by up_ to make up for the zero-stuffing.
+    const int length = taps_ * up_;
+    const double cutoff = kPassbandFraction * 0.5 / static_cast<double>(std::max(up_, down_));
+    const double centre = 0.5 * static_cast<double>(length - 1);
+    std::vector<double> prototype(static_cast<size_t>(length));
+    for (int i = 0; i < length; ++i) {
+        const double t = static_cast<double>(i) - centre;
+        const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * kPi * cutoff * t) / (kPi * t);
+        const double x = length > 1 ? static_cast<double>(i) / static_cast<double>(length - 1) : 0.5;
+        const double window = 0.42 - 0.5 * std::cos(2.0 * kPi * x) + 0.08 * std::cos(4.0 * kPi * x);
+        prototype[static_cast<size_t>(i)] = sinc * window;
+    }
+    double dc_gain = 0.0;
+    for (double h : prototype) dc_gain += h;
+    const double scale = static_cast<double>(up_) / dc_gain;
+
+    // Phase p applies h[p + j * up] to x[n - j]; store it reversed so the dot
+    // product runs over ascending input x[n - taps + 1 .. n].
+    coeffs_.assign(static_cast<size_t>(length), 0.0f);
+    for (int p = 0; p < up_; ++p) {
+        for (int j = 0; j < taps_; ++j) {
+            coeffs_[static_cast<size_t>(p * taps_ + taps_ - 1 - j)] =
+                static_cast<float>(prototype[static_cast<size_t>(p + j * up_)] * scale);
+        }
+    }
+    history_.assign(static_cast<size_t>(taps_ - 1 + kChunk), 0.0f);
+    reset();
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+int Resampler::process(const float* in, int num_samples, float* out) {
+    const int keep = taps_ - 1;
+    int produced = 0;
+    int consumed = 0;
+    while (consumed < num_samples) {
+        const int chunk = std::min(kChunk, num_samples - consumed);
+        std::memcpy(history_.data() + keep, in + consumed, static_cast<size_t>(chunk) * sizeof(float));
+
+        // history_[keep + i] is input i of this chunk; an output whose newest
+        // input is n reads history_[n .. n + keep].
+        while (next_input_ < chunk) {
+            out[produced++] = simd::dot(history_.data() + next_input_,
+                                        coeffs_.data() + static_cast<size_t>(phase_) * static_cast<size_t>(taps_),
+                                        taps_);
+            phase_ += down_;
+            next_input_ += phase_ / up_;
+            phase_ %= up_;
+        }
+        next_input_ -= chunk;
+
+        std::memmove(history_.data(), history_.data() + chunk, static_cast<size_t>(keep) * sizeof(float));
+        consumed += chunk;
+    }
+    return produced;
+}
+
+int Resampler::max_output(int num_samples) const {
+    if (num_samples <= 0) return 0;
+    return static_cast<int>((static_cast<long long>(num_samples) * up_ + down_ - 1) / down_) + 1;
+}
+
+float Resampler::group_delay() const {
+    return 0.5f * static_cast<float>(taps_ * up_ - 1) / static_cast<float>(up_);
+}
+
+void Resampler::reset() {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    next_input_ = (down_ - 1) / up_;
+    phase_      = 0;
+}
+
+} // namespace music_life
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Streaming polyphase rational resampler (up / down).
+ *
+ * The anti-aliasing low-pass is a Blackman-windowed sinc with its cut-off at
+ * 90 % of the lower of the two Nyquist rates, split into `up` phases of
+ * taps_per_phase coefficients each.  Only the phase needed for an output
+ * sample is evaluated, with one SIMD dot product over the input history, so
+ * decimating by M costs about taps_per_phase multiply-adds per input sample.
+ *
+ * The first output is aligned with input (down - 1) / up, so when decimating
+ * by M every output lands on the last of M inputs.  Storage is allocated once
+ * at construction; process() never allocates and accepts blocks of any length.
+ *
+ * Usage:
+ *   Resampler decimator(1, 4);       // 48 kHz -> 12 kHz
+ *   std::vector<float> out(decimator.max_output(block));
+ *   int n = decimator.process(in, block, out.data());
+ */
+class Resampler {
+public:
+    /**
+     * @param up              Interpolation factor L in [1, 16].
+     * @param down            Decimation factor M in [1, 16].
+     * @param taps_per_phase  Coefficients per phase; 0 picks 16 * ceil(M / L).
+     */
+    Resampler(int up, int down, int taps_per_phase = 0);
+
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    /**
+     * Resample num_samples input samples.
+     *
+     * @param out  Receives the produced samples; must hold max_output(num_samples).
+     * @return Number of samples written.
+     */
+    int process(const float* in, int num_samples, float* out);
+
+    /** Upper bound on the samples process() produces for num_samples input. */
+    int max_output(int num_samples) const;
+
+    /** Input samples needed before the next output sample is produced (>= 1). */
+    int inputs_until_next_output() const { return next_input_ + 1; }
+
+    /** Delay of the filter in input samples. */
+    float group_delay() const;
+
+    /** Clear the history (call on stream restart). */
+    void reset();
+
+    int up() const { return up_; }
+    int down() const { return down_; }
+
+private:
+    static constexpr int kChunk = 256;
+
+    int up_;
+    int down_;
+    int taps_;                ///< Coefficients per phase
+
+    std::vector<float> coeffs_;   ///< up_ phases of taps_ coefficients, time-reversed
+    std::vector<float> history_;  ///< taps_ - 1 previous inputs followed by one chunk
+
+    int next_input_;  ///< Index, relative to the next input, of the newest sample the next output reads
+    int phase_;       ///< Filter phase of the next output
+};
+
+} // namespace music_life
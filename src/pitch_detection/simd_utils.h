@@ -0,0 +1,353 @@
+#pragma once
+
+// Small vector kernels shared by the analysis modules.  Each has a NEON and
+// an SSE3 path plus a scalar tail, mirroring the kernels in yin.cpp.
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE3__)
+#include <pmmintrin.h>
+#endif
+
+namespace music_life {
+namespace simd {
+
+/** Sum of x[0..n). */
+inline float sum(const float* x, int n) {
+    int i = 0;
+    float total = 0.0f;
+#if defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 3 < n; i += 4) {
+        acc = vaddq_f32(acc, vld1q_f32(x + i));
+    }
+    alignas(16) float lanes[4];
+    vst1q_f32(lanes, acc);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__SSE3__)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 3 < n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(x + i));
+    }
+    acc = _mm_hadd_ps(acc, acc);
+    acc = _mm_hadd_ps(acc, acc);
+    total = _mm_cvtss_f32(acc);
+#endif
+    for (; i < n; ++i) total += x[i];
+    return total;
+}
+
+/** Dot product of a[0..n) and b[0..n). */
+inline float dot(const float* a, const float* b, int n) {
+    int i = 0;
+    float total = 0.0f;
+#if defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 3 < n; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    alignas(16) float lanes[4];
+    vst1q_f32(lanes, acc);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__SSE3__)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 3 < n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc = _mm_hadd_ps(acc, acc);
+    acc = _mm_hadd_ps(acc, acc);
+    total = _mm_cvtss_f32(acc);
+#endif
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+/** Sum of max(a[i] - b[i], 0): the half-wave rectified difference used by spectral flux. */
+inline float rectified_diff_sum(const float* a, const float* b, int n) {
+    int i = 0;
+    float total = 0.0f;
+#if defined(__ARM_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t acc = zero;
+    for (; i + 3 < n; i += 4) {
+        acc = vaddq_f32(acc, vmaxq_f32(vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i)), zero));
+    }
+    alignas(16) float lanes[4];
+    vst1q_f32(lanes, acc);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__SSE3__)
+    const __m128 zero = _mm_setzero_ps();
+    __m128 acc = zero;
+    for (; i + 3 < n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)), zero));
+    }
+    acc = _mm_hadd_ps(acc, acc);
+    acc = _mm_hadd_ps(acc, acc);
+    total = _mm_cvtss_f32(acc);
+#endif
+    for (; i < n; ++i) {
+        const float d = a[i] - b[i];
+        if (d > 0.0f) total += d;
+    }
+    return total;
+}
+
+/** Smallest and largest of x[0..n); n must be > 0. */
+inline void min_max(const float* x, int n, float& lo, float& hi) {
+    int i = 0;
+    float mn = x[0];
+    float mx = x[0];
+#if defined(__ARM_NEON)
+    if (n >= 4) {
+        float32x4_t vmin = vld1q_f32(x);
+        float32x4_t vmax = vmin;
+        for (i = 4; i + 3 < n; i += 4) {
+            const float32x4_t v = vld1q_f32(x + i);
+            vmin = vminq_f32(vmin, v);
+            vmax = vmaxq_f32(vmax, v);
+        }
+        alignas(16) float lanes_min[4];
+        alignas(16) float lanes_max[4];
+        vst1q_f32(lanes_min, vmin);
+        vst1q_f32(lanes_max, vmax);
+        mn = std::min(std::min(lanes_min[0], lanes_min[1]), std::min(lanes_min[2], lanes_min[3]));
+        mx = std::max(std::max(lanes_max[0], lanes_max[1]), std::max(lanes_max[2], lanes_max[3]));
+    }
+#elif defined(__SSE3__)
+    if (n >= 4) {
+        __m128 vmin = _mm_loadu_ps(x);
+        __m128 vmax = vmin;
+        for (i = 4; i + 3 < n; i += 4) {
+            const __m128 v = _mm_loadu_ps(x + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+        }
+        alignas(16) float lanes_min[4];
+        alignas(16) float lanes_max[4];
+        _mm_store_ps(lanes_min, vmin);
+        _mm_store_ps(lanes_max, vmax);
+        mn = std::min(std::min(lanes_min[0], lanes_min[1]), std::min(lanes_min[2], lanes_min[3]));
+        mx = std::max(std::max(lanes_max[0], lanes_max[1]), std::max(lanes_max[2], lanes_max[3]));
+    }
+#endif
+    for (; i < n; ++i) {
+        mn = std::min(mn, x[i]);
+        mx = std::max(mx, x[i]);
+    }
+    lo = mn;
+    hi = mx;
+}
+
+/** out[i] = a[i] * b[i]; out may alias a. */
+inline void multiply(const float* a, const float* b, float* out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+#elif defined(__SSE3__)
+    for (; i + 3 < n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; ++i) out[i] = a[i] * b[i];
+}
+
+/** out[i] += a[i] * gain; the overlap-add / mix kernel. */
+inline void multiply_add(const float* a, float gain, float* out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(a + i), g));
+    }
+#elif defined(__SSE3__)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 3 < n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(a + i), g)));
+    }
+#endif
+    for (; i < n; ++i) out[i] += a[i] * gain;
+}
+
+/** out[i] += a[i] * window[i]; the windowed overlap-add kernel. */
+inline void window_add(const float* a, const float* window, float* out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 3 < n; i += 4) {
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(a + i), vld1q_f32(window + i)));
+    }
+#elif defined(__SSE3__)
+    for (; i + 3 < n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(window + i))));
+    }
+#endif
+    for (; i < n; ++i) out[i] += a[i] * window[i];
+}
+
+/** out[i] += min(|a[i] - b[i]|, cap); a per-dimension distance. */
+inline void clamped_abs_diff_add(const float* a, const float* b, float cap, float* out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t c = vdupq_n_f32(cap);
+    for (; i + 3 < n; i += 4) {
+        const float32x4_t d = vminq_f32(vabdq_f32(vld1q_f32(a + i), vld1q_f32(b + i)), c);
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), d));
+    }
+#elif defined(__SSE3__)
+    const __m128 c = _mm_set1_ps(cap);
+    const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 3 < n; i += 4) {
+        const __m128 d = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)), sign_mask);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_min_ps(d, c)));
+    }
+#endif
+    for (; i < n; ++i) out[i] += std::min(std::fabs(a[i] - b[i]), cap);
+}
+
+/** out[i] = cost[i] + min(x[i], y[i], z[i]); the dynamic-time-warping step. */
+inline void min3_add(const float* x, const float* y, const float* z, const float* cost, float* out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 3 < n; i += 4) {
+        const float32x4_t m = vminq_f32(vminq_f32(vld1q_f32(x + i), vld1q_f32(y + i)), vld1q_f32(z + i));
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(cost + i), m));
+    }
+#elif defined(__SSE3__)
+    for (; i + 3 < n; i += 4) {
+        const __m128 m = _mm_min_ps(_mm_min_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)), _mm_loadu_ps(z + i));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(cost + i), m));
+    }
+#endif
+    for (; i < n; ++i) out[i] = cost[i] + std::min(std::min(x[i], y[i]), z[i]);
+}
+
+/**
+ * Fold `frames` interleaved frames of `channels` samples into one mono
+ * stream: out[i] = sum_c in[i * channels + c] * weights[c].  With null
+ * weights, out[i] = in[i * channels + channel] picks one channel instead.
+ * Stereo and 4-channel input are de-interleaved in registers.
+ */
+inline void deinterleave(const float* in, int channels, const float* weights, int channel, float* out, int frames) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    if (channels == 2) {
+        const float32x4_t w0 = vdupq_n_f32(weights ? weights[0] : 0.0f);
+        const float32x4_t w1 = vdupq_n_f32(weights ? weights[1] : 0.0f);
+        for (; i + 3 < frames; i += 4) {
+            const float32x4x2_t x = vld2q_f32(in + i * 2);
+            vst1q_f32(out + i, weights ? vmlaq_f32(vmulq_f32(x.val[0], w0), x.val[1], w1) : x.val[channel]);
+        }
+    } else if (channels == 4) {
+        const float32x4_t w0 = vdupq_n_f32(weights ? weights[0] : 0.0f);
+        const float32x4_t w1 = vdupq_n_f32(weights ? weights[1] : 0.0f);
+        const float32x4_t w2 = vdupq_n_f32(weights ? weights[2] : 0.0f);
+        const float32x4_t w3 = vdupq_n_f32(weights ? weights[3] : 0.0f);
+        for (; i + 3 < frames; i += 4) {
+            const float32x4x4_t x = vld4q_f32(in + i * 4);
+            if (!weights) {
+                vst1q_f32(out + i, x.val[channel]);
+                continue;
+            }
+            float32x4_t acc = vmulq_f32(x.val[0], w0);
+            acc = vmlaq_f32(acc, x.val[1], w1);
+            acc = vmlaq_f32(acc, x.val[2], w2);
+            vst1q_f32(out + i, vmlaq_f32(acc, x.val[3], w3));
+        }
+    }
+#elif defined(__SSE3__)
+    if (channels == 2) {
+        const __m128 w0 = _mm_set1_ps(weights ? weights[0] : 0.0f);
+        const __m128 w1 = _mm_set1_ps(weights ? weights[1] : 0.0f);
+        for (; i + 3 < frames; i += 4) {
+            const __m128 a = _mm_loadu_ps(in + i * 2);
+            const __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+            const __m128 left  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            if (!weights) {
+                _mm_storeu_ps(out + i, channel == 0 ? left : right);
+                continue;
+            }
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(left, w0), _mm_mul_ps(right, w1)));
+        }
+    } else if (channels == 4) {
+        const __m128 w0 = _mm_set1_ps(weights ? weights[0] : 0.0f);
+        const __m128 w1 = _mm_set1_ps(weights ? weights[1] : 0.0f);
+        const __m128 w2 = _mm_set1_ps(weights ? weights[2] : 0.0f);
+        const __m128 w3 = _mm_set1_ps(weights ? weights[3] : 0.0f);
+        for (; i + 3 < frames; i += 4) {
+            __m128 c0 = _mm_loadu_ps(in + i * 4);
+            __m128 c1 = _mm_loadu_ps(in + i * 4 + 4);
+            __m128 c2 = _mm_loadu_ps(in + i * 4 + 8);
+            __m128 c3 = _mm_loadu_ps(in + i * 4 + 12);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            if (!weights) {
+                const __m128 lanes[4] = {c0, c1, c2, c3};
+                _mm_storeu_ps(out + i, lanes[channel]);
+                continue;
+            }
+            __m128 acc = _mm_mul_ps(c0, w0);
+            acc = _mm_add_ps(acc, _mm_mul_ps(c1, w1));
+            acc = _mm_add_ps(acc, _mm_mul_ps(c2, w2));
+            _mm_storeu_ps(out + i, _mm_add_ps(acc, _mm_mul_ps(c3, w3)));
+        }
+    }
+#endif
+    for (; i < frames; ++i) {
+        const float* frame = in + static_cast<long>(i) * channels;
+        if (!weights) {
+            out[i] = frame[channel];
+            continue;
+        }
+        float total = 0.0f;
+        for (int c = 0; c < channels; ++c) total += frame[c] * weights[c];
+        out[i] = total;
+    }
+}
+
+/** Real samples times a window, widened to complex with zero imaginary part. */
+inline void window_to_complex(const float* x, const float* window, std::complex<float>* out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 3 < n; i += 4) {
+        float32x4x2_t interleaved;
+        interleaved.val[0] = vmulq_f32(vld1q_f32(x + i), vld1q_f32(window + i));
+        interleaved.val[1] = zero;
+        vst2q_f32(reinterpret_cast<float*>(out + i), interleaved);
+    }
+#elif defined(__SSE3__)
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 3 < n; i += 4) {
+        const __m128 w = _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(window + i));
+        _mm_storeu_ps(reinterpret_cast<float*>(out + i), _mm_unpacklo_ps(w, zero));
+        _mm_storeu_ps(reinterpret_cast<float*>(out + i + 2), _mm_unpackhi_ps(w, zero));
+    }
+#endif
+    for (; i < n; ++i) out[i] = {x[i] * window[i], 0.0f};
+}
+
+/** power[k] = |x[k]|^2 for k in [0, n). */
+inline void power_spectrum(const std::complex<float>* x, float* power, int n) {
+    int k = 0;
+#if defined(__ARM_NEON)
+    for (; k + 3 < n; k += 4) {
+        const float32x4x2_t parts = vld2q_f32(reinterpret_cast<const float*>(x + k));
+        vst1q_f32(power + k, vmlaq_f32(vmulq_f32(parts.val[0], parts.val[0]), parts.val[1], parts.val[1]));
+    }
+#elif defined(__SSE3__)
+    for (; k + 3 < n; k += 4) {
+        const __m128 lo = _mm_loadu_ps(reinterpret_cast<const float*>(x + k));
+        const __m128 hi = _mm_loadu_ps(reinterpret_cast<const float*>(x + k + 2));
+        _mm_storeu_ps(power + k, _mm_hadd_ps(_mm_mul_ps(lo, lo), _mm_mul_ps(hi, hi)));
+    }
+#endif
+    for (; k < n; ++k) power[k] = std::norm(x[k]);
+}
+
+} // namespace simd
+} // namespace music_life
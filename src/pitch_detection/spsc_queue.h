@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Bounded single-producer / single-consumer queue of trivially copyable
+ * items.  Storage is allocated once at construction; push and pop never
+ * block or allocate, so the producer can be a real-time audio thread.
+ *
+ * When full, push() rejects the item and counts it in dropped().
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /** @param min_capacity  Rounded up to a power of two. */
+    explicit SpscQueue(int min_capacity)
+        : head_(0)
+        , tail_(0)
+        , dropped_(0)
+    {
+        size_t capacity = 1;
+        while (capacity < static_cast<size_t>(min_capacity > 0 ? min_capacity : 1)) capacity <<= 1;
+        items_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /** Producer only. */
+    bool push(const T& item) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[static_cast<size_t>(tail & mask_)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer only.  Copies up to max_out items, oldest first. */
+    int pop(T* out, int max_out) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t available = tail_.load(std::memory_order_acquire) - head;
+        const int count = static_cast<int>(available < static_cast<uint64_t>(max_out) ? available
+                                                                                      : static_cast<uint64_t>(max_out));
+        for (int i = 0; i < count; ++i) {
+            out[i] = items_[static_cast<size_t>((head + static_cast<uint64_t>(i)) & mask_)];
+        }
+        head_.store(head + static_cast<uint64_t>(count), std::memory_order_release);
+        return count;
+    }
+
+    int capacity() const { return static_cast<int>(mask_ + 1); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> items_;
+    uint64_t mask_;
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+    std::atomic<uint64_t> dropped_;
+};
+
+} // namespace music_life
@@ -0,0 +1,329 @@
+#include "strobe_tuner.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE3__)
+#include <pmmintrin.h>
+#endif
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr double kTwoPi = 6.283185307179586476925286766559;
+
+// One-pole bandwidth: at most kMaxBandwidthHz, and narrow enough that the
+// neighbouring harmonic (target_hz away) is rejected by the whole cascade.
+constexpr float kMaxBandwidthHz     = 20.0f;
+constexpr float kBandwidthPerTarget = 1.0f / 8.0f;
+// Time constants per stage before estimates are reported.
+constexpr float kWarmupTimeConstants = 2.0f;
+constexpr float kHarmonicBandLimit   = 0.45f;  // Fraction of the sample rate
+constexpr float kMinProbability      = 0.5f;
+constexpr float kMinMeanSquare       = 1.0e-8f;  // -80 dBFS, as for YIN
+constexpr int   kMinHop              = 16;
+constexpr int   kHopDivisor          = 375;      // sample_rate / 375: 128 at 48 kHz
+
+float wrap_phase(float radians) {
+    return radians - static_cast<float>(kTwoPi) * std::round(radians / static_cast<float>(kTwoPi));
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+StrobeTuner::StrobeTuner(int sample_rate, int hop_size)
+    : sample_rate_(sample_rate)
+    , hop_size_(hop_size > 0 ? hop_size : std::max(kMinHop, sample_rate / kHopDivisor))
+    , target_hz_(0.0f)
+    , alpha_(0.0f)
+    , bandwidth_hz_(0.0f)
+    , warmup_samples_(0)
+    , harmonics_in_band_(0)
+    , osc_cycles_(0.0)
+    , samples_in_hop_(0)
+    , samples_seen_(0)
+    , hops_seen_(0)
+    , history_slot_(0)
+    , latest_{}
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+    if (hop_size < 0) throw std::invalid_argument("hop_size must be >= 0");
+    std::fill(std::begin(step_re_), std::end(step_re_), 1.0f);
+    std::fill(std::begin(step_im_), std::end(step_im_), 0.0f);
+    reset_oscillators();
+}
+
+void StrobeTuner::retune(float target_hz) {
+    if (!std::isfinite(target_hz) || target_hz <= 0.0f || target_hz >= 0.5f * static_cast<float>(sample_rate_)) {
+        throw std::invalid_argument("target_hz must be in (0, sample_rate / 2)");
+    }
+    target_hz_    = target_hz;
+    bandwidth_hz_ = std::min(kMaxBandwidthHz, target_hz * kBandwidthPerTarget);
+    alpha_ = static_cast<float>(1.0 - std::exp(-kTwoPi * bandwidth_hz_ / sample_rate_));
+
+    const double time_constant = 1.0 / (kTwoPi * bandwidth_hz_);
+    warmup_samples_ = static_cast<int>(std::ceil(kWarmupTimeConstants * kStages * time_constant * sample_rate_));
+
+    harmonics_in_band_ = 0;
+    for (int h = 0; h < kHarmonics; ++h) {
+        const double radians = -kTwoPi * (h + 1) * target_hz / sample_rate_;
+        step_re_[h] = static_cast<float>(std::cos(radians));
+        step_im_[h] = static_cast<float>(std::sin(radians));
+        if ((h + 1) * target_hz < kHarmonicBandLimit * static_cast<float>(sample_rate_)) ++harmonics_in_band_;
+    }
+    harmonics_in_band_ = std::max(harmonics_in_band_, 1);  // The fundamental is below Nyquist
+    reset_oscillators();
+}
+
+// ---------------------------------------------------------------------------
+// Processing
+// ---------------------------------------------------------------------------
+
+int StrobeTuner::process(const float* samples, int num_samples, Estimate* out, int max_out, int* end_offsets) {
+    ML_TRACE_SCOPE("strobe.process");
+    if (target_hz_ <= 0.0f || samples == nullptr || num_samples <= 0) return 0;
+
+    int hops = 0;
+    int offset = 0;
+    while (offset < num_samples) {
+        const int chunk = std::min(num_samples - offset, hop_size_ - samples_in_hop_);
+        filter(samples + offset, chunk);
+        offset += chunk;
+        samples_in_hop_ += chunk;
+        samples_seen_ = std::min(samples_seen_ + chunk, warmup_samples_);
+        if (samples_in_hop_ < hop_size_) continue;
+
+        samples_in_hop_ = 0;
+        latest_ = estimate();
+        if (hops < max_out) {
+            out[hops] = latest_;
+            if (end_offsets != nullptr) end_offsets[hops] = offset;
+        }
+        ++hops;
+    }
+    return hops;
+}
+
+void StrobeTuner::filter(const float* samples, int num_samples) {
+    int i = 0;
+#if defined(__SSE3__)
+    static_assert(kHarmonics == 4, "One SSE register holds the harmonic bank.");
+    const __m128 a = _mm_set1_ps(alpha_);
+    const __m128 step_re = _mm_load_ps(step_re_);
+    const __m128 step_im = _mm_load_ps(step_im_);
+    __m128 osc_re = _mm_load_ps(osc_re_);
+    __m128 osc_im = _mm_load_ps(osc_im_);
+    __m128 re[kStages];
+    __m128 im[kStages];
+    for (int s = 0; s < kStages; ++s) {
+        re[s] = _mm_load_ps(state_re_[s]);
+        im[s] = _mm_load_ps(state_im_[s]);
+    }
+    for (; i < num_samples; ++i) {
+        const float sample = std::isfinite(samples[i]) ? samples[i] : 0.0f;
+        const __m128 x = _mm_set1_ps(sample);
+        __m128 in_re = _mm_mul_ps(x, osc_re);
+        __m128 in_im = _mm_mul_ps(x, osc_im);
+        const __m128 next_re = _mm_sub_ps(_mm_mul_ps(osc_re, step_re), _mm_mul_ps(osc_im, step_im));
+        osc_im = _mm_add_ps(_mm_mul_ps(osc_re, step_im), _mm_mul_ps(osc_im, step_re));
+        osc_re = next_re;
+        for (int s = 0; s < kStages; ++s) {
+            re[s] = _mm_add_ps(re[s], _mm_mul_ps(a, _mm_sub_ps(in_re, re[s])));
+            im[s] = _mm_add_ps(im[s], _mm_mul_ps(a, _mm_sub_ps(in_im, im[s])));
+            in_re = re[s];
+            in_im = im[s];
+        }
+        float in = sample * sample;
+        for (int s = 0; s < kStages; ++s) {
+            power_[s] += alpha_ * (in - power_[s]);
+            in = power_[s];
+        }
+    }
+    _mm_store_ps(osc_re_, osc_re);
+    _mm_store_ps(osc_im_, osc_im);
+    for (int s = 0; s < kStages; ++s) {
+        _mm_store_ps(state_re_[s], re[s]);
+        _mm_store_ps(state_im_[s], im[s]);
+    }
+#elif defined(__ARM_NEON)
+    static_assert(kHarmonics == 4, "One NEON register holds the harmonic bank.");
+    const float32x4_t a = vdupq_n_f32(alpha_);
+    const float32x4_t step_re = vld1q_f32(step_re_);
+    const float32x4_t step_im = vld1q_f32(step_im_);
+    float32x4_t osc_re = vld1q_f32(osc_re_);
+    float32x4_t osc_im = vld1q_f32(osc_im_);
+    float32x4_t re[kStages];
+    float32x4_t im[kStages];
+    for (int s = 0; s < kStages; ++s) {
+        re[s] = vld1q_f32(state_re_[s]);
+        im[s] = vld1q_f32(state_im_[s]);
+    }
+    for (; i < num_samples; ++i) {
+        const float sample = std::isfinite(samples[i]) ? samples[i] : 0.0f;
+        float32x4_t in_re = vmulq_n_f32(osc_re, sample);
+        float32x4_t in_im = vmulq_n_f32(osc_im, sample);
+        const float32x4_t next_re = vmlsq_f32(vmulq_f32(osc_re, step_re), osc_im, step_im);
+        osc_im = vmlaq_f32(vmulq_f32(osc_re, step_im), osc_im, step_re);
+        osc_re = next_re;
+        for (int s = 0; s < kStages; ++s) {
+            re[s] = vmlaq_f32(re[s], a, vsubq_f32(in_re, re[s]));
+            im[s] = vmlaq_f32(im[s], a, vsubq_f32(in_im, im[s]));
+            in_re = re[s];
+            in_im = im[s];
+        }
+        float in = sample * sample;
+        for (int s = 0; s < kStages; ++s) {
+            power_[s] += alpha_ * (in - power_[s]);
+            in = power_[s];
+        }
+    }
+    vst1q_f32(osc_re_, osc_re);
+    vst1q_f32(osc_im_, osc_im);
+    for (int s = 0; s < kStages; ++s) {
+        vst1q_f32(state_re_[s], re[s]);
+        vst1q_f32(state_im_[s], im[s]);
+    }
+#endif
+    for (; i < num_samples; ++i) {
+        const float sample = std::isfinite(samples[i]) ? samples[i] : 0.0f;
+        for (int h = 0; h < kHarmonics; ++h) {
+            float in_re = sample * osc_re_[h];
+            float in_im = sample * osc_im_[h];
+            const float next_re = osc_re_[h] * step_re_[h] - osc_im_[h] * step_im_[h];
+            osc_im_[h] = osc_re_[h] * step_im_[h] + osc_im_[h] * step_re_[h];
+            osc_re_[h] = next_re;
+            for (int s = 0; s < kStages; ++s) {
+                state_re_[s][h] += alpha_ * (in_re - state_re_[s][h]);
+                state_im_[s][h] += alpha_ * (in_im - state_im_[s][h]);
+                in_re = state_re_[s][h];
+                in_im = state_im_[s][h];
+            }
+        }
+        float in = sample * sample;
+        for (int s = 0; s < kStages; ++s) {
+            power_[s] += alpha_ * (in - power_[s]);
+            in = power_[s];
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Per-hop estimate
+//
+// Lane h (harmonic h + 1) holds z_h ~ (a_h / 2) * exp(j * 2 pi * (h + 1) * offset * t),
+// so its phase advance over one hop is 2 pi * (h + 1) * offset * hop / fs.
+// The strongest lane is unwrapped on its own and guides the others.  Each
+// lane's offset is then read from its unwrapped phase over the last
+// kSpanHops hops, which averages out the ripple neighbouring harmonics leave
+// after the low-pass, and lanes are combined with weights (h + 1)^2 |z_h|^2,
+// the inverse variance of their offset estimates.
+// ---------------------------------------------------------------------------
+
+StrobeTuner::Estimate StrobeTuner::estimate() {
+    // Re-derive the oscillators from the exact phase so rounding in the
+    // per-sample rotation never accumulates.
+    osc_cycles_ += static_cast<double>(hop_size_) * target_hz_ / sample_rate_;
+    osc_cycles_ -= std::floor(osc_cycles_);
+    for (int h = 0; h < kHarmonics; ++h) {
+        const double radians = -kTwoPi * (h + 1) * osc_cycles_;
+        osc_re_[h] = static_cast<float>(std::cos(radians));
+        osc_im_[h] = static_cast<float>(std::sin(radians));
+    }
+
+    const float* z_re = state_re_[kStages - 1];
+    const float* z_im = state_im_[kStages - 1];
+    const float radians_per_hz = static_cast<float>(kTwoPi * hop_size_ / sample_rate_);
+
+    float phase[kHarmonics];
+    float advance[kHarmonics];
+    float power[kHarmonics];
+    int strongest = 0;
+    for (int h = 0; h < harmonics_in_band_; ++h) {
+        phase[h]   = std::atan2(z_im[h], z_re[h]);
+        advance[h] = wrap_phase(phase[h] - last_phase_[h]);
+        power[h]   = z_re[h] * z_re[h] + z_im[h] * z_im[h];
+        if (power[h] > power[strongest]) strongest = h;
+        last_phase_[h] = phase[h];
+    }
+
+    const float guide_hz = advance[strongest] / (radians_per_hz * (strongest + 1));
+    const int slot = history_slot_;
+    history_slot_ = (history_slot_ + 1) % kSpanHops;
+    hops_seen_ = std::min(hops_seen_ + 1, kSpanHops);
+    const int span = hops_seen_;
+    double weighted_offset = 0.0;
+    double total_weight = 0.0;
+    for (int h = 0; h < harmonics_in_band_; ++h) {
+        const float expected = guide_hz * radians_per_hz * (h + 1);
+        unwrapped_[h] += expected + wrap_phase(advance[h] - expected);
+        const double turned = unwrapped_[h] - phase_history_[slot][h];
+        phase_history_[slot][h] = unwrapped_[h];
+        const double weight = static_cast<double>((h + 1) * (h + 1)) * power[h];
+        weighted_offset += weight * turned / (static_cast<double>(radians_per_hz) * (h + 1) * span);
+        total_weight += weight;
+    }
+
+    Estimate estimate{};
+    estimate.phase = static_cast<float>(phase[0] / kTwoPi);
+    if (estimate.phase < 0.0f) estimate.phase += 1.0f;
+
+    const float mean_square = power_[kStages - 1];
+    if (samples_seen_ < warmup_samples_ || total_weight <= 0.0 || !(mean_square > kMinMeanSquare)) {
+        return estimate;
+    }
+
+    const float offset_hz = static_cast<float>(weighted_offset / total_weight);
+    const float frequency = target_hz_ + offset_hz;
+
+    // Undo the cascade's attenuation at each lane's offset before comparing
+    // the tracked power with the total.
+    double explained = 0.0;
+    for (int h = 0; h < harmonics_in_band_; ++h) {
+        const float relative = (h + 1) * offset_hz / bandwidth_hz_;
+        explained += 2.0 * power[h] * std::pow(1.0 + relative * relative, static_cast<double>(kStages));
+    }
+    const float probability = std::clamp(static_cast<float>(explained / mean_square), 0.0f, 1.0f);
+    const float cents = 1200.0f * std::log2(frequency / target_hz_);
+
+    if (std::isfinite(cents) && std::abs(cents) <= kMaxOffsetCents && probability >= kMinProbability) {
+        estimate.pitched     = true;
+        estimate.frequency   = frequency;
+        estimate.probability = probability;
+    }
+    return estimate;
+}
+
+void StrobeTuner::reset_oscillators() {
+    for (int h = 0; h < kHarmonics; ++h) {
+        osc_re_[h] = 1.0f;
+        osc_im_[h] = 0.0f;
+        last_phase_[h] = 0.0f;
+        unwrapped_[h]  = 0.0;
+        for (int k = 0; k < kSpanHops; ++k) phase_history_[k][h] = 0.0;
+        for (int s = 0; s < kStages; ++s) {
+            state_re_[s][h] = 0.0f;
+            state_im_[s][h] = 0.0f;
+        }
+    }
+    std::fill(std::begin(power_), std::end(power_), 0.0f);
+    osc_cycles_     = 0.0;
+    samples_in_hop_ = 0;
+    samples_seen_   = 0;
+    hops_seen_      = 0;
+    history_slot_   = 0;
+    latest_         = Estimate{};
+}
+
+} // namespace music_life
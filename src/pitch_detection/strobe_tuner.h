@@ -0,0 +1,101 @@
+#pragma once
+
+namespace music_life {
+
+/**
+ * Narrowband tuner for a known target pitch.
+ *
+ * Instead of searching every lag like YIN, the input is demodulated at the
+ * target frequency and its first kHarmonics harmonics (one SIMD lane each)
+ * and every lane is low-passed by kStages cascaded one-pole filters.  The
+ * phase of each lane turns at the offset between the played harmonic and
+ * the target harmonic, so the phase advance over one short hop gives the
+ * frequency with sub-0.1-cent resolution on a steady tone, and the phase of
+ * the fundamental lane is exactly what a strobe display draws.
+ *
+ * Cost is a few multiply-adds per harmonic per input sample, with no FFT,
+ * and an estimate every hop_size() samples (about 2.7 ms).  Tones more than
+ * sample_rate / (2 * hop_size()) Hz from the target alias; estimates report
+ * unpitched beyond kMaxOffsetCents.  All state is fixed-size, so retune()
+ * and process() never allocate and are real-time safe.
+ *
+ * Usage:
+ *   StrobeTuner tuner(48000);
+ *   tuner.retune(110.0f);  // A2
+ *   int hops = tuner.process(buffer, n, estimates, max_out);
+ */
+class StrobeTuner {
+public:
+    static constexpr int   kHarmonics      = 4;
+    static constexpr int   kStages         = 4;
+    static constexpr int   kSpanHops       = 8;
+    static constexpr float kMaxOffsetCents = 100.0f;
+
+    struct Estimate {
+        bool  pitched;
+        float frequency;    ///< Hz; 0 if unpitched
+        float probability;  ///< Share of the signal power explained by the tracked harmonics [0, 1]
+        float phase;        ///< Fundamental phase against the target in cycles [0, 1)
+    };
+
+    /**
+     * @param sample_rate  Input rate in Hz.
+     * @param hop_size     Samples per estimate; 0 picks sample_rate / 375.
+     */
+    explicit StrobeTuner(int sample_rate, int hop_size = 0);
+
+    /** Track a new target in (0, sample_rate / 2) Hz and clear all state.
+     *  Throws std::invalid_argument otherwise. */
+    void retune(float target_hz);
+
+    /**
+     * Filter num_samples samples.
+     *
+     * @param out          Receives up to max_out estimates in order; may be
+     *                     null when max_out is 0.
+     * @param end_offsets  Optional; per estimate, the index in samples one
+     *                     past its last sample.
+     * @return Hops completed in the block, which may exceed max_out.
+     */
+    int process(const float* samples, int num_samples, Estimate* out, int max_out, int* end_offsets = nullptr);
+
+    /** Estimate of the most recent hop. */
+    const Estimate& latest() const { return latest_; }
+
+    float target() const { return target_hz_; }
+    int   hop_size() const { return hop_size_; }
+
+private:
+    int   sample_rate_;
+    int   hop_size_;
+    float target_hz_;
+    float alpha_;             ///< One-pole coefficient shared by every stage
+    float bandwidth_hz_;      ///< -3 dB frequency of one stage
+    int   warmup_samples_;    ///< Samples before the filters have settled
+    int   harmonics_in_band_; ///< Lanes below 0.45 * sample_rate
+
+    // Structure-of-arrays lanes: one harmonic per lane.
+    alignas(16) float osc_re_[kHarmonics];
+    alignas(16) float osc_im_[kHarmonics];
+    alignas(16) float step_re_[kHarmonics];
+    alignas(16) float step_im_[kHarmonics];
+    alignas(16) float state_re_[kStages][kHarmonics];
+    alignas(16) float state_im_[kStages][kHarmonics];
+    float  power_[kStages];   ///< Same low-pass on x^2, for the probability
+    float  last_phase_[kHarmonics];
+    double unwrapped_[kHarmonics];                 ///< Phase summed over all hops
+    double phase_history_[kSpanHops][kHarmonics];  ///< unwrapped_ of the last kSpanHops hops
+    double osc_cycles_;       ///< Fundamental oscillator phase, re-derived every hop
+    int    samples_in_hop_;
+    int    samples_seen_;
+    int    hops_seen_;        ///< Saturates at kSpanHops
+    int    history_slot_;
+
+    Estimate latest_;
+
+    void     filter(const float* samples, int num_samples);
+    void     reset_oscillators();
+    Estimate estimate();
+};
+
+} // namespace music_life
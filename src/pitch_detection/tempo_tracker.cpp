@@ -0,0 +1,170 @@
+#include "tempo_tracker.h"
+
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr float kPriorCentreBpm    = 120.0f;
+static constexpr float kPriorOctaveWidth  = 1.0f;   // std-dev of the prior in octaves
+static constexpr float kMemorySeconds     = 4.0f;   // autocorrelation time constant
+static constexpr float kMinConfidence     = 0.05f;
+static constexpr double kPhaseTolerance   = 0.2;    // fraction of a beat period
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+TempoTracker::TempoTracker(int sample_rate, int hop_size, float min_bpm, float max_bpm)
+    : sample_rate_(sample_rate)
+    , hop_size_(hop_size)
+    , min_lag_(0)
+    , max_lag_(0)
+    , decay_(0.0f)
+    , history_pos_(0)
+    , hops_seen_(0)
+    , bpm_(0.0f)
+    , confidence_(0.0f)
+    , period_samples_(0.0)
+    , last_beat_sample_(-1)
+    , next_beat_sample_(-1)
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+    if (hop_size <= 0) throw std::invalid_argument("hop_size must be > 0");
+    if (!(min_bpm > 0.0f) || !(max_bpm > min_bpm)) {
+        throw std::invalid_argument("bpm range must satisfy 0 < min_bpm < max_bpm");
+    }
+
+    const float hops_per_second = static_cast<float>(sample_rate_) / static_cast<float>(hop_size_);
+    min_lag_ = std::max(1, static_cast<int>(std::floor(60.0f / max_bpm * hops_per_second)));
+    max_lag_ = std::max(min_lag_ + 2, static_cast<int>(std::ceil(60.0f / min_bpm * hops_per_second)));
+    decay_   = std::exp(-1.0f / (kMemorySeconds * hops_per_second));
+
+    const int lags = max_lag_ + 1;
+    history_.assign(static_cast<size_t>(lags) * 2, 0.0f);
+    acf_.assign(static_cast<size_t>(lags), 0.0f);
+    prior_.assign(static_cast<size_t>(lags), 0.0f);
+    for (int lag = min_lag_; lag <= max_lag_; ++lag) {
+        const float bpm = 60.0f * hops_per_second / static_cast<float>(lag);
+        const float octaves = std::log2(bpm / kPriorCentreBpm) / kPriorOctaveWidth;
+        prior_[lag] = std::exp(-0.5f * octaves * octaves);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void TempoTracker::reset() {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    std::fill(acf_.begin(), acf_.end(), 0.0f);
+    history_pos_      = 0;
+    hops_seen_        = 0;
+    bpm_              = 0.0f;
+    confidence_       = 0.0f;
+    period_samples_   = 0.0;
+    last_beat_sample_ = -1;
+    next_beat_sample_ = -1;
+}
+
+void TempoTracker::push(float strength, int64_t hop_end_sample, int64_t onset_sample) {
+    const int lags = max_lag_ + 1;
+    history_pos_ = history_pos_ == 0 ? lags - 1 : history_pos_ - 1;
+    history_[history_pos_]        = strength;
+    history_[history_pos_ + lags] = strength;
+    ++hops_seen_;
+
+    // acf[lag] <- decay * acf[lag] + x[n] * x[n - lag]
+    float* acf = acf_.data();
+    for (int lag = 0; lag < lags; ++lag) acf[lag] *= decay_;
+    simd::multiply_add(history_.data() + history_pos_, strength, acf, lags);
+
+    estimate_tempo();
+    update_phase(hop_end_sample, onset_sample);
+}
+
+// ---------------------------------------------------------------------------
+// Estimation
+// ---------------------------------------------------------------------------
+
+void TempoTracker::estimate_tempo() {
+    if (hops_seen_ <= max_lag_ || acf_[0] <= 0.0f) {
+        bpm_ = 0.0f;
+        confidence_ = 0.0f;
+        period_samples_ = 0.0;
+        return;
+    }
+
+    int best_lag = -1;
+    float best_score = 0.0f;
+    for (int lag = min_lag_; lag <= max_lag_; ++lag) {
+        const float score = acf_[lag] * prior_[lag];
+        if (score > best_score) {
+            best_score = score;
+            best_lag = lag;
+        }
+    }
+    const float confidence = best_lag > 0 ? acf_[best_lag] / acf_[0] : 0.0f;
+    if (best_lag < 0 || confidence < kMinConfidence) {
+        bpm_ = 0.0f;
+        confidence_ = std::max(confidence, 0.0f);
+        period_samples_ = 0.0;
+        return;
+    }
+
+    // Parabolic interpolation around the peak for sub-hop period resolution.
+    float lag = static_cast<float>(best_lag);
+    if (best_lag > min_lag_ && best_lag < max_lag_) {
+        const float a = acf_[best_lag - 1];
+        const float b = acf_[best_lag];
+        const float c = acf_[best_lag + 1];
+        const float denom = a - 2.0f * b + c;
+        if (denom < 0.0f) {
+            lag += std::max(-0.5f, std::min(0.5f, 0.5f * (a - c) / denom));
+        }
+    }
+
+    period_samples_ = static_cast<double>(lag) * hop_size_;
+    bpm_ = static_cast<float>(60.0 * sample_rate_ / period_samples_);
+    confidence_ = std::min(confidence, 1.0f);
+}
+
+void TempoTracker::update_phase(int64_t hop_end_sample, int64_t onset_sample) {
+    if (period_samples_ <= 0.0) {
+        // No tempo yet: remember the latest onset as a phase anchor.
+        if (onset_sample >= 0) {
+            last_beat_sample_ = onset_sample;
+            next_beat_sample_ = -1;
+        }
+        return;
+    }
+
+    const double tolerance = kPhaseTolerance * period_samples_;
+    if (next_beat_sample_ < 0 && last_beat_sample_ >= 0) {
+        next_beat_sample_ = last_beat_sample_ + static_cast<int64_t>(std::llround(period_samples_));
+    }
+
+    if (onset_sample >= 0) {
+        if (next_beat_sample_ < 0 ||
+            std::fabs(static_cast<double>(onset_sample - next_beat_sample_)) <= tolerance) {
+            last_beat_sample_ = onset_sample;
+            next_beat_sample_ = onset_sample + static_cast<int64_t>(std::llround(period_samples_));
+        }
+    }
+
+    // Coast through beats with no supporting onset.
+    while (next_beat_sample_ >= 0 &&
+           static_cast<double>(hop_end_sample) > static_cast<double>(next_beat_sample_) + tolerance) {
+        last_beat_sample_ = next_beat_sample_;
+        next_beat_sample_ += static_cast<int64_t>(std::llround(period_samples_));
+    }
+}
+
+} // namespace music_life
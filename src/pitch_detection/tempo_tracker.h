@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Incremental tempo and beat-phase tracker driven by an onset-strength
+ * envelope (one value per analysis hop).
+ *
+ * The autocorrelation of the envelope is updated with exponential forgetting
+ * on every hop, so memory is fixed at construction and the per-hop cost is
+ * O(max lag).  The tempo is the autocorrelation peak weighted by a log-normal
+ * prior around 120 BPM; beat phase is predicted from the period and snapped
+ * to onsets that land close to the prediction.
+ */
+class TempoTracker {
+public:
+    /**
+     * @param sample_rate  Audio sample rate in Hz.
+     * @param hop_size     Samples between successive push() calls.
+     * @param min_bpm      Slowest tempo considered.
+     * @param max_bpm      Fastest tempo considered.
+     */
+    TempoTracker(int sample_rate, int hop_size, float min_bpm = 40.0f, float max_bpm = 240.0f);
+
+    /**
+     * Add one hop of onset strength.
+     *
+     * @param strength        Non-negative onset strength for the hop.
+     * @param hop_end_sample  Absolute index one past the hop's last sample.
+     * @param onset_sample    Absolute sample position of an onset reported in
+     *                        this hop, or -1 if none.
+     */
+    void push(float strength, int64_t hop_end_sample, int64_t onset_sample);
+
+    void reset();
+
+    /** Current tempo estimate in BPM, or 0 until enough history is available. */
+    float bpm() const { return bpm_; }
+    /** Autocorrelation peak relative to the zero-lag energy, in [0, 1]. */
+    float confidence() const { return confidence_; }
+    /** Beat period in samples, or 0 while bpm() is 0. */
+    double beat_period_samples() const { return period_samples_; }
+    /** Absolute sample position of the most recent beat, or -1. */
+    int64_t last_beat_sample() const { return last_beat_sample_; }
+    /** Predicted absolute sample position of the next beat, or -1. */
+    int64_t next_beat_sample() const { return next_beat_sample_; }
+
+private:
+    int   sample_rate_;
+    int   hop_size_;
+    int   min_lag_;
+    int   max_lag_;
+    float decay_;
+
+    // Envelope history stored twice so history_ + pos is a contiguous,
+    // newest-first view of the last max_lag_ + 1 hops.
+    std::vector<float> history_;
+    int history_pos_;
+    std::vector<float> acf_;
+    std::vector<float> prior_;
+    int64_t hops_seen_;
+
+    float   bpm_;
+    float   confidence_;
+    double  period_samples_;
+    int64_t last_beat_sample_;
+    int64_t next_beat_sample_;
+
+    void estimate_tempo();
+    void update_phase(int64_t hop_end_sample, int64_t onset_sample);
+};
+
+} // namespace music_life
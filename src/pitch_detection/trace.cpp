@@ -0,0 +1,174 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace music_life {
+namespace trace {
+
+namespace {
+
+constexpr uint64_t kEventMask = static_cast<uint64_t>(kEventsPerThread) - 1;
+constexpr size_t   kThreadNameSize = 32;
+
+static_assert((kEventsPerThread & (kEventsPerThread - 1)) == 0, "kEventsPerThread must be a power of two");
+
+// Fields are relaxed atomics so the dump may read a slot the owner is
+// rewriting; such slots are detected through `head` and discarded.
+struct Event {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t>    begin_ns{0};
+    std::atomic<uint64_t>    end_ns{0};
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events{new Event[kEventsPerThread]};
+    std::atomic<uint64_t>    head{0};   ///< Events ever written; owner thread only
+    std::atomic<uint64_t>    tail{0};   ///< First event still visible, moved by clear()
+    int                      tid = 0;
+    char                     name[kThreadNameSize] = {};
+};
+
+// Buffers outlive their threads so a dump after a stream stops still sees
+// them; the registry is capped at kMaxThreads.
+std::mutex g_registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_registry;
+std::atomic<bool> g_registry_full{false};
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer* thread_buffer() noexcept {
+    if (t_buffer != nullptr || g_registry_full.load(std::memory_order_relaxed)) return t_buffer;
+    try {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        if (static_cast<int>(g_registry.size()) >= kMaxThreads) {
+            g_registry_full.store(true, std::memory_order_relaxed);
+            return nullptr;
+        }
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->tid = static_cast<int>(g_registry.size()) + 1;
+        std::snprintf(buffer->name, sizeof(buffer->name), "thread %d", buffer->tid);
+        t_buffer = buffer.get();
+        g_registry.push_back(std::move(buffer));
+    } catch (...) {
+        return nullptr;
+    }
+    return t_buffer;
+}
+
+void append_escaped(std::string& out, const char* text) {
+    for (const char* c = text; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+            out += *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out += *c;
+        }
+    }
+}
+
+} // namespace
+
+uint64_t now_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(const char* name, uint64_t begin_ns, uint64_t end_ns) noexcept {
+    ThreadBuffer* buffer = thread_buffer();
+    if (buffer == nullptr) return;
+    const uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    Event& event = buffer->events[index & kEventMask];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    event.end_ns.store(end_ns, std::memory_order_relaxed);
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+void register_thread(const char* name) noexcept {
+    ThreadBuffer* buffer = thread_buffer();
+    if (buffer == nullptr || name == nullptr) return;
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    std::snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+}
+
+void clear() noexcept {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    for (auto& buffer : g_registry) {
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+std::string chrome_json() {
+    struct Copied {
+        const char* name;
+        uint64_t    begin_ns;
+        uint64_t    end_ns;
+    };
+
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    const auto separator = [&out, &first]() {
+        if (!first) out += ',';
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    std::vector<Copied> events;
+    char number[160];
+    for (const auto& buffer : g_registry) {
+        separator();
+        std::snprintf(number, sizeof(number), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,", buffer->tid);
+        out += number;
+        out += "\"args\":{\"name\":\"";
+        append_escaped(out, buffer->name);
+        out += "\"}}";
+
+        // Copy the newest events, then drop any the owner may have
+        // overwritten meanwhile: slot i is reused by event i + capacity,
+        // which is being written while head == i + capacity.
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t capacity = static_cast<uint64_t>(kEventsPerThread);
+        const uint64_t start = std::max(buffer->tail.load(std::memory_order_relaxed),
+                                        head + 1 > capacity ? head + 1 - capacity : 0);
+        events.clear();
+        for (uint64_t i = start; i < head; ++i) {
+            const Event& event = buffer->events[i & kEventMask];
+            events.push_back(Copied{event.name.load(std::memory_order_relaxed),
+                                    event.begin_ns.load(std::memory_order_relaxed),
+                                    event.end_ns.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t head_after = buffer->head.load(std::memory_order_relaxed);
+        const uint64_t first_intact = head_after + 1 > capacity ? head_after + 1 - capacity : 0;
+        const size_t skip = static_cast<size_t>(std::min<uint64_t>(first_intact > start ? first_intact - start : 0,
+                                                                   events.size()));
+
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Copied& event = events[i];
+            if (event.name == nullptr) continue;
+            separator();
+            out += "{\"name\":\"";
+            append_escaped(out, event.name);
+            std::snprintf(number, sizeof(number),
+                          "\",\"cat\":\"music_life\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                          "\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u}",
+                          buffer->tid,
+                          event.begin_ns / 1000, static_cast<unsigned>(event.begin_ns % 1000),
+                          (event.end_ns - event.begin_ns) / 1000,
+                          static_cast<unsigned>((event.end_ns - event.begin_ns) % 1000));
+            out += number;
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace trace
+} // namespace music_life
@@ -0,0 +1,77 @@
+#pragma once
+
+// Per-stage timing trace points.
+//
+// ML_TRACE_SCOPE("stage") times the enclosing scope.  With ML_TRACING off
+// (the default; see the ML_ENABLE_TRACING CMake option) it expands to
+// nothing.  With it on, each scope writes one complete event into a
+// fixed-size ring owned by the calling thread: no locks, no allocation
+// after the thread's first event, and old events are overwritten once the
+// ring is full.  chrome_json() turns every thread's ring into Chrome /
+// Perfetto trace JSON.
+
+#include <cstdint>
+#include <string>
+
+#ifndef ML_TRACING
+#define ML_TRACING 0
+#endif
+
+namespace music_life {
+namespace trace {
+
+/** Ring slots per thread; the newest kEventsPerThread - 1 events are kept
+ *  (one slot is always the one being written). */
+constexpr int kEventsPerThread = 1 << 14;
+/** Threads that can hold a buffer; events from further threads are dropped. */
+constexpr int kMaxThreads = 64;
+
+constexpr bool enabled() { return ML_TRACING != 0; }
+
+/** Steady-clock nanoseconds, the time base of every event. */
+uint64_t now_ns() noexcept;
+
+/** Append a complete event to the calling thread's ring.  `name` must have
+ *  static storage duration.  The first call on a thread allocates its ring;
+ *  call register_thread() first on real-time threads. */
+void record(const char* name, uint64_t begin_ns, uint64_t end_ns) noexcept;
+
+/** Allocate the calling thread's ring now and label it `name` in the trace. */
+void register_thread(const char* name) noexcept;
+
+/** Forget every buffered event.  Safe while other threads record. */
+void clear() noexcept;
+
+/**
+ * Every buffered event as Chrome trace JSON: one "X" (complete) event per
+ * scope plus a thread_name record per thread, timestamps in microseconds.
+ * Open with chrome://tracing or ui.perfetto.dev.  Safe while other threads
+ * record; events overwritten during the copy are left out.  Allocates.
+ */
+std::string chrome_json();
+
+/** RAII timer behind ML_TRACE_SCOPE. */
+class Scope {
+public:
+    explicit Scope(const char* name) noexcept : name_(name), begin_ns_(now_ns()) {}
+    ~Scope() { record(name_, begin_ns_, now_ns()); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t    begin_ns_;
+};
+
+} // namespace trace
+} // namespace music_life
+
+#define ML_TRACE_JOIN_INNER(a, b) a##b
+#define ML_TRACE_JOIN(a, b) ML_TRACE_JOIN_INNER(a, b)
+
+#if ML_TRACING
+#define ML_TRACE_SCOPE(name) const ::music_life::trace::Scope ML_TRACE_JOIN(ml_trace_scope_, __LINE__)(name)
+#else
+#define ML_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
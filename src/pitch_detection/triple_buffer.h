@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace music_life {
+
+/**
+ * Lock-free triple buffer: one producer repeatedly publishes a whole value,
+ * one consumer reads the most recent one at its own rate.
+ *
+ * The producer fills back() and calls publish(), which swaps the back slot
+ * with the shared middle slot; the consumer calls update(), which swaps its
+ * front slot with the middle one if something new was published.  Neither
+ * side ever waits for the other or allocates, and intermediate values the
+ * consumer was too slow to see are simply overwritten.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    /** Each of the three slots starts as a copy of `initial`. */
+    explicit TripleBuffer(const T& initial)
+        : slots_{initial, initial, initial}
+        , middle_(1)
+        , back_(0)
+        , front_(2)
+    {
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /** Producer only.  The slot to fill before the next publish(). */
+    T& back() { return slots_[back_]; }
+
+    /** Producer only.  Make back() visible to the consumer. */
+    void publish() {
+        back_ = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    /** Consumer only.  Take the newest published value, if any; returns true
+     *  if front() changed. */
+    bool update() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    /** Consumer only.  Stable until the next update(). */
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh     = 0x4;
+
+    T slots_[3];
+    alignas(64) std::atomic<uint8_t> middle_;  ///< Slot index, plus kFresh when unread
+    alignas(64) uint8_t back_;
+    alignas(64) uint8_t front_;
+};
+
+} // namespace music_life
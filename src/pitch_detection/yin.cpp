@@ -1,29 +1,23 @@
 #include "yin.h"
+#include "trace.h"
 
 #include <algorithm>
 #include <cmath>
 #include <complex>
-#include <cstdlib>
+#include <cstdint>
 #include <cstring>
 #include <limits>
-#include <string>
 #if defined(__ARM_NEON)
 #include <arm_neon.h>
 #endif
 #if defined(__SSE3__)
 #include <pmmintrin.h>
 #endif
-#if defined(ML_HAS_ACCELERATE)
-#include <Accelerate/Accelerate.h>
-#endif
-#if defined(ML_HAS_FFTW)
-#include <fftw3.h>
-#endif
 
 namespace music_life {
 
 // ---------------------------------------------------------------------------
-// Internal FFT utilities (anonymous namespace)
+// Internal DSP utilities (anonymous namespace)
 // ---------------------------------------------------------------------------
 
 namespace {
@@ -34,62 +28,6 @@ constexpr float kMinSignalMeanSquare = 1.0e-8f;
 static_assert(sizeof(std::complex<float>) == sizeof(float) * 2,
               "SIMD complex operations require tightly packed std::complex<float>.");
 
-const char* backend_to_name(FftBackend backend) {
-    switch (backend) {
-        case FftBackend::Radix2: return "radix2";
-        case FftBackend::Accelerate: return "accelerate";
-        case FftBackend::Fftw: return "fftw";
-        default: return "auto";
-    }
-}
-
-bool backend_available(FftBackend backend) {
-    switch (backend) {
-        case FftBackend::Accelerate:
-#if defined(ML_HAS_ACCELERATE)
-            return true;
-#else
-            return false;
-#endif
-        case FftBackend::Fftw:
-#if defined(ML_HAS_FFTW)
-            return true;
-#else
-            return false;
-#endif
-        case FftBackend::Radix2:
-        case FftBackend::Auto:
-        default:
-            return true;
-    }
-}
-
-FftBackend parse_requested_backend() {
-    const char* env = std::getenv("ML_FFT_BACKEND");
-    if (env == nullptr || *env == '\0') {
-        return FftBackend::Auto;
-    }
-    const std::string value(env);
-    if (value == "radix2" || value == "manual") return FftBackend::Radix2;
-    if (value == "accelerate") return FftBackend::Accelerate;
-    if (value == "fftw") return FftBackend::Fftw;
-    return FftBackend::Auto;
-}
-
-FftBackend resolve_backend() {
-    const FftBackend requested = parse_requested_backend();
-    if (requested != FftBackend::Auto) {
-        return backend_available(requested) ? requested : FftBackend::Radix2;
-    }
-#if defined(ML_HAS_ACCELERATE)
-    return FftBackend::Accelerate;
-#elif defined(ML_HAS_FFTW)
-    return FftBackend::Fftw;
-#else
-    return FftBackend::Radix2;
-#endif
-}
-
 inline void multiply_conj_fft_bins(std::complex<float>* lhs,
                                    const std::complex<float>* rhs,
                                    int n) {
@@ -164,9 +102,13 @@ inline void compute_difference_from_corr(const std::vector<float>& sq_prefix,
                                          const std::vector<std::complex<float>>& corr,
                                          int W,
                                          std::vector<float>& df) {
+    // d(tau) is a sum of squares, but rounding in the FFT correlation can
+    // leave it just below zero at an exact period; clamp so the dip survives
+    // sanitize_cmndf().  The clamps keep NaN so a bad frame is not a match.
     const float A = sq_prefix[W];
     int tau = 0;
 #if defined(__ARM_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
     const float32x4_t a_vec = vdupq_n_f32(A);
     for (; tau + 3 < W; tau += 4) {
         const float32x4_t b_lo = vld1q_f32(sq_prefix.data() + tau);
@@ -178,9 +120,10 @@ inline void compute_difference_from_corr(const std::vector<float>& sq_prefix,
         r = vsetq_lane_f32(corr[tau + 2].real(), r, 2);
         r = vsetq_lane_f32(corr[tau + 3].real(), r, 3);
         const float32x4_t out = vsubq_f32(vaddq_f32(a_vec, b), vmulq_n_f32(r, 2.0f));
-        vst1q_f32(df.data() + tau, out);
+        vst1q_f32(df.data() + tau, vmaxq_f32(out, zero));
     }
 #elif defined(__SSE3__)
+    const __m128 zero = _mm_setzero_ps();
     const __m128 a_vec = _mm_set1_ps(A);
     const __m128 two = _mm_set1_ps(2.0f);
     for (; tau + 3 < W; tau += 4) {
@@ -190,13 +133,14 @@ inline void compute_difference_from_corr(const std::vector<float>& sq_prefix,
         const __m128 r = _mm_set_ps(corr[tau + 3].real(), corr[tau + 2].real(),
                                     corr[tau + 1].real(), corr[tau].real());
         const __m128 out = _mm_sub_ps(_mm_add_ps(a_vec, b), _mm_mul_ps(two, r));
-        _mm_storeu_ps(df.data() + tau, out);
+        _mm_storeu_ps(df.data() + tau, _mm_max_ps(zero, out));  // Second operand wins on NaN
     }
 #endif
     for (; tau < W; ++tau) {
         const float B_tau = sq_prefix[tau + W] - sq_prefix[tau];
         const float r_tau = corr[tau].real();
-        df[tau] = A + B_tau - 2.0f * r_tau;
+        const float d = A + B_tau - 2.0f * r_tau;
+        df[tau] = d < 0.0f ? 0.0f : d;
     }
 }
 
@@ -218,210 +162,91 @@ bool has_sufficient_signal(const float* samples, int n) {
     return sum_squares > min_sum_squares;
 }
 
-void sanitize_cmndf(std::vector<float>& df, int n) {
-    for (int tau = 0; tau < n; ++tau) {
-        float& value = df[tau];
-        if (!std::isfinite(value) || value < 0.0f) {
-            value = 1.0f;
-        }
-    }
+// d'(tau) for one lag, sanitised: a non-finite or negative value becomes 1
+// so it can never be taken for a dip.
+inline float normalise_lag(float d, int tau, float& running_sum) {
+    running_sum += d;
+    const float value = running_sum == 0.0f ? 1.0f : d * (static_cast<float>(tau) / running_sum);
+    return (value >= 0.0f && value <= std::numeric_limits<float>::max()) ? value : 1.0f;
 }
 
-// In-place Cooley-Tukey radix-2 DIT FFT.  n must be a power of two.
-void fft_stage_len2(std::vector<std::complex<float>>& x) {
-    const int n = static_cast<int>(x.size());
-    int i = 0;
-#if defined(__ARM_NEON)
-    for (; i + 1 < n; i += 2) {
-        const float32x4_t uv = vld1q_f32(reinterpret_cast<const float*>(x.data() + i));
-        const float32x2_t u = vget_low_f32(uv);
-        const float32x2_t v = vget_high_f32(uv);
-        vst1_f32(reinterpret_cast<float*>(x.data() + i), vadd_f32(u, v));
-        vst1_f32(reinterpret_cast<float*>(x.data() + i + 1), vsub_f32(u, v));
-    }
-#elif defined(__SSE3__)
-    for (; i + 1 < n; i += 2) {
-        const __m128 uv = _mm_loadu_ps(reinterpret_cast<const float*>(x.data() + i));
-        const __m128 u = _mm_movelh_ps(uv, uv);
-        const __m128 v = _mm_movehl_ps(uv, uv);
-        const __m128 sum = _mm_add_ps(u, v);
-        const __m128 diff = _mm_sub_ps(u, v);
-        x[static_cast<size_t>(i)] = {
-            _mm_cvtss_f32(sum),
-            _mm_cvtss_f32(_mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)))
-        };
-        x[static_cast<size_t>(i + 1)] = {
-            _mm_cvtss_f32(diff),
-            _mm_cvtss_f32(_mm_shuffle_ps(diff, diff, _MM_SHUFFLE(1, 1, 1, 1)))
-        };
-    }
-#endif
-    for (; i + 1 < n; i += 2) {
-        const std::complex<float> u = x[static_cast<size_t>(i)];
-        const std::complex<float> v = x[static_cast<size_t>(i + 1)];
-        x[static_cast<size_t>(i)] = u + v;
-        x[static_cast<size_t>(i + 1)] = u - v;
-    }
-}
-
-void fft_inplace_radix2(std::vector<std::complex<float>>& x,
-                        const std::vector<std::complex<float>>& twiddle) {
-    const int n = static_cast<int>(x.size());
+// Four lags at a time for the fused CMNDF / threshold pass.  NEON needs
+// AArch64 for the vector divide.
+#if defined(__SSE3__)
+#define ML_YIN_SIMD_LAGS 1
+using LagVec = __m128;
 
-    // Bit-reversal permutation
-    for (int i = 1, j = 0; i < n; ++i) {
-        int bit = n >> 1;
-        for (; j & bit; bit >>= 1) j ^= bit;
-        j ^= bit;
-        if (i < j) std::swap(x[i], x[j]);
-    }
+inline LagVec lag_set1(float v) { return _mm_set1_ps(v); }
+inline LagVec lag_ramp(float first) { return _mm_set_ps(first + 3.0f, first + 2.0f, first + 1.0f, first); }
+inline LagVec lag_add(LagVec a, LagVec b) { return _mm_add_ps(a, b); }
+inline void   lag_store(float* out, LagVec v) { _mm_storeu_ps(out, v); }
+inline int    lag_less_mask(LagVec a, LagVec b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
 
-    // Butterfly passes – twiddle factor for butterfly j in stage len is
-    // W_len^j = W_n^(j*n/len) = twiddle[j * (n/len)].
-    // No transcendental calls in the hot path.
-    fft_stage_len2(x);
-    for (int len = 4; len <= n; len <<= 1) {
-        const int step = n / len;
-        for (int i = 0; i < n; i += len) {
-            for (int j = 0; j < len / 2; ++j) {
-                const std::complex<float> w = twiddle[j * step];
-                const std::complex<float> u = x[i + j];
-                const std::complex<float> v = x[i + j + len / 2] * w;
-                x[i + j]           = u + v;
-                x[i + j + len / 2] = u - v;
-            }
-        }
-    }
+inline LagVec normalise_lags(const float* d, LagVec tau_vec, float& running_sum) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 x = _mm_loadu_ps(d);
+    // Horizontal prefix sum in lanes: [a,b,c,d] -> [a,a+b,a+b+c,a+b+c+d].
+    __m128 prefix = x;
+    prefix = _mm_add_ps(prefix, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(prefix), 4)));
+    prefix = _mm_add_ps(prefix, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(prefix), 8)));
+    prefix = _mm_add_ps(prefix, _mm_set1_ps(running_sum));
+    const __m128 normalized = _mm_div_ps(_mm_mul_ps(x, tau_vec), prefix);
+    const __m128 is_zero = _mm_cmpeq_ps(prefix, zero);
+    __m128 out = _mm_or_ps(_mm_and_ps(is_zero, one), _mm_andnot_ps(is_zero, normalized));
+    // NaN fails both comparisons, +inf the second.
+    const __m128 valid = _mm_and_ps(_mm_cmpge_ps(out, zero),
+                                    _mm_cmple_ps(out, _mm_set1_ps(std::numeric_limits<float>::max())));
+    out = _mm_or_ps(_mm_and_ps(valid, out), _mm_andnot_ps(valid, one));
+    running_sum = _mm_cvtss_f32(_mm_shuffle_ps(prefix, prefix, _MM_SHUFFLE(3, 3, 3, 3)));
+    return out;
 }
 
-// In-place IFFT via conjugate trick.
-void ifft_inplace_radix2(std::vector<std::complex<float>>& x,
-                         const std::vector<std::complex<float>>& twiddle) {
-    for (auto& c : x) c = std::conj(c);
-    fft_inplace_radix2(x, twiddle);
-    const float inv_n = 1.0f / static_cast<float>(x.size());
-    for (auto& c : x) c = std::conj(c) * inv_n;
+inline void lag_keep_lower(LagVec value, LagVec tau_vec, LagVec& lane_min, LagVec& lane_tau) {
+    const __m128 lower = _mm_cmplt_ps(value, lane_min);
+    lane_min = _mm_or_ps(_mm_and_ps(lower, value), _mm_andnot_ps(lower, lane_min));
+    lane_tau = _mm_or_ps(_mm_and_ps(lower, tau_vec), _mm_andnot_ps(lower, lane_tau));
 }
-
-#if defined(ML_HAS_ACCELERATE)
-void fft_inplace_accelerate(std::vector<std::complex<float>>& x,
-                            vDSP_DFT_Setup setup,
-                            std::vector<float>& in_real,
-                            std::vector<float>& in_imag,
-                            std::vector<float>& out_real,
-                            std::vector<float>& out_imag) {
-    const int n = static_cast<int>(x.size());
-    for (int i = 0; i < n; ++i) {
-        in_real[static_cast<size_t>(i)] = x[static_cast<size_t>(i)].real();
-        in_imag[static_cast<size_t>(i)] = x[static_cast<size_t>(i)].imag();
-    }
-    vDSP_DFT_Execute(setup,
-                     in_real.data(),
-                     in_imag.data(),
-                     out_real.data(),
-                     out_imag.data());
-    for (int i = 0; i < n; ++i) {
-        x[static_cast<size_t>(i)] = {out_real[static_cast<size_t>(i)], out_imag[static_cast<size_t>(i)]};
-    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define ML_YIN_SIMD_LAGS 1
+using LagVec = float32x4_t;
+
+inline LagVec lag_set1(float v) { return vdupq_n_f32(v); }
+inline LagVec lag_ramp(float first) {
+    const float values[4] = {first, first + 1.0f, first + 2.0f, first + 3.0f};
+    return vld1q_f32(values);
 }
-#endif
-
-#if defined(ML_HAS_FFTW)
-void fft_inplace_fftw(std::vector<std::complex<float>>& x, void* fftw_plan) {
-    fftwf_complex* data = reinterpret_cast<fftwf_complex*>(x.data());
-    fftwf_execute_dft(static_cast<fftwf_plan>(fftw_plan), data, data);
+inline LagVec lag_add(LagVec a, LagVec b) { return vaddq_f32(a, b); }
+inline void   lag_store(float* out, LagVec v) { vst1q_f32(out, v); }
+inline int    lag_less_mask(LagVec a, LagVec b) {
+    const uint32x4_t bits = {1u, 2u, 4u, 8u};
+    return static_cast<int>(vaddvq_u32(vandq_u32(vcltq_f32(a, b), bits)));
 }
-#endif
 
-void fft_inplace(std::vector<std::complex<float>>& x,
-                 const std::vector<std::complex<float>>& twiddle,
-                 FftBackend backend,
-                 void* accelerate_setup,
-                 void* fftw_plan,
-                 std::vector<float>* accelerate_in_real,
-                 std::vector<float>* accelerate_in_imag,
-                 std::vector<float>* accelerate_out_real,
-                 std::vector<float>* accelerate_out_imag) {
-    (void)accelerate_setup;
-    (void)fftw_plan;
-    (void)accelerate_in_real;
-    (void)accelerate_in_imag;
-    (void)accelerate_out_real;
-    (void)accelerate_out_imag;
-    switch (backend) {
-        case FftBackend::Accelerate:
-#if defined(ML_HAS_ACCELERATE)
-            fft_inplace_accelerate(x,
-                                   static_cast<vDSP_DFT_Setup>(accelerate_setup),
-                                   *accelerate_in_real,
-                                   *accelerate_in_imag,
-                                   *accelerate_out_real,
-                                   *accelerate_out_imag);
-            return;
-#else
-            break;
-#endif
-        case FftBackend::Fftw:
-#if defined(ML_HAS_FFTW)
-            fft_inplace_fftw(x, fftw_plan);
-            return;
-#else
-            break;
-#endif
-        case FftBackend::Radix2:
-        case FftBackend::Auto:
-        default:
-            fft_inplace_radix2(x, twiddle);
-            return;
-    }
-    fft_inplace_radix2(x, twiddle);
+inline LagVec normalise_lags(const float* d, LagVec tau_vec, float& running_sum) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t x = vld1q_f32(d);
+    // Horizontal prefix sum in lanes: [a,b,c,d] -> [a,a+b,a+b+c,a+b+c+d].
+    float32x4_t prefix = vaddq_f32(x, vextq_f32(zero, x, 3));
+    prefix = vaddq_f32(prefix, vextq_f32(zero, prefix, 2));
+    prefix = vaddq_f32(prefix, vdupq_n_f32(running_sum));
+    const float32x4_t normalized = vdivq_f32(vmulq_f32(x, tau_vec), prefix);
+    float32x4_t out = vbslq_f32(vceqq_f32(prefix, zero), one, normalized);
+    // NaN fails both comparisons, +inf the second.
+    const uint32x4_t valid = vandq_u32(vcgeq_f32(out, zero),
+                                       vcleq_f32(out, vdupq_n_f32(std::numeric_limits<float>::max())));
+    out = vbslq_f32(valid, out, one);
+    running_sum = vgetq_lane_f32(prefix, 3);
+    return out;
 }
 
-void ifft_inplace(std::vector<std::complex<float>>& x,
-                  const std::vector<std::complex<float>>& twiddle,
-                  FftBackend backend,
-                  void* accelerate_setup,
-                  void* fftw_plan,
-                  std::vector<float>* accelerate_in_real,
-                  std::vector<float>* accelerate_in_imag,
-                  std::vector<float>* accelerate_out_real,
-                  std::vector<float>* accelerate_out_imag) {
-    (void)accelerate_setup;
-    (void)fftw_plan;
-    (void)accelerate_in_real;
-    (void)accelerate_in_imag;
-    (void)accelerate_out_real;
-    (void)accelerate_out_imag;
-    switch (backend) {
-        case FftBackend::Accelerate:
-#if defined(ML_HAS_ACCELERATE)
-            fft_inplace_accelerate(x,
-                                   static_cast<vDSP_DFT_Setup>(accelerate_setup),
-                                   *accelerate_in_real,
-                                   *accelerate_in_imag,
-                                   *accelerate_out_real,
-                                   *accelerate_out_imag);
-            for (auto& c : x) c /= static_cast<float>(x.size());
-            return;
-#else
-            break;
-#endif
-        case FftBackend::Fftw:
-#if defined(ML_HAS_FFTW)
-            fft_inplace_fftw(x, fftw_plan);
-            for (auto& c : x) c /= static_cast<float>(x.size());
-            return;
-#else
-            break;
-#endif
-        case FftBackend::Radix2:
-        case FftBackend::Auto:
-        default:
-            ifft_inplace_radix2(x, twiddle);
-            return;
-    }
-    ifft_inplace_radix2(x, twiddle);
+inline void lag_keep_lower(LagVec value, LagVec tau_vec, LagVec& lane_min, LagVec& lane_tau) {
+    const uint32x4_t lower = vcltq_f32(value, lane_min);
+    lane_min = vbslq_f32(lower, value, lane_min);
+    lane_tau = vbslq_f32(lower, tau_vec, lane_tau);
 }
+#endif
 
 } // anonymous namespace
 
@@ -439,101 +264,41 @@ static int compute_fft_size(int buffer_size) {
 // Construction
 // ---------------------------------------------------------------------------
 
-Yin::Yin(int sample_rate, int buffer_size, float threshold)
+Yin::Yin(int sample_rate, int buffer_size, float threshold, FftBackend fft_backend)
     : sample_rate_(sample_rate)
     , buffer_size_(buffer_size)
     , threshold_(threshold)
     , half_buffer_(buffer_size / 2)
     , fft_size_(compute_fft_size(buffer_size))
     , probability_(0.0f)
+    , full_cmndf_(false)
     , fft_F_(fft_size_, {0.0f, 0.0f})
     , fft_G_(fft_size_, {0.0f, 0.0f})
     , sq_prefix_(buffer_size + 1, 0.0f)
-    , twiddle_(fft_size_ / 2)
-    , fft_backend_(resolve_backend())
-    , accelerate_forward_setup_(nullptr)
-    , accelerate_inverse_setup_(nullptr)
-    , fftw_forward_plan_(nullptr)
-    , fftw_inverse_plan_(nullptr)
-    , fftw_plan_buffer_(fft_size_, {0.0f, 0.0f})
-    , accelerate_in_real_(fft_size_, 0.0f)
-    , accelerate_in_imag_(fft_size_, 0.0f)
-    , accelerate_out_real_(fft_size_, 0.0f)
-    , accelerate_out_imag_(fft_size_, 0.0f)
+    , fft_(fft_size_, fft_backend)
 {
-    // Pre-compute twiddle factors: twiddle_[k] = exp(-2pi*i*k / fft_size_).
-    // These are computed once here so the real-time audio path is free of
-    // any std::cos / std::sin calls during FFT butterfly passes.
-    const float two_pi_over_n =
-        -2.0f * static_cast<float>(M_PI) / static_cast<float>(fft_size_);
-    for (int k = 0; k < fft_size_ / 2; ++k) {
-        const float ang = two_pi_over_n * static_cast<float>(k);
-        twiddle_[k] = {std::cos(ang), std::sin(ang)};
-    }
-
-#if defined(ML_HAS_ACCELERATE)
-    if (fft_backend_ == FftBackend::Accelerate) {
-        accelerate_forward_setup_ = static_cast<void*>(vDSP_DFT_zop_CreateSetup(
-            nullptr, static_cast<vDSP_Length>(fft_size_), vDSP_DFT_FORWARD));
-        accelerate_inverse_setup_ = static_cast<void*>(vDSP_DFT_zop_CreateSetup(
-            nullptr, static_cast<vDSP_Length>(fft_size_), vDSP_DFT_INVERSE));
-        if (accelerate_forward_setup_ == nullptr || accelerate_inverse_setup_ == nullptr) {
-            if (accelerate_forward_setup_ != nullptr) {
-                vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_forward_setup_));
-                accelerate_forward_setup_ = nullptr;
-            }
-            if (accelerate_inverse_setup_ != nullptr) {
-                vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_inverse_setup_));
-                accelerate_inverse_setup_ = nullptr;
-            }
-            fft_backend_ = FftBackend::Radix2;
-        }
-    }
-#endif
-
-#if defined(ML_HAS_FFTW)
-    if (fft_backend_ == FftBackend::Fftw) {
-        fftwf_complex* plan_data = reinterpret_cast<fftwf_complex*>(fftw_plan_buffer_.data());
-        fftw_forward_plan_ = static_cast<void*>(fftwf_plan_dft_1d(
-            fft_size_, plan_data, plan_data, FFTW_FORWARD, FFTW_MEASURE));
-        fftw_inverse_plan_ = static_cast<void*>(fftwf_plan_dft_1d(
-            fft_size_, plan_data, plan_data, FFTW_BACKWARD, FFTW_MEASURE));
-        if (fftw_forward_plan_ == nullptr || fftw_inverse_plan_ == nullptr) {
-            if (fftw_forward_plan_ != nullptr) {
-                fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_forward_plan_));
-                fftw_forward_plan_ = nullptr;
-            }
-            if (fftw_inverse_plan_ != nullptr) {
-                fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_inverse_plan_));
-                fftw_inverse_plan_ = nullptr;
-            }
-            fft_backend_ = FftBackend::Radix2;
-        }
-    }
-#endif
 }
 
-Yin::~Yin() {
-#if defined(ML_HAS_ACCELERATE)
-    if (accelerate_forward_setup_ != nullptr) {
-        vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_forward_setup_));
-    }
-    if (accelerate_inverse_setup_ != nullptr) {
-        vDSP_DFT_DestroySetup(static_cast<vDSP_DFT_Setup>(accelerate_inverse_setup_));
-    }
-#endif
-#if defined(ML_HAS_FFTW)
-    if (fftw_forward_plan_ != nullptr) {
-        fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_forward_plan_));
-    }
-    if (fftw_inverse_plan_ != nullptr) {
-        fftwf_destroy_plan(static_cast<fftwf_plan>(fftw_inverse_plan_));
-    }
-#endif
-}
+Yin::~Yin() = default;
 
 const char* Yin::fft_backend_name() const {
-    return backend_to_name(fft_backend_);
+    return fft_.backend_name();
+}
+
+int Yin::magnitude_spectrum(float* out, int bins) const {
+    // fft_G_ still holds the transform of the whole frame after difference():
+    // only fft_F_ is overwritten by the correlation.
+    const int half = fft_size_ / 2;
+    bins = std::clamp(bins, 1, half);
+    const float scale = 2.0f / static_cast<float>(buffer_size_);
+    int k = 0;
+    for (int i = 0; i < bins; ++i) {
+        const int end = static_cast<int>(static_cast<int64_t>(i + 1) * half / bins);
+        float peak = 0.0f;
+        for (; k < end; ++k) peak = std::max(peak, std::norm(fft_G_[k]));
+        out[i] = std::sqrt(peak) * scale;
+    }
+    return bins;
 }
 
 // ---------------------------------------------------------------------------
@@ -541,22 +306,28 @@ const char* Yin::fft_backend_name() const {
 // ---------------------------------------------------------------------------
 
 float Yin::detect(const float* samples, std::vector<float>& workspace) {
-    if (static_cast<int>(workspace.size()) < half_buffer_ || !has_sufficient_signal(samples, buffer_size_)) {
+    if (!has_sufficient_signal(samples, buffer_size_)) {
         probability_ = 0.0f;
         return -1.0f;
     }
+    return detect_prevalidated(samples, workspace);
+}
 
-    difference(samples, workspace);
-    cmndf(workspace);
-    sanitize_cmndf(workspace, half_buffer_);
+float Yin::detect_prevalidated(const float* samples, std::vector<float>& workspace) {
+    ML_TRACE_SCOPE("yin.detect");
+    if (samples == nullptr || static_cast<int>(workspace.size()) < half_buffer_) {
+        probability_ = 0.0f;
+        return -1.0f;
+    }
 
-    int tau = absolute_threshold(workspace);
+    difference(samples, workspace);
+    int tau = cumulative_threshold(workspace);
     if (tau == -1) {
         probability_ = 0.0f;
         return -1.0f;
     }
 
-    float refined_tau = parabolic_interpolation(workspace, tau);
+    float refined_tau = parabolic_interpolation(tau);
     if (!std::isfinite(refined_tau) || refined_tau <= 0.0f) {
         probability_ = 0.0f;
         return -1.0f;
@@ -585,140 +356,170 @@ float Yin::detect(const float* samples, std::vector<float>& workspace) {
 // ---------------------------------------------------------------------------
 
 void Yin::difference(const float* samples, std::vector<float>& df) const {
+    ML_TRACE_SCOPE("yin.difference");
     const int W = half_buffer_;
 
-    // f = x[0..W-1], zero-padded to fft_size_
-    for (int j = 0; j < W; ++j) fft_F_[j] = {samples[j], 0.0f};
-    std::fill(fft_F_.begin() + W, fft_F_.end(), std::complex<float>{0.0f, 0.0f});
-
-    // g = x[0..buffer_size_-1], zero-padded to fft_size_
-    for (int j = 0; j < buffer_size_; ++j) fft_G_[j] = {samples[j], 0.0f};
-    std::fill(fft_G_.begin() + buffer_size_, fft_G_.end(), std::complex<float>{0.0f, 0.0f});
-
-    fft_inplace(fft_F_,
-                twiddle_,
-                fft_backend_,
-                accelerate_forward_setup_,
-                fftw_forward_plan_,
-                &accelerate_in_real_,
-                &accelerate_in_imag_,
-                &accelerate_out_real_,
-                &accelerate_out_imag_);
-    fft_inplace(fft_G_,
-                twiddle_,
-                fft_backend_,
-                accelerate_forward_setup_,
-                fftw_forward_plan_,
-                &accelerate_in_real_,
-                &accelerate_in_imag_,
-                &accelerate_out_real_,
-                &accelerate_out_imag_);
-
-    // Cross-correlation in frequency domain: conj(F) * G
-    multiply_conj_fft_bins(fft_F_.data(), fft_G_.data(), fft_size_);
-    ifft_inplace(fft_F_,
-                 twiddle_,
-                 fft_backend_,
-                 accelerate_inverse_setup_,
-                 fftw_inverse_plan_,
-                 &accelerate_in_real_,
-                 &accelerate_in_imag_,
-                 &accelerate_out_real_,
-                 &accelerate_out_imag_);  // fft_F_[tau].real() == r(tau)
+    {
+        ML_TRACE_SCOPE("yin.difference.load");
+        // f = x[0..W-1], zero-padded to fft_size_
+        for (int j = 0; j < W; ++j) fft_F_[j] = {samples[j], 0.0f};
+        std::fill(fft_F_.begin() + W, fft_F_.end(), std::complex<float>{0.0f, 0.0f});
+
+        // g = x[0..buffer_size_-1], zero-padded to fft_size_
+        for (int j = 0; j < buffer_size_; ++j) fft_G_[j] = {samples[j], 0.0f};
+        std::fill(fft_G_.begin() + buffer_size_, fft_G_.end(), std::complex<float>{0.0f, 0.0f});
+    }
+    {
+        ML_TRACE_SCOPE("yin.difference.forward_fft");
+        fft_.forward(fft_F_);
+        fft_.forward(fft_G_);
+    }
+    {
+        // Cross-correlation in frequency domain: conj(F) * G
+        ML_TRACE_SCOPE("yin.difference.multiply");
+        multiply_conj_fft_bins(fft_F_.data(), fft_G_.data(), fft_size_);
+    }
+    {
+        ML_TRACE_SCOPE("yin.difference.inverse_fft");
+        fft_.inverse(fft_F_);  // fft_F_[tau].real() == r(tau)
+    }
 
     // Prefix sums of squares for A and B(tau)
+    ML_TRACE_SCOPE("yin.difference.prefix_sums");
     compute_sq_prefix(samples, buffer_size_, sq_prefix_);
     compute_difference_from_corr(sq_prefix_, fft_F_, W, df);
 }
 
 // ---------------------------------------------------------------------------
-// Step 3: Cumulative mean normalized difference function
+// Steps 3-4: Cumulative mean normalized difference function and absolute
+// threshold, fused into one pass
 //
 //   d'(0)   = 1
 //   d'(tau) = d(tau) / [ (1/tau) * sum_{j=1}^{tau} d(j) ]
+//
+// Each block of lags is normalised, sanitised, compared with the threshold
+// and folded into the running global minimum while it is still in
+// registers.  The pass stops at the first dip below the threshold once its
+// local minimum is found, so for clean periodic input the lags beyond the
+// period are never touched (unless full_cmndf_ asks for all of them).  Only
+// without a dip does it scan every lag, for the global-minimum fallback.
 // ---------------------------------------------------------------------------
 
-void Yin::cmndf(std::vector<float>& df) const {
-    df[0] = 1.0f;
+int Yin::cumulative_threshold(std::vector<float>& df) const {
+    ML_TRACE_SCOPE("yin.cmndf_threshold");
+    const float threshold =
+        std::isfinite(threshold_) ? std::clamp(threshold_, 0.0f, 1.0f) : kDefaultThreshold;
+    float* d = df.data();
+    const int n = half_buffer_;
+
+    d[0] = 1.0f;
     float running_sum = 0.0f;
-    int tau = 1;
-#if defined(__SSE3__)
-    const __m128 zero = _mm_set1_ps(0.0f);
-    const __m128 one = _mm_set1_ps(1.0f);
-    const __m128 four = _mm_set1_ps(4.0f);
-    __m128 tau_vec = _mm_set_ps(4.0f, 3.0f, 2.0f, 1.0f);
-    for (; tau + 3 < half_buffer_; tau += 4) {
-        const __m128 d = _mm_loadu_ps(df.data() + tau);
-        __m128 prefix = d;
-        // Horizontal prefix sum in lanes: [a,b,c,d] -> [a,a+b,a+b+c,a+b+c+d].
-        prefix = _mm_add_ps(prefix, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(prefix), 4)));
-        prefix = _mm_add_ps(prefix, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(prefix), 8)));
-        prefix = _mm_add_ps(prefix, _mm_set1_ps(running_sum));
-        const __m128 normalized = _mm_div_ps(_mm_mul_ps(d, tau_vec), prefix);
-        const __m128 is_zero = _mm_cmpeq_ps(prefix, zero);
-        const __m128 out = _mm_or_ps(_mm_and_ps(is_zero, one), _mm_andnot_ps(is_zero, normalized));
-        _mm_storeu_ps(df.data() + tau, out);
-        running_sum = _mm_cvtss_f32(_mm_shuffle_ps(prefix, prefix, _MM_SHUFFLE(3, 3, 3, 3)));
-        tau_vec = _mm_add_ps(tau_vec, four);
+    if (n > 1) d[1] = normalise_lag(d[1], 1, running_sum);
+
+    // Search from tau = 2 (tau = 1 is always very low for periodic signals).
+    // tau is the next lag to normalise.
+    int tau = 2;
+    int dip = -1;
+    float min_value = std::numeric_limits<float>::infinity();
+    int   min_tau = -1;
+
+#if defined(ML_YIN_SIMD_LAGS)
+    {
+        const LagVec limit = lag_set1(threshold);
+        const LagVec four  = lag_set1(4.0f);
+        LagVec tau_vec  = lag_ramp(2.0f);
+        LagVec lane_min = lag_set1(std::numeric_limits<float>::infinity());
+        LagVec lane_tau = lag_set1(-1.0f);
+        for (; tau + 3 < n; tau += 4) {
+            const LagVec value = normalise_lags(d + tau, tau_vec, running_sum);
+            lag_store(d + tau, value);
+            const int below = lag_less_mask(value, limit);
+            if (below != 0) {
+                int lane = 0;
+                while ((below & (1 << lane)) == 0) ++lane;
+                dip = tau + lane;
+                tau += 4;
+                break;
+            }
+            lag_keep_lower(value, tau_vec, lane_min, lane_tau);
+            tau_vec = lag_add(tau_vec, four);
+        }
+        if (dip < 0) {
+            // Lanes hold interleaved lags; ties go to the lowest lag.
+            alignas(16) float mins[4];
+            alignas(16) float taus[4];
+            lag_store(mins, lane_min);
+            lag_store(taus, lane_tau);
+            for (int lane = 0; lane < 4; ++lane) {
+                const int lane_lag = static_cast<int>(taus[lane]);
+                if (lane_lag < 0) continue;
+                if (mins[lane] < min_value || (mins[lane] == min_value && lane_lag < min_tau)) {
+                    min_value = mins[lane];
+                    min_tau   = lane_lag;
+                }
+            }
+        }
     }
 #endif
-    for (; tau < half_buffer_; ++tau) {
-        running_sum += df[tau];
-        if (running_sum == 0.0f) {
-            df[tau] = 1.0f;
-        } else {
-            df[tau] *= static_cast<float>(tau) / running_sum;
+    for (; dip < 0 && tau < n; ++tau) {
+        d[tau] = normalise_lag(d[tau], tau, running_sum);
+        if (d[tau] < threshold) {
+            dip = tau;
+        } else if (d[tau] < min_value) {
+            min_value = d[tau];
+            min_tau   = tau;
         }
     }
-}
 
-// ---------------------------------------------------------------------------
-// Step 4: Absolute threshold
-// ---------------------------------------------------------------------------
-
-int Yin::absolute_threshold(const std::vector<float>& df) const {
-    const float threshold =
-        std::isfinite(threshold_) ? std::clamp(threshold_, 0.0f, 1.0f) : kDefaultThreshold;
-
-    // Start from tau = 2 (tau = 1 is always very low for periodic signals)
-    for (int tau = 2; tau < half_buffer_; ++tau) {
-        if (!std::isfinite(df[tau])) {
-            continue;
-        }
-        if (df[tau] < threshold) {
-            // Find the local minimum in this dip
-            while (tau + 1 < half_buffer_ &&
-                   std::isfinite(df[tau + 1]) &&
-                   df[tau + 1] < df[tau]) {
+    // Walk down to the local minimum of the dip, normalising lags on demand.
+    if (dip >= 0) {
+        while (dip + 1 < n) {
+            if (dip + 1 == tau) {
+                d[tau] = normalise_lag(d[tau], tau, running_sum);
                 ++tau;
             }
-            return tau;
+            if (!(d[dip + 1] < d[dip])) break;
+            ++dip;
         }
     }
-    // No pitch found below threshold – return the global minimum instead
-    int min_tau = -1;
-    for (int tau = 2; tau < half_buffer_; ++tau) {
-        if (!std::isfinite(df[tau])) {
-            continue;
-        }
-        if (min_tau == -1 || df[tau] < df[min_tau]) {
-            min_tau = tau;
+
+    if (full_cmndf_) {
+#if defined(ML_YIN_SIMD_LAGS)
+        const LagVec four = lag_set1(4.0f);
+        LagVec tau_vec = lag_ramp(static_cast<float>(tau));
+        for (; tau + 3 < n; tau += 4) {
+            lag_store(d + tau, normalise_lags(d + tau, tau_vec, running_sum));
+            tau_vec = lag_add(tau_vec, four);
         }
+#endif
+        for (; tau < n; ++tau) d[tau] = normalise_lag(d[tau], tau, running_sum);
     }
-    return (min_tau != -1 && df[min_tau] < 0.5f) ? min_tau : -1;
+
+    if (dip >= 0) return dip;
+    // No pitch found below threshold: fall back to the global minimum.
+    return (min_tau != -1 && min_value < 0.5f) ? min_tau : -1;
 }
 
 // ---------------------------------------------------------------------------
 // Step 5: Parabolic interpolation for sub-sample accuracy
 // ---------------------------------------------------------------------------
 
-float Yin::parabolic_interpolation(const std::vector<float>& df, int tau) const {
+float Yin::parabolic_interpolation(int tau) const {
+    ML_TRACE_SCOPE("yin.parabolic");
     if (tau <= 0 || tau >= half_buffer_ - 1) {
         return static_cast<float>(tau);
     }
-    const float s0 = df[tau - 1];
-    const float s1 = df[tau];
-    const float s2 = df[tau + 1];
+    // Fit the raw difference function rather than the CMNDF: its running-mean
+    // normalisation skews the parabola at short lags, biasing high notes sharp
+    // (about 10 cents at a 9-sample period).  fft_F_ and sq_prefix_ still hold
+    // this frame's correlation and prefix sums.
+    const float A = sq_prefix_[half_buffer_];
+    auto raw = [this, A](int t) {
+        return A + (sq_prefix_[t + half_buffer_] - sq_prefix_[t]) - 2.0f * fft_F_[t].real();
+    };
+    const float s0 = raw(tau - 1);
+    const float s1 = raw(tau);
+    const float s2 = raw(tau + 1);
     if (!std::isfinite(s0) || !std::isfinite(s1) || !std::isfinite(s2)) {
         return static_cast<float>(tau);
     }
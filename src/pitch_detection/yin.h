@@ -1,17 +1,12 @@
 #pragma once
 
+#include "fft.h"
+
 #include <complex>
 #include <vector>
 
 namespace music_life {
 
-enum class FftBackend {
-    Auto,
-    Radix2,
-    Accelerate,
-    Fftw
-};
-
 /**
  * YIN pitch detection algorithm.
  *
@@ -28,8 +23,9 @@ public:
      * @param sample_rate   Audio sample rate in Hz (e.g. 44100).
      * @param buffer_size   Number of samples in one analysis frame.
      * @param threshold     CMNDF threshold for peak detection (default 0.10).
+     * @param fft_backend   Backend of the difference-function FFT; see Fft.
      */
-    Yin(int sample_rate, int buffer_size, float threshold = 0.10f);
+    Yin(int sample_rate, int buffer_size, float threshold = 0.10f, FftBackend fft_backend = FftBackend::Auto);
     ~Yin();
 
     /**
@@ -44,11 +40,41 @@ public:
      * @return Fundamental frequency in Hz, or -1 if no pitch is detected.
      */
     float detect(const float* samples, std::vector<float>& workspace);
+
+    /**
+     * Like detect(), but skips the per-frame energy and finiteness scan.
+     * The caller guarantees that every sample is finite and the frame is not
+     * silent, e.g. from running sums kept as samples arrive.
+     */
+    float detect_prevalidated(const float* samples, std::vector<float>& workspace);
     const char* fft_backend_name() const;
 
+    /**
+     * Peak-pooled magnitude spectrum of the frame last passed to detect(),
+     * read from the transform the difference function already computed: no
+     * extra FFT.  The frame is unwindowed and zero-padded to fft_size(), so
+     * a full-scale sine peaks near 1.0 with rectangular-window leakage.
+     * Output bin i is the largest magnitude among FFT bins
+     * [i * H / bins, (i + 1) * H / bins), where H = fft_size() / 2.
+     *
+     * @param bins  Output bins, clamped to [1, fft_size() / 2].
+     * @return Number of bins written.
+     */
+    int magnitude_spectrum(float* out, int bins) const;
+
+    int fft_size() const { return fft_size_; }
+
     /** Probability of the last detected pitch (0–1). */
     float probability() const { return probability_; }
 
+    /**
+     * detect() stops normalising the CMNDF at the first dip below the
+     * threshold, leaving the rest of the workspace as raw differences.  Set
+     * this to normalise every lag, e.g. when the workspace is displayed.
+     * The detected pitch is the same either way.
+     */
+    void set_full_cmndf(bool full) { full_cmndf_ = full; }
+
 private:
     int   sample_rate_;
     int   buffer_size_;
@@ -57,6 +83,7 @@ private:
     int   fft_size_;
 
     float probability_;
+    bool  full_cmndf_;
 
     // Pre-allocated scratch buffers for difference() – avoids per-call
     // heap allocations in the real-time audio path.
@@ -64,34 +91,22 @@ private:
     mutable std::vector<std::complex<float>> fft_G_;
     mutable std::vector<float>               sq_prefix_;
 
-    // Pre-computed twiddle factors: twiddle_[k] = exp(-2pi*i*k / fft_size_)
-    // for k = 0 ... fft_size_/2 - 1.  Computed once in the constructor so the
-    // hot audio path never calls std::cos / std::sin.
-    std::vector<std::complex<float>> twiddle_;
-    FftBackend fft_backend_;
-
-    void* accelerate_forward_setup_;
-    void* accelerate_inverse_setup_;
-    void* fftw_forward_plan_;
-    void* fftw_inverse_plan_;
-    std::vector<std::complex<float>> fftw_plan_buffer_;
-    mutable std::vector<float> accelerate_in_real_;
-    mutable std::vector<float> accelerate_in_imag_;
-    mutable std::vector<float> accelerate_out_real_;
-    mutable std::vector<float> accelerate_out_imag_;
+    // FFT plans, backend scratch and pre-computed twiddle factors for
+    // fft_size_-point transforms; set up once in the constructor.
+    Fft fft_;
 
 
     /** Step 2: Difference function. */
     void  difference(const float* samples, std::vector<float>& df) const;
 
-    /** Step 3: Cumulative mean normalized difference function. */
-    void  cmndf(std::vector<float>& df) const;
-
-    /** Steps 4–5: Absolute threshold + parabolic interpolation. */
-    float parabolic_interpolation(const std::vector<float>& df, int tau) const;
+    /** Steps 3–4: Normalise df in place into the CMNDF while searching for
+     *  the first dip below the threshold; returns the best lag or -1.  Lags
+     *  past the dip are left unnormalised unless full_cmndf_ is set. */
+    int   cumulative_threshold(std::vector<float>& df) const;
 
-    /** Return the best lag index using the absolute threshold. */
-    int   absolute_threshold(const std::vector<float>& df) const;
+    /** Step 5: Parabolic interpolation around tau on the raw difference
+     *  function of the frame last passed to difference(). */
+    float parabolic_interpolation(int tau) const;
 };
 
 } // namespace music_life
@@ -0,0 +1,274 @@
+#include "time_stretcher.h"
+
+#include "simd_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace music_life {
+
+// ---------------------------------------------------------------------------
+// Constants
+// ---------------------------------------------------------------------------
+
+static constexpr double kPi = 3.14159265358979323846;
+// Frame length: long enough to hold a few periods of a low voice, short
+// enough that transients are not smeared audibly.
+static constexpr double kFrameSeconds = 0.04;
+static constexpr int    kMinFrameSize = 256;
+static constexpr int    kMaxFrameSize = 8192;
+// Relative score margin an offset needs to beat the natural continuation,
+// so periodic input at speed 1 is passed through unchanged.
+static constexpr float  kPreferNaturalMargin = 1e-5f;
+
+static int next_power_of_two(int n) {
+    int size = 1;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+static int frame_size_for(int sample_rate) {
+    const int target = static_cast<int>(kFrameSeconds * std::max(sample_rate, 1));
+    return std::min(std::max(next_power_of_two(target), kMinFrameSize), kMaxFrameSize);
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+
+TimeStretcher::TimeStretcher(int sample_rate, int channels, FftBackend fft_backend)
+    : sample_rate_(sample_rate)
+    , channels_(channels)
+    , frame_size_(frame_size_for(sample_rate))
+    , hop_(frame_size_ / 2)
+    , tolerance_(frame_size_ / 4)
+    , capacity_(5 * frame_size_)
+    , speed_(1.0f)
+    , reset_pending_(false)
+    , fft_(next_power_of_two(hop_ + 2 * tolerance_), fft_backend)
+{
+    if (sample_rate <= 0) throw std::invalid_argument("sample_rate must be > 0");
+    if (channels < 1 || channels > kMaxChannels) {
+        throw std::invalid_argument("channels must be in [1, kMaxChannels]");
+    }
+
+    // Periodic Hann: copies at half-frame spacing sum to exactly one.
+    window_.resize(static_cast<size_t>(frame_size_));
+    for (int n = 0; n < frame_size_; ++n) {
+        window_[static_cast<size_t>(n)] =
+            static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * n / frame_size_));
+    }
+
+    // The region a hop reads spans at most frame_size_ + 3 * tolerance_ +
+    // (kMaxSpeed - 1) * hop_ frames (< 4.25 frames); the rest of the
+    // capacity is room for writes.
+    input_.assign(static_cast<size_t>(channels_), std::vector<float>(static_cast<size_t>(capacity_)));
+    if (channels_ > 1) mono_.resize(static_cast<size_t>(capacity_));
+    mono_energy_.resize(static_cast<size_t>(hop_ + 2 * tolerance_ + 1));
+    downmix_weights_.assign(static_cast<size_t>(channels_), 1.0f / static_cast<float>(channels_));
+    accum_.assign(static_cast<size_t>(channels_), std::vector<float>(static_cast<size_t>(frame_size_)));
+    ready_.resize(static_cast<size_t>(hop_ * channels_));
+    spectrum_.resize(static_cast<size_t>(fft_.size()));
+    clear();
+}
+
+// ---------------------------------------------------------------------------
+// Control (any thread)
+// ---------------------------------------------------------------------------
+
+void TimeStretcher::set_speed(float speed) {
+    if (!(speed >= kMinSpeed && speed <= kMaxSpeed)) {
+        throw std::invalid_argument("speed must be in [kMinSpeed, kMaxSpeed]");
+    }
+    speed_.store(speed, std::memory_order_relaxed);
+}
+
+void TimeStretcher::reset() {
+    reset_pending_.store(true, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// Streaming
+// ---------------------------------------------------------------------------
+
+int TimeStretcher::write(const float* in, int num_frames) {
+    apply_pending_reset();
+    if (!in || num_frames <= 0 || finished_) return 0;
+
+    const int n = std::min(num_frames, capacity_ - filled_);
+    for (int c = 0; c < channels_; ++c) {
+        simd::deinterleave(in, channels_, nullptr, c, input_[static_cast<size_t>(c)].data() + filled_, n);
+    }
+    if (channels_ > 1) simd::deinterleave(in, channels_, downmix_weights_.data(), 0, mono_.data() + filled_, n);
+    filled_ += n;
+    return n;
+}
+
+int TimeStretcher::read(float* out, int num_frames) {
+    apply_pending_reset();
+    if (!out || num_frames <= 0) return 0;
+
+    int written = 0;
+    while (written < num_frames) {
+        if (ready_pos_ == ready_frames_) {
+            if (run_hop()) continue;
+            if (!finished_ || tail_flushed_) break;
+            // The second half of the last frame is still in the accumulator.
+            emit_hop(hop_);
+            tail_flushed_ = true;
+            continue;
+        }
+        const int n = std::min(num_frames - written, ready_frames_ - ready_pos_);
+        std::memcpy(out + static_cast<size_t>(written) * channels_,
+                    ready_.data() + static_cast<size_t>(ready_pos_) * channels_,
+                    static_cast<size_t>(n) * channels_ * sizeof(float));
+        ready_pos_ += n;
+        written += n;
+    }
+    return written;
+}
+
+int TimeStretcher::input_space() const {
+    return finished_ ? 0 : capacity_ - filled_;
+}
+
+void TimeStretcher::finish() {
+    apply_pending_reset();
+    if (finished_) return;
+    finished_ = true;
+    input_end_ = filled_;
+}
+
+bool TimeStretcher::drained() const {
+    return finished_ && tail_flushed_ && ready_pos_ == ready_frames_ &&
+        !reset_pending_.load(std::memory_order_acquire);
+}
+
+// ---------------------------------------------------------------------------
+// Internal
+// ---------------------------------------------------------------------------
+
+void TimeStretcher::apply_pending_reset() {
+    if (reset_pending_.exchange(false, std::memory_order_acquire)) clear();
+}
+
+void TimeStretcher::clear() {
+    // Lead with silence so the first frame's window peaks on the first input
+    // sample and the search region never starts before the buffer.
+    filled_ = tolerance_ + hop_;
+    for (auto& channel : input_) std::fill(channel.begin(), channel.begin() + filled_, 0.0f);
+    if (channels_ > 1) std::fill(mono_.begin(), mono_.begin() + filled_, 0.0f);
+    for (auto& channel : accum_) std::fill(channel.begin(), channel.end(), 0.0f);
+
+    analysis_pos_ = static_cast<double>(tolerance_);
+    natural_      = -1;
+    input_end_    = 0;
+    finished_     = false;
+    tail_flushed_ = false;
+    ready_pos_    = 0;
+    ready_frames_ = 0;
+}
+
+bool TimeStretcher::run_hop() {
+    const int nominal = static_cast<int>(analysis_pos_);
+    if (finished_ && nominal >= input_end_) return false;
+
+    const int natural      = natural_ < 0 ? nominal : natural_;
+    const int search_start = nominal - tolerance_;
+    const int needed       = std::max(natural, nominal + tolerance_) + frame_size_;
+    if (filled_ < needed) {
+        if (!finished_) return false;
+        // Past the end of the input: pad with silence to drain the tail.
+        for (auto& channel : input_) std::fill(channel.begin() + filled_, channel.begin() + needed, 0.0f);
+        if (channels_ > 1) std::fill(mono_.begin() + filled_, mono_.begin() + needed, 0.0f);
+        filled_ = needed;
+    }
+
+    const int start = natural_ < 0 ? nominal : best_offset(natural, search_start);
+    for (int c = 0; c < channels_; ++c) {
+        simd::window_add(input_[static_cast<size_t>(c)].data() + start, window_.data(),
+                         accum_[static_cast<size_t>(c)].data(), frame_size_);
+    }
+    natural_ = start + hop_;
+    analysis_pos_ += static_cast<double>(hop_) * speed_.load(std::memory_order_relaxed);
+    emit_hop(hop_);
+    discard_input(std::min(natural_, static_cast<int>(analysis_pos_) - tolerance_));
+    return true;
+}
+
+int TimeStretcher::best_offset(int natural, int search_start) {
+    // Only the overlap with the previous frame is compared: hop_ samples.
+    const int span = hop_ + 2 * tolerance_;
+    const int size = fft_.size();
+    const int mask = size - 1;
+    const float* x = mono();
+
+    // Region (real part) and template (imaginary part) share one transform.
+    for (int n = 0; n < size; ++n) {
+        spectrum_[static_cast<size_t>(n)] = {n < span ? x[search_start + n] : 0.0f,
+                                             n < hop_ ? x[natural + n] : 0.0f};
+    }
+    fft_.forward(spectrum_);
+    for (int k = 0; k <= size / 2; ++k) {
+        const std::complex<float> a = spectrum_[static_cast<size_t>(k)];
+        const std::complex<float> b = std::conj(spectrum_[static_cast<size_t>((size - k) & mask)]);
+        const std::complex<float> region = 0.5f * (a + b);
+        const std::complex<float> templ  = std::complex<float>(0.0f, -0.5f) * (a - b);
+        const std::complex<float> cross  = region * std::conj(templ);
+        spectrum_[static_cast<size_t>(k)] = cross;
+        spectrum_[static_cast<size_t>((size - k) & mask)] = std::conj(cross);
+    }
+    fft_.inverse(spectrum_);   // Real part: sum_n region[n + lag] * template[n]
+
+    double energy = 0.0;
+    mono_energy_[0] = 0.0;
+    for (int n = 0; n < span; ++n) {
+        const double v = x[search_start + n];
+        energy += v * v;
+        mono_energy_[static_cast<size_t>(n + 1)] = energy;
+    }
+    const auto score = [this](int lag) {
+        const double e = mono_energy_[static_cast<size_t>(lag + hop_)] - mono_energy_[static_cast<size_t>(lag)];
+        return static_cast<float>(spectrum_[static_cast<size_t>(lag)].real() / std::sqrt(std::max(e, 1e-12)));
+    };
+
+    const int natural_lag = natural - search_start;
+    int best = natural_lag >= 0 && natural_lag <= 2 * tolerance_ ? natural_lag : tolerance_;
+    float best_score = score(best);
+    const float margin = kPreferNaturalMargin *
+        std::sqrt(std::max(simd::dot(x + natural, x + natural, hop_), 0.0f));
+    for (int lag = 0; lag <= 2 * tolerance_; ++lag) {
+        const float s = score(lag);
+        if (s > best_score + margin) {
+            best = lag;
+            best_score = s;
+        }
+    }
+    return search_start + best;
+}
+
+void TimeStretcher::emit_hop(int frames) {
+    for (int c = 0; c < channels_; ++c) {
+        float* acc = accum_[static_cast<size_t>(c)].data();
+        for (int i = 0; i < frames; ++i) ready_[static_cast<size_t>(i * channels_ + c)] = acc[i];
+        std::memmove(acc, acc + frames, static_cast<size_t>(frame_size_ - frames) * sizeof(float));
+        std::fill(acc + frame_size_ - frames, acc + frame_size_, 0.0f);
+    }
+    ready_pos_ = 0;
+    ready_frames_ = frames;
+}
+
+void TimeStretcher::discard_input(int frames) {
+    if (frames <= 0) return;
+    const size_t keep = static_cast<size_t>(filled_ - frames);
+    for (auto& channel : input_) std::memmove(channel.data(), channel.data() + frames, keep * sizeof(float));
+    if (channels_ > 1) std::memmove(mono_.data(), mono_.data() + frames, keep * sizeof(float));
+    filled_       -= frames;
+    analysis_pos_ -= frames;
+    natural_      -= frames;
+    if (finished_) input_end_ -= frames;
+}
+
+} // namespace music_life
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "fft.h"
+
+#include <atomic>
+#include <complex>
+#include <vector>
+
+namespace music_life {
+
+/**
+ * Streaming WSOLA time-stretch: plays audio slower or faster without
+ * changing its pitch.
+ *
+ * Hann-windowed frames of frame_size() samples (about 40 ms) are
+ * overlap-added at a fixed synthesis hop of half a frame, while the
+ * analysis position advances by hop * speed.  Each frame is taken from
+ * within a quarter frame of that nominal position, at the offset whose mono
+ * downmix best continues the previous frame across their overlap
+ * (normalised cross-correlation over every candidate offset at once, from
+ * one forward and one inverse Fft of frame_size() points).  Every channel
+ * uses the same offset, so the stereo image is kept.
+ *
+ * Speed is continuously variable: set_speed() may be called at any time
+ * from any thread and is picked up at the next hop.  All storage is
+ * allocated at construction; write() and read() never allocate, so the pair
+ * runs on the audio thread for playback, or in a loop over large blocks for
+ * offline export.
+ *
+ * Usage:
+ *   TimeStretcher stretcher(48000, 2);
+ *   stretcher.set_speed(0.75f);
+ *   // In the audio callback, feeding decoded source frames as needed:
+ *   while (done < frames) {
+ *       done += stretcher.read(out + done * 2, frames - done);
+ *       if (done < frames) source.pull(stretcher, stretcher.input_space());
+ *   }
+ */
+class TimeStretcher {
+public:
+    static constexpr int   kMaxChannels = 8;
+    static constexpr float kMinSpeed    = 0.25f;
+    static constexpr float kMaxSpeed    = 4.0f;
+
+    /**
+     * @param sample_rate  Sample rate in Hz; sets the frame length.
+     * @param channels     Interleaved channels in [1, kMaxChannels].
+     * @param fft_backend  Backend of the correlation FFT.
+     * Throws std::invalid_argument on invalid arguments.
+     */
+    TimeStretcher(int sample_rate, int channels, FftBackend fft_backend = FftBackend::Auto);
+
+    TimeStretcher(const TimeStretcher&) = delete;
+    TimeStretcher& operator=(const TimeStretcher&) = delete;
+
+    /** Playback speed: 0.5 is half speed.  Thread-safe; applied from the
+     *  next hop.  Throws std::invalid_argument outside [kMinSpeed, kMaxSpeed]. */
+    void set_speed(float speed);
+    float speed() const { return speed_.load(std::memory_order_relaxed); }
+
+    /**
+     * Append interleaved input frames.
+     *
+     * @return Frames accepted: at most input_space(), and 0 after finish().
+     */
+    int write(const float* in, int num_frames);
+
+    /**
+     * Produce interleaved output frames.
+     *
+     * @return Frames written; fewer than num_frames when more input must be
+     *         written first (or, after finish(), once everything is drained).
+     */
+    int read(float* out, int num_frames);
+
+    /** Frames write() accepts now. */
+    int input_space() const;
+
+    /** Mark the end of the input: read() then drains the tail. */
+    void finish();
+
+    /** True once finish() was called and the last output frame was read. */
+    bool drained() const;
+
+    /** Request a fresh stream (e.g. after a seek); applied at the start of
+     *  the next write() or read().  Thread-safe. */
+    void reset();
+
+    /** Output frames produced before the first input sample is heard. */
+    int latency() const { return hop_; }
+
+    int sample_rate() const { return sample_rate_; }
+    int channels() const { return channels_; }
+    int frame_size() const { return frame_size_; }
+
+private:
+    int sample_rate_;
+    int channels_;
+    int frame_size_;   ///< Analysis / synthesis frame, a power of two
+    int hop_;          ///< Synthesis hop: frame_size_ / 2
+    int tolerance_;    ///< Largest offset from the nominal analysis position
+    int capacity_;     ///< Input frames held per channel
+
+    std::atomic<float> speed_;
+    std::atomic<bool>  reset_pending_;
+
+    Fft fft_;   ///< Correlation transform, >= hop_ + 2 * tolerance_
+
+    std::vector<float> window_;
+    std::vector<std::vector<float>> input_;   ///< Planar input, one per channel
+    std::vector<float> mono_;                 ///< Downmix searched for the best offset
+    std::vector<double> mono_energy_;         ///< Prefix sums of the squared downmix over the search region
+    std::vector<float> downmix_weights_;
+    std::vector<std::vector<float>> accum_;   ///< Overlap-add accumulators, frame_size_ each
+    std::vector<float> ready_;                ///< One interleaved hop of finished output
+    std::vector<std::complex<float>> spectrum_;
+
+    int    filled_;          ///< Input frames buffered
+    double analysis_pos_;    ///< Nominal start of the next frame in input_
+    int    natural_;         ///< Where the previous frame continues in input_; -1 before the first
+    int    input_end_;       ///< End of the real input after finish()
+    bool   finished_;
+    bool   tail_flushed_;
+    int    ready_pos_;
+    int    ready_frames_;
+
+    void apply_pending_reset();
+    void clear();
+    bool run_hop();
+    int  best_offset(int natural, int search_start);
+    void emit_hop(int frames);
+    void discard_input(int frames);
+    const float* mono() const { return channels_ == 1 ? input_[0].data() : mono_.data(); }
+};
+
+} // namespace music_life
@@ -114,8 +114,7 @@ void main() {
       final messages = <dynamic>[];
       final firstMessage = Completer<void>();
       final manager = NativePitchIsolateManager(
-        handle: nullptr,
-        buffer: Pointer<Float>.fromAddress(0),
+        mailbox: nullptr,
         frameSize: 0,
         entryPoint: _successfulIsolate,
         onMessage: (message) {
@@ -146,8 +145,7 @@ void main() {
       final messages = <dynamic>[];
       final firstMessage = Completer<void>();
       final manager = NativePitchIsolateManager(
-        handle: nullptr,
-        buffer: Pointer<Float>.fromAddress(0),
+        mailbox: nullptr,
         frameSize: 0,
         entryPoint: _successfulIsolate,
         onMessage: (message) {
@@ -180,8 +178,7 @@ void main() {
     test('fails start when handshake ack does not arrive', () async {
       Object? reportedError;
       final manager = NativePitchIsolateManager(
-        handle: nullptr,
-        buffer: Pointer<Float>.fromAddress(0),
+        mailbox: nullptr,
         frameSize: 0,
         entryPoint: _missingHandshakeAckIsolate,
         handshakeTimeout: const Duration(milliseconds: 80),
@@ -201,8 +198,7 @@ void main() {
     test('propagates isolate startup errors with phase context', () async {
       Object? reportedError;
       final manager = NativePitchIsolateManager(
-        handle: nullptr,
-        buffer: Pointer<Float>.fromAddress(0),
+        mailbox: nullptr,
         frameSize: 0,
         entryPoint: _startupErrorIsolate,
         onMessage: (_) {},
@@ -224,8 +220,7 @@ void main() {
       NativeIsolateMetrics? latestMetrics;
       final metricsReady = Completer<void>();
       final manager = NativePitchIsolateManager(
-        handle: nullptr,
-        buffer: Pointer<Float>.fromAddress(0),
+        mailbox: nullptr,
         frameSize: 64,
         entryPoint: _metricsReportingIsolate,
         heartbeatInterval: const Duration(milliseconds: 10),
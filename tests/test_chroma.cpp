@@ -0,0 +1,140 @@
+/**
+ * Unit tests for the streaming chroma / chord / key analyser.
+ */
+
+#include "chroma.h"
+#include "pitch_detector_ffi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::ChordQuality;
+using music_life::ChromaAnalyzer;
+
+namespace {
+
+constexpr int   kSampleRate = 44100;
+constexpr float kPi = 3.14159265358979323846f;
+
+float midi_to_hz(int midi) {
+    return 440.0f * std::pow(2.0f, static_cast<float>(midi - 69) / 12.0f);
+}
+
+// Sum of sines at the given MIDI notes, each with a quieter octave partial.
+std::vector<float> chord(std::initializer_list<int> midi_notes, float seconds) {
+    std::vector<float> buf(static_cast<size_t>(seconds * kSampleRate), 0.0f);
+    for (int midi : midi_notes) {
+        const float f = midi_to_hz(midi);
+        for (size_t i = 0; i < buf.size(); ++i) {
+            const float t = static_cast<float>(i) / kSampleRate;
+            buf[i] += 0.15f * std::sin(2.0f * kPi * f * t) +
+                      0.05f * std::sin(2.0f * kPi * 2.0f * f * t);
+        }
+    }
+    return buf;
+}
+
+// Feed in uneven block sizes to exercise the hop walk.
+ChromaAnalyzer::Result feed(ChromaAnalyzer& analyzer, const std::vector<float>& buf) {
+    static const int kBlocks[] = {512, 300, 1024, 97};
+    ChromaAnalyzer::Result r{};
+    size_t pos = 0;
+    for (int i = 0; pos < buf.size(); ++i) {
+        const int n = static_cast<int>(std::min<size_t>(kBlocks[i % 4], buf.size() - pos));
+        r = analyzer.process(buf.data() + pos, n);
+        pos += static_cast<size_t>(n);
+    }
+    return r;
+}
+
+}  // namespace
+
+TEST(ChromaAnalyzerTest, RejectsInvalidArguments) {
+    EXPECT_THROW(ChromaAnalyzer(0, 4096), std::invalid_argument);
+    EXPECT_THROW(ChromaAnalyzer(kSampleRate, 128), std::invalid_argument);
+    EXPECT_THROW(ChromaAnalyzer(kSampleRate, 4096, 400.0f), std::invalid_argument);
+}
+
+TEST(ChromaAnalyzerTest, SilenceReportsNoChord) {
+    ChromaAnalyzer analyzer(kSampleRate, 4096);
+    const std::vector<float> silence(kSampleRate / 2, 0.0f);
+    const ChromaAnalyzer::Result r = feed(analyzer, silence);
+    for (float v : r.chroma) EXPECT_EQ(v, 0.0f);
+    EXPECT_EQ(r.chord_root, -1);
+    EXPECT_EQ(r.chord_quality, ChordQuality::None);
+    EXPECT_EQ(r.key_tonic, -1);
+}
+
+TEST(ChromaAnalyzerTest, DetectsCMajorTriad) {
+    ChromaAnalyzer analyzer(kSampleRate, 4096);
+    const ChromaAnalyzer::Result r = feed(analyzer, chord({60, 64, 67}, 0.5f));
+    EXPECT_EQ(r.chord_root, 0);
+    EXPECT_EQ(r.chord_quality, ChordQuality::Major);
+    EXPECT_GT(r.chord_confidence, 0.8f);
+    EXPECT_FLOAT_EQ(*std::max_element(r.chroma.begin(), r.chroma.end()), 1.0f);
+}
+
+TEST(ChromaAnalyzerTest, DetectsAMinorTriad) {
+    ChromaAnalyzer analyzer(kSampleRate, 4096);
+    const ChromaAnalyzer::Result r = feed(analyzer, chord({57, 60, 64}, 0.5f));
+    EXPECT_EQ(r.chord_root, 9);
+    EXPECT_EQ(r.chord_quality, ChordQuality::Minor);
+}
+
+TEST(ChromaAnalyzerTest, TracksChordChanges) {
+    ChromaAnalyzer analyzer(kSampleRate, 4096);
+    feed(analyzer, chord({60, 64, 67}, 0.5f));
+    const ChromaAnalyzer::Result r = feed(analyzer, chord({55, 59, 62}, 0.5f));
+    EXPECT_EQ(r.chord_root, 7);
+    EXPECT_EQ(r.chord_quality, ChordQuality::Major);
+}
+
+TEST(ChromaAnalyzerTest, EstimatesKeyFromProgression) {
+    ChromaAnalyzer analyzer(kSampleRate, 4096);
+    ChromaAnalyzer::Result r{};
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        feed(analyzer, chord({60, 64, 67}, 0.75f));
+        feed(analyzer, chord({65, 69, 72}, 0.75f));
+        feed(analyzer, chord({67, 71, 74}, 0.75f));
+        r = feed(analyzer, chord({60, 64, 67}, 0.75f));
+    }
+    EXPECT_EQ(r.key_tonic, 0);
+    EXPECT_FALSE(r.key_minor);
+}
+
+TEST(ChromaAnalyzerTest, ResetClearsState) {
+    ChromaAnalyzer analyzer(kSampleRate, 4096);
+    feed(analyzer, chord({60, 64, 67}, 0.5f));
+    analyzer.reset();
+    const float one = 0.0f;
+    const ChromaAnalyzer::Result r = analyzer.process(&one, 1);
+    EXPECT_FALSE(r.updated);
+    EXPECT_EQ(r.chord_root, -1);
+    EXPECT_EQ(r.key_tonic, -1);
+}
+
+TEST(ChromaFfiTest, ProcessReportsChord) {
+    EXPECT_EQ(ml_chroma_create(kSampleRate, 100, 440.0f), nullptr);
+
+    MLChromaHandle* handle = ml_chroma_create(kSampleRate, 4096, 440.0f);
+    ASSERT_NE(handle, nullptr);
+
+    const MLChromaResult empty = ml_chroma_process(handle, nullptr, 0);
+    EXPECT_EQ(empty.updated, 0);
+    EXPECT_EQ(empty.chord_root, -1);
+
+    const std::vector<float> buf = chord({62, 65, 69}, 0.5f);
+    MLChromaResult r{};
+    for (size_t pos = 0; pos < buf.size(); pos += 1024) {
+        r = ml_chroma_process(handle, buf.data() + pos, static_cast<int>(std::min<size_t>(1024, buf.size() - pos)));
+    }
+    EXPECT_EQ(r.chord_root, 2);
+    EXPECT_EQ(r.chord_quality, ML_CHORD_MINOR);
+
+    ml_chroma_destroy(handle);
+}
@@ -0,0 +1,252 @@
+/**
+ * Unit tests for banded DTW alignment of pitch and chroma contours.
+ */
+
+#include "contour_aligner.h"
+#include "pitch_detector_ffi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::ContourAligner;
+
+namespace {
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+struct SungNote {
+    int   midi_note;
+    int   frames;
+    float cents;   // Offset from the note centre
+};
+
+// Pitch contour in absolute cents: each note followed by a two-hop unvoiced
+// gap, with a slow +-8 cent wobble so no two hops are identical.
+std::vector<float> sing(const std::vector<SungNote>& notes) {
+    std::vector<float> contour;
+    for (const SungNote& note : notes) {
+        for (int i = 0; i < note.frames; ++i) {
+            contour.push_back(100.0f * note.midi_note + note.cents +
+                              8.0f * static_cast<float>(std::sin(0.3 * static_cast<double>(contour.size()))));
+        }
+        contour.push_back(kNaN);
+        contour.push_back(kNaN);
+    }
+    return contour;
+}
+
+// A melody of `count` notes, and a take of it played with per-note tempo
+// changes; note 3 is sung 25 cents sharp.
+void melody(int count, std::vector<SungNote>& ref, std::vector<SungNote>& take) {
+    static const int kScale[] = {60, 62, 64, 65, 67, 69, 71, 72, 71, 69, 67, 65, 64, 62};
+    for (int n = 0; n < count; ++n) {
+        const int midi = kScale[n % 14];
+        const int frames = 20 + 7 * (n % 5);
+        ref.push_back({midi, frames, 0.0f});
+        const int stretched = static_cast<int>(frames * (n % 3 == 0 ? 1.3 : n % 3 == 1 ? 0.8 : 1.0));
+        take.push_back({midi, stretched, n == 3 ? 25.0f : 0.0f});
+    }
+}
+
+// Unbanded DTW cost with a full matrix, the reference for small problems.
+double brute_force_cost(const std::vector<float>& ref, const std::vector<float>& take, float max_cost) {
+    const size_t n = ref.size();
+    const size_t m = take.size();
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> total(n * m, inf);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < m; ++j) {
+            const bool ru = std::isnan(ref[i]);
+            const bool tu = std::isnan(take[j]);
+            const double cost = ru && tu ? 0.0 : ru || tu ? max_cost
+                                                          : std::min<double>(std::fabs(ref[i] - take[j]), max_cost);
+            double prev = i == 0 && j == 0 ? 0.0 : inf;
+            if (i > 0) prev = std::min(prev, total[(i - 1) * m + j]);
+            if (j > 0) prev = std::min(prev, total[i * m + j - 1]);
+            if (i > 0 && j > 0) prev = std::min(prev, total[(i - 1) * m + j - 1]);
+            total[i * m + j] = prev + cost;
+        }
+    }
+    return total.back();
+}
+
+void expect_valid_path(const std::vector<ContourAligner::Step>& path, int n, int m) {
+    ASSERT_FALSE(path.empty());
+    EXPECT_EQ(path.front().ref, 0);
+    EXPECT_EQ(path.front().take, 0);
+    EXPECT_EQ(path.back().ref, n - 1);
+    EXPECT_EQ(path.back().take, m - 1);
+    for (size_t s = 1; s < path.size(); ++s) {
+        const int dr = path[s].ref - path[s - 1].ref;
+        const int dt = path[s].take - path[s - 1].take;
+        ASSERT_TRUE(dr >= 0 && dr <= 1 && dt >= 0 && dt <= 1 && dr + dt > 0) << "step " << s;
+    }
+}
+
+}  // namespace
+
+TEST(ContourAlignerTest, RejectsInvalidArguments) {
+    ContourAligner::Config config;
+    config.band = 0;
+    EXPECT_THROW(ContourAligner{config}, std::invalid_argument);
+    config.band = 10;
+    config.max_cost = kNaN;
+    EXPECT_THROW(ContourAligner{config}, std::invalid_argument);
+
+    const ContourAligner aligner;
+    const float contour[4] = {6000.0f, 6000.0f, 6200.0f, 6200.0f};
+    EXPECT_THROW(aligner.align(nullptr, 4, contour, 4, 1), std::invalid_argument);
+    EXPECT_THROW(aligner.align(contour, 0, contour, 4, 1), std::invalid_argument);
+    EXPECT_THROW(aligner.align(contour, 4, contour, 4, ContourAligner::kMaxDims + 1), std::invalid_argument);
+    EXPECT_THROW(ContourAligner::note_deviations(contour, 4, contour, 4, {{0, 0}, {2, 2}, {3, 3}}),
+                 std::invalid_argument);
+}
+
+TEST(ContourAlignerTest, IdenticalContoursAlignOnDiagonal) {
+    std::vector<SungNote> ref, take;
+    melody(40, ref, take);
+    const std::vector<float> contour = sing(ref);
+    const int n = static_cast<int>(contour.size());
+    const ContourAligner::Alignment alignment = ContourAligner().align(contour.data(), n, contour.data(), n, 1);
+    ASSERT_EQ(alignment.path.size(), contour.size());
+    for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(alignment.path[static_cast<size_t>(i)].ref, i);
+        EXPECT_EQ(alignment.path[static_cast<size_t>(i)].take, i);
+    }
+    EXPECT_DOUBLE_EQ(alignment.cost, 0.0);
+}
+
+TEST(ContourAlignerTest, MatchesFullMatrixCost) {
+    // Large enough that the path is recovered by splitting, not one matrix.
+    std::vector<SungNote> ref, take;
+    melody(16, ref, take);
+    const std::vector<float> r = sing(ref);
+    const std::vector<float> t = sing(take);
+    ASSERT_GT(static_cast<int64_t>(r.size() * t.size()), 4 * ContourAligner::kDirectCells);
+
+    for (const int threads : {1, 4}) {
+        ContourAligner::Config config;
+        config.band = static_cast<int>(t.size());   // Unconstrained
+        config.threads = threads;
+        const ContourAligner::Alignment alignment =
+            ContourAligner(config).align(r.data(), static_cast<int>(r.size()), t.data(), static_cast<int>(t.size()), 1);
+        expect_valid_path(alignment.path, static_cast<int>(r.size()), static_cast<int>(t.size()));
+        EXPECT_NEAR(alignment.cost, brute_force_cost(r, t, config.max_cost), 1.0) << "threads " << threads;
+    }
+}
+
+TEST(ContourAlignerTest, ReportsPerNoteDeviations) {
+    std::vector<SungNote> ref, take;
+    melody(12, ref, take);
+    const std::vector<float> r = sing(ref);
+    const std::vector<float> t = sing(take);
+    const int n = static_cast<int>(r.size());
+    const int m = static_cast<int>(t.size());
+
+    ContourAligner::Config config;
+    config.band = 40;
+    const ContourAligner::Alignment alignment = ContourAligner(config).align(r.data(), n, t.data(), m, 1);
+    expect_valid_path(alignment.path, n, m);
+    const std::vector<ContourAligner::NoteDeviation> notes =
+        ContourAligner::note_deviations(r.data(), n, t.data(), m, alignment.path);
+    ASSERT_EQ(notes.size(), ref.size());
+
+    int ref_pos = 0;
+    int take_pos = 0;
+    for (size_t k = 0; k < notes.size(); ++k) {
+        const ContourAligner::NoteDeviation& note = notes[k];
+        EXPECT_EQ(note.midi_note, ref[k].midi_note);
+        EXPECT_EQ(note.ref_start, ref_pos);
+        EXPECT_EQ(note.ref_end, ref_pos + ref[k].frames);
+        // The aligned take note starts and ends within a hop of the truth.
+        EXPECT_NEAR(note.take_start, take_pos, 1) << "note " << k;
+        EXPECT_NEAR(note.take_end, take_pos + take[k].frames, 1) << "note " << k;
+        EXPECT_NEAR(note.duration_ratio, static_cast<float>(take[k].frames) / ref[k].frames, 0.1f) << "note " << k;
+        EXPECT_NEAR(note.cents_error, k == 3 ? 25.0f : 0.0f, 6.0f) << "note " << k;
+        EXPECT_GT(note.voiced_frames, 0);
+        ref_pos += ref[k].frames + 2;
+        take_pos += take[k].frames + 2;
+    }
+    // The first note is stretched, so the second starts late against the
+    // overall tempo.
+    EXPECT_GT(notes[1].timing_error, 3.0f);
+}
+
+TEST(ContourAlignerTest, AlignsChromaContours) {
+    // Twelve-bin one-hot chroma of a chord sequence; the take holds each
+    // chord half as long again.
+    std::vector<float> ref, take;
+    for (int chord = 0; chord < 30; ++chord) {
+        const int root = (chord * 7) % 12;
+        for (int copy = 0; copy < 2; ++copy) {
+            std::vector<float>& out = copy == 0 ? ref : take;
+            const int frames = copy == 0 ? 10 : 15;
+            for (int f = 0; f < frames; ++f) {
+                for (int bin = 0; bin < 12; ++bin) {
+                    out.push_back(bin == root || bin == (root + 4) % 12 || bin == (root + 7) % 12 ? 1.0f : 0.0f);
+                }
+            }
+        }
+    }
+    const int n = static_cast<int>(ref.size() / 12);
+    const int m = static_cast<int>(take.size() / 12);
+    ContourAligner::Config config;
+    config.band = 20;
+    config.max_cost = 1.0f;
+    const ContourAligner::Alignment alignment = ContourAligner(config).align(ref.data(), n, take.data(), m, 12);
+    expect_valid_path(alignment.path, n, m);
+    EXPECT_DOUBLE_EQ(alignment.cost, 0.0);
+    for (const ContourAligner::Step& step : alignment.path) EXPECT_EQ(step.ref / 10, step.take / 15);
+}
+
+TEST(ContourAlignerTest, TenMinuteTakeScores) {
+    // 100 hops per second: a 10-minute reference against a take 5% slower.
+    // Its runtime is tracked by ml_bench (contour_align_10min), not here.
+    std::vector<SungNote> ref, take;
+    melody(1700, ref, take);
+    for (SungNote& note : take) note.frames = note.frames * 105 / 100;
+    const std::vector<float> r = sing(ref);
+    const std::vector<float> t = sing(take);
+    ASSERT_GE(r.size(), 60000u);
+
+    const ContourAligner::Alignment alignment =
+        ContourAligner().align(r.data(), static_cast<int>(r.size()), t.data(), static_cast<int>(t.size()), 1);
+    const std::vector<ContourAligner::NoteDeviation> notes = ContourAligner::note_deviations(
+        r.data(), static_cast<int>(r.size()), t.data(), static_cast<int>(t.size()), alignment.path);
+
+    expect_valid_path(alignment.path, static_cast<int>(r.size()), static_cast<int>(t.size()));
+    EXPECT_EQ(notes.size(), ref.size());
+    EXPECT_NEAR(notes[3].cents_error, 25.0f, 6.0f);
+}
+
+TEST(ContourAlignerFfiTest, AlignsThroughCApi) {
+    std::vector<SungNote> ref, take;
+    melody(6, ref, take);
+    const std::vector<float> r = sing(ref);
+    const std::vector<float> t = sing(take);
+    const int n = static_cast<int>(r.size());
+    const int m = static_cast<int>(t.size());
+
+    EXPECT_EQ(ml_align_contours(nullptr, n, t.data(), m, 1, 40, 200.0f, nullptr, 0), -1);
+    EXPECT_EQ(ml_align_contours(r.data(), n, t.data(), m, 1, 0, 200.0f, nullptr, 0), -1);
+    const int length = ml_align_contours(r.data(), n, t.data(), m, 1, 40, 200.0f, nullptr, 0);
+    ASSERT_GT(length, 0);
+    ASSERT_LE(length, n + m - 1);
+
+    std::vector<MLAlignmentStep> path(static_cast<size_t>(length));
+    ASSERT_EQ(ml_align_contours(r.data(), n, t.data(), m, 1, 40, 200.0f, path.data(), length), length);
+    EXPECT_EQ(path.back().ref_frame, n - 1);
+    EXPECT_EQ(path.back().take_frame, m - 1);
+
+    MLNoteDeviation notes[8];
+    EXPECT_EQ(ml_align_note_deviations(r.data(), n, t.data(), m, nullptr, length, notes, 8), -1);
+    ASSERT_EQ(ml_align_note_deviations(r.data(), n, t.data(), m, path.data(), length, notes, 8), 6);
+    EXPECT_EQ(notes[3].midi_note, 65);
+    EXPECT_NEAR(notes[3].cents_error, 25.0f, 6.0f);
+    EXPECT_EQ(ml_align_note_deviations(r.data(), n, t.data(), m, path.data(), length, nullptr, 0), 6);
+}
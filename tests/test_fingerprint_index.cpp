@@ -0,0 +1,355 @@
+/**
+ * Unit tests for audio fingerprints and the on-disk fingerprint index.
+ */
+
+#include "fingerprint_index.h"
+#include "pitch_detector_ffi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::AudioFingerprint;
+using music_life::FingerprintIndex;
+
+namespace {
+
+constexpr int    kSampleRate = 22050;
+constexpr double kTwoPi = 6.28318530717958647692;
+
+void put_u16(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back(static_cast<unsigned char>(v & 0xFF));
+    out.push_back(static_cast<unsigned char>((v >> 8) & 0xFF));
+}
+
+void put_u32(std::vector<unsigned char>& out, uint32_t v) {
+    put_u16(out, v & 0xFFFF);
+    put_u16(out, v >> 16);
+}
+
+// Mono float samples as a 16-bit PCM WAV file.
+void write_wav(const std::string& path, const std::vector<float>& samples) {
+    std::vector<unsigned char> file;
+    file.insert(file.end(), {'R', 'I', 'F', 'F'});
+    put_u32(file, static_cast<uint32_t>(36 + 2 * samples.size()));
+    file.insert(file.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    put_u32(file, 16);
+    put_u16(file, 1);
+    put_u16(file, 1);
+    put_u32(file, kSampleRate);
+    put_u32(file, kSampleRate * 2);
+    put_u16(file, 2);
+    put_u16(file, 16);
+    file.insert(file.end(), {'d', 'a', 't', 'a'});
+    put_u32(file, static_cast<uint32_t>(2 * samples.size()));
+    for (const float s : samples) put_u16(file, static_cast<uint32_t>(static_cast<int32_t>(std::lround(s * 32767.0))) & 0xFFFF);
+
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(out, nullptr);
+    std::fwrite(file.data(), 1, file.size(), out);
+    std::fclose(out);
+}
+
+// A random melody of harmonic notes; `tempo` scales every note's length, so
+// two calls with the same seed play the same piece at different speeds.
+std::vector<float> melody(unsigned seed, double seconds, double tempo = 1.0, double noise = 0.0) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> note(55, 79);
+    std::uniform_int_distribution<int> beats(1, 3);
+    std::normal_distribution<float> hiss(0.0f, 1.0f);
+    std::vector<float> out;
+    while (out.size() < static_cast<size_t>(seconds * kSampleRate)) {
+        const double hz = 440.0 * std::pow(2.0, (note(rng) - 69) / 12.0);
+        const int length = static_cast<int>(0.2 * beats(rng) * tempo * kSampleRate);
+        for (int i = 0; i < length; ++i) {
+            const double t = static_cast<double>(i) / kSampleRate;
+            const double envelope = std::min(t / 0.01, 1.0) * std::exp(-2.0 * t);
+            double s = 0.0;
+            for (int h = 1; h <= 4; ++h) s += std::sin(kTwoPi * hz * h * t) / h;
+            out.push_back(static_cast<float>(0.3 * envelope * s));
+        }
+    }
+    out.resize(static_cast<size_t>(seconds * kSampleRate));
+    if (noise > 0.0) {
+        for (float& s : out) s += static_cast<float>(noise) * hiss(rng);
+    }
+    return out;
+}
+
+class FingerprintIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = std::filesystem::temp_directory_path() /
+                (std::string("ml_fingerprint_") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(root_); }
+
+    std::string path(const std::string& name) const { return (root_ / name).string(); }
+
+    // Library of `count` different 20 s melodies.
+    std::vector<std::string> library(int count) const {
+        std::vector<std::string> paths;
+        for (int i = 0; i < count; ++i) {
+            paths.push_back(path("take" + std::to_string(i) + ".wav"));
+            write_wav(paths.back(), melody(100 + static_cast<unsigned>(i), 20.0));
+        }
+        return paths;
+    }
+
+    std::filesystem::path root_;
+};
+
+}  // namespace
+
+TEST(AudioFingerprintTest, ComputesLandmarksAndWords) {
+    const std::vector<float> samples = melody(1, 20.0);
+    const AudioFingerprint fp = AudioFingerprint::compute(samples.data(), static_cast<int64_t>(samples.size()), 1, kSampleRate);
+    EXPECT_NEAR(fp.seconds, 20.0f, 1e-3f);
+    ASSERT_GT(fp.landmarks.size(), 200u);
+    ASSERT_GT(fp.words.size(), 20u);
+    for (size_t i = 1; i < fp.landmarks.size(); ++i) EXPECT_LE(fp.landmarks[i - 1].frame, fp.landmarks[i].frame);
+    EXPECT_LT(fp.landmarks.back().frame, static_cast<uint32_t>(20.0 / AudioFingerprint::kFrameSeconds) + 1);
+    for (const auto& landmark : fp.landmarks) EXPECT_EQ(landmark.hash & AudioFingerprint::kWordFlag, 0u);
+    for (size_t i = 0; i < fp.words.size(); ++i) {
+        EXPECT_NE(fp.words[i] & AudioFingerprint::kWordFlag, 0u);
+        if (i > 0) EXPECT_LT(fp.words[i - 1], fp.words[i]);
+    }
+
+    // Stereo with the melody on both channels fingerprints the same.
+    std::vector<float> stereo;
+    for (const float s : samples) stereo.insert(stereo.end(), {s, s});
+    const AudioFingerprint both = AudioFingerprint::compute(stereo.data(), static_cast<int64_t>(samples.size()), 2, kSampleRate);
+    EXPECT_EQ(both.landmarks.size(), fp.landmarks.size());
+    EXPECT_EQ(both.words, fp.words);
+
+    const std::vector<float> silence(kSampleRate * 5, 0.0f);
+    const AudioFingerprint quiet = AudioFingerprint::compute(silence.data(), kSampleRate * 5, 1, kSampleRate);
+    EXPECT_TRUE(quiet.landmarks.empty());
+    EXPECT_TRUE(quiet.words.empty());
+
+    EXPECT_THROW(AudioFingerprint::compute(samples.data(), 100, 0, kSampleRate), std::invalid_argument);
+    EXPECT_THROW(AudioFingerprint::compute(samples.data(), 100, 1, 4000), std::invalid_argument);
+}
+
+TEST_F(FingerprintIndexTest, FindsNoisyExcerptAtItsOffset) {
+    const std::vector<std::string> paths = library(6);
+    FingerprintIndex index(path("index"), 3);
+    const std::vector<FingerprintIndex::Status> statuses = index.add(paths);
+    for (const auto status : statuses) EXPECT_EQ(status, FingerprintIndex::Status::Added);
+    EXPECT_EQ(index.size(), 6u);
+
+    // Seconds 5 to 12 of take3, quieter and with hiss.
+    const std::vector<float> full = melody(103, 20.0);
+    std::vector<float> excerpt(full.begin() + 5 * kSampleRate, full.begin() + 12 * kSampleRate);
+    std::mt19937 rng(7);
+    std::normal_distribution<float> hiss(0.0f, 0.02f);
+    for (float& s : excerpt) s = 0.7f * s + hiss(rng);
+    const AudioFingerprint fp = AudioFingerprint::compute(excerpt.data(), static_cast<int64_t>(excerpt.size()), 1, kSampleRate);
+
+    const std::vector<FingerprintIndex::Match> matches = index.query(fp, 3, 0.05f);
+    ASSERT_FALSE(matches.empty());
+    EXPECT_EQ(matches[0].path, paths[3]);
+    EXPECT_GT(matches[0].duplicate_score, 0.2f);
+    EXPECT_NEAR(matches[0].offset_seconds, 5.0f, 0.1f);
+    for (size_t i = 1; i < matches.size(); ++i) EXPECT_LT(matches[i].duplicate_score, 0.05f);
+}
+
+TEST_F(FingerprintIndexTest, SamePieceAtAnotherTempoIsSimilar) {
+    std::vector<std::string> paths = library(6);
+    paths.push_back(path("slow_take2.wav"));
+    write_wav(paths.back(), melody(102, 25.0, 1.25, 0.01));
+    FingerprintIndex index(path("index"), 2);
+    index.add(paths);
+
+    std::vector<FingerprintIndex::Match> matches;
+    ASSERT_TRUE(index.find_similar(paths.back(), 5, 0.0f, matches));
+    ASSERT_FALSE(matches.empty());
+    EXPECT_EQ(matches[0].path, paths[2]);
+    EXPECT_GT(matches[0].similarity, 0.2f);
+    for (size_t i = 1; i < matches.size(); ++i) EXPECT_LT(matches[i].similarity, matches[0].similarity / 2);
+    for (const auto& match : matches) EXPECT_NE(match.path, paths.back());
+
+    EXPECT_FALSE(index.find_similar(path("unknown.wav"), 5, 0.0f, matches));
+}
+
+TEST_F(FingerprintIndexTest, AddsIncrementallyAndPersists) {
+    const std::vector<std::string> paths = library(4);
+    {
+        FingerprintIndex index(path("index"), 2);
+        index.add({paths[0], paths[1]});
+        EXPECT_EQ(index.segment_count(), 1);
+        const auto statuses = index.add(paths);
+        EXPECT_EQ(statuses[0], FingerprintIndex::Status::Current);
+        EXPECT_EQ(statuses[1], FingerprintIndex::Status::Current);
+        EXPECT_EQ(statuses[2], FingerprintIndex::Status::Added);
+        EXPECT_EQ(index.segment_count(), 2);
+
+        const auto again = index.add(paths);
+        for (const auto status : again) EXPECT_EQ(status, FingerprintIndex::Status::Current);
+        EXPECT_EQ(index.segment_count(), 2);
+    }
+
+    // A changed recording supersedes its entry: take0 now plays take5's music.
+    write_wav(paths[0], melody(105, 20.0));
+    FingerprintIndex index(path("index"), 2);
+    EXPECT_EQ(index.size(), 4u);
+    EXPECT_EQ(index.add({paths[0]})[0], FingerprintIndex::Status::Added);
+    EXPECT_EQ(index.size(), 4u);
+    EXPECT_EQ(index.segment_count(), 3);
+
+    const std::vector<float> old_music = melody(100, 20.0);
+    const AudioFingerprint old_fp = AudioFingerprint::compute(old_music.data(), static_cast<int64_t>(old_music.size()), 1, kSampleRate);
+    EXPECT_TRUE(index.query(old_fp, 5, 0.2f).empty());
+
+    index.compact();
+    EXPECT_EQ(index.segment_count(), 1);
+    EXPECT_EQ(index.size(), 4u);
+    const std::vector<float> new_music = melody(105, 20.0);
+    const AudioFingerprint new_fp = AudioFingerprint::compute(new_music.data(), static_cast<int64_t>(new_music.size()), 1, kSampleRate);
+    const auto matches = index.query(new_fp, 5, 0.2f);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].path, paths[0]);
+    EXPECT_GT(matches[0].duplicate_score, 0.9f);
+
+    size_t segment_files = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(path("index"))) {
+        segment_files += entry.path().extension() == ".mlfp";
+    }
+    EXPECT_EQ(segment_files, 1u);
+}
+
+TEST_F(FingerprintIndexTest, ReportsUnsupportedAndMissingFiles) {
+    const std::string text = path("notes.txt");
+    std::FILE* out = std::fopen(text.c_str(), "wb");
+    ASSERT_NE(out, nullptr);
+    std::fputs("not audio", out);
+    std::fclose(out);
+
+    FingerprintIndex index(path("index"), 1);
+    const auto statuses = index.add({text, path("missing.wav")});
+    EXPECT_EQ(statuses[0], FingerprintIndex::Status::Unsupported);
+    EXPECT_EQ(statuses[1], FingerprintIndex::Status::IoError);
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_EQ(index.segment_count(), 0);
+    EXPECT_THROW(FingerprintIndex(""), std::invalid_argument);
+}
+
+TEST_F(FingerprintIndexTest, SkipsCorruptSegments) {
+    const std::vector<std::string> paths = library(1);
+    FingerprintIndex(path("index"), 1).add(paths);
+    std::string segment;
+    for (const auto& entry : std::filesystem::directory_iterator(path("index"))) {
+        if (entry.path().extension() == ".mlfp") segment = entry.path().string();
+    }
+    ASSERT_FALSE(segment.empty());
+
+    // The first posting's recording, past the 48-byte header and the one
+    // 64-byte recording entry, points outside the segment.
+    std::FILE* file = std::fopen(segment.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fseek(file, 48 + 64 + 4, SEEK_SET), 0);
+    const uint32_t bad_recording = 7;
+    ASSERT_EQ(std::fwrite(&bad_recording, sizeof(bad_recording), 1, file), 1u);
+    std::fclose(file);
+
+    FingerprintIndex index(path("index"), 1);
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_EQ(index.segment_count(), 0);
+    EXPECT_EQ(index.add(paths)[0], FingerprintIndex::Status::Added);
+    EXPECT_EQ(index.size(), 1u);
+}
+
+TEST_F(FingerprintIndexTest, MergesSegmentsPastTheLimit) {
+    const std::vector<std::string> paths = library(FingerprintIndex::kMaxSegments + 1);
+    FingerprintIndex index(path("index"), 1);
+    for (int i = 0; i < FingerprintIndex::kMaxSegments; ++i) index.add({paths[static_cast<size_t>(i)]});
+    EXPECT_EQ(index.segment_count(), FingerprintIndex::kMaxSegments);
+    index.add({paths.back()});
+    EXPECT_EQ(index.segment_count(), 1);
+    EXPECT_EQ(index.size(), paths.size());
+    for (const auto status : index.add(paths)) EXPECT_EQ(status, FingerprintIndex::Status::Current);
+}
+
+TEST_F(FingerprintIndexTest, QueriesThousandsOfRecordings) {
+    constexpr int kRecordings = 2000;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint32_t> hash(0, (1u << 21) - 1);
+    std::uniform_int_distribution<uint32_t> word(0, 0x7FFFFFFFu);
+    std::vector<std::string> paths;
+    std::vector<AudioFingerprint> fingerprints;
+    for (int r = 0; r < kRecordings; ++r) {
+        paths.push_back(path("r" + std::to_string(r) + ".m4a"));
+        std::FILE* out = std::fopen(paths.back().c_str(), "wb");
+        ASSERT_NE(out, nullptr);
+        std::fputc(r & 0xFF, out);
+        std::fclose(out);
+
+        AudioFingerprint fp;
+        fp.seconds = 180.0f;
+        for (uint32_t frame = 0; frame < 2800; frame += 2) fp.landmarks.push_back({hash(rng), frame});
+        for (int w = 0; w < 300; ++w) fp.words.push_back(word(rng) | AudioFingerprint::kWordFlag);
+        std::sort(fp.words.begin(), fp.words.end());
+        fp.words.erase(std::unique(fp.words.begin(), fp.words.end()), fp.words.end());
+        fingerprints.push_back(std::move(fp));
+    }
+
+    FingerprintIndex index(path("index"), 1);
+    ASSERT_TRUE(index.store(paths, fingerprints));
+    ASSERT_EQ(index.size(), static_cast<size_t>(kRecordings));
+
+    std::vector<FingerprintIndex::Match> matches;
+    ASSERT_TRUE(index.find_similar(paths[1234], 10, 0.1f, matches));
+    EXPECT_TRUE(matches.empty());
+    const AudioFingerprint& fp = fingerprints[1234];
+    const AudioFingerprint excerpt{60.0f, {fp.landmarks.begin() + 300, fp.landmarks.begin() + 700}, fp.words};
+    matches = index.query(excerpt, 10, 0.1f);
+
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].path, paths[1234]);
+    EXPECT_NEAR(matches[0].offset_seconds, 0.0f, 1e-6f);
+    EXPECT_FLOAT_EQ(matches[0].similarity, 1.0f);
+}
+
+TEST_F(FingerprintIndexTest, FfiAddsAndFindsSimilar) {
+    EXPECT_EQ(ml_fingerprint_index_create(nullptr, 0), nullptr);
+    MLFingerprintIndexHandle* handle = ml_fingerprint_index_create(path("index").c_str(), 0);
+    ASSERT_NE(handle, nullptr);
+
+    const std::string original = path("take.wav");
+    const std::string copy = path("copy.wav");
+    const std::string missing = path("missing.wav");
+    write_wav(original, melody(3, 15.0));
+    write_wav(copy, melody(3, 15.0));
+    const char* paths[] = {original.c_str(), copy.c_str(), missing.c_str()};
+    int32_t statuses[3] = {-1, -1, -1};
+    EXPECT_EQ(ml_fingerprint_index_add(handle, nullptr, 3, statuses), -1);
+    EXPECT_EQ(ml_fingerprint_index_add(handle, paths, 3, statuses), 2);
+    EXPECT_EQ(statuses[0], ML_FINGERPRINT_ADDED);
+    EXPECT_EQ(statuses[2], ML_FINGERPRINT_IO_ERROR);
+    EXPECT_EQ(ml_fingerprint_index_size(handle), 2);
+
+    MLFingerprintMatch matches[4];
+    char names[256];
+    ASSERT_EQ(ml_fingerprint_index_find_similar(handle, original.c_str(), 0.5f, matches, 4, names, sizeof(names)), 1);
+    EXPECT_GT(matches[0].duplicate_score, 0.9f);
+    EXPECT_GT(matches[0].similarity, 0.9f);
+    ASSERT_EQ(matches[0].path_offset, 0);
+    EXPECT_EQ(std::string(names), copy);
+    ASSERT_EQ(ml_fingerprint_index_find_similar(handle, original.c_str(), 0.5f, matches, 4, names, 4), 1);
+    EXPECT_EQ(matches[0].path_offset, -1);
+    EXPECT_EQ(ml_fingerprint_index_find_similar(handle, missing.c_str(), 0.5f, matches, 4, names, 4), -1);
+    EXPECT_EQ(ml_fingerprint_index_find_similar(handle, original.c_str(), 0.5f, nullptr, 4, names, 4), -1);
+    ml_fingerprint_index_destroy(handle);
+}
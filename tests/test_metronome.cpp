@@ -0,0 +1,188 @@
+/**
+ * Unit tests for the sample-accurate metronome.
+ */
+
+#include "metronome.h"
+#include "pitch_detector_ffi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::Metronome;
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+
+std::vector<Metronome::ClickEvent> render_clicks(Metronome& metronome, int total, int block,
+                                                 std::vector<float>* audio = nullptr) {
+    std::vector<Metronome::ClickEvent> clicks;
+    std::vector<float> out(static_cast<size_t>(block));
+    Metronome::ClickEvent events[8];
+    for (int done = 0; done < total; done += block) {
+        const int n = std::min(block, total - done);
+        std::fill(out.begin(), out.end(), 0.0f);
+        const int count = metronome.render(out.data(), n, events, 8);
+        clicks.insert(clicks.end(), events, events + std::min(count, 8));
+        if (audio) audio->insert(audio->end(), out.begin(), out.begin() + n);
+    }
+    return clicks;
+}
+
+}  // namespace
+
+TEST(MetronomeTest, RejectsInvalidArguments) {
+    EXPECT_THROW(Metronome(0), std::invalid_argument);
+    Metronome metronome(kSampleRate);
+    EXPECT_THROW(metronome.set_tempo(10.0f), std::invalid_argument);
+    EXPECT_THROW(metronome.set_time_signature(0, 1), std::invalid_argument);
+    EXPECT_THROW(metronome.set_time_signature(4, 5), std::invalid_argument);
+    EXPECT_THROW(metronome.set_volume(-1.0f), std::invalid_argument);
+    EXPECT_THROW(metronome.load_sound(Metronome::Sound::Click, nullptr, 0), std::invalid_argument);
+}
+
+TEST(MetronomeTest, SilentUntilStarted) {
+    Metronome metronome(kSampleRate);
+    std::vector<float> audio;
+    EXPECT_TRUE(render_clicks(metronome, kSampleRate, 256, &audio).empty());
+    for (float v : audio) EXPECT_EQ(v, 0.0f);
+}
+
+TEST(MetronomeTest, ClicksAreSampleExactAcrossBlockSizes) {
+    for (int block : {64, 100, 441, 4096}) {
+        Metronome metronome(kSampleRate);
+        metronome.set_tempo(137.0f);
+        metronome.start();
+        const std::vector<Metronome::ClickEvent> clicks = render_clicks(metronome, kSampleRate * 30, block);
+
+        const double period = 60.0 * kSampleRate / 137.0;
+        ASSERT_EQ(clicks.size(), static_cast<size_t>(std::ceil(kSampleRate * 30 / period)));
+        for (size_t i = 0; i < clicks.size(); ++i) {
+            EXPECT_EQ(clicks[i].sample_position, static_cast<int64_t>(std::llround(i * period))) << "block=" << block;
+            EXPECT_EQ(clicks[i].beat_in_bar, static_cast<int>(i % 4));
+        }
+    }
+}
+
+TEST(MetronomeTest, ClickAudioStartsAtScheduledSample) {
+    Metronome metronome(kSampleRate);
+    const float impulse = 1.0f;
+    metronome.load_sound(Metronome::Sound::Click, &impulse, 1);
+    metronome.load_sound(Metronome::Sound::Accent, &impulse, 1);
+    metronome.set_tempo(100.0f);
+    metronome.start();
+
+    std::vector<float> audio;
+    const std::vector<Metronome::ClickEvent> clicks = render_clicks(metronome, kSampleRate * 3, 333, &audio);
+    ASSERT_EQ(clicks.size(), 5u);
+    for (size_t i = 0; i < audio.size(); ++i) {
+        const bool is_click = std::any_of(clicks.begin(), clicks.end(), [i](const Metronome::ClickEvent& c) {
+            return c.sample_position == static_cast<int64_t>(i);
+        });
+        if (is_click) {
+            EXPECT_GT(audio[i], 0.0f) << i;
+        } else {
+            EXPECT_EQ(audio[i], 0.0f) << i;
+        }
+    }
+}
+
+TEST(MetronomeTest, TimeSignatureAndSubdivision) {
+    Metronome metronome(kSampleRate);
+    metronome.set_tempo(120.0f);
+    metronome.set_time_signature(3, 2);
+    metronome.start();
+    const std::vector<Metronome::ClickEvent> clicks = render_clicks(metronome, kSampleRate * 3, 512);
+
+    ASSERT_EQ(clicks.size(), 12u);
+    for (size_t i = 0; i < clicks.size(); ++i) {
+        EXPECT_EQ(clicks[i].sample_position, static_cast<int64_t>(i) * kSampleRate / 4);
+        EXPECT_EQ(clicks[i].tick_in_beat, static_cast<int>(i % 2));
+        EXPECT_EQ(clicks[i].beat_in_bar, static_cast<int>((i / 2) % 3));
+    }
+}
+
+TEST(MetronomeTest, TempoChangeAppliesFromNextTick) {
+    Metronome metronome(kSampleRate);
+    metronome.set_tempo(60.0f);
+    metronome.start();
+    std::vector<Metronome::ClickEvent> clicks = render_clicks(metronome, kSampleRate / 2, 480);
+    ASSERT_EQ(clicks.size(), 1u);
+
+    metronome.set_tempo(120.0f);
+    clicks = render_clicks(metronome, kSampleRate * 2, 480);
+    ASSERT_GE(clicks.size(), 3u);
+    // The tick already scheduled at 1 s keeps its place; later ticks follow the new tempo.
+    EXPECT_EQ(clicks[0].sample_position, kSampleRate);
+    EXPECT_EQ(clicks[1].sample_position, kSampleRate + kSampleRate / 2);
+    EXPECT_EQ(clicks[2].sample_position, 2 * kSampleRate);
+}
+
+TEST(MetronomeTest, StopLetsClickRingOutAndStartRestartsBar) {
+    Metronome metronome(kSampleRate);
+    metronome.start();
+    std::vector<float> audio;
+    render_clicks(metronome, 256, 256, &audio);
+    metronome.stop();
+    audio.clear();
+    const std::vector<Metronome::ClickEvent> none = render_clicks(metronome, kSampleRate, 256, &audio);
+    EXPECT_TRUE(none.empty());
+    EXPECT_NE(audio.front(), 0.0f);  // Tail of the first click
+    EXPECT_EQ(audio.back(), 0.0f);
+
+    metronome.start();
+    const std::vector<Metronome::ClickEvent> clicks = render_clicks(metronome, 256, 256);
+    ASSERT_EQ(clicks.size(), 1u);
+    EXPECT_EQ(clicks[0].sample_position, metronome.samples_rendered() - 256);
+    EXPECT_EQ(clicks[0].beat_in_bar, 0);
+}
+
+TEST(MetronomeTest, ConcurrentControlDoesNotDisturbRendering) {
+    Metronome metronome(kSampleRate);
+    metronome.start();
+    std::thread ui([&metronome] {
+        for (int i = 0; i < 2000; ++i) {
+            metronome.set_tempo(60.0f + static_cast<float>(i % 120));
+            metronome.set_time_signature(1 + i % 7, 1 + i % 4);
+        }
+    });
+    std::vector<float> out(128);
+    for (int i = 0; i < 4000; ++i) {
+        std::fill(out.begin(), out.end(), 0.0f);
+        metronome.render(out.data(), 128);
+        for (float v : out) ASSERT_TRUE(std::isfinite(v));
+    }
+    ui.join();
+    EXPECT_GE(metronome.bpm(), 60.0f);
+    EXPECT_TRUE(metronome.running());
+}
+
+TEST(MetronomeFfiTest, RenderReportsClicks) {
+    EXPECT_EQ(ml_metronome_create(0), nullptr);
+
+    MLMetronomeHandle* handle = ml_metronome_create(kSampleRate);
+    ASSERT_NE(handle, nullptr);
+    EXPECT_EQ(ml_metronome_set_tempo(handle, 1000.0f), 0);
+    EXPECT_EQ(ml_metronome_set_tempo(handle, 90.0f), 1);
+    EXPECT_EQ(ml_metronome_set_time_signature(handle, 6, 1), 1);
+    EXPECT_EQ(ml_metronome_load_sound(handle, 7, nullptr, 0), 0);
+    EXPECT_EQ(ml_metronome_render(handle, nullptr, 16, nullptr, 0), -1);
+
+    ml_metronome_start(handle);
+    std::vector<float> out(static_cast<size_t>(kSampleRate), 0.0f);
+    MLMetronomeClick clicks[4];
+    const int count = ml_metronome_render(handle, out.data(), kSampleRate, clicks, 4);
+    ASSERT_EQ(count, 2);
+    EXPECT_EQ(clicks[0].sample_position, 0);
+    EXPECT_EQ(clicks[1].sample_position, kSampleRate * 2 / 3);
+    EXPECT_EQ(clicks[1].beat_in_bar, 1);
+
+    ml_metronome_stop(handle);
+    ml_metronome_destroy(handle);
+}
@@ -0,0 +1,182 @@
+/**
+ * Unit tests for note-event segmentation.
+ */
+
+#include "note_segmenter.h"
+#include "pitch_detector_ffi.h"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::NoteEventType;
+using music_life::NoteSegmenter;
+using music_life::PitchDetector;
+
+namespace {
+
+constexpr int kHop = 1024;
+
+PitchDetector::Result frame(int midi, float cents, float probability = 0.95f) {
+    PitchDetector::Result r{};
+    r.pitched      = true;
+    r.frequency    = 440.0f * std::pow(2.0f, (static_cast<float>(midi - 69) + cents / 100.0f) / 12.0f);
+    r.probability  = probability;
+    r.midi_note    = midi;
+    r.cents_offset = cents;
+    return r;
+}
+
+PitchDetector::Result silence() {
+    PitchDetector::Result r{};
+    r.probability = 0.1f;
+    return r;
+}
+
+struct Feed {
+    NoteSegmenter& segmenter;
+    int64_t clock = 0;
+    std::vector<NoteSegmenter::Event> events;
+
+    void push(const PitchDetector::Result& r, int hops = 1) {
+        for (int i = 0; i < hops; ++i) {
+            clock += kHop;
+            NoteSegmenter::Event out[NoteSegmenter::kMaxEventsPerHop];
+            const int n = segmenter.push(r, clock, out);
+            events.insert(events.end(), out, out + n);
+        }
+    }
+};
+
+}  // namespace
+
+TEST(NoteSegmenterTest, RejectsInvalidConfig) {
+    NoteSegmenter::Config config;
+    config.off_probability = 0.9f;
+    config.on_probability  = 0.8f;
+    EXPECT_THROW(NoteSegmenter{config}, std::invalid_argument);
+
+    config = NoteSegmenter::Config{};
+    config.median_window = 0;
+    EXPECT_THROW(NoteSegmenter{config}, std::invalid_argument);
+}
+
+TEST(NoteSegmenterTest, EmitsNoteOnAndOffWithHysteresis) {
+    NoteSegmenter segmenter;
+    Feed feed{segmenter};
+    feed.push(silence(), 3);
+    feed.push(frame(69, 2.0f), 10);
+    // A one-hop dropout is bridged by the release hysteresis.
+    feed.push(silence(), 1);
+    feed.push(frame(69, 2.0f), 5);
+    feed.push(silence(), 4);
+
+    ASSERT_EQ(feed.events.size(), 2u);
+    EXPECT_EQ(feed.events[0].type, NoteEventType::NoteOn);
+    EXPECT_EQ(feed.events[0].midi_note, 69);
+    EXPECT_NEAR(feed.events[0].cents, 2.0f, 1e-3f);
+    EXPECT_EQ(feed.events[0].sample_position, 4 * kHop);  // First supporting frame
+    EXPECT_EQ(feed.events[1].type, NoteEventType::NoteOff);
+    EXPECT_EQ(feed.events[1].sample_position, 20 * kHop); // First silent frame
+    EXPECT_EQ(segmenter.active_note(), -1);
+}
+
+TEST(NoteSegmenterTest, IgnoresShortAndUnconfidentBlips) {
+    NoteSegmenter segmenter;
+    Feed feed{segmenter};
+    feed.push(frame(60, 0.0f), 2);        // Shorter than min_note_hops
+    feed.push(silence(), 3);
+    feed.push(frame(60, 0.0f, 0.7f), 10); // Below on_probability
+    EXPECT_TRUE(feed.events.empty());
+}
+
+TEST(NoteSegmenterTest, MedianRejectsOctaveSpikes) {
+    NoteSegmenter segmenter;
+    Feed feed{segmenter};
+    feed.push(frame(57, 0.0f), 6);
+    feed.push(frame(69, 0.0f), 1);  // Single octave error
+    feed.push(frame(57, 0.0f), 6);
+    ASSERT_EQ(feed.events.size(), 1u);
+    EXPECT_EQ(feed.events[0].type, NoteEventType::NoteOn);
+}
+
+TEST(NoteSegmenterTest, NoteChangeAndPitchBend) {
+    NoteSegmenter segmenter;
+    Feed feed{segmenter};
+    feed.push(frame(64, 0.0f), 6);
+    feed.push(frame(64, 20.0f), 6);  // Bend within the note
+    feed.push(frame(65, 0.0f), 8);   // New note
+
+    ASSERT_GE(feed.events.size(), 4u);
+    EXPECT_EQ(feed.events[0].type, NoteEventType::NoteOn);
+    EXPECT_EQ(feed.events[1].type, NoteEventType::PitchBend);
+    EXPECT_NEAR(feed.events[1].cents, 20.0f, 1e-3f);
+    const NoteSegmenter::Event& off = feed.events[feed.events.size() - 2];
+    const NoteSegmenter::Event& on = feed.events.back();
+    EXPECT_EQ(off.type, NoteEventType::NoteOff);
+    EXPECT_EQ(off.midi_note, 64);
+    EXPECT_EQ(on.type, NoteEventType::NoteOn);
+    EXPECT_EQ(on.midi_note, 65);
+    EXPECT_EQ(off.sample_position, on.sample_position);
+}
+
+TEST(NoteSegmenterTest, FlushAndReset) {
+    NoteSegmenter segmenter;
+    Feed feed{segmenter};
+    feed.push(frame(50, 0.0f), 5);
+    NoteSegmenter::Event out[NoteSegmenter::kMaxEventsPerHop];
+    ASSERT_EQ(segmenter.flush(feed.clock, out), 1);
+    EXPECT_EQ(out[0].type, NoteEventType::NoteOff);
+    EXPECT_EQ(segmenter.flush(feed.clock, out), 0);
+
+    feed.push(frame(50, 0.0f), 5);
+    segmenter.reset();
+    feed.events.clear();
+    feed.push(silence(), 5);
+    EXPECT_TRUE(feed.events.empty());
+    EXPECT_EQ(segmenter.active_note(), -1);
+}
+
+TEST(NoteSegmenterFfiTest, ProcessBlockDeliversEvents) {
+    constexpr int kSampleRate = 44100;
+    constexpr float kPi = 3.14159265358979323846f;
+
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(kSampleRate, 2048, 0.10f);
+    ASSERT_NE(handle, nullptr);
+    EXPECT_EQ(ml_pitch_detector_enable_note_events(handle, nullptr, 0), 0);
+    ASSERT_EQ(ml_pitch_detector_enable_note_events(handle, nullptr, 64), 1);
+
+    // 0.5 s of A4, then 0.5 s of C5, then 0.5 s of silence.
+    std::vector<float> audio(static_cast<size_t>(kSampleRate * 3 / 2), 0.0f);
+    for (size_t i = 0; i < static_cast<size_t>(kSampleRate); ++i) {
+        const float f = i < static_cast<size_t>(kSampleRate / 2) ? 440.0f : 523.25f;
+        audio[i] = 0.5f * std::sin(2.0f * kPi * f * static_cast<float>(i) / kSampleRate);
+    }
+
+    int pitched[64];
+    MLPitchBlockResults results{64, pitched, nullptr, nullptr, nullptr, nullptr, nullptr};
+    for (size_t pos = 0; pos < audio.size(); pos += 4096) {
+        const int n = static_cast<int>(std::min<size_t>(4096, audio.size() - pos));
+        ASSERT_GE(ml_pitch_detector_process_block(handle, audio.data() + pos, n, &results), 0);
+    }
+
+    MLNoteEvent events[16];
+    const int count = ml_pitch_detector_read_note_events(handle, events, 16);
+    ASSERT_EQ(count, 4);
+    EXPECT_EQ(events[0].type, ML_NOTE_EVENT_ON);
+    EXPECT_EQ(events[0].midi_note, 69);
+    EXPECT_EQ(events[1].type, ML_NOTE_EVENT_OFF);
+    EXPECT_EQ(events[2].type, ML_NOTE_EVENT_ON);
+    EXPECT_EQ(events[2].midi_note, 72);
+    EXPECT_EQ(events[3].type, ML_NOTE_EVENT_OFF);
+    // Median filtering delays the change by a few hops past the switch.
+    EXPECT_GT(events[2].sample_position, kSampleRate / 2);
+    EXPECT_LT(events[2].sample_position, kSampleRate / 2 + 3 * 2048);
+    EXPECT_EQ(ml_pitch_detector_read_note_events(handle, events, 16), 0);
+    EXPECT_EQ(ml_pitch_detector_note_events_dropped(handle), 0u);
+
+    ml_pitch_detector_destroy(handle);
+}
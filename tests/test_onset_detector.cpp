@@ -0,0 +1,171 @@
+/**
+ * Unit tests for the spectral-flux onset detector and tempo tracker.
+ */
+
+#include "onset_detector.h"
+#include "pitch_detector_ffi.h"
+#include "tempo_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::OnsetDetector;
+using music_life::TempoTracker;
+
+namespace {
+
+constexpr int   kSampleRate = 44100;
+constexpr float kPi = 3.14159265358979323846f;
+
+// Decaying 1 kHz bursts starting at the returned positions, over low noise.
+std::vector<float> click_track(float bpm, float seconds, int first_click, std::vector<int64_t>* clicks) {
+    std::vector<float> buf(static_cast<size_t>(seconds * kSampleRate), 0.0f);
+    uint32_t seed = 12345;
+    for (float& v : buf) {
+        seed = seed * 1664525u + 1013904223u;
+        v = 1e-3f * (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f);
+    }
+    const double period = 60.0 * kSampleRate / bpm;
+    for (double pos = first_click; pos + 2000 < buf.size(); pos += period) {
+        const int64_t start = static_cast<int64_t>(std::llround(pos));
+        clicks->push_back(start);
+        for (int i = 0; i < 2000; ++i) {
+            buf[static_cast<size_t>(start + i)] +=
+                0.5f * std::exp(-static_cast<float>(i) / 300.0f) *
+                std::sin(2.0f * kPi * 1000.0f * static_cast<float>(i) / kSampleRate);
+        }
+    }
+    return buf;
+}
+
+std::vector<OnsetDetector::Onset> run(OnsetDetector& detector, const std::vector<float>& buf, int block) {
+    std::vector<OnsetDetector::Onset> onsets;
+    OnsetDetector::Onset found[8];
+    for (size_t pos = 0; pos < buf.size(); pos += static_cast<size_t>(block)) {
+        const int n = static_cast<int>(std::min<size_t>(static_cast<size_t>(block), buf.size() - pos));
+        const int count = detector.process(buf.data() + pos, n, found, 8);
+        onsets.insert(onsets.end(), found, found + count);
+    }
+    return onsets;
+}
+
+}  // namespace
+
+TEST(OnsetDetectorTest, RejectsInvalidArguments) {
+    EXPECT_THROW(OnsetDetector(0), std::invalid_argument);
+    EXPECT_THROW(OnsetDetector(kSampleRate, 32), std::invalid_argument);
+    EXPECT_THROW(OnsetDetector(kSampleRate, 1024, 2048), std::invalid_argument);
+    EXPECT_THROW(TempoTracker(kSampleRate, 256, 200.0f, 100.0f), std::invalid_argument);
+}
+
+TEST(OnsetDetectorTest, SilenceHasNoOnsets) {
+    OnsetDetector detector(kSampleRate);
+    const std::vector<float> silence(kSampleRate * 2, 0.0f);
+    EXPECT_TRUE(run(detector, silence, 512).empty());
+    EXPECT_EQ(detector.tempo().bpm(), 0.0f);
+    EXPECT_EQ(detector.samples_processed(), static_cast<int64_t>(silence.size()));
+}
+
+TEST(OnsetDetectorTest, ClickPositionsAreSampleAccurate) {
+    std::vector<int64_t> clicks;
+    const std::vector<float> buf = click_track(120.0f, 4.0f, 3000, &clicks);
+
+    OnsetDetector detector(kSampleRate);
+    const std::vector<OnsetDetector::Onset> onsets = run(detector, buf, 441);
+    ASSERT_EQ(onsets.size(), clicks.size());
+    for (size_t i = 0; i < clicks.size(); ++i) {
+        // Within 1 ms of the true attack.
+        EXPECT_NEAR(static_cast<double>(onsets[i].sample_position), static_cast<double>(clicks[i]), 44.0);
+        EXPECT_GT(onsets[i].strength, 0.0f);
+    }
+}
+
+TEST(OnsetDetectorTest, OnsetsDoNotDependOnBlockSize) {
+    std::vector<int64_t> clicks;
+    const std::vector<float> buf = click_track(100.0f, 3.0f, 1500, &clicks);
+
+    OnsetDetector a(kSampleRate);
+    OnsetDetector b(kSampleRate);
+    const std::vector<OnsetDetector::Onset> small = run(a, buf, 64);
+    const std::vector<OnsetDetector::Onset> large = run(b, buf, 4096);
+    ASSERT_EQ(small.size(), large.size());
+    for (size_t i = 0; i < small.size(); ++i) {
+        EXPECT_EQ(small[i].sample_position, large[i].sample_position);
+    }
+}
+
+TEST(OnsetDetectorTest, TracksTempoAndBeatPhase) {
+    for (float bpm : {90.0f, 120.0f, 150.0f}) {
+        std::vector<int64_t> clicks;
+        const std::vector<float> buf = click_track(bpm, 8.0f, 2000, &clicks);
+
+        OnsetDetector detector(kSampleRate);
+        run(detector, buf, 512);
+        const TempoTracker& tempo = detector.tempo();
+        EXPECT_NEAR(tempo.bpm(), bpm, bpm * 0.02f) << "bpm=" << bpm;
+        EXPECT_GT(tempo.confidence(), 0.2f);
+        ASSERT_GE(tempo.last_beat_sample(), 0);
+
+        // The last beat lands on (or is predicted within 2% of) a click.
+        int64_t nearest = clicks.front();
+        for (int64_t c : clicks) {
+            if (std::llabs(c - tempo.last_beat_sample()) < std::llabs(nearest - tempo.last_beat_sample())) {
+                nearest = c;
+            }
+        }
+        EXPECT_NEAR(static_cast<double>(tempo.last_beat_sample()), static_cast<double>(nearest),
+                    0.02 * tempo.beat_period_samples());
+        EXPECT_GT(tempo.next_beat_sample(), tempo.last_beat_sample());
+    }
+}
+
+TEST(OnsetDetectorTest, ResetRestartsSampleCount) {
+    std::vector<int64_t> clicks;
+    const std::vector<float> buf = click_track(120.0f, 2.0f, 1000, &clicks);
+    OnsetDetector detector(kSampleRate);
+    run(detector, buf, 512);
+    detector.reset();
+
+    const std::vector<OnsetDetector::Onset> again = run(detector, buf, 512);
+    ASSERT_FALSE(again.empty());
+    EXPECT_NEAR(static_cast<double>(again.front().sample_position), static_cast<double>(clicks.front()), 44.0);
+}
+
+TEST(OnsetFfiTest, ProcessAndTempo) {
+    EXPECT_EQ(ml_onset_create(kSampleRate, 1024, 0), nullptr);
+
+    MLOnsetHandle* handle = ml_onset_create(kSampleRate, 1024, 256);
+    ASSERT_NE(handle, nullptr);
+    EXPECT_EQ(ml_onset_process(handle, nullptr, 10, nullptr, 0), -1);
+
+    std::vector<int64_t> clicks;
+    const std::vector<float> buf = click_track(120.0f, 6.0f, 2000, &clicks);
+    MLOnsetEvent events[4];
+    int total = 0;
+    for (size_t pos = 0; pos < buf.size(); pos += 1024) {
+        const int n = static_cast<int>(std::min<size_t>(1024, buf.size() - pos));
+        const int count = ml_onset_process(handle, buf.data() + pos, n, events, 4);
+        ASSERT_GE(count, 0);
+        for (int i = 0; i < count; ++i) {
+            EXPECT_NEAR(static_cast<double>(events[i].sample_position),
+                        static_cast<double>(clicks[static_cast<size_t>(total + i)]), 44.0);
+        }
+        total += count;
+    }
+    EXPECT_EQ(total, static_cast<int>(clicks.size()));
+
+    const MLTempoEstimate tempo = ml_onset_tempo(handle);
+    EXPECT_NEAR(tempo.bpm, 120.0f, 2.5f);
+    EXPECT_GE(tempo.last_beat_sample, 0);
+
+    const MLTempoEstimate none = ml_onset_tempo(nullptr);
+    EXPECT_EQ(none.bpm, 0.0f);
+    EXPECT_EQ(none.last_beat_sample, -1);
+
+    ml_onset_destroy(handle);
+}
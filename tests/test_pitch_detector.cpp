@@ -6,23 +6,35 @@
  * CTest/CI.
  */
 
+#include "biquad_cascade.h"
+#include "mirrored_ring_buffer.h"
 #include "pitch_detector.h"
 #include "pitch_detector_ffi.h"
+#include "triple_buffer.h"
 #include "yin.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 #include <limits>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
 #include <gtest/gtest.h>
 
+using music_life::BiquadCascade;
+using music_life::BiquadSection;
+using music_life::MirroredRingBuffer;
 using music_life::PitchDetector;
+using music_life::TripleBuffer;
 using music_life::Yin;
 
 // ---------------------------------------------------------------------------
@@ -75,6 +87,18 @@ static void make_sine(std::vector<float>& buf, float freq_hz, int sample_rate) {
     }
 }
 
+/** Interleave one sine per entry of freqs_hz (0 gives silence), frames long. */
+static std::vector<float> make_interleaved(const std::vector<float>& freqs_hz, int frames, int sample_rate) {
+    const int channels = static_cast<int>(freqs_hz.size());
+    std::vector<float> channel(static_cast<size_t>(frames));
+    std::vector<float> out(static_cast<size_t>(frames) * channels);
+    for (int c = 0; c < channels; ++c) {
+        make_sine(channel, freqs_hz[c], sample_rate);
+        for (int i = 0; i < frames; ++i) out[static_cast<size_t>(i) * channels + c] = 0.5f * channel[i];
+    }
+    return out;
+}
+
 // ---------------------------------------------------------------------------
 // Tests – YIN internals
 // ---------------------------------------------------------------------------
@@ -153,8 +177,8 @@ static bool test_yin_low_amplitude_returns_no_pitch() {
 
     std::vector<float> workspace(FRAME / 2);
     float detected = yin.detect(buf.data(), workspace);
-    ASSERT_TRUE(detected < 0.0f);
-    ASSERT_TRUE(yin.probability() == 0.0f);
+    ML_ASSERT_TRUE(detected < 0.0f);
+    ML_ASSERT_TRUE(yin.probability() == 0.0f);
     return true;
 }
 
@@ -167,8 +191,8 @@ static bool test_yin_nan_input_returns_no_pitch() {
 
     std::vector<float> workspace(FRAME / 2);
     float detected = yin.detect(buf.data(), workspace);
-    ASSERT_TRUE(detected < 0.0f);
-    ASSERT_TRUE(yin.probability() == 0.0f);
+    ML_ASSERT_TRUE(detected < 0.0f);
+    ML_ASSERT_TRUE(yin.probability() == 0.0f);
     return true;
 }
 
@@ -239,6 +263,34 @@ static bool test_yin_simd_aligned_frame_repeatability() {
     return true;
 }
 
+static bool test_yin_early_exit_matches_full_cmndf() {
+    // The fused pass stops just past the dip; normalising every lag must not
+    // change the pitch, and the shared prefix must be identical.
+    const int SR    = 44100;
+    const int FRAME = 2050;  // 1025 lags: exercises the SIMD tail too
+
+    Yin early(SR, FRAME, 0.10f);
+    Yin full(SR, FRAME, 0.10f);
+    full.set_full_cmndf(true);
+    std::vector<float> early_ws(FRAME / 2);
+    std::vector<float> full_ws(FRAME / 2);
+    std::vector<float> buf(FRAME);
+
+    for (float hz : {82.41f, 196.0f, 440.0f, 1046.5f}) {
+        make_sine(buf, hz, SR);
+        const float a = early.detect(buf.data(), early_ws);
+        const float b = full.detect(buf.data(), full_ws);
+        ML_ASSERT_NEAR(a, hz, 1.0f);
+        ML_ASSERT_TRUE(a == b);
+        ML_ASSERT_TRUE(early.probability() == full.probability());
+
+        const int tau = static_cast<int>(std::lround(SR / hz));
+        for (int i = 0; i <= tau; ++i) ML_ASSERT_TRUE(early_ws[i] == full_ws[i]);
+        for (int i = 1; i < FRAME / 2; ++i) ML_ASSERT_TRUE(full_ws[i] >= 0.0f && std::isfinite(full_ws[i]));
+    }
+    return true;
+}
+
 static bool test_yin_manual_backend_selection() {
     const char* original = std::getenv("ML_FFT_BACKEND");
     std::string original_value = original ? original : "";
@@ -254,6 +306,227 @@ static bool test_yin_manual_backend_selection() {
     return true;
 }
 
+// ---------------------------------------------------------------------------
+// Tests – MirroredRingBuffer
+// ---------------------------------------------------------------------------
+
+static bool check_ring_latest_is_contiguous(bool allow_mirroring) {
+    const int CAPACITY = 1000;
+    MirroredRingBuffer ring(CAPACITY, allow_mirroring);
+    ML_ASSERT_TRUE(ring.capacity() >= CAPACITY);
+    ML_ASSERT_TRUE(allow_mirroring || !ring.is_mirrored());
+
+    // Write a ramp in odd-sized blocks so the write position wraps at
+    // arbitrary offsets, then check the latest window reads back in order.
+    std::vector<float> block(377);
+    float next = 0.0f;
+    for (int iteration = 0; iteration < 20; ++iteration) {
+        for (float& sample : block) sample = next++;
+        ring.write(block.data(), static_cast<int>(block.size()));
+        if (next < static_cast<float>(CAPACITY)) continue;
+
+        const float* window = ring.latest(CAPACITY);
+        for (int i = 0; i < CAPACITY; ++i) {
+            ML_ASSERT_TRUE(window[i] == next - static_cast<float>(CAPACITY - i));
+        }
+    }
+
+    ring.clear();
+    const float* cleared = ring.latest(CAPACITY);
+    for (int i = 0; i < CAPACITY; ++i) {
+        ML_ASSERT_TRUE(cleared[i] == 0.0f);
+    }
+    return true;
+}
+
+static bool test_ring_mirrored_latest_is_contiguous() {
+    return check_ring_latest_is_contiguous(true);
+}
+
+static bool test_ring_fallback_latest_is_contiguous() {
+    return check_ring_latest_is_contiguous(false);
+}
+
+static bool test_ring_oversized_write_keeps_newest_samples() {
+    const int CAPACITY = 256;
+    MirroredRingBuffer ring(CAPACITY, false);
+    std::vector<float> block(CAPACITY * 3 + 17);
+    for (size_t i = 0; i < block.size(); ++i) block[i] = static_cast<float>(i);
+    ring.write(block.data(), static_cast<int>(block.size()));
+
+    const float* window = ring.latest(CAPACITY);
+    const float first = static_cast<float>(block.size() - CAPACITY);
+    for (int i = 0; i < CAPACITY; ++i) {
+        ML_ASSERT_TRUE(window[i] == first + static_cast<float>(i));
+    }
+    return true;
+}
+
+// Direct form I in double precision over the same float coefficients.
+struct ReferenceCascade {
+    std::vector<BiquadSection> sections;
+    std::vector<std::array<double, 4>> state;
+
+    explicit ReferenceCascade(std::vector<BiquadSection> s) : sections(std::move(s)), state(sections.size()) {}
+
+    double process(double x) {
+        for (size_t k = 0; k < sections.size(); ++k) {
+            const BiquadSection& c = sections[k];
+            std::array<double, 4>& st = state[k];
+            const double y = c.b0 * x + c.b1 * st[0] + c.b2 * st[1] - c.a1 * st[2] - c.a2 * st[3];
+            st = {x, st[0], y, st[2]};
+            x = y;
+        }
+        return x;
+    }
+};
+
+static std::vector<BiquadSection> make_cleanup_sections(double sample_rate) {
+    return {BiquadSection::dc_blocker(5.0, sample_rate), BiquadSection::high_pass(80.0, sample_rate),
+            BiquadSection::notch(60.0, 30.0, sample_rate), BiquadSection::notch(120.0, 30.0, sample_rate)};
+}
+
+static bool test_biquad_cascade_matches_direct_form() {
+    const std::vector<BiquadSection> sections = make_cleanup_sections(48000.0);
+    BiquadCascade cascade;
+    cascade.set(sections.data(), static_cast<int>(sections.size()));
+    ReferenceCascade reference(sections);
+
+    // Odd block sizes exercise the four-sample blocks and the scalar tail
+    // with state carried across calls; every other block runs in place.
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    std::uniform_int_distribution<int> block(1, 301);
+    std::vector<float> in(24000), out(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = 0.3f + noise(rng) + 0.4f * static_cast<float>(std::sin(2.0 * M_PI * 60.0 * i / 48000.0));
+    }
+    int calls = 0;
+    for (size_t pos = 0; pos < in.size(); ++calls) {
+        const size_t n = std::min(static_cast<size_t>(block(rng)), in.size() - pos);
+        if (calls % 2 == 0) {
+            cascade.process(in.data() + pos, out.data() + pos, static_cast<int>(n));
+        } else {
+            std::copy(in.begin() + static_cast<std::ptrdiff_t>(pos), in.begin() + static_cast<std::ptrdiff_t>(pos + n),
+                      out.begin() + static_cast<std::ptrdiff_t>(pos));
+            cascade.process(out.data() + pos, out.data() + pos, static_cast<int>(n));
+        }
+        pos += n;
+    }
+    ML_ASSERT_TRUE(cascade.active_sections() == 4);
+    for (size_t i = 0; i < in.size(); ++i) {
+        ML_ASSERT_NEAR(out[i], static_cast<float>(reference.process(in[i])), 2e-4f);
+    }
+
+    // New coefficients with the same number of stages keep the state.
+    const std::vector<BiquadSection> fifty = {sections[0], sections[1], BiquadSection::notch(50.0, 30.0, 48000.0),
+                                              BiquadSection::notch(100.0, 30.0, 48000.0)};
+    cascade.set(fifty.data(), 4);
+    reference.sections = fifty;
+    cascade.process(in.data(), out.data(), 1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        ML_ASSERT_NEAR(out[i], static_cast<float>(reference.process(in[i])), 2e-4f);
+    }
+
+    // No stages copies; a non-finite sample does not stick in the state.
+    cascade.set(nullptr, 0);
+    cascade.process(in.data(), out.data(), 64);
+    ML_ASSERT_TRUE(std::equal(in.begin(), in.begin() + 64, out.begin()));
+    cascade.set(sections.data(), 4);
+    std::vector<float> spike(64, 0.0f);
+    spike[10] = std::numeric_limits<float>::quiet_NaN();
+    cascade.process(spike.data(), out.data(), 64);
+    cascade.process(in.data(), out.data(), 64);
+    for (int i = 0; i < 64; ++i) ML_ASSERT_TRUE(std::isfinite(out[static_cast<size_t>(i)]));
+
+    BiquadSection unstable;
+    unstable.a2 = 1.5f;
+    bool threw = false;
+    try {
+        cascade.set(&unstable, 1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ML_ASSERT_TRUE(threw);
+    threw = false;
+    try {
+        std::vector<BiquadSection> too_many(BiquadCascade::kMaxSections + 1);
+        cascade.set(too_many.data(), static_cast<int>(too_many.size()));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ML_ASSERT_TRUE(threw);
+    return true;
+}
+
+static bool test_ring_filtered_write_matches_cascade() {
+    // The filter sees every sample, including those of an oversized write
+    // that the ring itself cannot keep.
+    const std::vector<BiquadSection> sections = make_cleanup_sections(16000.0);
+    for (bool allow_mirroring : {true, false}) {
+        MirroredRingBuffer ring(64, allow_mirroring);
+        BiquadCascade cascade;
+        cascade.set(sections.data(), static_cast<int>(sections.size()));
+        ReferenceCascade reference(sections);
+
+        std::vector<float> in(ring.capacity() * 3 + 123);
+        for (size_t i = 0; i < in.size(); ++i) in[i] = static_cast<float>((i * 37) % 101) / 101.0f - 0.3f;
+        std::vector<float> expected(in.size());
+        for (size_t i = 0; i < in.size(); ++i) expected[i] = static_cast<float>(reference.process(in[i]));
+
+        const int sizes[] = {37, ring.capacity() * 2 + 5, 81};
+        size_t pos = 0;
+        for (const int n : sizes) {
+            ring.write(in.data() + pos, n, &cascade);
+            pos += static_cast<size_t>(n);
+            const int keep = std::min(n, ring.capacity());
+            const float* latest = ring.latest(keep);
+            for (int i = 0; i < keep; ++i) ML_ASSERT_NEAR(latest[i], expected[pos - keep + i], 2e-4f);
+        }
+
+        // Interleaved: folded, then filtered in place.
+        std::vector<float> stereo;
+        for (size_t i = pos; i < in.size(); ++i) stereo.insert(stereo.end(), {in[i], 0.0f});
+        const int frames = static_cast<int>(in.size() - pos);
+        ring.write_interleaved(stereo.data(), frames, 2, nullptr, 0, &cascade);
+        const int keep = std::min(frames, ring.capacity());
+        const float* latest = ring.latest(keep);
+        for (int i = 0; i < keep; ++i) ML_ASSERT_NEAR(latest[i], expected[in.size() - keep + i], 2e-4f);
+    }
+    return true;
+}
+
+static bool test_ring_interleaved_write_folds_channels() {
+    // 3 and 5 channels take the scalar path, 2 and 4 the vector one; 37
+    // frames leave a scalar tail and the 64-sample fallback ring wraps.
+    for (bool allow_mirroring : {true, false}) {
+        for (int channels : {2, 3, 4, 5}) {
+            MirroredRingBuffer ring(64, allow_mirroring);
+            const int frames = 37;
+            std::vector<float> in(static_cast<size_t>(frames) * channels);
+            for (size_t i = 0; i < in.size(); ++i) in[i] = static_cast<float>(i % 97) - 48.0f;
+            std::vector<float> weights(static_cast<size_t>(channels));
+            for (int c = 0; c < channels; ++c) weights[c] = 0.25f * static_cast<float>(c + 1);
+
+            for (int pass = 0; pass < 3; ++pass) {
+                ring.write_interleaved(in.data(), frames, channels, weights.data(), 0);
+                const float* mixed = ring.latest(frames);
+                for (int i = 0; i < frames; ++i) {
+                    float expected = 0.0f;
+                    for (int c = 0; c < channels; ++c) expected += in[static_cast<size_t>(i) * channels + c] * weights[c];
+                    ML_ASSERT_NEAR(mixed[i], expected, 1e-4f);
+                }
+                ring.write_interleaved(in.data(), frames, channels, nullptr, channels - 1);
+                const float* picked = ring.latest(frames);
+                for (int i = 0; i < frames; ++i) {
+                    ML_ASSERT_TRUE(picked[i] == in[static_cast<size_t>(i) * channels + channels - 1]);
+                }
+            }
+        }
+    }
+    return true;
+}
+
 // ---------------------------------------------------------------------------
 // Tests – PitchDetector
 // ---------------------------------------------------------------------------
@@ -502,6 +775,1018 @@ static bool test_pd_preserves_hop_remainder_between_calls() {
     return true;
 }
 
+static bool test_pd_process_block_reports_every_hop() {
+    // A block spanning several hops must yield one result per hop, each
+    // matching what hop-sized process() calls produce for the same audio.
+    const int SR    = 44100;
+    const int FRAME = 2048;
+    const int HOP   = FRAME / 2;
+    const int TOTAL = FRAME + HOP * 6;
+
+    std::vector<float> signal(TOTAL);
+    std::vector<float> tone(HOP * 4);
+    make_sine(signal, 440.0f, SR);
+    make_sine(tone, 660.0f, SR);
+    std::copy(tone.begin(), tone.end(), signal.begin() + FRAME + HOP * 2);
+
+    PitchDetector block_pd(SR, FRAME);
+    PitchDetector::Result results[16];
+    int offsets[16];
+    const int count = block_pd.process_block(signal.data(), TOTAL, results, 16, offsets);
+    ML_ASSERT_TRUE(count == 7);
+
+    PitchDetector hop_pd(SR, FRAME);
+    PitchDetector::Result expected = hop_pd.process(signal.data(), FRAME);
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            expected = hop_pd.process(signal.data() + FRAME + HOP * (i - 1), HOP);
+        }
+        ML_ASSERT_TRUE(offsets[i] == FRAME + HOP * i);
+        ML_ASSERT_TRUE(results[i].pitched == expected.pitched);
+        ML_ASSERT_NEAR(results[i].frequency, expected.frequency, 0.01f);
+    }
+    ML_ASSERT_NEAR(results[0].frequency, 440.0f, 2.0f);
+    ML_ASSERT_NEAR(results[count - 1].frequency, 660.0f, 3.0f);
+    return true;
+}
+
+static bool test_pd_process_block_respects_max_out() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+    const int HOP   = FRAME / 2;
+
+    PitchDetector pd(SR, FRAME);
+    std::vector<float> buf(FRAME + HOP * 4);
+    make_sine(buf, 440.0f, SR);
+
+    PitchDetector::Result results[2];
+    ML_ASSERT_TRUE(pd.process_block(buf.data(), static_cast<int>(buf.size()), results, 2) == 2);
+
+    // Hop timing continues even when results were dropped.
+    PitchDetector::Result more[2];
+    std::vector<float> tail(HOP);
+    make_sine(tail, 440.0f, SR);
+    ML_ASSERT_TRUE(pd.process_block(tail.data(), HOP - 1, more, 2) == 0);
+    ML_ASSERT_TRUE(pd.process_block(tail.data() + HOP - 1, 1, more, 2) == 1);
+    return true;
+}
+
+static bool test_pd_adaptive_high_note_uses_short_frame() {
+    // A high note switches to the shortest frame, which doubles the hop rate
+    // twice over without losing accuracy.
+    const int SR    = 44100;
+    const int FRAME = 2048;
+
+    std::vector<float> buf(SR);
+    make_sine(buf, 880.0f, SR);
+
+    PitchDetector fixed_pd(SR, FRAME);
+    PitchDetector adaptive_pd(SR, FRAME, 0.10f, 440.0f, true);
+    ML_ASSERT_TRUE(adaptive_pd.frame_size() == FRAME);
+    ML_ASSERT_TRUE(adaptive_pd.min_hop_size() == FRAME / 8);
+
+    std::vector<PitchDetector::Result> results(256);
+    const int fixed_count = fixed_pd.process_block(buf.data(), SR, results.data(), 256);
+    const int adaptive_count = adaptive_pd.process_block(buf.data(), SR, results.data(), 256);
+    ML_ASSERT_TRUE(adaptive_pd.active_frame_size() == FRAME / 4);
+    ML_ASSERT_TRUE(adaptive_pd.hop_size() == FRAME / 8);
+    ML_ASSERT_TRUE(adaptive_count > fixed_count * 3);
+    for (int i = 0; i < adaptive_count; ++i) {
+        ML_ASSERT_TRUE(results[i].pitched);
+        ML_ASSERT_NEAR(results[i].frequency, 880.0f, 3.0f);
+    }
+    return true;
+}
+
+static bool test_pd_adaptive_low_note_keeps_full_frame() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+
+    PitchDetector pd(SR, FRAME, 0.10f, 440.0f, true);
+    std::vector<float> buf(SR / 2);
+    make_sine(buf, 82.41f, SR);
+    PitchDetector::Result results[32];
+    const int count = pd.process_block(buf.data(), static_cast<int>(buf.size()), results, 32);
+    ML_ASSERT_TRUE(count > 0);
+    ML_ASSERT_TRUE(pd.active_frame_size() == FRAME);
+    ML_ASSERT_NEAR(results[count - 1].frequency, 82.41f, 1.0f);
+    return true;
+}
+
+static bool test_pd_adaptive_returns_to_full_frame() {
+    // After a high note, a low note the short frame cannot resolve must bring
+    // back the full frame within a couple of hops.
+    const int SR    = 44100;
+    const int FRAME = 2048;
+
+    PitchDetector pd(SR, FRAME, 0.10f, 440.0f, true);
+    std::vector<float> high(SR / 2);
+    std::vector<float> low(SR / 2);
+    make_sine(high, 1046.5f, SR);
+    make_sine(low, 82.41f, SR);
+    std::vector<PitchDetector::Result> results(256);
+    pd.process_block(high.data(), static_cast<int>(high.size()), results.data(), 256);
+    ML_ASSERT_TRUE(pd.active_frame_size() == FRAME / 4);
+
+    const int count = pd.process_block(low.data(), static_cast<int>(low.size()), results.data(), 256);
+    ML_ASSERT_TRUE(pd.active_frame_size() == FRAME);
+    ML_ASSERT_NEAR(results[count - 1].frequency, 82.41f, 1.0f);
+
+    pd.process_block(high.data(), static_cast<int>(high.size()), results.data(), 256);
+    pd.reset();
+    pd.process(low.data(), 1);
+    ML_ASSERT_TRUE(pd.active_frame_size() == FRAME);
+    return true;
+}
+
+static bool test_ffi_create_adaptive() {
+    ML_ASSERT_TRUE(ml_pitch_detector_create_adaptive(0, 2048, 0.10f, 440.0f) == nullptr);
+
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create_adaptive(44100, 2048, 0.10f, 440.0f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    std::vector<float> buf(44100);
+    make_sine(buf, 880.0f, 44100);
+    int pitched[256];
+    float frequency[256];
+    MLPitchBlockResults results{256, pitched, frequency, nullptr, nullptr, nullptr, nullptr};
+    const int count = ml_pitch_detector_process_block(handle, buf.data(), static_cast<int>(buf.size()), &results);
+    ml_pitch_detector_destroy(handle);
+
+    // One batch slice spans several short hops; none may be lost.
+    ML_ASSERT_TRUE(count > 44100 / 1024 * 3);
+    ML_ASSERT_NEAR(frequency[count - 1], 880.0f, 3.0f);
+    return true;
+}
+
+static bool test_pd_gate_skips_silence() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+
+    PitchDetector pd(SR, FRAME);
+    std::vector<float> silence(SR, 0.0f);
+    std::vector<PitchDetector::Result> results(64);
+    const int count = pd.process_block(silence.data(), SR, results.data(), 64);
+    ML_ASSERT_TRUE(count > 0);
+    ML_ASSERT_TRUE(pd.frames_gated() == pd.frames_analysed());
+    ML_ASSERT_TRUE(!pd.gate_open());
+    for (int i = 0; i < count; ++i) ML_ASSERT_TRUE(!results[i].pitched);
+
+    // Defaults only gate what YIN would reject anyway.
+    std::vector<float> tone(SR / 4);
+    make_sine(tone, 440.0f, SR);
+    pd.process_block(tone.data(), static_cast<int>(tone.size()), results.data(), 64);
+    ML_ASSERT_TRUE(pd.gate_open());
+    ML_ASSERT_TRUE(pd.frames_gated() < pd.frames_analysed());
+    return true;
+}
+
+static bool test_pd_gate_hangover() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+    const int HOP   = FRAME / 2;
+
+    PitchDetector pd(SR, FRAME);
+    PitchDetector::GateConfig bad;
+    bad.open_db  = -50.0f;
+    bad.close_db = -40.0f;
+    try {
+        pd.set_noise_gate(bad);
+        return false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    PitchDetector::GateConfig gate;
+    gate.open_db       = -30.0f;
+    gate.close_db      = -40.0f;
+    gate.hangover_hops = 3;
+    pd.set_noise_gate(gate);
+    ML_ASSERT_NEAR(pd.noise_gate().open_db, -30.0f, 1e-3f);
+
+    // Loud tone, then the same tone at -49 dBFS RMS: quiet but pitched.
+    std::vector<float> audio(FRAME + HOP * 20);
+    make_sine(audio, 440.0f, SR);
+    for (size_t i = FRAME + HOP * 4; i < audio.size(); ++i) audio[i] *= 0.005f;
+
+    std::vector<PitchDetector::Result> results(32);
+    const int count = pd.process_block(audio.data(), static_cast<int>(audio.size()), results.data(), 32);
+    ML_ASSERT_TRUE(count == 21);
+    ML_ASSERT_TRUE(results[4].pitched);
+    int pitched_quiet = 0;
+    for (int i = 6; i < count; ++i) {
+        if (results[i].pitched) ++pitched_quiet;
+    }
+    // Frame 5 straddles the drop; the next hangover_hops quiet frames pass.
+    ML_ASSERT_TRUE(pitched_quiet == 3);
+    ML_ASSERT_TRUE(!results[count - 1].pitched);
+    ML_ASSERT_TRUE(!pd.gate_open());
+    return true;
+}
+
+static bool test_pd_gate_recovers_after_nan() {
+    // A NaN makes every frame it is part of unpitched; once it has left the
+    // frame, the running energy must be exact enough to analyse again.
+    const int SR    = 44100;
+    const int FRAME = 2048;
+
+    PitchDetector pd(SR, FRAME);
+    std::vector<float> audio(SR);
+    make_sine(audio, 440.0f, SR);
+    audio[FRAME * 2] = std::numeric_limits<float>::quiet_NaN();
+    audio[FRAME * 2 + 1] = std::numeric_limits<float>::infinity();
+
+    std::vector<PitchDetector::Result> results(64);
+    std::vector<int> offsets(64);
+    const int count = pd.process_block(audio.data(), SR, results.data(), 64, offsets.data());
+    for (int i = 0; i < count; ++i) {
+        const bool contains_nan = offsets[i] > FRAME * 2 && offsets[i] - FRAME <= FRAME * 2 + 1;
+        ML_ASSERT_TRUE(results[i].pitched == !contains_nan);
+        if (!contains_nan) ML_ASSERT_NEAR(results[i].frequency, 440.0f, 2.0f);
+    }
+    return true;
+}
+
+// A quiet 440 Hz tone under DC offset and 60 Hz mains hum with harmonics.
+static std::vector<float> make_hummy_tone(int frames, int sample_rate) {
+    std::vector<float> audio(static_cast<size_t>(frames));
+    for (int i = 0; i < frames; ++i) {
+        const double t = static_cast<double>(i) / sample_rate;
+        audio[static_cast<size_t>(i)] = static_cast<float>(
+            0.3 + 0.05 * std::sin(2.0 * M_PI * 440.0 * t) + 0.4 * std::sin(2.0 * M_PI * 60.0 * t) +
+            0.2 * std::sin(2.0 * M_PI * 120.0 * t + 0.5) + 0.1 * std::sin(2.0 * M_PI * 180.0 * t + 1.0));
+    }
+    return audio;
+}
+
+static bool test_pd_input_filter_removes_hum() {
+    const int SR    = 48000;
+    const int FRAME = 2048;
+    const std::vector<float> audio = make_hummy_tone(SR, SR);
+
+    // The last hop of one second of input; fails the test if there is none.
+    const auto last_pitch = [&](PitchDetector& pd, PitchDetector::Result& last) {
+        std::vector<PitchDetector::Result> results(64);
+        const int count = pd.process_block(audio.data(), SR, results.data(), 64);
+        ML_ASSERT_TRUE(count > 0);
+        last = results[static_cast<size_t>(count - 1)];
+        return true;
+    };
+
+    PitchDetector plain(SR, FRAME);
+    PitchDetector::Result hum;
+    ML_ASSERT_TRUE(last_pitch(plain, hum));
+    ML_ASSERT_TRUE(!(hum.pitched && std::fabs(hum.frequency - 440.0f) < 2.0f));
+
+    PitchDetector pd(SR, FRAME);
+    PitchDetector::FilterConfig filter;
+    filter.dc_block     = true;
+    filter.high_pass_hz = 80.0f;
+    filter.hum_hz       = 60.0f;
+    filter.gain_db      = 6.0f;
+    pd.set_input_filter(filter);
+    ML_ASSERT_TRUE(pd.input_filter().hum_hz == 60.0f);
+    PitchDetector::Result clean;
+    ML_ASSERT_TRUE(last_pitch(pd, clean));
+    ML_ASSERT_TRUE(clean.pitched);
+    ML_ASSERT_NEAR(clean.frequency, 440.0f, 1.0f);
+
+    // Decimated and per-channel paths filter at their own ring writes.
+    PitchDetector decimated(SR, FRAME, 0.10f, 440.0f, false, 2);
+    decimated.set_input_filter(filter);
+    PitchDetector::Result half_rate;
+    ML_ASSERT_TRUE(last_pitch(decimated, half_rate));
+    ML_ASSERT_TRUE(half_rate.pitched);
+    ML_ASSERT_NEAR(half_rate.frequency, 440.0f, 1.5f);
+
+    PitchDetector channels(SR, FRAME);
+    channels.set_input_filter(filter);
+    channels.enable_channel_detection(2);
+    std::vector<float> stereo;
+    for (const float v : audio) stereo.insert(stereo.end(), {v, 0.0f});
+    PitchDetector::Result results[2];
+    for (int pos = 0; pos + 480 <= SR; pos += 480) {
+        channels.process_channels(stereo.data() + static_cast<size_t>(pos) * 2, 480, results);
+    }
+    ML_ASSERT_TRUE(results[0].pitched);
+    ML_ASSERT_NEAR(results[0].frequency, 440.0f, 1.0f);
+    ML_ASSERT_TRUE(!results[1].pitched);
+
+    PitchDetector::FilterConfig bad = filter;
+    bad.hum_harmonics = 5;
+    bool threw = false;
+    try {
+        pd.set_input_filter(bad);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ML_ASSERT_TRUE(threw);
+    bad = filter;
+    bad.high_pass_hz = 5.0f;
+    threw = false;
+    try {
+        pd.set_input_filter(bad);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ML_ASSERT_TRUE(threw);
+    ML_ASSERT_TRUE(pd.input_filter().high_pass_hz == 80.0f);
+    return true;
+}
+
+static bool test_pd_input_filter_swaps_while_processing() {
+    const int SR    = 48000;
+    const int BLOCK = 480;
+    const std::vector<float> audio = make_hummy_tone(SR, SR);
+
+    PitchDetector pd(SR, 2048);
+    PitchDetector::FilterConfig filter;
+    filter.dc_block     = true;
+    filter.high_pass_hz = 80.0f;
+    filter.hum_hz       = 60.0f;
+    pd.set_input_filter(filter);
+
+    // The control thread keeps republishing the same design at the same
+    // number of stages, so the state must carry over and no swap be heard.
+    // (A real change of a notch this narrow rings for a while, swap or not.)
+    std::atomic<bool> done{false};
+    std::thread control([&pd, &done, filter] {
+        while (!done.load()) {
+            pd.set_input_filter(filter);
+            std::this_thread::yield();
+        }
+    });
+
+    int off_pitch = 0;
+    for (int round = 0; round < 4; ++round) {
+        for (int pos = 0; pos < SR; pos += BLOCK) {
+            const PitchDetector::Result r = pd.process(audio.data() + pos, BLOCK);
+            if (round == 0) continue;  // the notches settle in about 0.3 s
+            if (!(r.pitched && std::fabs(r.frequency - 440.0f) < 1.5f)) ++off_pitch;
+        }
+    }
+    done.store(true);
+    control.join();
+    ML_ASSERT_TRUE(off_pitch == 0);
+    return true;
+}
+
+static bool test_ffi_set_noise_gate() {
+    ML_ASSERT_TRUE(ml_pitch_detector_set_noise_gate(nullptr, -40.0f, -50.0f, 2) == 0);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(44100, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_noise_gate(handle, -40.0f, -30.0f, 2) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_noise_gate(handle, -40.0f, -50.0f, -1) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_noise_gate(handle, -40.0f, -50.0f, 2) == 1);
+
+    std::vector<float> buf(2048);
+    make_sine(buf, 440.0f, 44100);
+    for (float& v : buf) v *= 0.001f;  // -63 dBFS RMS
+    const MLPitchResult r = ml_pitch_detector_process(handle, buf.data(), 2048);
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(r.pitched == 0);
+    return true;
+}
+
+static bool test_ffi_set_input_filter() {
+    ML_ASSERT_TRUE(ml_pitch_detector_set_input_filter(nullptr, 1, 80.0f, 60.0f, 3, 0.0f) == 0);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(48000, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_input_filter(handle, 1, 80.0f, 60.0f, 0, 0.0f) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_input_filter(handle, 1, 80.0f, 60.0f, 3, 60.0f) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_input_filter(handle, 1, 80.0f, 60.0f, 3, 0.0f) == 1);
+
+    const std::vector<float> audio = make_hummy_tone(48000, 48000);
+    MLPitchResult r{};
+    for (int pos = 0; pos + 512 <= 48000; pos += 512) r = ml_pitch_detector_process(handle, audio.data() + pos, 512);
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(r.pitched == 1);
+    ML_ASSERT_NEAR(r.frequency, 440.0f, 1.0f);
+    return true;
+}
+
+static bool test_pd_decimation_reports_input_rate() {
+    // YIN runs at 12 kHz on 512-sample frames; frequencies, hop sizes and
+    // offsets are still reported at 48 kHz.
+    const int SR    = 48000;
+    const int FRAME = 2048;
+
+    ML_ASSERT_TRUE([] {
+        try {
+            PitchDetector pd(48000, 2050, 0.10f, 440.0f, false, 4);
+            return false;
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+    }());
+
+    PitchDetector pd(SR, FRAME, 0.10f, 440.0f, false, 4);
+    ML_ASSERT_TRUE(pd.frame_size() == FRAME);
+    ML_ASSERT_TRUE(pd.hop_size() == FRAME / 2);
+    ML_ASSERT_TRUE(pd.analysis_sample_rate() == SR / 4);
+
+    // YIN needs a period of about five samples: 2 kHz is near the top at 12 kHz.
+    for (float freq : {82.41f, 440.0f, 1318.5f, 2000.0f}) {
+        pd.reset();
+        std::vector<float> buf(SR / 2);
+        make_sine(buf, freq, SR);
+        PitchDetector::Result results[32];
+        int offsets[32];
+        const int count = pd.process_block(buf.data(), static_cast<int>(buf.size()), results, 32, offsets);
+        ML_ASSERT_TRUE(count == (SR / 2 - FRAME) / (FRAME / 2) + 1);
+        for (int i = 0; i < count; ++i) {
+            ML_ASSERT_TRUE(offsets[i] == FRAME + i * FRAME / 2);
+        }
+        ML_ASSERT_TRUE(results[count - 1].pitched);
+        ML_ASSERT_NEAR(results[count - 1].frequency, freq, freq * 0.001f);  // < 2 cents
+    }
+    return true;
+}
+
+static bool test_pd_decimation_matches_across_entry_points() {
+    // process() and process_block() must see the same decimated stream.
+    const int SR    = 48000;
+    const int FRAME = 3072;
+    const int HOP   = FRAME / 2;
+
+    std::vector<float> buf(FRAME + HOP * 4);
+    make_sine(buf, 196.0f, SR);
+    PitchDetector block_pd(SR, FRAME, 0.10f, 440.0f, false, 3);
+    PitchDetector hop_pd(SR, FRAME, 0.10f, 440.0f, false, 3);
+    PitchDetector::Result results[8];
+    const int count = block_pd.process_block(buf.data(), static_cast<int>(buf.size()), results, 8);
+    ML_ASSERT_TRUE(count == 5);
+
+    PitchDetector::Result expected = hop_pd.process(buf.data(), FRAME);
+    ML_ASSERT_NEAR(results[0].frequency, expected.frequency, 1e-3f);
+    for (int i = 1; i < count; ++i) {
+        expected = hop_pd.process(buf.data() + FRAME + HOP * (i - 1), HOP);
+        ML_ASSERT_NEAR(results[i].frequency, expected.frequency, 1e-3f);
+    }
+    ML_ASSERT_NEAR(expected.frequency, 196.0f, 0.5f);
+    return true;
+}
+
+static bool test_pd_interleaved_downmix_and_select() {
+    const int SR    = 48000;
+    const int FRAME = 2048;
+    const int TOTAL = FRAME * 3;
+
+    // Identical channels average back to the mono signal, hop for hop.
+    const std::vector<float> stereo = make_interleaved({330.0f, 330.0f}, TOTAL, SR);
+    std::vector<float> mono(TOTAL);
+    for (int i = 0; i < TOTAL; ++i) mono[i] = stereo[static_cast<size_t>(i) * 2];
+    PitchDetector mono_pd(SR, FRAME);
+    PitchDetector stereo_pd(SR, FRAME);
+    PitchDetector::Result expected[8];
+    PitchDetector::Result actual[8];
+    int expected_ends[8];
+    int actual_ends[8];
+    const int expected_count = mono_pd.process_block(mono.data(), TOTAL, expected, 8, expected_ends);
+    const int actual_count = stereo_pd.process_block_interleaved(stereo.data(), TOTAL, 2, nullptr, actual, 8, actual_ends);
+    ML_ASSERT_TRUE(expected_count == 5 && actual_count == expected_count);
+    for (int i = 0; i < actual_count; ++i) {
+        ML_ASSERT_TRUE(actual_ends[i] == expected_ends[i]);
+        ML_ASSERT_NEAR(actual[i].frequency, expected[i].frequency, 1e-3f);
+    }
+
+    // Selecting one channel ignores the others, even a broken one.
+    std::vector<float> quad = make_interleaved({220.0f, 330.0f, 440.0f, 0.0f}, TOTAL, SR);
+    for (int i = 0; i < TOTAL; ++i) quad[static_cast<size_t>(i) * 4 + 3] = std::numeric_limits<float>::quiet_NaN();
+    const float freqs[3] = {220.0f, 330.0f, 440.0f};
+    for (int c = 0; c < 3; ++c) {
+        float weights[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        weights[c] = 1.0f;
+        PitchDetector pd(SR, FRAME);
+        const PitchDetector::Result r = pd.process_interleaved(quad.data(), TOTAL, 4, weights);
+        ML_ASSERT_TRUE(r.pitched);
+        ML_ASSERT_NEAR(r.frequency, freqs[c], 1.0f);
+    }
+
+    // A weighted 3-channel mix dominated by one channel, through the decimator.
+    const std::vector<float> trio = make_interleaved({196.0f, 0.0f, 0.0f}, TOTAL, SR);
+    const float weights[3] = {1.0f, 0.5f, 0.5f};
+    PitchDetector decimated(SR, FRAME, 0.10f, 440.0f, false, 2);
+    const PitchDetector::Result r = decimated.process_interleaved(trio.data(), TOTAL, 3, weights);
+    ML_ASSERT_TRUE(r.pitched);
+    ML_ASSERT_NEAR(r.frequency, 196.0f, 1.0f);
+
+    bool threw = false;
+    try {
+        decimated.process_interleaved(trio.data(), TOTAL, PitchDetector::kMaxChannels + 1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ML_ASSERT_TRUE(threw);
+    return true;
+}
+
+static bool test_pd_channel_detection_keeps_channels_apart() {
+    const int SR    = 48000;
+    const int FRAME = 2048;
+    const int BLOCK = 512;
+
+    PitchDetector pd(SR, FRAME, 0.10f, 440.0f, true);
+    ML_ASSERT_TRUE(pd.channel_count() == 0);
+    pd.enable_channel_detection(3);
+    ML_ASSERT_TRUE(pd.channel_count() == 3);
+
+    const std::vector<float> audio = make_interleaved({110.0f, 0.0f, 880.0f}, FRAME * 4, SR);
+    PitchDetector::Result results[3];
+    for (int offset = 0; offset + BLOCK <= FRAME * 4; offset += BLOCK) {
+        ML_ASSERT_TRUE(pd.process_channels(audio.data() + static_cast<size_t>(offset) * 3, BLOCK, results) == 3);
+    }
+    ML_ASSERT_TRUE(results[0].pitched);
+    ML_ASSERT_NEAR(results[0].frequency, 110.0f, 0.5f);
+    ML_ASSERT_TRUE(!results[1].pitched);
+    ML_ASSERT_TRUE(pd.channel(1).frames_gated() == pd.channel(1).frames_analysed());
+    ML_ASSERT_TRUE(results[2].pitched);
+    ML_ASSERT_NEAR(results[2].frequency, 880.0f, 2.0f);
+    // Adaptive frames switch per channel: the high channel hops faster.
+    ML_ASSERT_TRUE(pd.channel(2).frames_analysed() > pd.channel(0).frames_analysed());
+
+    // Settings and reset follow the owning detector.
+    pd.set_target(110.0f);
+    pd.reset();
+    for (int offset = 0; offset + BLOCK <= FRAME * 4; offset += BLOCK) {
+        pd.process_channels(audio.data() + static_cast<size_t>(offset) * 3, BLOCK, results);
+    }
+    ML_ASSERT_TRUE(results[0].pitched);
+    ML_ASSERT_NEAR(results[0].frequency, 110.0f, 0.05f);
+    ML_ASSERT_TRUE(!results[2].pitched);
+    return true;
+}
+
+static bool test_pd_reconfigure_swaps_without_gap() {
+    const int SR    = 48000;
+    const int BLOCK = 256;
+    std::vector<float> audio(SR);
+    make_sine(audio, 440.0f, SR);
+
+    PitchDetector pd(SR, 2048);
+    int pos = 0;
+    PitchDetector::Result r{};
+    for (; pos < 4096; pos += BLOCK) r = pd.process(audio.data() + pos, BLOCK);
+    ML_ASSERT_TRUE(r.pitched);
+
+    // Shorter frame: the history is already there, so the next hop analyses
+    // at the new size and no result in between is unpitched.
+    PitchDetector::AnalysisConfig config = pd.analysis_config();
+    config.frame_size = 1024;
+    pd.reconfigure(config);
+    ML_ASSERT_TRUE(pd.frame_size() == 2048);  // Swapped by the processing thread
+    const uint64_t before = pd.frames_analysed();
+    for (int end = pos + 512; pos < end; pos += BLOCK) {
+        r = pd.process(audio.data() + pos, BLOCK);
+        ML_ASSERT_TRUE(r.pitched);
+        ML_ASSERT_TRUE(pd.frame_size() == 1024);
+    }
+    ML_ASSERT_TRUE(pd.frames_analysed() == before + 1);
+    ML_ASSERT_NEAR(r.frequency, 440.0f, 1.0f);
+
+    // Longer frame on another backend: the last result holds while it fills.
+    config.frame_size  = 4096;
+    config.fft_backend = music_life::FftBackend::Radix2;
+    pd.reconfigure(config);
+    const uint64_t filled_before = pd.frames_analysed();
+    for (int end = pos + 4096; pos < end; pos += BLOCK) {
+        r = pd.process(audio.data() + pos, BLOCK);
+        ML_ASSERT_TRUE(r.pitched);
+    }
+    ML_ASSERT_TRUE(pd.frame_size() == 4096);
+    ML_ASSERT_TRUE(pd.hop_size() == 2048);
+    ML_ASSERT_TRUE(pd.frames_analysed() > filled_before);
+    ML_ASSERT_NEAR(r.frequency, 440.0f, 0.5f);
+
+    config.threshold = 1.5f;
+    bool threw = false;
+    try {
+        pd.reconfigure(config);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ML_ASSERT_TRUE(threw);
+    ML_ASSERT_TRUE(pd.analysis_config().threshold == 0.10f);
+    return true;
+}
+
+static bool test_pd_reconfigure_while_processing() {
+    // One second loops seamlessly: whole cycles, and BLOCK divides it.
+    const int SR    = 48000;
+    const int BLOCK = 480;
+    std::vector<float> audio(SR);
+    make_sine(audio, 220.0f, SR);
+    const std::vector<float> stereo = make_interleaved({220.0f, 330.0f}, SR, SR);
+
+    PitchDetector pd(SR, 2048, 0.10f, 440.0f, false, 2);
+    pd.enable_channel_detection(2);
+
+    std::atomic<bool> done{false};
+    int last_size = 0;
+    std::thread control([&pd, &done, &last_size] {
+        const int sizes[] = {1024, 2048, 4096, 2048};
+        for (int i = 0; !done.load(); ++i) {
+            PitchDetector::AnalysisConfig config;
+            config.frame_size          = sizes[i % 4];
+            config.adaptive_frame_size = (i & 1) != 0;
+            pd.reconfigure(config);
+            last_size = config.frame_size;
+            std::this_thread::yield();
+        }
+    });
+
+    // Every result after warm-up stays on pitch, whichever engines it ran on.
+    int off_pitch = 0;
+    PitchDetector::Result results[2];
+    for (int round = 0; round < 8; ++round) {
+        for (int pos = 0; pos < SR; pos += BLOCK) {
+            const PitchDetector::Result r = pd.process(audio.data() + pos, BLOCK);
+            pd.process_channels(stereo.data() + static_cast<size_t>(pos) * 2, BLOCK, results);
+            if (round == 0) continue;
+            if (!(r.pitched && std::fabs(r.frequency - 220.0f) < 1.0f)) ++off_pitch;
+            if (!(results[0].pitched && std::fabs(results[0].frequency - 220.0f) < 1.0f)) ++off_pitch;
+            if (!(results[1].pitched && std::fabs(results[1].frequency - 330.0f) < 1.5f)) ++off_pitch;
+        }
+    }
+    done.store(true);
+    control.join();
+    ML_ASSERT_TRUE(off_pitch == 0);
+
+    // The last reconfigure() is never lost behind one the processing thread
+    // was still swapping in.
+    for (int pos = 0; pos < 4 * BLOCK; pos += BLOCK) {
+        pd.process(audio.data() + pos, BLOCK);
+        pd.process_channels(stereo.data() + static_cast<size_t>(pos) * 2, BLOCK, results);
+    }
+    ML_ASSERT_TRUE(pd.analysis_config().frame_size == last_size);
+    ML_ASSERT_TRUE(pd.frame_size() == last_size);
+    for (int c = 0; c < pd.channel_count(); ++c) {
+        ML_ASSERT_TRUE(pd.channel(c).frame_size() == last_size);
+    }
+    return true;
+}
+
+static bool test_ffi_create_with_config() {
+    ML_ASSERT_TRUE(ml_pitch_detector_create_with_config(nullptr) == nullptr);
+    MLPitchDetectorConfig config{48000, 2048, 0.10f, 440.0f, 0, 5};
+    ML_ASSERT_TRUE(ml_pitch_detector_create_with_config(&config) == nullptr);
+
+    config.decimation = 2;
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create_with_config(&config);
+    ML_ASSERT_TRUE(handle != nullptr);
+    std::vector<float> buf(2048);
+    make_sine(buf, 440.0f, 48000);
+    const MLPitchResult r = ml_pitch_detector_process(handle, buf.data(), 2048);
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(r.pitched == 1);
+    ML_ASSERT_NEAR(r.frequency, 440.0f, 1.0f);
+    return true;
+}
+
+static bool test_pd_snapshots_expose_spectrum_and_cmndf() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+
+    PitchDetector pd(SR, FRAME);
+    ML_ASSERT_TRUE(pd.latest_snapshot() == nullptr);
+    ML_ASSERT_TRUE([&pd] {
+        try {
+            pd.enable_snapshots(0);
+            return false;
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+    }());
+    pd.enable_snapshots(256);
+    ML_ASSERT_TRUE(pd.latest_snapshot() == nullptr);
+
+    std::vector<float> audio(SR / 2);
+    make_sine(audio, 440.0f, SR);
+    std::vector<PitchDetector::Result> results(32);
+    const int count = pd.process_block(audio.data(), static_cast<int>(audio.size()), results.data(), 32);
+    ML_ASSERT_TRUE(count > 0);
+
+    const PitchDetector::Snapshot* snapshot = pd.latest_snapshot();
+    ML_ASSERT_TRUE(snapshot != nullptr);
+    ML_ASSERT_TRUE(snapshot->frame_index == pd.frames_analysed());
+    ML_ASSERT_NEAR(snapshot->frequency, results[count - 1].frequency, 1e-3f);
+    ML_ASSERT_TRUE(snapshot->analysis_frame_size == FRAME);
+
+    // 256 bins of 86 Hz: the tone peaks in bin 5 at roughly full scale.
+    ML_ASSERT_TRUE(snapshot->spectrum_size == 256);
+    ML_ASSERT_NEAR(snapshot->bin_hz, SR / 2.0f / 256.0f, 1e-3f);
+    const auto peak = std::max_element(snapshot->spectrum.begin(), snapshot->spectrum.begin() + snapshot->spectrum_size);
+    ML_ASSERT_TRUE(peak - snapshot->spectrum.begin() == static_cast<long>(440.0f / snapshot->bin_hz));
+    ML_ASSERT_NEAR(*peak, 1.0f, 0.2f);
+
+    // The CMNDF dips at the 100.2-sample period.
+    ML_ASSERT_TRUE(snapshot->cmndf_size == FRAME / 2);
+    const auto dip = std::min_element(snapshot->cmndf.begin() + 2, snapshot->cmndf.begin() + 150);
+    ML_ASSERT_TRUE(std::abs((dip - snapshot->cmndf.begin()) - 100) <= 1);
+    ML_ASSERT_TRUE(*dip < 0.1f);
+
+    // Gated hops publish nothing: the reader keeps the last analysed hop.
+    std::vector<float> silence(FRAME * 2, 0.0f);
+    pd.process_block(silence.data(), static_cast<int>(silence.size()), results.data(), 32);
+    ML_ASSERT_TRUE(pd.frames_gated() > 0);
+    const uint64_t last_index = pd.latest_snapshot()->frame_index;
+    ML_ASSERT_TRUE(last_index < pd.frames_analysed());
+    pd.process_block(silence.data(), static_cast<int>(silence.size()), results.data(), 32);
+    ML_ASSERT_TRUE(pd.latest_snapshot()->frame_index == last_index);
+    return true;
+}
+
+static bool test_pd_target_mode_tracks_near_target() {
+    const int SR    = 48000;
+    const int FRAME = 2048;
+
+    PitchDetector pd(SR, FRAME);
+    ML_ASSERT_TRUE([&pd] {
+        try {
+            pd.set_target(10.0f);
+            return false;
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+    }());
+
+    // Low E string 7 cents flat.
+    const float target = 82.41f;
+    const float played = target * std::pow(2.0f, -7.0f / 1200.0f);
+    std::vector<float> audio(SR);
+    make_sine(audio, played, SR);
+    pd.set_target(target);
+    ML_ASSERT_NEAR(pd.target(), target, 1e-6f);
+
+    std::vector<PitchDetector::Result> results(512);
+    std::vector<int> offsets(512);
+    const int count = pd.process_block(audio.data(), SR, results.data(), 512, offsets.data());
+    ML_ASSERT_TRUE(pd.hop_size() == pd.strobe_hop_size());
+    ML_ASSERT_TRUE(count == SR / pd.strobe_hop_size());
+    ML_ASSERT_TRUE(offsets[0] == pd.strobe_hop_size());
+    ML_ASSERT_TRUE(results[count - 1].pitched);
+    ML_ASSERT_TRUE(results[count - 1].midi_note == 40);
+    ML_ASSERT_NEAR(1200.0f * std::log2(results[count - 1].frequency / played), 0.0f, 0.1f);
+    ML_ASSERT_NEAR(results[count - 1].cents_offset, -7.0f, 0.1f);
+
+    // Clearing the target returns to YIN, starting from an empty frame.
+    pd.set_target(0.0f);
+    const int yin_count = pd.process_block(audio.data(), SR, results.data(), 512);
+    ML_ASSERT_TRUE(pd.hop_size() == FRAME / 2);
+    ML_ASSERT_TRUE(yin_count == 1 + (SR - FRAME) / (FRAME / 2));
+    ML_ASSERT_NEAR(results[yin_count - 1].frequency, played, 0.5f);
+    return true;
+}
+
+static bool test_triple_buffer_reader_sees_whole_values() {
+    // Every published value is an array of one repeated counter; the reader
+    // must never see a mix of two publishes or go backwards.
+    struct Value {
+        int items[64];
+    };
+    Value initial{};
+    TripleBuffer<Value> buffer(initial);
+    const int kPublishes = 20000;
+
+    std::thread producer([&buffer] {
+        for (int n = 1; n <= kPublishes; ++n) {
+            Value& value = buffer.back();
+            for (int& item : value.items) item = n;
+            buffer.publish();
+        }
+    });
+
+    bool torn = false;
+    int last = 0;
+    while (last < kPublishes && !torn) {
+        if (!buffer.update()) continue;
+        const Value& value = buffer.front();
+        for (int item : value.items) torn |= item != value.items[0];
+        torn |= value.items[0] <= last;
+        last = value.items[0];
+    }
+    producer.join();
+    ML_ASSERT_TRUE(!torn);
+    ML_ASSERT_TRUE(last == kPublishes);
+    ML_ASSERT_TRUE(!buffer.update());
+    return true;
+}
+
+static bool test_ffi_set_target() {
+    ML_ASSERT_TRUE(ml_pitch_detector_set_target(nullptr, 110.0f) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_strobe_phase(nullptr) == 0.0f);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(44100, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_target(handle, 5000.0f) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_set_target(handle, 110.0f) == 1);
+
+    // 0.25 Hz sharp: results arrive long before a YIN frame would fill.
+    std::vector<float> buf(4096);
+    MLPitchResult r{};
+    float phase = 0.0f;
+    for (int block = 0; block < 20; ++block) {
+        for (size_t i = 0; i < buf.size(); ++i) {
+            const double t = static_cast<double>(block * 4096 + static_cast<int>(i)) / 44100.0;
+            buf[i] = static_cast<float>(0.5 * std::sin(2.0 * 3.14159265358979323846 * 110.25 * t));
+        }
+        r = ml_pitch_detector_process(handle, buf.data(), 1024);
+        r = ml_pitch_detector_process(handle, buf.data() + 1024, 3072);
+        phase = ml_pitch_detector_strobe_phase(handle);
+    }
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(r.pitched == 1);
+    ML_ASSERT_NEAR(r.frequency, 110.25f, 0.01f);
+    ML_ASSERT_TRUE(phase >= 0.0f && phase < 1.0f);
+    return true;
+}
+
+static bool test_ffi_reconfigure() {
+    ML_ASSERT_TRUE(ml_pitch_detector_reconfigure(nullptr, 1024, 0.10f, 0, ML_FFT_BACKEND_AUTO) == 0);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(48000, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(ml_pitch_detector_reconfigure(handle, 65536, 0.10f, 0, ML_FFT_BACKEND_AUTO) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_reconfigure(handle, 1024, 0.10f, 0, 7) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_reconfigure(handle, 1024, -1.0f, 0, ML_FFT_BACKEND_AUTO) == 0);
+
+    // Growing the frame also raises the per-call limit of process().
+    ML_ASSERT_TRUE(ml_pitch_detector_reconfigure(handle, 8192, 0.10f, 1, ML_FFT_BACKEND_RADIX2) == 1);
+    std::vector<float> buf(8192 * 2);
+    make_sine(buf, 440.0f, 48000);
+    const MLPitchResult r = ml_pitch_detector_process(handle, buf.data(), static_cast<int>(buf.size()));
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(r.pitched == 1);
+    ML_ASSERT_NEAR(r.frequency, 440.0f, 1.0f);
+    return true;
+}
+
+static bool test_ffi_processes_interleaved_input() {
+    const int SR = 48000;
+    const std::vector<float> stereo = make_interleaved({440.0f, 660.0f}, 4096, SR);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(SR, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+
+    const float right[2] = {0.0f, 1.0f};
+    ML_ASSERT_TRUE(ml_pitch_detector_process_interleaved(handle, stereo.data(), 2048, 9, nullptr).pitched == 0);
+    MLPitchResult r = ml_pitch_detector_process_interleaved(handle, stereo.data(), 2048, 2, right);
+    ML_ASSERT_TRUE(r.pitched == 1);
+    ML_ASSERT_NEAR(r.frequency, 660.0f, 1.0f);
+
+    float frequency[4] = {};
+    MLPitchBlockResults block{4, nullptr, frequency, nullptr, nullptr, nullptr, nullptr};
+    ML_ASSERT_TRUE(ml_pitch_detector_process_block_interleaved(handle, stereo.data(), 4096, 0, nullptr, &block) == -1);
+    ML_ASSERT_TRUE(ml_pitch_detector_process_block_interleaved(handle, stereo.data(), 2048, 2, right, &block) == 2);
+    ML_ASSERT_NEAR(frequency[1], 660.0f, 1.0f);
+
+    MLPitchResult channels[2];
+    ML_ASSERT_TRUE(ml_pitch_detector_process_channels(handle, stereo.data(), 2048, channels, 2) == -1);
+    ML_ASSERT_TRUE(ml_pitch_detector_enable_channel_detection(handle, 0) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_enable_channel_detection(handle, 2) == 1);
+    ML_ASSERT_TRUE(ml_pitch_detector_process_channels(handle, stereo.data(), 2048, channels, 2) == 2);
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(channels[0].pitched == 1 && channels[1].pitched == 1);
+    ML_ASSERT_NEAR(channels[0].frequency, 440.0f, 1.0f);
+    ML_ASSERT_NEAR(channels[1].frequency, 660.0f, 1.0f);
+    ML_ASSERT_TRUE(std::strcmp(channels[0].note_name, "A4") == 0);
+    return true;
+}
+
+static bool test_ffi_read_snapshot() {
+    MLPitchSnapshotInfo info{};
+    ML_ASSERT_TRUE(ml_pitch_detector_enable_snapshots(nullptr, 128) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_read_snapshot(nullptr, &info, nullptr, 0, nullptr, 0) == -1);
+
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(44100, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(ml_pitch_detector_read_snapshot(handle, &info, nullptr, 0, nullptr, 0) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_enable_snapshots(handle, 9000) == 0);
+    ML_ASSERT_TRUE(ml_pitch_detector_enable_snapshots(handle, 128) == 1);
+
+    std::vector<float> buf(2048);
+    make_sine(buf, 440.0f, 44100);
+    const MLPitchResult r = ml_pitch_detector_process(handle, buf.data(), 2048);
+
+    // Capacities smaller than the snapshot copy only what fits.
+    std::vector<float> spectrum(64, -1.0f);
+    std::vector<float> cmndf(2048, -1.0f);
+    const int status = ml_pitch_detector_read_snapshot(handle, &info, spectrum.data(), 64, cmndf.data(), 2048);
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(status == 1);
+    ML_ASSERT_TRUE(info.frame_index == 1);
+    ML_ASSERT_NEAR(info.frequency, r.frequency, 1e-3f);
+    ML_ASSERT_TRUE(info.spectrum_size == 128);
+    ML_ASSERT_TRUE(info.cmndf_size == 1024);
+    ML_ASSERT_TRUE(spectrum[63] >= 0.0f);
+    ML_ASSERT_TRUE(cmndf[0] == 1.0f);
+    ML_ASSERT_TRUE(cmndf[1023] >= 0.0f && cmndf[1024] == -1.0f);
+    return true;
+}
+
+static bool test_ffi_process_block_accepts_large_blocks() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+    const int HOP   = FRAME / 2;
+
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(SR, FRAME, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+
+    // Well beyond the 2 x frame_size limit of ml_pitch_detector_process and
+    // beyond one internal staging batch.
+    const int TOTAL = FRAME + HOP * 39;
+    std::vector<float> buf(TOTAL);
+    make_sine(buf, 440.0f, SR);
+
+    std::vector<int> pitched(64);
+    std::vector<float> frequency(64);
+    std::vector<int> offsets(64);
+    MLPitchBlockResults results{64, pitched.data(), frequency.data(), nullptr, nullptr, nullptr, offsets.data()};
+    const int count = ml_pitch_detector_process_block(handle, buf.data(), TOTAL, &results);
+    ML_ASSERT_TRUE(count == 40);
+    for (int i = 0; i < count; ++i) {
+        ML_ASSERT_TRUE(pitched[i] == 1);
+        ML_ASSERT_NEAR(frequency[i], 440.0f, 2.0f);
+        ML_ASSERT_TRUE(offsets[i] == FRAME + HOP * i);
+    }
+
+    ML_ASSERT_TRUE(ml_pitch_detector_process_block(handle, nullptr, TOTAL, &results) == -1);
+    ML_ASSERT_TRUE(ml_pitch_detector_process_block(handle, buf.data(), TOTAL, nullptr) == -1);
+    ml_pitch_detector_destroy(handle);
+    return true;
+}
+
+static bool test_ffi_mailbox_publishes_every_hop() {
+    const int SR    = 44100;
+    const int FRAME = 2048;
+    const int HOP   = FRAME / 2;
+
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(SR, FRAME, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    MLPitchMailbox* mailbox = ml_pitch_mailbox_create(handle, FRAME * 3, 4);
+    ML_ASSERT_TRUE(mailbox != nullptr);
+
+    const MLPitchMailboxHeader* header = ml_pitch_mailbox_header(mailbox);
+    ML_ASSERT_TRUE(header->sample_capacity == 8192);
+    ML_ASSERT_TRUE(header->result_capacity == 4);
+
+    std::vector<float> buf(FRAME + HOP * 5);
+    make_sine(buf, 440.0f, SR);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_write(mailbox, buf.data(), FRAME + 100) == FRAME + 100);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_pump(mailbox) == 1);
+    ML_ASSERT_TRUE(header->results_published == 1);
+
+    // Write the rest in place and commit, as a consumer mapping the sample
+    // ring directly would.
+    float* ring = ml_pitch_mailbox_samples(mailbox);
+    const int rest = static_cast<int>(buf.size()) - (FRAME + 100);
+    for (int i = 0; i < rest; ++i) {
+        ring[(FRAME + 100 + i) & (header->sample_capacity - 1)] = buf[FRAME + 100 + i];
+    }
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit(mailbox, rest) == rest);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_pump(mailbox) == 5);
+    ML_ASSERT_TRUE(header->results_published == 6);
+    ML_ASSERT_TRUE(header->samples_consumed == buf.size());
+
+    // Only the newest result_capacity results survive in the ring.
+    MLPitchMailboxSlot slots[8];
+    const int count = ml_pitch_mailbox_read(mailbox, 0, slots, 8);
+    ML_ASSERT_TRUE(count == 4);
+    for (int i = 0; i < count; ++i) {
+        ML_ASSERT_TRUE(slots[i].sequence == static_cast<uint32_t>(3 + i));
+        ML_ASSERT_TRUE(slots[i].pitched == 1);
+        ML_ASSERT_NEAR(slots[i].frequency, 440.0f, 2.0f);
+        ML_ASSERT_TRUE(slots[i].end_sample == FRAME + HOP * (2 + i));
+    }
+    ML_ASSERT_TRUE(ml_pitch_mailbox_read(mailbox, 6, slots, 8) == 0);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_results(mailbox)[1].sequence == 2u * 6u);
+
+    ml_pitch_mailbox_destroy(mailbox);
+    ml_pitch_detector_destroy(handle);
+    return true;
+}
+
+static bool test_ffi_mailbox_counts_dropped_samples() {
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(44100, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    MLPitchMailbox* mailbox = ml_pitch_mailbox_create(handle, 4096, 8);
+    ML_ASSERT_TRUE(mailbox != nullptr);
+
+    std::vector<float> buf(5000, 0.0f);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_write(mailbox, buf.data(), 5000) == 4096);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_header(mailbox)->samples_dropped == 904);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit(mailbox, 1) == 0);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit_and_pump(mailbox, 1) == -1);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_header(mailbox)->samples_written == 4096);
+
+    // Once pumped the ring has room again; one hop in place is one result.
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit_and_pump(mailbox, 0) == 3);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit_and_pump(mailbox, 1024) == 1);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_header(mailbox)->samples_consumed == 4096 + 1024);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit_and_pump(mailbox, -1) == -1);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_commit_and_pump(nullptr, 1) == -1);
+
+    ml_pitch_mailbox_destroy(mailbox);
+    ml_pitch_detector_destroy(handle);
+    ML_ASSERT_TRUE(ml_pitch_mailbox_create(nullptr, 4096, 8) == nullptr);
+    return true;
+}
+
 static bool test_ffi_process_null_handle() {
     // ml_pitch_detector_process must return a zeroed result (not crash) when
     // the handle is null.
@@ -613,15 +1898,133 @@ static bool test_ffi_log_callback_supports_trace_level() {
     return true;
 }
 
+static bool test_ffi_process_logs_are_deferred_until_drain() {
+    ml_pitch_detector_set_log_callback(test_log_callback);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(44100, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    g_last_log_level = -1;
+    g_last_log_message.clear();
+
+    // The audio path only queues the record; nothing is delivered inline.
+    std::vector<float> buf(5000, 0.0f);
+    (void)ml_pitch_detector_process(handle, buf.data(), static_cast<int>(buf.size()));
+    ML_ASSERT_TRUE(g_last_log_level == -1);
+
+    ML_ASSERT_TRUE(ml_pitch_detector_drain_logs() == 1);
+    ML_ASSERT_TRUE(g_last_log_level == ML_LOG_LEVEL_ERROR);
+    ML_ASSERT_TRUE(g_last_log_message == "ml_pitch_detector_process: invalid num_samples=5000");
+    ML_ASSERT_TRUE(ml_pitch_detector_drain_logs() == 0);
+
+    ml_pitch_detector_destroy(handle);
+    ml_pitch_detector_set_log_callback(nullptr);
+    return true;
+}
+
+static bool test_ffi_log_formats_recorded_arguments() {
+    ml_pitch_detector_set_log_callback(test_log_callback);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create_with_reference_pitch(48000, 1024, 0.125f, 442.0f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(g_last_log_message ==
+                   "ml_pitch_detector_create: sample_rate=48000 frame_size=1024 threshold=0.125 reference_pitch_hz=442.00");
+    ml_pitch_detector_destroy(handle);
+    ml_pitch_detector_set_log_callback(nullptr);
+    return true;
+}
+
+static bool test_ffi_log_thread_delivers_queued_logs() {
+    ml_pitch_detector_set_log_callback(test_log_callback);
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(44100, 2048, 0.10f);
+    ML_ASSERT_TRUE(handle != nullptr);
+    ML_ASSERT_TRUE(ml_pitch_detector_start_log_thread(1) == 1);
+    g_last_log_level = -1;
+
+    std::vector<float> buf(5000, 0.0f);
+    (void)ml_pitch_detector_process(handle, buf.data(), static_cast<int>(buf.size()));
+    // Stopping joins the thread after a final drain.
+    ml_pitch_detector_stop_log_thread();
+    ML_ASSERT_TRUE(g_last_log_level == ML_LOG_LEVEL_ERROR);
+
+    ml_pitch_detector_destroy(handle);
+    ml_pitch_detector_set_log_callback(nullptr);
+    return true;
+}
+
 static bool test_ffi_api_is_noexcept() {
     static_assert(noexcept(ml_pitch_detector_create(44100, 2048, 0.10f)));
     static_assert(noexcept(ml_pitch_detector_create_with_reference_pitch(44100, 2048, 0.10f, 440.0f)));
+    static_assert(noexcept(ml_pitch_detector_create_adaptive(44100, 2048, 0.10f, 440.0f)));
+    static_assert(noexcept(ml_pitch_detector_create_with_config(nullptr)));
     static_assert(noexcept(ml_pitch_detector_destroy(nullptr)));
     static_assert(noexcept(ml_pitch_detector_reset(nullptr)));
     static_assert(noexcept(ml_pitch_detector_set_reference_pitch(nullptr, 440.0f)));
+    static_assert(noexcept(ml_pitch_detector_set_noise_gate(nullptr, -60.0f, -66.0f, 4)));
+    static_assert(noexcept(ml_pitch_detector_set_input_filter(nullptr, 1, 80.0f, 60.0f, 3, 0.0f)));
     static_assert(noexcept(ml_pitch_detector_process(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_detector_enable_snapshots(nullptr, 128)));
+    static_assert(noexcept(ml_pitch_detector_set_target(nullptr, 110.0f)));
+    static_assert(noexcept(ml_pitch_detector_reconfigure(nullptr, 1024, 0.10f, 0, 0)));
+    static_assert(noexcept(ml_pitch_detector_enable_practice_stats(nullptr, 0.8f, 10.0f)));
+    static_assert(noexcept(ml_pitch_detector_reset_practice_stats(nullptr)));
+    static_assert(noexcept(ml_pitch_detector_read_practice_stats(nullptr, nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_detector_strobe_phase(nullptr)));
+    static_assert(noexcept(ml_pitch_detector_read_snapshot(nullptr, nullptr, nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_detector_process_block(nullptr, nullptr, 0, nullptr)));
+    static_assert(noexcept(ml_pitch_detector_process_interleaved(nullptr, nullptr, 0, 2, nullptr)));
+    static_assert(noexcept(ml_pitch_detector_process_block_interleaved(nullptr, nullptr, 0, 2, nullptr, nullptr)));
+    static_assert(noexcept(ml_pitch_detector_enable_channel_detection(nullptr, 2)));
+    static_assert(noexcept(ml_pitch_detector_process_channels(nullptr, nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_mailbox_create(nullptr, 0, 0)));
+    static_assert(noexcept(ml_pitch_mailbox_write(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_mailbox_pump(nullptr)));
+    static_assert(noexcept(ml_pitch_mailbox_commit_and_pump(nullptr, 0)));
+    static_assert(noexcept(ml_pitch_mailbox_read(nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_chroma_create(44100, 4096, 440.0f)));
+    static_assert(noexcept(ml_chroma_destroy(nullptr)));
+    static_assert(noexcept(ml_chroma_reset(nullptr)));
+    static_assert(noexcept(ml_chroma_process(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_onset_create(44100, 1024, 256)));
+    static_assert(noexcept(ml_onset_destroy(nullptr)));
+    static_assert(noexcept(ml_onset_reset(nullptr)));
+    static_assert(noexcept(ml_onset_process(nullptr, nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_onset_tempo(nullptr)));
+    static_assert(noexcept(ml_metronome_create(48000)));
+    static_assert(noexcept(ml_metronome_destroy(nullptr)));
+    static_assert(noexcept(ml_metronome_set_tempo(nullptr, 120.0f)));
+    static_assert(noexcept(ml_metronome_start(nullptr)));
+    static_assert(noexcept(ml_metronome_render(nullptr, nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_time_stretch_create(48000, 2)));
+    static_assert(noexcept(ml_time_stretch_destroy(nullptr)));
+    static_assert(noexcept(ml_time_stretch_set_speed(nullptr, 1.0f)));
+    static_assert(noexcept(ml_time_stretch_reset(nullptr)));
+    static_assert(noexcept(ml_time_stretch_write(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_time_stretch_read(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_time_stretch_input_space(nullptr)));
+    static_assert(noexcept(ml_time_stretch_finish(nullptr)));
+    static_assert(noexcept(ml_time_stretch_drained(nullptr)));
+    static_assert(noexcept(ml_time_stretch_latency(nullptr)));
+    static_assert(noexcept(ml_waveform_cache_create(nullptr, 0)));
+    static_assert(noexcept(ml_waveform_cache_destroy(nullptr)));
+    static_assert(noexcept(ml_waveform_cache_generate(nullptr, nullptr, 0, nullptr)));
+    static_assert(noexcept(ml_waveform_cache_read(nullptr, nullptr, 0, nullptr)));
+    static_assert(noexcept(ml_align_contours(nullptr, 0, nullptr, 0, 1, 1, 1.0f, nullptr, 0)));
+    static_assert(noexcept(ml_align_note_deviations(nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_fingerprint_index_create(nullptr, 0)));
+    static_assert(noexcept(ml_fingerprint_index_destroy(nullptr)));
+    static_assert(noexcept(ml_fingerprint_index_add(nullptr, nullptr, 0, nullptr)));
+    static_assert(noexcept(ml_fingerprint_index_find_similar(nullptr, nullptr, 0.0f, nullptr, 0, nullptr, 0)));
+    static_assert(noexcept(ml_fingerprint_index_size(nullptr)));
+    static_assert(noexcept(ml_pitch_detector_enable_note_events(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_detector_read_note_events(nullptr, nullptr, 0)));
+    static_assert(noexcept(ml_pitch_detector_note_events_dropped(nullptr)));
     static_assert(noexcept(ml_pitch_detector_set_log_callback(nullptr)));
+    static_assert(noexcept(ml_pitch_detector_drain_logs()));
+    static_assert(noexcept(ml_pitch_detector_start_log_thread(1)));
+    static_assert(noexcept(ml_pitch_detector_stop_log_thread()));
     static_assert(noexcept(ml_pitch_detector_install_crash_handlers()));
+    static_assert(noexcept(ml_trace_enabled()));
+    static_assert(noexcept(ml_trace_register_thread(nullptr)));
+    static_assert(noexcept(ml_trace_clear()));
+    static_assert(noexcept(ml_trace_write_json(nullptr, 0)));
     return true;
 }
 
@@ -638,12 +2041,22 @@ ML_REGISTER_TEST(YinTest, DetectsA4Sine, test_yin_sine_a4);
 ML_REGISTER_TEST(YinTest, DetectsLowEGuitar, test_yin_sine_e2);
 ML_REGISTER_TEST(YinTest, DetectsC5Sine, test_yin_sine_c5);
 ML_REGISTER_TEST(YinTest, SilenceReturnsNoPitch, test_yin_silence_returns_no_pitch);
+ML_REGISTER_TEST(YinTest, LowAmplitudeReturnsNoPitch, test_yin_low_amplitude_returns_no_pitch);
+ML_REGISTER_TEST(YinTest, NanInputReturnsNoPitch, test_yin_nan_input_returns_no_pitch);
 ML_REGISTER_TEST(YinTest, WorkspaceDoesNotReallocate, test_yin_workspace_no_reallocation);
 ML_REGISTER_TEST(YinTest, WorkspaceSizeIsNotChanged, test_yin_workspace_size_is_not_changed);
 ML_REGISTER_TEST(YinTest, HandlesNonSimdMultipleFrameSize, test_yin_non_simd_multiple_frame_size);
 ML_REGISTER_TEST(YinTest, StableOnSimdAlignedFrame, test_yin_simd_aligned_frame_repeatability);
+ML_REGISTER_TEST(YinTest, EarlyExitMatchesFullCmndf, test_yin_early_exit_matches_full_cmndf);
 ML_REGISTER_TEST(YinTest, SupportsBackendOverride, test_yin_manual_backend_selection);
 
+ML_REGISTER_TEST(MirroredRingBufferTest, MirroredLatestIsContiguous, test_ring_mirrored_latest_is_contiguous);
+ML_REGISTER_TEST(MirroredRingBufferTest, FallbackLatestIsContiguous, test_ring_fallback_latest_is_contiguous);
+ML_REGISTER_TEST(MirroredRingBufferTest, OversizedWriteKeepsNewestSamples, test_ring_oversized_write_keeps_newest_samples);
+ML_REGISTER_TEST(MirroredRingBufferTest, InterleavedWriteFoldsChannels, test_ring_interleaved_write_folds_channels);
+ML_REGISTER_TEST(MirroredRingBufferTest, FilteredWriteMatchesCascade, test_ring_filtered_write_matches_cascade);
+ML_REGISTER_TEST(BiquadCascadeTest, MatchesDirectForm, test_biquad_cascade_matches_direct_form);
+
 ML_REGISTER_TEST(PitchDetectorTest, DetectsA4MidiAndNoteName, test_pd_a4_midi_and_note_name);
 ML_REGISTER_TEST(PitchDetectorTest, DetectsC4, test_pd_c4_note);
 ML_REGISTER_TEST(PitchDetectorTest, SilenceIsNotPitched, test_pd_silence_not_pitched);
@@ -656,9 +2069,36 @@ ML_REGISTER_TEST(PitchDetectorTest, SupportsReferencePitchA4432, test_pd_referen
 ML_REGISTER_TEST(PitchDetectorTest, AcceptsReferencePitchBoundaries, test_pd_reference_pitch_boundaries);
 ML_REGISTER_TEST(PitchDetectorTest, HopSizeSkipsRedundantProcessing, test_pd_hop_size_skips_processing);
 ML_REGISTER_TEST(PitchDetectorTest, PreservesHopRemainderAcrossCalls, test_pd_preserves_hop_remainder_between_calls);
+ML_REGISTER_TEST(PitchDetectorTest, ProcessBlockReportsEveryHop, test_pd_process_block_reports_every_hop);
+ML_REGISTER_TEST(PitchDetectorTest, ProcessBlockRespectsMaxOut, test_pd_process_block_respects_max_out);
+ML_REGISTER_TEST(PitchDetectorTest, AdaptiveHighNoteUsesShortFrame, test_pd_adaptive_high_note_uses_short_frame);
+ML_REGISTER_TEST(PitchDetectorTest, AdaptiveLowNoteKeepsFullFrame, test_pd_adaptive_low_note_keeps_full_frame);
+ML_REGISTER_TEST(PitchDetectorTest, AdaptiveReturnsToFullFrame, test_pd_adaptive_returns_to_full_frame);
+ML_REGISTER_TEST(PitchDetectorTest, GateSkipsSilence, test_pd_gate_skips_silence);
+ML_REGISTER_TEST(PitchDetectorTest, GateHangover, test_pd_gate_hangover);
+ML_REGISTER_TEST(PitchDetectorTest, GateRecoversAfterNan, test_pd_gate_recovers_after_nan);
+ML_REGISTER_TEST(PitchDetectorTest, InputFilterRemovesHum, test_pd_input_filter_removes_hum);
+ML_REGISTER_TEST(PitchDetectorTest, InputFilterSwapsWhileProcessing, test_pd_input_filter_swaps_while_processing);
+ML_REGISTER_TEST(PitchDetectorTest, DecimationReportsInputRate, test_pd_decimation_reports_input_rate);
+ML_REGISTER_TEST(PitchDetectorTest, DecimationMatchesAcrossEntryPoints, test_pd_decimation_matches_across_entry_points);
+ML_REGISTER_TEST(PitchDetectorTest, SnapshotsExposeSpectrumAndCmndf, test_pd_snapshots_expose_spectrum_and_cmndf);
+ML_REGISTER_TEST(PitchDetectorTest, TargetModeTracksNearTarget, test_pd_target_mode_tracks_near_target);
+ML_REGISTER_TEST(PitchDetectorTest, InterleavedDownmixAndSelect, test_pd_interleaved_downmix_and_select);
+ML_REGISTER_TEST(PitchDetectorTest, ChannelDetectionKeepsChannelsApart, test_pd_channel_detection_keeps_channels_apart);
+ML_REGISTER_TEST(PitchDetectorTest, ReconfigureSwapsWithoutGap, test_pd_reconfigure_swaps_without_gap);
+ML_REGISTER_TEST(PitchDetectorTest, ReconfigureWhileProcessing, test_pd_reconfigure_while_processing);
+ML_REGISTER_TEST(TripleBufferTest, ReaderSeesWholeValues, test_triple_buffer_reader_sees_whole_values);
 
 ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessesA4Bridge, test_ffi_process_a4);
 ML_REGISTER_TEST(PitchDetectorFfiTest, SetsReferencePitch, test_ffi_set_reference_pitch);
+ML_REGISTER_TEST(PitchDetectorFfiTest, CreatesAdaptiveDetector, test_ffi_create_adaptive);
+ML_REGISTER_TEST(PitchDetectorFfiTest, SetsNoiseGate, test_ffi_set_noise_gate);
+ML_REGISTER_TEST(PitchDetectorFfiTest, SetsInputFilter, test_ffi_set_input_filter);
+ML_REGISTER_TEST(PitchDetectorFfiTest, CreatesWithConfig, test_ffi_create_with_config);
+ML_REGISTER_TEST(PitchDetectorFfiTest, SetsTarget, test_ffi_set_target);
+ML_REGISTER_TEST(PitchDetectorFfiTest, Reconfigures, test_ffi_reconfigure);
+ML_REGISTER_TEST(PitchDetectorFfiTest, ReadsSnapshot, test_ffi_read_snapshot);
+ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessesInterleavedInput, test_ffi_processes_interleaved_input);
 ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessNullHandleIsSafe, test_ffi_process_null_handle);
 ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessNullSamplesIsSafe, test_ffi_process_null_samples);
 ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessZeroNumSamplesIsSafe, test_ffi_process_zero_num_samples);
@@ -667,52 +2107,16 @@ ML_REGISTER_TEST(PitchDetectorFfiTest, CreateInvalidFrameSizeReturnsNull, test_f
 ML_REGISTER_TEST(PitchDetectorFfiTest, SetReferencePitchOutOfRangeReturnsZero, test_ffi_set_reference_pitch_invalid_returns_zero);
 ML_REGISTER_TEST(PitchDetectorFfiTest, CreateInvalidThresholdReturnsNull, test_ffi_create_invalid_threshold_returns_null);
 ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessExcessiveNumSamplesIsSafe, test_ffi_process_excessive_num_samples_returns_zero);
+ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessBlockAcceptsLargeBlocks, test_ffi_process_block_accepts_large_blocks);
+ML_REGISTER_TEST(PitchDetectorFfiTest, MailboxPublishesEveryHop, test_ffi_mailbox_publishes_every_hop);
+ML_REGISTER_TEST(PitchDetectorFfiTest, MailboxCountsDroppedSamples, test_ffi_mailbox_counts_dropped_samples);
 ML_REGISTER_TEST(PitchDetectorFfiTest, LogCallbackReceivesErrorLogs, test_ffi_log_callback_receives_error_logs);
 ML_REGISTER_TEST(PitchDetectorFfiTest, LogCallbackSupportsTraceLevel, test_ffi_log_callback_supports_trace_level);
+ML_REGISTER_TEST(PitchDetectorFfiTest, ProcessLogsAreDeferredUntilDrain, test_ffi_process_logs_are_deferred_until_drain);
+ML_REGISTER_TEST(PitchDetectorFfiTest, LogFormatsRecordedArguments, test_ffi_log_formats_recorded_arguments);
+ML_REGISTER_TEST(PitchDetectorFfiTest, LogThreadDeliversQueuedLogs, test_ffi_log_thread_delivers_queued_logs);
 ML_REGISTER_TEST(PitchDetectorFfiTest, ApiIsNoexcept, test_ffi_api_is_noexcept);
 
 #undef ML_REGISTER_TEST
 #undef ML_ASSERT_NEAR
 #undef ML_ASSERT_TRUE
-int main() {
-    run_test("yin: detects A4 sine",                test_yin_sine_a4);
-    run_test("yin: detects low-E guitar (82 Hz)",   test_yin_sine_e2);
-    run_test("yin: detects C5 (523 Hz)",            test_yin_sine_c5);
-    run_test("yin: silence returns -1",             test_yin_silence_returns_no_pitch);
-    run_test("yin: low amplitude returns -1",       test_yin_low_amplitude_returns_no_pitch);
-    run_test("yin: NaN input returns -1",           test_yin_nan_input_returns_no_pitch);
-    run_test("yin: no realloc with pre-alloc ws",   test_yin_workspace_no_reallocation);
-    run_test("yin: keeps caller workspace size",    test_yin_workspace_size_is_not_changed);
-    run_test("yin: handles non-SIMD-multiple frame", test_yin_non_simd_multiple_frame_size);
-    run_test("yin: stable on SIMD-aligned frame",   test_yin_simd_aligned_frame_repeatability);
-    run_test("yin: supports backend override",       test_yin_manual_backend_selection);
-    run_test("pd:  A4 MIDI=69 note_name=A4",        test_pd_a4_midi_and_note_name);
-    run_test("pd:  C4 (middle C)",                  test_pd_c4_note);
-    run_test("pd:  silence is not pitched",         test_pd_silence_not_pitched);
-    run_test("pd:  NaN input is not pitched",       test_pd_nan_input_not_pitched);
-    run_test("pd:  incremental block feeding",      test_pd_incremental_blocks);
-    run_test("pd:  reset clears state",             test_pd_reset_clears_state);
-    run_test("pd:  throws on bad sample_rate",      test_pd_invalid_sample_rate_throws);
-    run_test("pd:  throws on bad frame_size",       test_pd_invalid_frame_size_throws);
-    run_test("pd:  supports A4=432 reference",      test_pd_reference_pitch_a4_432);
-    run_test("pd:  accepts reference pitch boundaries", test_pd_reference_pitch_boundaries);
-    run_test("ffi: A4 process bridge",              test_ffi_process_a4);
-    run_test("ffi: set reference pitch",            test_ffi_set_reference_pitch);
-    run_test("ffi: process null handle is safe",    test_ffi_process_null_handle);
-    run_test("ffi: process null samples is safe",   test_ffi_process_null_samples);
-    run_test("ffi: process zero num_samples safe",  test_ffi_process_zero_num_samples);
-    run_test("pd:  hop-size skips redundant processing", test_pd_hop_size_skips_processing);
-    run_test("pd:  preserves hop remainder across calls", test_pd_preserves_hop_remainder_between_calls);
-    run_test("ffi: create invalid sample_rate returns null", test_ffi_create_invalid_sample_rate_returns_null);
-    run_test("ffi: create invalid frame_size returns null",  test_ffi_create_invalid_frame_size_returns_null);
-    run_test("ffi: set_reference_pitch out-of-range returns 0", test_ffi_set_reference_pitch_invalid_returns_zero);
-    run_test("ffi: create invalid threshold returns null", test_ffi_create_invalid_threshold_returns_null);
-    run_test("ffi: process excessive num_samples safe", test_ffi_process_excessive_num_samples_returns_zero);
-    run_test("ffi: log callback receives error logs", test_ffi_log_callback_receives_error_logs);
-    run_test("ffi: log callback supports trace level", test_ffi_log_callback_supports_trace_level);
-    run_test("ffi: C API functions are noexcept", test_ffi_api_is_noexcept);
-
-
-    std::printf("\n%d passed, %d failed\n", g_passed, g_failed);
-    return g_failed == 0 ? 0 : 1;
-}
@@ -0,0 +1,217 @@
+/**
+ * Unit tests for incremental practice statistics.
+ */
+
+#include "practice_stats.h"
+#include "pitch_detector_ffi.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::PitchDetector;
+using music_life::PracticeStats;
+
+namespace {
+
+constexpr int    kSampleRate = 48000;
+constexpr int    kHop = 256;
+constexpr double kPi = 3.14159265358979323846;
+
+// Result for an absolute pitch in cents (midi_note * 100 + offset).
+PitchDetector::Result at_cents(double pitch_cents, float probability = 0.95f) {
+    PitchDetector::Result r{};
+    const int midi = static_cast<int>(std::lround(pitch_cents / 100.0));
+    r.pitched      = true;
+    r.frequency    = static_cast<float>(440.0 * std::pow(2.0, (pitch_cents / 100.0 - 69.0) / 12.0));
+    r.probability  = probability;
+    r.midi_note    = midi;
+    r.cents_offset = static_cast<float>(pitch_cents - midi * 100.0);
+    return r;
+}
+
+PitchDetector::Result silence() {
+    PitchDetector::Result r{};
+    return r;
+}
+
+struct Feed {
+    PracticeStats& stats;
+    int64_t clock = 0;
+
+    double seconds() const { return static_cast<double>(clock) / kSampleRate; }
+
+    void push(const PitchDetector::Result& r, int hops = 1) {
+        for (int i = 0; i < hops; ++i) {
+            clock += kHop;
+            stats.push(r, clock);
+        }
+    }
+};
+
+const PracticeStats::NoteStats* find_note(const PracticeStats::Summary& summary, int midi) {
+    for (int i = 0; i < summary.note_count; ++i) {
+        if (summary.notes[i].midi_note == midi) return &summary.notes[i];
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(PracticeStatsTest, RejectsInvalidConfig) {
+    EXPECT_THROW(PracticeStats(0), std::invalid_argument);
+    PracticeStats::Config config;
+    config.min_probability = 1.5f;
+    EXPECT_THROW(PracticeStats(kSampleRate, config), std::invalid_argument);
+    config = PracticeStats::Config{};
+    config.in_tune_cents = 0.0f;
+    EXPECT_THROW(PracticeStats(kSampleRate, config), std::invalid_argument);
+    config = PracticeStats::Config{};
+    config.max_vibrato_hz = config.min_vibrato_hz;
+    EXPECT_THROW(PracticeStats(kSampleRate, config), std::invalid_argument);
+}
+
+TEST(PracticeStatsTest, IntonationMomentsAndHistogram) {
+    PracticeStats stats(kSampleRate);
+    Feed feed{stats};
+    // A4 alternating +3 / +7 cents, then 20 cents flat of C5.
+    for (int i = 0; i < 100; ++i) {
+        feed.push(at_cents(6900.0 + 3.0));
+        feed.push(at_cents(6900.0 + 7.0));
+    }
+    feed.push(silence(), 5);
+    feed.push(at_cents(7200.0 - 20.0), 50);
+    feed.push(at_cents(7200.0, 0.3f), 20);  // Unconfident: ignored
+
+    auto summary = std::make_unique<PracticeStats::Summary>();
+    stats.summarize(*summary);
+    EXPECT_EQ(summary->hops, 275u);
+    EXPECT_NEAR(summary->total_seconds, feed.seconds() - static_cast<double>(kHop) / kSampleRate, 1e-4);
+    ASSERT_EQ(summary->note_count, 2);
+
+    const PracticeStats::NoteStats* a4 = find_note(*summary, 69);
+    ASSERT_NE(a4, nullptr);
+    EXPECT_EQ(a4->hops, 200u);
+    EXPECT_NEAR(a4->mean_cents, 5.0f, 1e-4f);
+    EXPECT_NEAR(a4->stddev_cents, 2.0f, 1e-4f);
+    EXPECT_FLOAT_EQ(a4->in_tune_ratio, 1.0f);
+    EXPECT_EQ(a4->histogram[10], 100u);  // [0, 5)
+    EXPECT_EQ(a4->histogram[11], 100u);  // [5, 10)
+    EXPECT_NEAR(a4->seconds, 199.0 * kHop / kSampleRate, 1e-4);  // The first hop has no duration yet
+
+    const PracticeStats::NoteStats* c5 = find_note(*summary, 72);
+    ASSERT_NE(c5, nullptr);
+    EXPECT_EQ(c5->hops, 50u);
+    EXPECT_NEAR(c5->mean_cents, -20.0f, 1e-4f);
+    EXPECT_FLOAT_EQ(c5->in_tune_ratio, 0.0f);
+    EXPECT_EQ(c5->histogram[6], 50u);    // [-20, -15)
+
+    EXPECT_EQ(summary->overall.midi_note, -1);
+    EXPECT_EQ(summary->overall.hops, 250u);
+    EXPECT_NEAR(summary->overall.mean_cents, (200.0f * 5.0f - 50.0f * 20.0f) / 250.0f, 1e-3f);
+    EXPECT_EQ(summary->overall.vibrato_cycles, 0u);
+}
+
+TEST(PracticeStatsTest, MeasuresVibratoAcrossSemitoneBoundary) {
+    PracticeStats stats(kSampleRate);
+    Feed feed{stats};
+    // 5.5 Hz, 30 cents deep, centred 40 cents sharp of C4: the peaks
+    // report C#4, but it is one sustained tone.
+    const int hops = 3 * kSampleRate / kHop;
+    for (int i = 0; i < hops; ++i) {
+        const double t = static_cast<double>(i) * kHop / kSampleRate;
+        feed.push(at_cents(6040.0 + 30.0 * std::sin(2.0 * kPi * 5.5 * t)));
+    }
+
+    auto summary = std::make_unique<PracticeStats::Summary>();
+    stats.summarize(*summary);
+    ASSERT_TRUE(stats.in_run());
+    EXPECT_EQ(summary->note_count, 2);
+    EXPECT_GE(summary->overall.vibrato_cycles, 14u);
+    EXPECT_NEAR(summary->overall.vibrato_rate_hz, 5.5f, 0.2f);
+    EXPECT_NEAR(summary->overall.vibrato_depth_cents, 30.0f, 4.0f);
+    EXPECT_NEAR(summary->overall.stability_cents, 30.0f / std::sqrt(2.0f), 4.0f);
+    EXPECT_NEAR(summary->overall.longest_sustain_seconds, 3.0f, 0.05f);
+}
+
+TEST(PracticeStatsTest, SustainStabilityAndRuns) {
+    PracticeStats stats(kSampleRate);
+    Feed feed{stats};
+    const int second = kSampleRate / kHop;
+    feed.push(at_cents(5500.0), second);        // 1 s of G3
+    feed.push(silence(), 10);
+    feed.push(at_cents(5500.0 + 2.0), 2 * second);  // 2 s of G3
+    feed.push(at_cents(5700.0), second / 2);    // Jump to A3: new run
+
+    auto summary = std::make_unique<PracticeStats::Summary>();
+    stats.summarize(*summary);
+    const PracticeStats::NoteStats* g3 = find_note(*summary, 55);
+    ASSERT_NE(g3, nullptr);
+    EXPECT_NEAR(g3->longest_sustain_seconds, 2.0f, 0.02f);
+    EXPECT_LT(g3->stability_cents, 0.5f);
+    EXPECT_EQ(g3->vibrato_cycles, 0u);
+    const PracticeStats::NoteStats* a3 = find_note(*summary, 57);
+    ASSERT_NE(a3, nullptr);
+    EXPECT_NEAR(a3->longest_sustain_seconds, 0.5f, 0.02f);  // Run still in progress
+
+    // A gap in the sample clock ends the run and is not counted as time.
+    const float before = summary->total_seconds;
+    feed.clock += kSampleRate;
+    feed.push(at_cents(5700.0), 1);
+    stats.summarize(*summary);
+    EXPECT_FLOAT_EQ(summary->total_seconds, before);
+    EXPECT_NEAR(find_note(*summary, 57)->longest_sustain_seconds, 0.5f, 0.02f);
+}
+
+TEST(PracticeStatsTest, ResetStartsNewSession) {
+    PracticeStats stats(kSampleRate);
+    Feed feed{stats};
+    feed.push(at_cents(6900.0), 50);
+    stats.reset();
+    feed.push(at_cents(6000.0), 10);
+
+    auto summary = std::make_unique<PracticeStats::Summary>();
+    stats.summarize(*summary);
+    EXPECT_EQ(summary->hops, 10u);
+    ASSERT_EQ(summary->note_count, 1);
+    EXPECT_EQ(summary->notes[0].midi_note, 60);
+}
+
+TEST(PracticeStatsFfiTest, ProcessBlockPublishesWhenPlayingStops) {
+    constexpr float kTwoPi = 6.28318530717958647692f;
+
+    MLPitchDetectorHandle* handle = ml_pitch_detector_create(kSampleRate, 2048, 0.10f);
+    ASSERT_NE(handle, nullptr);
+    MLPracticeStats stats{};
+    MLPracticeNoteStats notes[4];
+    EXPECT_EQ(ml_pitch_detector_read_practice_stats(handle, &stats, notes, 4), -1);
+    EXPECT_EQ(ml_pitch_detector_enable_practice_stats(handle, 2.0f, 10.0f), 0);
+    ASSERT_EQ(ml_pitch_detector_enable_practice_stats(handle, 0.8f, 10.0f), 1);
+    EXPECT_EQ(ml_pitch_detector_read_practice_stats(handle, &stats, notes, 4), 0);
+
+    // 1 s of A4, then 0.2 s of silence: the tone ending publishes it all.
+    std::vector<float> audio(static_cast<size_t>(kSampleRate * 6 / 5), 0.0f);
+    for (size_t i = 0; i < static_cast<size_t>(kSampleRate); ++i) {
+        audio[i] = 0.5f * std::sin(kTwoPi * 440.0f * static_cast<float>(i) / kSampleRate);
+    }
+    MLPitchBlockResults results{64, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    for (size_t pos = 0; pos < audio.size(); pos += 4096) {
+        const int n = static_cast<int>(std::min<size_t>(4096, audio.size() - pos));
+        ASSERT_GE(ml_pitch_detector_process_block(handle, audio.data() + pos, n, &results), 0);
+    }
+
+    ASSERT_EQ(ml_pitch_detector_read_practice_stats(handle, &stats, notes, 4), 1);
+    EXPECT_EQ(stats.note_count, 1);
+    EXPECT_EQ(notes[0].midi_note, 69);
+    EXPECT_NEAR(notes[0].mean_cents, 0.0f, 1.0f);
+    EXPECT_FLOAT_EQ(notes[0].in_tune_ratio, 1.0f);
+    EXPECT_NEAR(notes[0].longest_sustain_seconds, 1.0f - 2048.0f / kSampleRate, 0.05f);
+    EXPECT_EQ(stats.overall.hops, notes[0].hops);
+
+    ml_pitch_detector_reset_practice_stats(handle);
+    ml_pitch_detector_destroy(handle);
+}
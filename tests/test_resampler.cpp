@@ -0,0 +1,103 @@
+/**
+ * Unit tests for the polyphase resampler.
+ */
+
+#include "resampler.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::Resampler;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::vector<float> sine(double freq, double rate, int n) {
+    std::vector<float> out(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) out[static_cast<size_t>(i)] = static_cast<float>(std::sin(2.0 * kPi * freq * i / rate));
+    return out;
+}
+
+std::vector<float> run(Resampler& resampler, const std::vector<float>& in, int block) {
+    std::vector<float> out;
+    std::vector<float> scratch(static_cast<size_t>(resampler.max_output(block)));
+    for (size_t pos = 0; pos < in.size(); pos += static_cast<size_t>(block)) {
+        const int n = static_cast<int>(std::min<size_t>(static_cast<size_t>(block), in.size() - pos));
+        const int produced = resampler.process(in.data() + pos, n, scratch.data());
+        EXPECT_LE(produced, resampler.max_output(n));
+        out.insert(out.end(), scratch.begin(), scratch.begin() + produced);
+    }
+    return out;
+}
+
+float rms(const std::vector<float>& x, size_t skip) {
+    double sum = 0.0;
+    for (size_t i = skip; i < x.size(); ++i) sum += static_cast<double>(x[i]) * x[i];
+    return static_cast<float>(std::sqrt(sum / static_cast<double>(x.size() - skip)));
+}
+
+}  // namespace
+
+TEST(ResamplerTest, RejectsInvalidFactors) {
+    EXPECT_THROW(Resampler(0, 2), std::invalid_argument);
+    EXPECT_THROW(Resampler(1, 17), std::invalid_argument);
+    EXPECT_THROW(Resampler(1, 2, -1), std::invalid_argument);
+}
+
+TEST(ResamplerTest, OutputCountMatchesRatio) {
+    for (int down : {2, 3, 4}) {
+        Resampler resampler(1, down);
+        const std::vector<float> in(48000, 0.0f);
+        EXPECT_EQ(run(resampler, in, 333).size(), static_cast<size_t>(48000 / down));
+    }
+    Resampler rational(2, 3);
+    const std::vector<float> in(48000, 0.0f);
+    EXPECT_EQ(run(rational, in, 100).size(), 32000u);
+}
+
+TEST(ResamplerTest, PassesInbandToneAtUnitGain) {
+    Resampler resampler(1, 4);
+    const std::vector<float> out = run(resampler, sine(1000.0, 48000.0, 48000), 512);
+    EXPECT_NEAR(rms(out, 100), std::sqrt(0.5f), 0.01f);
+
+    // The decimated tone is the same sine at the lower rate, delayed by the filter.
+    // Output i lands on input 4 * i + 3.
+    for (size_t i = 100; i < 200; ++i) {
+        const double t = 4.0 * static_cast<double>(i) + 3.0 - resampler.group_delay();
+        EXPECT_NEAR(out[i], std::sin(2.0 * kPi * 1000.0 * t / 48000.0), 0.01);
+    }
+}
+
+TEST(ResamplerTest, RejectsAliases) {
+    // 9 kHz would alias to 3 kHz at 12 kHz; it must be attenuated by > 60 dB.
+    Resampler resampler(1, 4);
+    const std::vector<float> out = run(resampler, sine(9000.0, 48000.0, 48000), 777);
+    EXPECT_LT(rms(out, 100), std::sqrt(0.5f) * 1e-3f);
+}
+
+TEST(ResamplerTest, BlockSizeDoesNotChangeOutput) {
+    const std::vector<float> in = sine(440.0, 44100.0, 10000);
+    Resampler a(2, 3);
+    Resampler b(2, 3);
+    const std::vector<float> one = run(a, in, 10000);
+    const std::vector<float> many = run(b, in, 7);
+    ASSERT_EQ(one.size(), many.size());
+    for (size_t i = 0; i < one.size(); ++i) EXPECT_FLOAT_EQ(one[i], many[i]);
+}
+
+TEST(ResamplerTest, InputsUntilNextOutput) {
+    Resampler resampler(1, 3);
+    float out[4];
+    const float x[3] = {1.0f, 1.0f, 1.0f};
+    EXPECT_EQ(resampler.inputs_until_next_output(), 3);
+    EXPECT_EQ(resampler.process(x, 2, out), 0);
+    EXPECT_EQ(resampler.inputs_until_next_output(), 1);
+    EXPECT_EQ(resampler.process(x, 3, out), 1);
+    EXPECT_EQ(resampler.inputs_until_next_output(), 1);
+    resampler.reset();
+    EXPECT_EQ(resampler.inputs_until_next_output(), 3);
+}
@@ -0,0 +1,133 @@
+/**
+ * Unit tests for the targeted strobe tuner.
+ */
+
+#include "strobe_tuner.h"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::StrobeTuner;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Harmonic tone with 1/k partials, normalised to a peak near 0.5.
+std::vector<float> tone(double freq, int sample_rate, int n, int harmonics = 4) {
+    std::vector<float> out(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        double value = 0.0;
+        for (int k = 1; k <= harmonics; ++k) value += std::sin(2.0 * kPi * k * freq * i / sample_rate + k) / k;
+        out[static_cast<size_t>(i)] = static_cast<float>(0.25 * value);
+    }
+    return out;
+}
+
+double cents(double f, double reference) {
+    return 1200.0 * std::log2(f / reference);
+}
+
+std::vector<StrobeTuner::Estimate> run(StrobeTuner& tuner, const std::vector<float>& audio, int block) {
+    std::vector<StrobeTuner::Estimate> all;
+    std::vector<StrobeTuner::Estimate> out(64);
+    for (size_t pos = 0; pos < audio.size(); pos += static_cast<size_t>(block)) {
+        const int n = static_cast<int>(std::min<size_t>(static_cast<size_t>(block), audio.size() - pos));
+        const int hops = tuner.process(audio.data() + pos, n, out.data(), 64);
+        all.insert(all.end(), out.begin(), out.begin() + std::min(hops, 64));
+    }
+    return all;
+}
+
+}  // namespace
+
+TEST(StrobeTunerTest, RejectsInvalidArguments) {
+    EXPECT_THROW(StrobeTuner(0), std::invalid_argument);
+    EXPECT_THROW(StrobeTuner(48000, -1), std::invalid_argument);
+    StrobeTuner tuner(48000);
+    EXPECT_THROW(tuner.retune(0.0f), std::invalid_argument);
+    EXPECT_THROW(tuner.retune(24000.0f), std::invalid_argument);
+    EXPECT_THROW(tuner.retune(std::nanf("")), std::invalid_argument);
+}
+
+TEST(StrobeTunerTest, UpdatesEveryShortHop) {
+    StrobeTuner tuner(48000);
+    EXPECT_EQ(tuner.hop_size(), 128);
+    const std::vector<float> audio(48000, 0.0f);
+    EXPECT_EQ(tuner.process(audio.data(), 48000, nullptr, 0), 0);  // No target yet
+    tuner.retune(440.0f);
+    EXPECT_EQ(run(tuner, audio, 480).size(), 375u);
+    EXPECT_FALSE(tuner.latest().pitched);
+}
+
+TEST(StrobeTunerTest, ResolvesSmallOffsets) {
+    // Each played pitch must be measured to within 0.1 cent once settled.
+    const int sr = 48000;
+    const struct { double target; double offset_cents; } cases[] = {
+        {82.41, -20.0}, {110.0, 3.37}, {329.63, 45.0}, {440.0, -0.05}, {1318.5, 12.0},
+    };
+    for (const auto& c : cases) {
+        StrobeTuner tuner(sr);
+        tuner.retune(static_cast<float>(c.target));
+        const double played = c.target * std::pow(2.0, c.offset_cents / 1200.0);
+        const auto estimates = run(tuner, tone(played, sr, sr * 2), 256);
+        ASSERT_FALSE(estimates.empty());
+        int checked = 0;
+        for (size_t i = estimates.size() / 2; i < estimates.size(); ++i) {
+            ASSERT_TRUE(estimates[i].pitched) << c.target;
+            EXPECT_NEAR(cents(estimates[i].frequency, played), 0.0, 0.1) << c.target;
+            EXPECT_GT(estimates[i].probability, 0.9f);
+            ++checked;
+        }
+        EXPECT_GT(checked, 300);
+    }
+}
+
+TEST(StrobeTunerTest, PhaseTurnsAtTheOffset) {
+    // 0.5 Hz sharp: the strobe turns half a cycle per second.
+    const int sr = 48000;
+    StrobeTuner tuner(sr);
+    tuner.retune(220.0f);
+    const auto estimates = run(tuner, tone(220.5, sr, sr * 2), 128);
+    const size_t a = estimates.size() / 2;
+    const size_t b = a + 75;  // 0.2 s later
+    double turned = estimates[b].phase - estimates[a].phase;
+    turned -= std::floor(turned);
+    EXPECT_NEAR(turned, 0.1, 0.002);
+}
+
+TEST(StrobeTunerTest, RejectsNoiseAndDistantNotes) {
+    const int sr = 48000;
+    StrobeTuner tuner(sr);
+    tuner.retune(440.0f);
+
+    std::vector<float> noise(sr);
+    uint32_t state = 12345u;
+    for (float& v : noise) {
+        state = state * 1664525u + 1013904223u;
+        v = static_cast<float>(state >> 8) / 16777216.0f - 0.5f;
+    }
+    for (const auto& e : run(tuner, noise, 512)) EXPECT_FALSE(e.pitched);
+
+    // Three semitones away is outside the tuner's window.
+    tuner.retune(440.0f);
+    const auto far = run(tuner, tone(523.25, sr, sr), 512);
+    EXPECT_FALSE(far.back().pitched);
+}
+
+TEST(StrobeTunerTest, BlockSizeDoesNotChangeEstimates) {
+    const int sr = 44100;
+    const std::vector<float> audio = tone(196.5, sr, sr);
+    StrobeTuner a(sr);
+    StrobeTuner b(sr);
+    a.retune(196.0f);
+    b.retune(196.0f);
+    const auto one = run(a, audio, 4096);
+    const auto many = run(b, audio, 37);
+    ASSERT_EQ(one.size(), many.size());
+    for (size_t i = 0; i < one.size(); ++i) EXPECT_FLOAT_EQ(one[i].frequency, many[i].frequency);
+}
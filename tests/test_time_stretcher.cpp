@@ -0,0 +1,214 @@
+/**
+ * Unit tests for the WSOLA time-stretch engine.
+ */
+
+#include "time_stretcher.h"
+#include "pitch_detector_ffi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::TimeStretcher;
+
+namespace {
+
+constexpr int    kSampleRate = 48000;
+constexpr double kTwoPi = 6.28318530717958647692;
+
+// Interleaved sines, one frequency per channel, amplitude 0.5.
+std::vector<float> make_tones(const std::vector<double>& freqs, int frames) {
+    const size_t channels = freqs.size();
+    std::vector<float> out(static_cast<size_t>(frames) * channels);
+    for (int i = 0; i < frames; ++i) {
+        for (size_t c = 0; c < channels; ++c) {
+            out[static_cast<size_t>(i) * channels + c] =
+                static_cast<float>(0.5 * std::sin(kTwoPi * freqs[c] * i / kSampleRate));
+        }
+    }
+    return out;
+}
+
+// Run the whole input through, writing and reading in small blocks as an
+// audio callback would, then drain the tail.
+std::vector<float> stretch(TimeStretcher& stretcher, const std::vector<float>& in, int block = 480) {
+    const int channels = stretcher.channels();
+    const int frames = static_cast<int>(in.size()) / channels;
+    std::vector<float> out;
+    std::vector<float> chunk(static_cast<size_t>(block * channels));
+    int written = 0;
+    while (!stretcher.drained()) {
+        const int n = stretcher.read(chunk.data(), block);
+        out.insert(out.end(), chunk.begin(), chunk.begin() + n * channels);
+        if (n < block) {
+            if (written < frames) {
+                written += stretcher.write(in.data() + static_cast<size_t>(written) * channels,
+                                           std::min(frames - written, block));
+            } else {
+                stretcher.finish();
+            }
+        }
+    }
+    return out;
+}
+
+// Mean frequency of one channel over [begin, end) from its rising zero
+// crossings, located to a fraction of a sample.
+double zero_crossing_hz(const std::vector<float>& x, int channels, int channel, int begin, int end) {
+    double first = -1.0, last = -1.0;
+    int crossings = 0;
+    for (int i = begin + 1; i < end; ++i) {
+        const float a = x[static_cast<size_t>(i - 1) * channels + channel];
+        const float b = x[static_cast<size_t>(i) * channels + channel];
+        if (a < 0.0f && b >= 0.0f) {
+            const double t = i - 1 + a / (a - b);
+            if (first < 0.0) first = t;
+            last = t;
+            ++crossings;
+        }
+    }
+    return crossings > 1 ? (crossings - 1) * kSampleRate / (last - first) : 0.0;
+}
+
+}  // namespace
+
+TEST(TimeStretcherTest, RejectsInvalidArguments) {
+    EXPECT_THROW(TimeStretcher(0, 1), std::invalid_argument);
+    EXPECT_THROW(TimeStretcher(kSampleRate, 0), std::invalid_argument);
+    EXPECT_THROW(TimeStretcher(kSampleRate, TimeStretcher::kMaxChannels + 1), std::invalid_argument);
+    TimeStretcher stretcher(kSampleRate, 2);
+    EXPECT_EQ(stretcher.frame_size(), 2048);
+    EXPECT_THROW(stretcher.set_speed(0.1f), std::invalid_argument);
+    EXPECT_THROW(stretcher.set_speed(std::nanf("")), std::invalid_argument);
+    EXPECT_FLOAT_EQ(stretcher.speed(), 1.0f);
+}
+
+TEST(TimeStretcherTest, UnitySpeedPassesInputThrough) {
+    TimeStretcher stretcher(kSampleRate, 1);
+    std::vector<float> in(static_cast<size_t>(kSampleRate));
+    unsigned seed = 1;
+    for (size_t i = 0; i < in.size(); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        const float noise = static_cast<float>((seed >> 16) & 0x7FFF) / 32768.0f - 0.5f;
+        in[i] = 0.3f * static_cast<float>(std::sin(kTwoPi * 220.0 * i / kSampleRate)) + 0.2f * noise;
+    }
+    const std::vector<float> out = stretch(stretcher, in);
+    const size_t latency = static_cast<size_t>(stretcher.latency());
+    ASSERT_GE(out.size(), in.size() + latency);
+    float max_error = 0.0f;
+    for (size_t i = 0; i < in.size(); ++i) max_error = std::max(max_error, std::fabs(out[i + latency] - in[i]));
+    EXPECT_LT(max_error, 1e-4f);
+}
+
+TEST(TimeStretcherTest, PreservesPitchAndScalesDuration) {
+    for (const float speed : {0.5f, 0.75f, 1.5f, 2.0f}) {
+        TimeStretcher stretcher(kSampleRate, 1);
+        stretcher.set_speed(speed);
+        const int frames = 2 * kSampleRate;
+        const std::vector<float> out = stretch(stretcher, make_tones({440.0}, frames));
+
+        // Draining the tail plays about one more hop of (silent) input.
+        const double expected = stretcher.latency() + (frames + stretcher.latency()) / speed;
+        EXPECT_NEAR(static_cast<double>(out.size()), expected, stretcher.latency()) << "speed " << speed;
+        const int middle = static_cast<int>(out.size()) / 2;
+        EXPECT_NEAR(zero_crossing_hz(out, 1, 0, middle - kSampleRate / 4, middle + kSampleRate / 4), 440.0, 1.0)
+            << "speed " << speed;
+    }
+}
+
+TEST(TimeStretcherTest, StereoKeepsChannelsApart) {
+    TimeStretcher stretcher(kSampleRate, 2);
+    stretcher.set_speed(0.8f);
+    const std::vector<float> out = stretch(stretcher, make_tones({440.0, 660.0}, kSampleRate));
+    const int frames = static_cast<int>(out.size()) / 2;
+    EXPECT_NEAR(zero_crossing_hz(out, 2, 0, frames / 4, 3 * frames / 4), 440.0, 1.0);
+    EXPECT_NEAR(zero_crossing_hz(out, 2, 1, frames / 4, 3 * frames / 4), 660.0, 1.0);
+}
+
+TEST(TimeStretcherTest, SpeedSweepsWithoutDiscontinuities) {
+    TimeStretcher stretcher(kSampleRate, 1);
+    const std::vector<float> in = make_tones({440.0}, 3 * kSampleRate);
+    std::vector<float> out;
+    std::vector<float> chunk(480);
+    int written = 0;
+    while (out.size() < static_cast<size_t>(4 * kSampleRate) && written < static_cast<int>(in.size())) {
+        // Glide from half to double speed and back, once per output second.
+        const double t = static_cast<double>(out.size()) / kSampleRate;
+        stretcher.set_speed(static_cast<float>(std::pow(2.0, std::sin(kTwoPi * t))));
+        const int n = stretcher.read(chunk.data(), 480);
+        out.insert(out.end(), chunk.begin(), chunk.begin() + n);
+        if (n < 480) written += stretcher.write(in.data() + written, std::min(480, static_cast<int>(in.size()) - written));
+    }
+
+    // A 0.5-amplitude 440 Hz sine moves at most 0.029 per sample.
+    float max_step = 0.0f;
+    for (size_t i = static_cast<size_t>(stretcher.frame_size()); i + 1 < out.size(); ++i) {
+        max_step = std::max(max_step, std::fabs(out[i + 1] - out[i]));
+    }
+    EXPECT_LT(max_step, 0.04f);
+    EXPECT_NEAR(zero_crossing_hz(out, 1, 0, kSampleRate / 2, static_cast<int>(out.size())), 440.0, 2.0);
+}
+
+TEST(TimeStretcherTest, ResetStartsFreshStream) {
+    TimeStretcher stretcher(kSampleRate, 1);
+    const std::vector<float> in = make_tones({440.0}, kSampleRate / 2);
+    stretch(stretcher, in);
+    ASSERT_TRUE(stretcher.drained());
+    stretcher.reset();
+    EXPECT_FALSE(stretcher.drained());
+    const std::vector<float> out = stretch(stretcher, in);
+    EXPECT_GE(out.size(), in.size() + static_cast<size_t>(stretcher.latency()));
+    EXPECT_FLOAT_EQ(out[0], 0.0f);
+}
+
+TEST(TimeStretcherTest, OfflineExportKeepsLengthAndPitch) {
+    // Large blocks as an offline export uses; its speed is tracked by
+    // ml_bench (time_stretch_export), not here.
+    TimeStretcher stretcher(kSampleRate, 2);
+    stretcher.set_speed(0.5f);
+    const int frames = 10 * kSampleRate;
+    const std::vector<float> in = make_tones({330.0, 495.0}, frames);
+    const std::vector<float> out = stretch(stretcher, in, 8192);
+    EXPECT_NEAR(static_cast<double>(out.size()) / 2, 2.0 * frames, 4.0 * stretcher.latency());
+    const int stretched = static_cast<int>(out.size() / 2);
+    EXPECT_NEAR(zero_crossing_hz(out, 2, 0, stretched / 4, 3 * stretched / 4), 330.0, 1.0);
+    EXPECT_NEAR(zero_crossing_hz(out, 2, 1, stretched / 4, 3 * stretched / 4), 495.0, 1.0);
+}
+
+TEST(TimeStretcherFfiTest, StreamsThroughHandle) {
+    EXPECT_EQ(ml_time_stretch_create(kSampleRate, 0), nullptr);
+    MLTimeStretchHandle* handle = ml_time_stretch_create(kSampleRate, 2);
+    ASSERT_NE(handle, nullptr);
+    EXPECT_EQ(ml_time_stretch_set_speed(handle, 8.0f), 0);
+    ASSERT_EQ(ml_time_stretch_set_speed(handle, 0.5f), 1);
+    EXPECT_EQ(ml_time_stretch_write(handle, nullptr, 16), -1);
+    EXPECT_EQ(ml_time_stretch_read(handle, nullptr, 16), -1);
+    EXPECT_EQ(ml_time_stretch_latency(handle), 1024);
+
+    const std::vector<float> in = make_tones({440.0, 440.0}, kSampleRate / 2);
+    std::vector<float> out(960 * 2);
+    int written = 0;
+    int produced = 0;
+    while (!ml_time_stretch_drained(handle)) {
+        const int n = ml_time_stretch_read(handle, out.data(), 960);
+        ASSERT_GE(n, 0);
+        produced += n;
+        if (n == 960) continue;
+        if (written == kSampleRate / 2) {
+            ml_time_stretch_finish(handle);
+            continue;
+        }
+        const int space = ml_time_stretch_input_space(handle);
+        ASSERT_GT(space, 0);
+        written += ml_time_stretch_write(handle, in.data() + written * 2, std::min(space, kSampleRate / 2 - written));
+    }
+    EXPECT_EQ(ml_time_stretch_input_space(handle), 0);
+    EXPECT_NEAR(produced, 1024 + (kSampleRate / 2 + 1024) * 2, 1024);
+
+    ml_time_stretch_reset(handle);
+    EXPECT_GT(ml_time_stretch_write(handle, in.data(), 480), 0);
+    ml_time_stretch_destroy(handle);
+}
@@ -0,0 +1,98 @@
+/**
+ * Unit tests for the per-stage trace buffers and their Chrome JSON export.
+ */
+
+#include "pitch_detector.h"
+#include "pitch_detector_ffi.h"
+#include "trace.h"
+
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+int count_of(const std::string& text, const std::string& needle) {
+    int count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + needle.size())) {
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+TEST(TraceTest, RecordedEventsExportAsChromeJson) {
+    music_life::trace::clear();
+    std::thread([] {
+        music_life::trace::register_thread("replay \"rig\"");
+        music_life::trace::record("test.stage", 2000, 3500);
+    }).join();
+
+    const std::string json = music_life::trace::chrome_json();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"name\":\"replay \\\"rig\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"test.stage\",\"cat\":\"music_life\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":2.000,\"dur\":1.500}"), std::string::npos);
+
+    music_life::trace::clear();
+    EXPECT_EQ(music_life::trace::chrome_json().find("test.stage"), std::string::npos);
+}
+
+TEST(TraceTest, RingKeepsNewestEvents) {
+    music_life::trace::clear();
+    std::thread([] {
+        for (int i = 0; i < music_life::trace::kEventsPerThread + 100; ++i) {
+            music_life::trace::record(i <= 100 ? "test.old" : "test.new", 0, 1);
+        }
+    }).join();
+
+    const std::string json = music_life::trace::chrome_json();
+    EXPECT_EQ(count_of(json, "\"test.old\""), 0);
+    EXPECT_EQ(count_of(json, "\"test.new\""), music_life::trace::kEventsPerThread - 1);
+    music_life::trace::clear();
+}
+
+TEST(TraceTest, DetectorStagesFollowBuildFlag) {
+    music_life::trace::clear();
+    std::vector<float> buf(4096);
+    for (size_t i = 0; i < buf.size(); ++i) buf[i] = std::sin(2.0f * 3.14159265f * 440.0f * i / 44100.0f);
+    std::thread([&buf] {
+        music_life::PitchDetector detector(44100, 2048);
+        detector.process(buf.data(), static_cast<int>(buf.size()));
+    }).join();
+
+    const std::string json = music_life::trace::chrome_json();
+    const int expected = music_life::trace::enabled() ? 1 : 0;
+    EXPECT_EQ(count_of(json, "\"yin.difference.forward_fft\""), expected);
+    EXPECT_EQ(count_of(json, "\"yin.cmndf_threshold\""), expected);
+    EXPECT_EQ(count_of(json, "\"pitch.analyse\""), expected);
+    EXPECT_EQ(count_of(json, "\"pitch.ingest\""), expected);
+    music_life::trace::clear();
+}
+
+TEST(TraceTest, FfiSizesAndCopiesJson) {
+    EXPECT_EQ(ml_trace_enabled(), music_life::trace::enabled() ? 1 : 0);
+    EXPECT_EQ(ml_trace_write_json(nullptr, 16), -1);
+    ml_trace_clear();
+    std::thread([] {
+        ml_trace_register_thread("ffi");
+        music_life::trace::record("test.ffi", 0, 1000);
+    }).join();
+
+    const int length = ml_trace_write_json(nullptr, 0);
+    ASSERT_GT(length, 0);
+    std::vector<char> full(static_cast<size_t>(length) + 1);
+    EXPECT_EQ(ml_trace_write_json(full.data(), length + 1), length);
+    EXPECT_EQ(std::string(full.data()), music_life::trace::chrome_json());
+    EXPECT_NE(std::string(full.data()).find("\"test.ffi\""), std::string::npos);
+
+    char truncated[8];
+    EXPECT_EQ(ml_trace_write_json(truncated, sizeof(truncated)), length);
+    EXPECT_EQ(std::string(truncated), std::string(full.data(), 7));
+    ml_trace_clear();
+}
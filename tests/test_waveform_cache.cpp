@@ -0,0 +1,230 @@
+/**
+ * Unit tests for batch waveform thumbnails and their on-disk cache.
+ */
+
+#include "waveform_cache.h"
+#include "pitch_detector_ffi.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using music_life::WaveformBucket;
+using music_life::WaveformCache;
+using music_life::WaveformThumbnail;
+
+namespace {
+
+constexpr int    kSampleRate = 48000;
+constexpr double kTwoPi = 6.28318530717958647692;
+
+void put_u16(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back(static_cast<unsigned char>(v & 0xFF));
+    out.push_back(static_cast<unsigned char>((v >> 8) & 0xFF));
+}
+
+void put_u32(std::vector<unsigned char>& out, uint32_t v) {
+    put_u16(out, v & 0xFFFF);
+    put_u16(out, v >> 16);
+}
+
+// Interleaved float samples as a WAV file of 16 / 24-bit PCM or 32-bit float.
+void write_wav(const std::string& path, const std::vector<float>& samples, int channels, int bits) {
+    const bool is_float = bits == 32;
+    std::vector<unsigned char> data;
+    for (const float s : samples) {
+        if (is_float) {
+            uint32_t v = 0;
+            std::memcpy(&v, &s, sizeof(v));
+            put_u32(data, v);
+        } else {
+            const double scale = bits == 16 ? 32767.0 : 8388607.0;
+            const uint32_t v = static_cast<uint32_t>(static_cast<int32_t>(std::lround(s * scale)));
+            put_u16(data, v & 0xFFFF);
+            if (bits == 24) data.push_back(static_cast<unsigned char>((v >> 16) & 0xFF));
+        }
+    }
+
+    std::vector<unsigned char> file;
+    file.insert(file.end(), {'R', 'I', 'F', 'F'});
+    put_u32(file, static_cast<uint32_t>(36 + data.size()));
+    file.insert(file.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    put_u32(file, 16);
+    put_u16(file, is_float ? 3 : 1);
+    put_u16(file, static_cast<uint32_t>(channels));
+    put_u32(file, kSampleRate);
+    put_u32(file, static_cast<uint32_t>(kSampleRate * channels * bits / 8));
+    put_u16(file, static_cast<uint32_t>(channels * bits / 8));
+    put_u16(file, static_cast<uint32_t>(bits));
+    file.insert(file.end(), {'d', 'a', 't', 'a'});
+    put_u32(file, static_cast<uint32_t>(data.size()));
+    file.insert(file.end(), data.begin(), data.end());
+
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(out, nullptr);
+    std::fwrite(file.data(), 1, file.size(), out);
+    std::fclose(out);
+}
+
+// A 0.5-amplitude sine on the first channel for the first half, then silence.
+std::vector<float> half_tone(int frames, int channels, double amplitude = 0.5) {
+    std::vector<float> samples(static_cast<size_t>(frames) * channels, 0.0f);
+    for (int i = 0; i < frames / 2; ++i) {
+        samples[static_cast<size_t>(i) * channels] = static_cast<float>(amplitude * std::sin(kTwoPi * 440.0 * i / kSampleRate));
+    }
+    return samples;
+}
+
+class WaveformCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = std::filesystem::temp_directory_path() /
+                (std::string("ml_waveform_") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(root_); }
+
+    std::string path(const std::string& name) const { return (root_ / name).string(); }
+
+    std::filesystem::path root_;
+};
+
+}  // namespace
+
+TEST(WaveformThumbnailTest, BuildsPowerOfTwoLevels) {
+    const std::vector<float> samples = half_tone(10000, 1);
+    const WaveformThumbnail thumbnail = WaveformCache::build(samples.data(), 10000, 1, kSampleRate);
+    ASSERT_EQ(thumbnail.level0_buckets, WaveformThumbnail::kMaxBuckets);
+    ASSERT_EQ(thumbnail.levels(), 7);  // 4096 ... 64
+    EXPECT_EQ(thumbnail.level_size(6), WaveformThumbnail::kMinBuckets);
+    EXPECT_EQ(thumbnail.level(7), nullptr);
+
+    const WaveformBucket* coarse = thumbnail.level(6);
+    EXPECT_NEAR(coarse[0].max, 16383, 40);
+    EXPECT_NEAR(coarse[0].min, -16383, 40);
+    EXPECT_NEAR(coarse[0].rms, 16383 / std::sqrt(2.0), 300);
+    EXPECT_EQ(coarse[63].max, 0);
+    EXPECT_EQ(coarse[63].rms, 0);
+
+    EXPECT_EQ(WaveformCache::build(samples.data(), 100, 1, kSampleRate).level0_buckets, 64);
+    EXPECT_EQ(WaveformCache::build(samples.data(), 100, 1, kSampleRate).levels(), 1);
+    EXPECT_EQ(WaveformCache::build(nullptr, 0, 1, kSampleRate).levels(), 0);
+    EXPECT_THROW(WaveformCache::build(samples.data(), 100, 0, kSampleRate), std::invalid_argument);
+}
+
+TEST_F(WaveformCacheTest, GeneratesOnceThenReadsFromCache) {
+    const std::string wav = path("take.wav");
+    write_wav(wav, half_tone(kSampleRate, 2), 2, 16);
+    WaveformCache cache(path("cache"), 2);
+
+    std::vector<WaveformBucket> buckets(WaveformThumbnail::kMaxBuckets);
+    EXPECT_EQ(cache.read_level(wav, 256, buckets.data()), -1);
+    EXPECT_EQ(cache.generate_one(wav), WaveformCache::Status::Generated);
+    EXPECT_EQ(cache.generate_one(wav), WaveformCache::Status::Cached);
+
+    ASSERT_EQ(cache.read_level(wav, 300, buckets.data()), 256);
+    EXPECT_NEAR(buckets[10].max, 16383, 40);
+    EXPECT_EQ(buckets[200].max, 0);
+    EXPECT_EQ(cache.read_level(wav, 63, buckets.data()), 0);
+    EXPECT_EQ(cache.read_level(wav, 100000, buckets.data()), WaveformThumbnail::kMaxBuckets);
+
+    WaveformThumbnail loaded;
+    ASSERT_TRUE(cache.load(wav, loaded));
+    EXPECT_EQ(loaded.channels, 2);
+    EXPECT_EQ(loaded.frames, kSampleRate);
+    EXPECT_EQ(loaded.levels(), 7);
+}
+
+TEST_F(WaveformCacheTest, RegeneratesChangedRecording) {
+    const std::string wav = path("take.wav");
+    write_wav(wav, half_tone(kSampleRate, 1), 1, 16);
+    WaveformCache cache(path("cache"), 1);
+    ASSERT_EQ(cache.generate_one(wav), WaveformCache::Status::Generated);
+
+    // Same size, different content.
+    write_wav(wav, half_tone(kSampleRate, 1, 0.25), 1, 16);
+    std::vector<WaveformBucket> buckets(64);
+    EXPECT_EQ(cache.read_level(wav, 64, buckets.data()), -1);
+    ASSERT_EQ(cache.generate_one(wav), WaveformCache::Status::Generated);
+    ASSERT_EQ(cache.read_level(wav, 64, buckets.data()), 64);
+    EXPECT_NEAR(buckets[0].max, 8192, 40);
+}
+
+TEST_F(WaveformCacheTest, DecodesSampleFormats) {
+    const std::vector<float> samples = half_tone(20000, 1);
+    const WaveformThumbnail expected = WaveformCache::build(samples.data(), 20000, 1, kSampleRate);
+    WaveformCache cache(path("cache"), 1);
+    for (const int bits : {16, 24, 32}) {
+        const std::string wav = path("take" + std::to_string(bits) + ".wav");
+        write_wav(wav, samples, 1, bits);
+        ASSERT_EQ(cache.generate_one(wav), WaveformCache::Status::Generated) << bits;
+        WaveformThumbnail loaded;
+        ASSERT_TRUE(cache.load(wav, loaded));
+        ASSERT_EQ(loaded.buckets.size(), expected.buckets.size());
+        for (size_t i = 0; i < expected.buckets.size(); ++i) {
+            EXPECT_NEAR(loaded.buckets[i].max, expected.buckets[i].max, 2) << bits << " bucket " << i;
+            EXPECT_NEAR(loaded.buckets[i].rms, expected.buckets[i].rms, 2) << bits << " bucket " << i;
+        }
+    }
+}
+
+TEST_F(WaveformCacheTest, BatchReportsStatusPerPath) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 12; ++i) {
+        paths.push_back(path("take" + std::to_string(i) + ".wav"));
+        write_wav(paths.back(), half_tone(4096 * (i + 1), 1), 1, 16);
+    }
+    const std::string m4a = path("take.m4a");
+    std::FILE* out = std::fopen(m4a.c_str(), "wb");
+    ASSERT_NE(out, nullptr);
+    const char m4a_header[] = "\0\0\0\x20" "ftypM4A ";
+    std::fwrite(m4a_header, 1, sizeof(m4a_header) - 1, out);
+    std::fclose(out);
+    paths.push_back(m4a);
+    paths.push_back(path("missing.wav"));
+
+    WaveformCache cache(path("cache"), 4);
+    const std::vector<WaveformCache::Status> first = cache.generate(paths);
+    ASSERT_EQ(first.size(), paths.size());
+    for (int i = 0; i < 12; ++i) EXPECT_EQ(first[static_cast<size_t>(i)], WaveformCache::Status::Generated);
+    EXPECT_EQ(first[12], WaveformCache::Status::Unsupported);
+    EXPECT_EQ(first[13], WaveformCache::Status::IoError);
+
+    const std::vector<WaveformCache::Status> second = cache.generate(paths);
+    for (int i = 0; i < 12; ++i) EXPECT_EQ(second[static_cast<size_t>(i)], WaveformCache::Status::Cached);
+    WaveformThumbnail loaded;
+    ASSERT_TRUE(cache.load(paths[11], loaded));
+    EXPECT_EQ(loaded.frames, 4096 * 12);
+}
+
+TEST_F(WaveformCacheTest, FfiGeneratesAndReads) {
+    EXPECT_EQ(ml_waveform_cache_create(nullptr, 0), nullptr);
+    MLWaveformCacheHandle* handle = ml_waveform_cache_create(path("cache").c_str(), 0);
+    ASSERT_NE(handle, nullptr);
+
+    const std::string wav = path("take.wav");
+    write_wav(wav, half_tone(kSampleRate, 1), 1, 16);
+    const std::string missing = path("missing.wav");
+    const char* paths[] = {wav.c_str(), missing.c_str()};
+    int32_t statuses[2] = {-1, -1};
+    EXPECT_EQ(ml_waveform_cache_generate(handle, nullptr, 2, statuses), -1);
+    EXPECT_EQ(ml_waveform_cache_generate(handle, paths, 2, statuses), 1);
+    EXPECT_EQ(statuses[0], ML_WAVEFORM_GENERATED);
+    EXPECT_EQ(statuses[1], ML_WAVEFORM_IO_ERROR);
+
+    MLWaveformBucket buckets[128];
+    EXPECT_EQ(ml_waveform_cache_read(handle, wav.c_str(), 128, nullptr), -1);
+    ASSERT_EQ(ml_waveform_cache_read(handle, wav.c_str(), 128, buckets), 128);
+    EXPECT_NEAR(buckets[0].max, 16383, 40);
+    EXPECT_EQ(ml_waveform_cache_read(handle, missing.c_str(), 128, buckets), -1);
+    ml_waveform_cache_destroy(handle);
+}
@@ -0,0 +1,177 @@
+/**
+ * ml_bench: wall-clock benchmarks for the offline paths that have a speed
+ * budget, kept out of the unit tests so a loaded machine cannot fail them.
+ *
+ * Each case runs --repeat times on deterministic synthetic input and prints
+ * its best time (around the measured work, not the input set-up), the length
+ * of audio it covers and the speed against real time:
+ *
+ *   time_stretch_export   10 s stereo stretched to 20 s at speed 0.5
+ *   contour_align_10min   banded DTW and note scoring of a 10-minute take
+ *                         against its reference (100 hops per second)
+ *
+ * Usage:
+ *   ml_bench [--repeat N] [--case NAME]...
+ *
+ * Cases print with an '!' and the exit status is 1 when a best time misses
+ * the case's budget, so a run on quiet hardware can still gate a change.
+ */
+
+#include "contour_aligner.h"
+#include "time_stretcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using music_life::ContourAligner;
+using music_life::TimeStretcher;
+
+namespace {
+
+constexpr double kTwoPi = 6.28318530717958647692;
+
+using Clock = std::chrono::steady_clock;
+
+struct Timing {
+    double seconds = 0.0;        ///< Wall clock around the measured work only
+    double audio_seconds = 0.0;  ///< Audio the work covers
+};
+
+struct Case {
+    const char* name;
+    double      budget_seconds;  ///< Best time must stay below this
+    std::function<Timing()> run;
+};
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Interleaved sines, one frequency per channel, amplitude 0.5.
+std::vector<float> make_tones(const std::vector<double>& freqs, int frames, int sample_rate) {
+    const size_t channels = freqs.size();
+    std::vector<float> out(static_cast<size_t>(frames) * channels);
+    for (int i = 0; i < frames; ++i) {
+        for (size_t c = 0; c < channels; ++c) {
+            out[static_cast<size_t>(i) * channels + c] =
+                static_cast<float>(0.5 * std::sin(kTwoPi * freqs[c] * i / sample_rate));
+        }
+    }
+    return out;
+}
+
+Timing time_stretch_export() {
+    const int sample_rate = 48000;
+    const int block = 8192;
+    TimeStretcher stretcher(sample_rate, 2);
+    stretcher.set_speed(0.5f);
+    const int frames = 10 * sample_rate;
+    const std::vector<float> in = make_tones({330.0, 495.0}, frames, sample_rate);
+
+    std::vector<float> chunk(static_cast<size_t>(block) * 2);
+    long long produced = 0;
+    int written = 0;
+    const Clock::time_point start = Clock::now();
+    while (!stretcher.drained()) {
+        const int n = stretcher.read(chunk.data(), block);
+        produced += n;
+        if (n < block) {
+            if (written < frames) {
+                written += stretcher.write(in.data() + static_cast<size_t>(written) * 2,
+                                           std::min(frames - written, block));
+            } else {
+                stretcher.finish();
+            }
+        }
+    }
+    return {seconds_since(start), static_cast<double>(produced) / sample_rate};
+}
+
+// Pitch contour in absolute cents of `notes` notes from a looping scale,
+// each followed by a two-hop unvoiced gap; `stretch` scales note lengths as a
+// take played at a different tempo would.
+std::vector<float> sing(int notes, double stretch) {
+    static const int kScale[] = {60, 62, 64, 65, 67, 69, 71, 72, 71, 69, 67, 65, 64, 62};
+    std::vector<float> contour;
+    for (int n = 0; n < notes; ++n) {
+        const int frames = static_cast<int>((20 + 7 * (n % 5)) * stretch);
+        for (int i = 0; i < frames; ++i) {
+            contour.push_back(100.0f * kScale[n % 14] +
+                              8.0f * static_cast<float>(std::sin(0.3 * static_cast<double>(contour.size()))));
+        }
+        contour.push_back(std::numeric_limits<float>::quiet_NaN());
+        contour.push_back(std::numeric_limits<float>::quiet_NaN());
+    }
+    return contour;
+}
+
+Timing contour_align_10min() {
+    const std::vector<float> ref = sing(1700, 1.0);
+    const std::vector<float> take = sing(1700, 1.05);
+    const int n = static_cast<int>(ref.size());
+    const int m = static_cast<int>(take.size());
+
+    const Clock::time_point start = Clock::now();
+    const ContourAligner::Alignment alignment = ContourAligner().align(ref.data(), n, take.data(), m, 1);
+    const std::vector<ContourAligner::NoteDeviation> notes =
+        ContourAligner::note_deviations(ref.data(), n, take.data(), m, alignment.path);
+    const double seconds = seconds_since(start);
+    if (notes.empty()) throw std::runtime_error("no notes scored");
+    return {seconds, m / 100.0};
+}
+
+std::vector<Case> all_cases() {
+    // Budgets leave a desktop core an order of magnitude of headroom over
+    // what a mobile one needs.
+    return {
+        {"time_stretch_export", 2.0, time_stretch_export},
+        {"contour_align_10min", 1.0, contour_align_10min},
+    };
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int repeat = 3;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--case" && i + 1 < argc) {
+            selected.emplace_back(argv[++i]);
+        } else {
+            std::fprintf(stderr, "ml_bench: unknown or incomplete option: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    int status = 0;
+    std::printf("  %-24s %10s %10s %10s\n", "case", "best s", "audio s", "x realtime");
+    for (const Case& c : all_cases()) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), c.name) == selected.end()) continue;
+        Timing best;
+        try {
+            for (int r = 0; r < repeat; ++r) {
+                const Timing timing = c.run();
+                if (r == 0 || timing.seconds < best.seconds) best = timing;
+            }
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "ml_bench: %s: %s\n", c.name, e.what());
+            return 2;
+        }
+        const bool over = best.seconds >= c.budget_seconds;
+        if (over) status = 1;
+        std::printf("%c %-24s %10.4f %10.1f %10.1f\n", over ? '!' : ' ', c.name, best.seconds, best.audio_seconds,
+                    best.seconds > 0.0 ? best.audio_seconds / best.seconds : 0.0);
+    }
+    return status;
+}
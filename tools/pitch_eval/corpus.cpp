@@ -0,0 +1,301 @@
+#include "corpus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace music_life {
+namespace eval {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// SplitMix64: portable and identical everywhere, unlike std:: distributions.
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /** Uniform in [-1, 1). */
+    double bipolar() { return static_cast<double>(next() >> 11) * 0x1.0p-52 - 1.0; }
+
+    int range(int lo, int hi) { return lo + static_cast<int>(next() % static_cast<uint64_t>(hi - lo + 1)); }
+
+private:
+    uint64_t state_;
+};
+
+struct Voice {
+    const char*         name;
+    std::vector<double> amplitudes;     ///< Per harmonic, starting at the fundamental
+    double              inharmonicity;  ///< Stiff-string B: partial k at k * f0 * sqrt(1 + B k^2)
+};
+
+Voice string_voice() {
+    Voice v{"string", {}, 2.0e-4};
+    for (int k = 1; k <= 12; ++k) v.amplitudes.push_back(1.0 / k);
+    return v;
+}
+
+Voice reed_voice() {
+    Voice v{"reed", {}, 0.0};
+    for (int k = 1; k <= 10; ++k) v.amplitudes.push_back(k % 2 == 1 ? 1.0 / k : 0.05 / k);
+    return v;
+}
+
+Voice weak_fundamental_voice() {
+    return Voice{"weakf0", {0.15, 1.0, 0.8, 0.5, 0.3, 0.2, 0.1}, 0.0};
+}
+
+double midi_to_hz(int midi) {
+    return 440.0 * std::pow(2.0, (midi - 69) / 12.0);
+}
+
+/**
+ * Add one note to clip.samples and its fundamental to clip.reference_hz.
+ *
+ * cents_at(t) gives the pitch deviation in cents at t seconds into the note;
+ * decay_seconds <= 0 holds the level, otherwise the note decays exponentially.
+ */
+template <typename CentsAt>
+void add_note(Clip& clip,
+              const Voice& voice,
+              double base_hz,
+              double start_seconds,
+              double length_seconds,
+              double amplitude,
+              double decay_seconds,
+              CentsAt&& cents_at) {
+    const double sr = static_cast<double>(clip.sample_rate);
+    const int start = static_cast<int>(std::lround(start_seconds * sr));
+    const int length = static_cast<int>(std::lround(length_seconds * sr));
+    const int attack = static_cast<int>(0.01 * sr);
+    const int release = static_cast<int>(0.02 * sr);
+    const double partial_one = std::sqrt(1.0 + voice.inharmonicity);
+
+    std::vector<double> phases(voice.amplitudes.size(), 0.0);
+    for (int i = 0; i < length && start + i < static_cast<int>(clip.samples.size()); ++i) {
+        const double t = static_cast<double>(i) / sr;
+        const double f0 = base_hz * std::pow(2.0, cents_at(t) / 1200.0);
+
+        double gain = amplitude;
+        if (i < attack) gain *= static_cast<double>(i) / attack;
+        if (length - i < release) gain *= static_cast<double>(length - i) / release;
+        if (decay_seconds > 0.0) gain *= std::exp(-t / decay_seconds);
+
+        double value = 0.0;
+        for (size_t k = 0; k < voice.amplitudes.size(); ++k) {
+            const double n = static_cast<double>(k + 1);
+            const double fk = n * f0 * std::sqrt(1.0 + voice.inharmonicity * n * n);
+            if (fk >= 0.45 * sr) break;
+            value += voice.amplitudes[k] * std::sin(phases[k]);
+            phases[k] = std::fmod(phases[k] + 2.0 * kPi * fk / sr, 2.0 * kPi);
+        }
+        clip.samples[static_cast<size_t>(start + i)] += static_cast<float>(gain * value);
+        clip.reference_hz[static_cast<size_t>(start + i)] = static_cast<float>(f0 * partial_one);
+    }
+}
+
+Clip empty_clip(const std::string& name, const char* category, int sample_rate, double seconds) {
+    const size_t n = static_cast<size_t>(seconds * sample_rate);
+    return Clip{name, category, sample_rate, std::vector<float>(n, 0.0f), std::vector<float>(n, 0.0f)};
+}
+
+void add_noise(Clip& clip, double snr_db, Random& random) {
+    double signal = 0.0;
+    size_t voiced = 0;
+    for (size_t i = 0; i < clip.samples.size(); ++i) {
+        if (clip.reference_hz[i] > 0.0f) {
+            signal += static_cast<double>(clip.samples[i]) * clip.samples[i];
+            ++voiced;
+        }
+    }
+    const double signal_rms = std::sqrt(signal / static_cast<double>(std::max<size_t>(voiced, 1)));
+    // Uniform noise on [-a, a] has RMS a / sqrt(3).
+    const double noise_peak = signal_rms * std::pow(10.0, -snr_db / 20.0) * std::sqrt(3.0);
+    for (float& s : clip.samples) s += static_cast<float>(noise_peak * random.bipolar());
+}
+
+std::string note_name(int midi) {
+    static const char* const kNames[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+    return std::string(kNames[midi % 12]) + std::to_string(midi / 12 - 1);
+}
+
+auto steady() {
+    return [](double) { return 0.0; };
+}
+
+} // namespace
+
+std::vector<Clip> synthetic_corpus(int sample_rate, bool quick) {
+    std::vector<Clip> corpus;
+    Random random(0x6d757369634c6966ull);
+
+    const std::vector<int> harmonic_notes = quick
+        ? std::vector<int>{40, 69, 88}
+        : std::vector<int>{28, 33, 40, 45, 52, 57, 64, 69, 76, 81, 88, 93, 96};
+    for (const Voice& voice : {string_voice(), reed_voice(), weak_fundamental_voice()}) {
+        for (int midi : harmonic_notes) {
+            Clip clip = empty_clip(std::string(voice.name) + "-" + note_name(midi), "harmonic", sample_rate, 1.0);
+            add_note(clip, voice, midi_to_hz(midi), 0.1, 0.8, 0.3, 0.0, steady());
+            corpus.push_back(std::move(clip));
+        }
+    }
+
+    const std::vector<int> vibrato_notes = quick ? std::vector<int>{57} : std::vector<int>{45, 57, 69, 81};
+    for (int midi : vibrato_notes) {
+        Clip clip = empty_clip("vibrato-" + note_name(midi), "vibrato", sample_rate, 1.5);
+        add_note(clip, string_voice(), midi_to_hz(midi), 0.1, 1.3, 0.3, 0.0, [](double t) {
+            return 30.0 * std::sin(2.0 * kPi * 5.5 * t) + 50.0 * t / 1.3;
+        });
+        corpus.push_back(std::move(clip));
+    }
+
+    const std::vector<int> snr_notes = quick ? std::vector<int>{57} : std::vector<int>{40, 52, 64, 76, 88};
+    for (int snr : {20, 10, 0}) {
+        for (int midi : snr_notes) {
+            const std::string category = "snr" + std::to_string(snr);
+            Clip clip = empty_clip(category + "-" + note_name(midi), category.c_str(), sample_rate, 1.0);
+            add_note(clip, string_voice(), midi_to_hz(midi), 0.1, 0.8, 0.3, 0.0, steady());
+            add_noise(clip, static_cast<double>(snr), random);
+            corpus.push_back(std::move(clip));
+        }
+    }
+
+    const int sequences = quick ? 1 : 4;
+    const int notes_per_sequence = quick ? 3 : 6;
+    for (int s = 0; s < sequences; ++s) {
+        Clip clip = empty_clip("transient-" + std::to_string(s), "transient", sample_rate,
+                               0.1 + 0.3 * notes_per_sequence);
+        for (int n = 0; n < notes_per_sequence; ++n) {
+            const double start = 0.1 + 0.3 * n;
+            add_note(clip, string_voice(), midi_to_hz(random.range(40, 84)), start, 0.25, 0.4, 0.4, steady());
+            // Pick noise on the attack; unpitched, so it does not touch the reference.
+            const int burst_start = static_cast<int>(start * sample_rate);
+            const int burst = static_cast<int>(0.005 * sample_rate);
+            for (int i = 0; i < burst; ++i) {
+                const double gain = 0.5 * (1.0 - static_cast<double>(i) / burst);
+                clip.samples[static_cast<size_t>(burst_start + i)] += static_cast<float>(gain * random.bipolar());
+            }
+        }
+        corpus.push_back(std::move(clip));
+    }
+    return corpus;
+}
+
+// ---------------------------------------------------------------------------
+// WAV and reference loading
+// ---------------------------------------------------------------------------
+
+namespace {
+
+uint32_t read_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t read_u16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+float decode_sample(const uint8_t* p, int format, int bits) {
+    if (format == 3) {
+        float value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    switch (bits) {
+        case 16: return static_cast<float>(static_cast<int16_t>(read_u16(p))) / 32768.0f;
+        case 24: {
+            const uint32_t packed = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+                                    (static_cast<uint32_t>(p[2]) << 24);
+            const int32_t value = static_cast<int32_t>(packed) >> 8;
+            return static_cast<float>(value) / 8388608.0f;
+        }
+        default: return static_cast<float>(static_cast<int32_t>(read_u32(p))) / 2147483648.0f;
+    }
+}
+
+} // namespace
+
+Clip load_wav_clip(const std::string& wav_path, const std::string& reference_path) {
+    std::ifstream wav(wav_path, std::ios::binary);
+    if (!wav) throw std::runtime_error("cannot open " + wav_path);
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(wav)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        throw std::runtime_error(wav_path + ": not a RIFF/WAVE file");
+    }
+
+    int format = 0, channels = 0, sample_rate = 0, bits = 0;
+    const uint8_t* data = nullptr;
+    size_t data_bytes = 0;
+    for (size_t pos = 12; pos + 8 <= bytes.size();) {
+        const uint8_t* chunk = bytes.data() + pos;
+        const size_t size = read_u32(chunk + 4);
+        const size_t available = std::min(size, bytes.size() - pos - 8);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            format      = read_u16(chunk + 8);
+            channels    = read_u16(chunk + 10);
+            sample_rate = static_cast<int>(read_u32(chunk + 12));
+            bits        = read_u16(chunk + 22);
+            if (format == 0xFFFE && available >= 26) format = read_u16(chunk + 32);  // Extensible sub-format
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            data_bytes = available;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    const bool supported = (format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32);
+    if (!data || channels <= 0 || sample_rate <= 0 || !supported) {
+        throw std::runtime_error(wav_path + ": unsupported WAV format (need PCM 16/24/32 or float 32)");
+    }
+
+    const size_t frame_bytes = static_cast<size_t>(channels) * static_cast<size_t>(bits / 8);
+    Clip clip{wav_path, "wav", sample_rate, std::vector<float>(data_bytes / frame_bytes), {}};
+    for (size_t i = 0; i < clip.samples.size(); ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            sum += decode_sample(data + i * frame_bytes + static_cast<size_t>(c) * (bits / 8), format, bits);
+        }
+        clip.samples[i] = sum / static_cast<float>(channels);
+    }
+
+    std::ifstream reference(reference_path);
+    if (!reference) throw std::runtime_error("cannot open " + reference_path);
+    std::vector<std::pair<double, double>> points;
+    std::string line;
+    while (std::getline(reference, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        double time = 0.0, f0 = 0.0;
+        if (line.empty() || line[0] == '#' || !(fields >> time >> f0)) continue;
+        points.emplace_back(time, f0);
+    }
+    if (points.size() < 2) throw std::runtime_error(reference_path + ": need at least two reference points");
+
+    // Hold each value until the next time stamp, and the last for one step.
+    clip.reference_hz.assign(clip.samples.size(), 0.0f);
+    const double step = (points.back().first - points.front().first) / static_cast<double>(points.size() - 1);
+    size_t p = 0;
+    for (size_t i = 0; i < clip.samples.size(); ++i) {
+        const double t = static_cast<double>(i) / sample_rate;
+        while (p + 1 < points.size() && points[p + 1].first <= t) ++p;
+        if (t < points[p].first || (p + 1 == points.size() && t > points[p].first + step)) continue;
+        clip.reference_hz[i] = points[p].second > 0.0 ? static_cast<float>(points[p].second) : 0.0f;
+    }
+    return clip;
+}
+
+} // namespace eval
+} // namespace music_life
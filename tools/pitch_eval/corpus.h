@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace music_life {
+namespace eval {
+
+/**
+ * One evaluation clip: mono audio plus a per-sample reference F0 track
+ * (0 where the reference is unvoiced).
+ */
+struct Clip {
+    std::string        name;
+    std::string        category;  ///< e.g. "harmonic", "vibrato", "snr10", "transient", "wav"
+    int                sample_rate;
+    std::vector<float> samples;
+    std::vector<float> reference_hz;
+};
+
+/**
+ * Build the deterministic synthetic corpus.
+ *
+ * Every clip is generated from a fixed seed with a portable PRNG, so the
+ * corpus is bit-identical across platforms and standard libraries:
+ *   - harmonic:  string-like (1/k, slightly inharmonic), reed-like (odd
+ *                harmonics) and weak-fundamental tones from E1 to C7
+ *   - vibrato:   5.5 Hz vibrato of +/-30 cents with a slow glide
+ *   - snrNN:     harmonic tones in white noise at 20, 10 and 0 dB SNR
+ *   - transient: plucked note sequences with noise-burst attacks and gaps
+ *
+ * @param quick  Generate a small subset for smoke tests.
+ */
+std::vector<Clip> synthetic_corpus(int sample_rate, bool quick);
+
+/**
+ * Load a WAV file (PCM 16/24/32-bit or IEEE float 32-bit; channels are
+ * averaged) and a reference F0 file of "time_seconds f0_hz" lines, with
+ * f0 <= 0 for unvoiced.  The reference is held between its time stamps.
+ * Throws std::runtime_error on malformed input.
+ */
+Clip load_wav_clip(const std::string& wav_path, const std::string& reference_path);
+
+} // namespace eval
+} // namespace music_life
@@ -0,0 +1,347 @@
+/**
+ * pitch_eval: accuracy-versus-cost harness for PitchDetector.
+ *
+ * Runs every detector configuration (engine, FFT backend, frame size,
+ * decimation) over a deterministic synthetic corpus and any WAV files given
+ * with reference F0, and prints one row per configuration:
+ *
+ *   GPE   gross pitch error: voiced frames more than 50 cents off
+ *   FPE   fine pitch error in cents over the remaining voiced frames
+ *   VDE   voicing decision error: missed or false voiced frames
+ *   err   (gross + voicing errors) / scored frames
+ *   ns/frame and CPU % of real time, measured around process_block only
+ *
+ * Rows on the Pareto front of err against ns/frame are marked with '*'.
+ * Frames whose reference voicing changes inside the analysis window are not
+ * scored.
+ *
+ * Usage:
+ *   pitch_eval [--quick] [--csv] [--by-category] [--frames 1024,2048,4096]
+ *              [--decimations 1,2,4] [--block 256] [--sample-rate 48000]
+ *              [--no-synthetic] [--wav audio.wav reference.txt]...
+ *              [--max-gpe PERCENT]
+ *
+ * --max-gpe exits with status 1 if any configuration's GPE exceeds PERCENT,
+ * so a run can gate a change.
+ */
+
+#include "corpus.h"
+#include "fft.h"
+#include "pitch_detector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using music_life::Fft;
+using music_life::PitchDetector;
+using music_life::eval::Clip;
+
+namespace {
+
+struct Options {
+    bool quick = false;
+    bool csv = false;
+    bool by_category = false;
+    bool synthetic = true;
+    int  block = 256;
+    int  sample_rate = 48000;
+    double max_gpe = -1.0;
+    std::vector<int> frames{1024, 2048, 4096};
+    std::vector<int> decimations{1, 2, 4};
+    std::vector<std::pair<std::string, std::string>> wavs;
+};
+
+struct Config {
+    bool        adaptive;
+    std::string backend;
+    int         frame_size;
+    int         decimation;
+
+    std::string name() const {
+        std::ostringstream out;
+        out << (adaptive ? "yin-adaptive" : "yin") << '/' << backend << '/' << frame_size << "/d" << decimation;
+        return out.str();
+    }
+};
+
+struct Score {
+    long long frames = 0;        ///< Scored frames
+    long long voiced = 0;        ///< Reference-voiced scored frames
+    long long gross = 0;
+    long long missed = 0;        ///< Voiced frames reported unpitched
+    long long false_alarms = 0;  ///< Unvoiced frames reported pitched
+    std::vector<float> fine_cents;
+
+    long long hops = 0;
+    double    seconds_audio = 0.0;
+    double    nanoseconds = 0.0;
+
+    void add(const Score& other) {
+        frames += other.frames;
+        voiced += other.voiced;
+        gross += other.gross;
+        missed += other.missed;
+        false_alarms += other.false_alarms;
+        fine_cents.insert(fine_cents.end(), other.fine_cents.begin(), other.fine_cents.end());
+        hops += other.hops;
+        seconds_audio += other.seconds_audio;
+        nanoseconds += other.nanoseconds;
+    }
+
+    double gpe() const { return voiced ? 100.0 * gross / voiced : 0.0; }
+    double vde() const { return frames ? 100.0 * (missed + false_alarms) / frames : 0.0; }
+    double error() const { return frames ? 100.0 * (gross + missed + false_alarms) / frames : 0.0; }
+    double ns_per_frame() const { return hops ? nanoseconds / hops : 0.0; }
+    double cpu_percent() const { return seconds_audio > 0.0 ? 100.0 * nanoseconds * 1e-9 / seconds_audio : 0.0; }
+
+    double fpe_mean() const {
+        if (fine_cents.empty()) return 0.0;
+        double sum = 0.0;
+        for (float c : fine_cents) sum += c;
+        return sum / static_cast<double>(fine_cents.size());
+    }
+
+    double fpe_p95() const {
+        if (fine_cents.empty()) return 0.0;
+        std::vector<float> sorted = fine_cents;
+        const size_t k = (sorted.size() * 95) / 100;
+        std::nth_element(sorted.begin(), sorted.begin() + static_cast<long>(std::min(k, sorted.size() - 1)), sorted.end());
+        return sorted[std::min(k, sorted.size() - 1)];
+    }
+};
+
+void set_backend(const std::string& name) {
+#if defined(_WIN32)
+    _putenv_s("ML_FFT_BACKEND", name.c_str());
+#else
+    setenv("ML_FFT_BACKEND", name.c_str(), 1);
+#endif
+}
+
+std::vector<std::string> available_backends() {
+    std::vector<std::string> backends;
+    for (const char* name : {"radix2", "accelerate", "fftw"}) {
+        set_backend(name);
+        const Fft probe(64);
+        if (std::strcmp(probe.backend_name(), name) == 0) backends.push_back(name);
+    }
+    return backends;
+}
+
+std::vector<int> parse_list(const char* text) {
+    std::vector<int> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) values.push_back(std::stoi(item));
+    return values;
+}
+
+Score evaluate(const Config& config, const Clip& clip, int block) {
+    PitchDetector detector(clip.sample_rate, config.frame_size, 0.10f, 440.0f, config.adaptive, config.decimation);
+    const int frame = detector.frame_size();
+    const int total = static_cast<int>(clip.samples.size());
+
+    // voiced_prefix[i] = voiced reference samples in [0, i).
+    std::vector<int> voiced_prefix(static_cast<size_t>(total) + 1, 0);
+    for (int i = 0; i < total; ++i) {
+        voiced_prefix[static_cast<size_t>(i) + 1] = voiced_prefix[static_cast<size_t>(i)] + (clip.reference_hz[static_cast<size_t>(i)] > 0.0f);
+    }
+
+    Score score;
+    score.seconds_audio = static_cast<double>(total) / clip.sample_rate;
+    std::vector<PitchDetector::Result> results(static_cast<size_t>(block / detector.min_hop_size() + 2));
+    std::vector<int> offsets(results.size());
+    for (int pos = 0; pos < total; pos += block) {
+        const int n = std::min(block, total - pos);
+        const auto start = std::chrono::steady_clock::now();
+        const int count = detector.process_block(clip.samples.data() + pos, n, results.data(),
+                                                 static_cast<int>(results.size()), offsets.data());
+        const auto stop = std::chrono::steady_clock::now();
+        score.nanoseconds += static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        score.hops += count;
+
+        for (int i = 0; i < count; ++i) {
+            const int end = pos + offsets[static_cast<size_t>(i)];
+            const int voiced = voiced_prefix[static_cast<size_t>(end)] - voiced_prefix[static_cast<size_t>(end - frame)];
+            if (voiced != 0 && voiced != frame) continue;  // Voicing changes inside the window
+
+            const PitchDetector::Result& r = results[static_cast<size_t>(i)];
+            ++score.frames;
+            if (voiced == 0) {
+                if (r.pitched) ++score.false_alarms;
+                continue;
+            }
+            ++score.voiced;
+            if (!r.pitched) {
+                ++score.missed;
+                continue;
+            }
+            const float reference = clip.reference_hz[static_cast<size_t>(end - frame / 2)];
+            const float cents = std::fabs(1200.0f * std::log2(r.frequency / reference));
+            if (cents > 50.0f) {
+                ++score.gross;
+            } else {
+                score.fine_cents.push_back(cents);
+            }
+        }
+    }
+    return score;
+}
+
+std::vector<bool> pareto_front(const std::vector<Score>& scores) {
+    std::vector<bool> front(scores.size(), true);
+    for (size_t i = 0; i < scores.size(); ++i) {
+        for (size_t j = 0; j < scores.size() && front[i]; ++j) {
+            const bool no_worse = scores[j].error() <= scores[i].error() && scores[j].ns_per_frame() <= scores[i].ns_per_frame();
+            const bool better = scores[j].error() < scores[i].error() || scores[j].ns_per_frame() < scores[i].ns_per_frame();
+            if (j != i && no_worse && better) front[i] = false;
+        }
+    }
+    return front;
+}
+
+void print_row(bool csv, const std::string& name, const Score& s, bool pareto) {
+    if (csv) {
+        std::printf("%s,%.0f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%lld,%d\n", name.c_str(), s.ns_per_frame(), s.cpu_percent(),
+                    s.gpe(), s.fpe_mean(), s.fpe_p95(), s.vde(), s.error(), s.frames, pareto ? 1 : 0);
+    } else {
+        std::printf("%c %-34s %10.0f %6.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7lld\n", pareto ? '*' : ' ', name.c_str(),
+                    s.ns_per_frame(), s.cpu_percent(), s.gpe(), s.fpe_mean(), s.fpe_p95(), s.vde(), s.error(), s.frames);
+    }
+}
+
+void print_header(bool csv) {
+    if (csv) {
+        std::printf("config,ns_per_frame,cpu_percent,gpe,fpe_mean_cents,fpe_p95_cents,vde,error,frames,pareto\n");
+    } else {
+        std::printf("  %-34s %10s %6s %7s %7s %7s %7s %7s %7s\n", "config", "ns/frame", "cpu%", "GPE%", "FPE",
+                    "FPE95", "VDE%", "err%", "frames");
+    }
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else if (arg == "--by-category") {
+            options.by_category = true;
+        } else if (arg == "--no-synthetic") {
+            options.synthetic = false;
+        } else if (arg == "--frames" && has_value) {
+            options.frames = parse_list(argv[++i]);
+        } else if (arg == "--decimations" && has_value) {
+            options.decimations = parse_list(argv[++i]);
+        } else if (arg == "--block" && has_value) {
+            options.block = std::stoi(argv[++i]);
+        } else if (arg == "--sample-rate" && has_value) {
+            options.sample_rate = std::stoi(argv[++i]);
+        } else if (arg == "--max-gpe" && has_value) {
+            options.max_gpe = std::stod(argv[++i]);
+        } else if (arg == "--wav" && i + 2 < argc) {
+            options.wavs.emplace_back(argv[i + 1], argv[i + 2]);
+            i += 2;
+        } else {
+            throw std::invalid_argument("unknown or incomplete option: " + arg);
+        }
+    }
+    if (options.block <= 0) throw std::invalid_argument("--block must be > 0");
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<Clip> corpus;
+    try {
+        options = parse_options(argc, argv);
+        if (options.synthetic) corpus = music_life::eval::synthetic_corpus(options.sample_rate, options.quick);
+        for (const auto& wav : options.wavs) corpus.push_back(music_life::eval::load_wav_clip(wav.first, wav.second));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "pitch_eval: %s\n", e.what());
+        return 2;
+    }
+    if (corpus.empty()) {
+        std::fprintf(stderr, "pitch_eval: empty corpus\n");
+        return 2;
+    }
+
+    std::vector<Config> configs;
+    for (const std::string& backend : available_backends()) {
+        for (bool adaptive : {false, true}) {
+            for (int frame : options.frames) {
+                for (int decimation : options.decimations) {
+                    if (decimation < 1 || frame % decimation != 0) continue;
+                    configs.push_back(Config{adaptive, backend, frame, decimation});
+                }
+            }
+        }
+    }
+
+    std::vector<Score> totals;
+    std::vector<std::map<std::string, Score>> categories;
+    for (const Config& config : configs) {
+        set_backend(config.backend);
+        Score total;
+        std::map<std::string, Score> by_category;
+        try {
+            for (const Clip& clip : corpus) {
+                const Score score = evaluate(config, clip, options.block);
+                total.add(score);
+                by_category[clip.category].add(score);
+            }
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "pitch_eval: %s: %s\n", config.name().c_str(), e.what());
+            return 2;
+        }
+        totals.push_back(std::move(total));
+        categories.push_back(std::move(by_category));
+    }
+
+    // Cheapest first, so the Pareto front reads top to bottom.
+    std::vector<size_t> order(configs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&totals](size_t a, size_t b) {
+        return totals[a].ns_per_frame() < totals[b].ns_per_frame();
+    });
+    const std::vector<bool> front = pareto_front(totals);
+
+    if (!options.csv) {
+        std::printf("%zu clips, %zu configurations (engine/backend/frame/decimation)\n\n", corpus.size(), configs.size());
+    }
+    print_header(options.csv);
+    for (size_t i : order) {
+        print_row(options.csv, configs[i].name(), totals[i], front[i]);
+        if (options.by_category) {
+            for (const auto& entry : categories[i]) {
+                print_row(options.csv, "  " + entry.first, entry.second, false);
+            }
+        }
+    }
+
+    int status = 0;
+    if (options.max_gpe >= 0.0) {
+        for (size_t i = 0; i < configs.size(); ++i) {
+            if (totals[i].gpe() > options.max_gpe) {
+                std::fprintf(stderr, "pitch_eval: %s GPE %.2f%% exceeds %.2f%%\n", configs[i].name().c_str(),
+                             totals[i].gpe(), options.max_gpe);
+                status = 1;
+            }
+        }
+    }
+    return status;
+}